@@ -14,3 +14,6 @@ fi
 #run test
 HOME=${TESTDIR} ${SOURCEDIR}/test/validation/run.sh ${TESTDIR}/usr/local/bin/spring-headless $@
 
+#replay it serially, the checksums have to match
+HOME=${TESTDIR} ${SOURCEDIR}/test/validation/replay-sync.sh ${TESTDIR}/usr/local/bin/spring-headless ${TESTDIR}/.spring/demos
+
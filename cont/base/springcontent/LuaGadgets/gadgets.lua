@@ -156,6 +156,7 @@ local callInLists = {
 	"TerraformComplete",
 	"AllowWeaponTargetCheck",
 	"AllowWeaponTarget",
+	"AllowWeaponTargets",
 	-- unsynced
 	"DrawUnit",
 	"DrawFeature",
@@ -1253,6 +1254,48 @@ function gadgetHandler:AllowWeaponTarget(attackerID, targetID, attackerWeaponNum
 	return allowed, priority
 end
 
+function gadgetHandler:AllowWeaponTargets(attackerID, attackerWeaponNum, attackerWeaponDefID, targetIDs)
+	local allowed = {}
+	local priorities = {}
+	local numTargets = #targetIDs
+
+	for i = 1, numTargets do
+		allowed[i] = false
+		priorities[i] = 1.0
+	end
+
+	for _, g in ipairs(self.AllowWeaponTargetsList) do
+		local targetsAllowed, targetPriorities = g:AllowWeaponTargets(attackerID, attackerWeaponNum, attackerWeaponDefID, targetIDs)
+
+		-- missing entries mean not allowed, priority 1
+		if (targetsAllowed) then
+			for i = 1, numTargets do
+				if (targetsAllowed[i]) then
+					priorities[i] = math.max(priorities[i], (targetPriorities and targetPriorities[i]) or 1.0)
+					allowed[i] = true
+				end
+			end
+		end
+	end
+
+	-- the engine no longer calls AllowWeaponTarget while this call-in
+	-- exists, so ask the gadgets that only define the per-unit version
+	for _, g in ipairs(self.AllowWeaponTargetList) do
+		if (g.AllowWeaponTargets == nil) then
+			for i = 1, numTargets do
+				local targetAllowed, targetPriority = g:AllowWeaponTarget(attackerID, targetIDs[i], attackerWeaponNum, attackerWeaponDefID)
+
+				if (targetAllowed) then
+					priorities[i] = math.max(priorities[i], targetPriority or 1.0)
+					allowed[i] = true
+				end
+			end
+		end
+	end
+
+	return allowed, priorities
+end
+
 
 --------------------------------------------------------------------------------
 --
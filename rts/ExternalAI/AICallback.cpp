@@ -731,6 +731,12 @@ int CAICallback::InitPath(const float3& start, const float3& end, int pathType,
 	return pathManager->RequestPath(moveinfo->moveData.at(pathType), start, end, goalRadius, NULL, false);
 }
 
+int CAICallback::InitPathAsync(const float3& start, const float3& end, int pathType, float goalRadius)
+{
+	assert(((size_t)pathType) < moveinfo->moveData.size());
+	return pathManager->RequestPathAsync(this, moveinfo->moveData.at(pathType), start, end, goalRadius);
+}
+
 float3 CAICallback::GetNextWaypoint(int pathId)
 {
 	return pathManager->NextWaypoint(pathId, ZeroVector, 0.0f, 0, 0, false);
@@ -838,7 +844,7 @@ static int FilterUnitsVector(const std::vector<CUnit*>& units, int* unitIds, int
 
 	return a;
 }
-static int FilterUnitsList(const std::list<CUnit*>& units, int* unitIds, int unitIds_max, bool (*includeUnit)(const CUnit*) = NULL)
+static int FilterUnitsList(const std::vector<CUnit*>& units, int* unitIds, int unitIds_max, bool (*includeUnit)(const CUnit*) = NULL)
 {
 	int a = 0;
 
@@ -847,7 +853,7 @@ static int FilterUnitsList(const std::list<CUnit*>& units, int* unitIds, int uni
 		unitIds_max = MAX_UNITS;
 	}
 
-	std::list<CUnit*>::const_iterator ui;
+	std::vector<CUnit*>::const_iterator ui;
 	for (ui = units.begin(); (ui != units.end()) && (a < unitIds_max); ++ui) {
 		CUnit* u = *ui;
 
@@ -113,6 +113,8 @@ private:
 public:
 
 	int InitPath(const float3& start, const float3& end, int pathType, float goalRadius);
+	/// @return the id of the request, its result is sent with EVENT_PATH_FINISHED
+	int InitPathAsync(const float3& start, const float3& end, int pathType, float goalRadius);
 	float3 GetNextWaypoint(int pathId);
 	void FreePath(int pathId);
 
@@ -138,8 +138,9 @@ enum CommandTopic {
 	COMMAND_DEBUG_DRAWER_OVERLAYTEXTURE_SET_LABEL = 94,
 	COMMAND_TRACE_RAY_FEATURE                     = 95,
 	COMMAND_CALL_LUA_UI                           = 96,
+	COMMAND_PATH_INIT_ASYNC                       = 97,
 };
-const int NUM_CMD_TOPICS = 97;
+const int NUM_CMD_TOPICS = 98;
 
 
 /**
@@ -257,6 +258,7 @@ enum UnitCommandOptions {
 		+ sizeof(struct SSetSizeOverlayTextureDrawerDebugCommand) \
 		+ sizeof(struct SSetLabelOverlayTextureDrawerDebugCommand) \
 		+ sizeof(struct SFeatureTraceRayCommand) \
+		+ sizeof(struct SInitPathAsyncCommand) \
 		)
 
 /**
@@ -375,6 +377,25 @@ struct SInitPathCommand {
 	int ret_pathId;
 }; //$ COMMAND_PATH_INIT Pathing_initPath REF:ret_pathId->Path
 
+/**
+ * Requests a path to be searched in the background, while the engine renders.
+ * The result arrives with an EVENT_PATH_FINISHED event in a later frame,
+ * carrying the returned request ID.
+ * Same parameters as COMMAND_PATH_INIT.
+ */
+struct SInitPathAsyncCommand {
+	/// The starting location of the requested path
+	float* start_posF3;
+	/// The goal location of the requested path
+	float* end_posF3;
+	/// For what type of unit should the path be calculated
+	int pathType;
+	/// default: 8.0f
+	float goalRadius;
+	/// 0 if the request could not be queued
+	int ret_requestId;
+}; //$ COMMAND_PATH_INIT_ASYNC Pathing_initPathAsync
+
 /**
  * Returns the approximate path cost between two points.
  * - for pathType {Ground_Move=0, Hover_Move=1, Ship_Move=2},
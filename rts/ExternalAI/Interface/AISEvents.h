@@ -62,8 +62,9 @@ enum EventTopic {
 	EVENT_ENEMY_CREATED                = 25,
 	EVENT_ENEMY_FINISHED               = 26,
 	EVENT_LUA_MESSAGE                  = 27,
+	EVENT_PATH_FINISHED                = 28,
 };
-const int NUM_EVENTS = 28;
+const int NUM_EVENTS = 29;
 
 
 
@@ -95,6 +96,7 @@ const int NUM_EVENTS = 28;
 		+ sizeof(struct SSaveEvent) \
 		+ sizeof(struct SEnemyCreatedEvent) \
 		+ sizeof(struct SEnemyFinishedEvent) \
+		+ sizeof(struct SPathFinishedEvent) \
 		)
 
 /**
@@ -403,6 +405,17 @@ struct SEnemyFinishedEvent {
 	int enemy;
 }; //$ EVENT_ENEMY_FINISHED INTERFACES:Unit(enemy),Enemy(enemy)
 
+/**
+ * This AI event is sent when a path requested with COMMAND_PATH_INIT_ASYNC
+ * has been searched.
+ * pathId is 0 if no path was found, otherwise it has to be freed with
+ * COMMAND_PATH_FREE like the ones from COMMAND_PATH_INIT.
+ */
+struct SPathFinishedEvent {
+	int requestId;
+	int pathId;
+}; //$ EVENT_PATH_FINISHED
+
 #ifdef	__cplusplus
 } // extern "C"
 #endif
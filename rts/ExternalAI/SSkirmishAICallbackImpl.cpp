@@ -367,6 +367,13 @@ EXPORT(int) skirmishAiCallback_Engine_handleCommand(int skirmishAIId, int toId,
 					cmd->end_posF3, cmd->pathType, cmd->goalRadius);
 			break;
 		}
+		case COMMAND_PATH_INIT_ASYNC:
+		{
+			SInitPathAsyncCommand* cmd = (SInitPathAsyncCommand*) commandData;
+			cmd->ret_requestId = clb->InitPathAsync(cmd->start_posF3,
+					cmd->end_posF3, cmd->pathType, cmd->goalRadius);
+			break;
+		}
 		case COMMAND_PATH_GET_APPROXIMATE_LENGTH:
 		{
 			SGetApproximateLengthPathCommand* cmd =
@@ -3536,7 +3543,7 @@ EXPORT(int) skirmishAiCallback_getTeamUnits(int skirmishAIId, int* unitIds, int
 	int a = 0;
 
 	const int teamId = skirmishAIId_teamId[skirmishAIId];
-	for (std::list<CUnit*>::iterator ui = uh->activeUnits.begin();
+	for (std::vector<CUnit*>::iterator ui = uh->activeUnits.begin();
 			ui != uh->activeUnits.end(); ++ui) {
 		CUnit* u = *ui;
 
@@ -11,6 +11,7 @@
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitHandler.h"
 #include "Sim/Misc/TeamHandler.h"
+#include "Sim/Path/IPathManager.h"
 #include "ExternalAI/AICallback.h"
 #include "ExternalAI/AICheats.h"
 #include "ExternalAI/SkirmishAI.h"
@@ -101,6 +102,10 @@ CSkirmishAIWrapper::~CSkirmishAIWrapper() {
 		skirmishAiCallback_release(skirmishAIId);
 		c_callback = NULL;
 
+		if (pathManager != NULL) {
+			pathManager->CancelPathRequests(callback);
+		}
+
 		delete callback;
 		callback = NULL;
 
@@ -374,6 +379,14 @@ void CSkirmishAIWrapper::EnemyDamaged(int enemyUnitId, int attackerUnitId,
 }
 
 void CSkirmishAIWrapper::Update(int frame) {
+	// deliver the async paths searched since the last update first
+	std::vector<IPathManager::FinishedPathRequest> finishedPaths;
+	pathManager->GetFinishedPathRequests(callback, finishedPaths);
+
+	for (size_t n = 0; n < finishedPaths.size(); n++) {
+		PathFinished(finishedPaths[n].first, finishedPaths[n].second);
+	}
+
 	SUpdateEvent evtData = {frame};
 	ai->HandleEvent(EVENT_UPDATE, &evtData);
 }
@@ -422,6 +435,11 @@ void CSkirmishAIWrapper::SeismicPing(int allyTeam, int unitId,
 	delete [] evtData.pos_posF3;
 }
 
+void CSkirmishAIWrapper::PathFinished(int requestId, int pathId) {
+	SPathFinishedEvent evtData = {requestId, pathId};
+	ai->HandleEvent(EVENT_PATH_FINISHED, &evtData);
+}
+
 
 int CSkirmishAIWrapper::GetTeamId() const {
 	return teamId;
@@ -64,6 +64,7 @@ public:
 	virtual void PlayerCommandGiven(const std::vector<int>& selectedUnits, const Command& c, int playerId);
 	virtual void CommandFinished(int unitId, int commandId, int commandTopicId);
 	virtual void SeismicPing(int allyTeam, int unitId, const float3& pos, float strength);
+	virtual void PathFinished(int requestId, int pathId);
 
 	/** Called just before all the units are destroyed. */
 	virtual void PreDestroy();
@@ -0,0 +1,168 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef EXPLOSION_DAMAGE_BATCH_H
+#define EXPLOSION_DAMAGE_BATCH_H
+
+#include <algorithm>
+#include <vector>
+#include "System/float3.h"
+
+#if defined(STREFLOP_SSE) && !defined(DEDICATED_NOSSE)
+	#define EXPLOSION_DAMAGE_BATCH_SSE
+	#include <xmmintrin.h>
+#endif
+
+/**
+ * Distance falloff of one explosion for many units at once, used by
+ * CGameHelper::Explosion before it applies the damage unit by unit.
+ *
+ * The inputs (center and bounding radius of each unit's collision volume)
+ * are stored as structure-of-arrays, so Compute can handle four units per
+ * SSE instruction. It only uses operations that SSE computes exactly as
+ * the scalar code does (add, sub, mul, div, sqrt, min, max), in the same
+ * order and with the same NaN behaviour as the scalar fallback, so the
+ * results are bit-identical to it and thus sync-safe.
+ */
+class CExplosionDamageBatch
+{
+public:
+	CExplosionDamageBatch(): numUnits(0) {}
+
+	void Clear() { numUnits = 0; }
+
+	/// @param underWater whether the unit gets the above-water explosion penalty
+	void Add(const float3& basePos, float volRad, bool underWater) {
+		// keep the arrays padded to a multiple of 4
+		if (numUnits == posX.size()) {
+			const unsigned int newSize = numUnits + 4;
+
+			posX.resize(newSize, 0.0f); posY.resize(newSize, 0.0f); posZ.resize(newSize, 0.0f);
+			volRads.resize(newSize, 0.0f);
+			underWaterMask.resize(newSize, 0.0f);
+
+			expDist2.resize(newSize); mod1.resize(newSize); mod2.resize(newSize);
+			dirX.resize(newSize); dirY.resize(newSize); dirZ.resize(newSize);
+			inRange.resize(newSize);
+		}
+
+		posX[numUnits] = basePos.x;
+		posY[numUnits] = basePos.y;
+		posZ[numUnits] = basePos.z;
+		volRads[numUnits] = volRad;
+		underWaterMask[numUnits] = underWater? 1.0f: 0.0f;
+		numUnits++;
+	}
+
+	unsigned int Size() const { return numUnits; }
+
+	/**
+	 * Fills the outputs for all units, see CGameHelper::DoExplosionDamage
+	 * for the meaning of the terms.
+	 */
+	void Compute(const float3& expPos, float expRad, float edgeEffectiveness) {
+		// subs only get the penalty from above-water explosions
+		const bool underWaterPenalty = (expPos.y > -1.0f);
+		unsigned int i = 0;
+
+	#ifdef EXPLOSION_DAMAGE_BATCH_SSE
+		const __m128 ex = _mm_set1_ps(expPos.x);
+		const __m128 ey = _mm_set1_ps(expPos.y);
+		const __m128 ez = _mm_set1_ps(expPos.z);
+		const __m128 er = _mm_set1_ps(expRad);
+		const __m128 ee = _mm_set1_ps(edgeEffectiveness);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 minRad = _mm_set1_ps(0.1f);
+		const __m128 minMod = _mm_set1_ps(0.01f);
+		const __m128 dirBias = _mm_set1_ps(0.12f);
+
+		// the arrays are padded, the last group can contain unused slots
+		for (; i < numUnits; i += 4) {
+			const __m128 vr = _mm_loadu_ps(&volRads[i]);
+			const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&posX[i]), ex);
+			const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&posY[i]), ey);
+			const __m128 dz = _mm_sub_ps(_mm_loadu_ps(&posZ[i]), ez);
+			const __m128 sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+			// the operand order of min/max matches std::min/std::max
+			const __m128 dist  = _mm_max_ps(_mm_add_ps(vr, minRad), _mm_sqrt_ps(sq));
+			const __m128 dist1 = _mm_min_ps(er, dist);
+			      __m128 dist2 = _mm_sub_ps(dist, vr);
+
+			const int inRangeBits = _mm_movemask_ps(_mm_cmpngt_ps(dist2, er));
+
+			if (underWaterPenalty) {
+				const __m128 uw = _mm_cmpgt_ps(_mm_loadu_ps(&underWaterMask[i]), zero);
+				const __m128 pd = _mm_min_ps(er, _mm_add_ps(dist2, vr));
+
+				dist2 = _mm_or_ps(_mm_and_ps(uw, pd), _mm_andnot_ps(uw, dist2));
+			}
+
+			const __m128 m1 = _mm_max_ps(_mm_div_ps(_mm_sub_ps(er, dist1), _mm_sub_ps(er, _mm_mul_ps(dist1, ee))), minMod);
+			const __m128 m2 = _mm_max_ps(_mm_div_ps(_mm_sub_ps(er, dist2), _mm_sub_ps(er, _mm_mul_ps(dist2, ee))), minMod);
+			const __m128 inv = _mm_div_ps(one, dist);
+
+			_mm_storeu_ps(&expDist2[i], dist2);
+			_mm_storeu_ps(&mod1[i], m1);
+			_mm_storeu_ps(&mod2[i], m2);
+			_mm_storeu_ps(&dirX[i], _mm_mul_ps(dx, inv));
+			_mm_storeu_ps(&dirY[i], _mm_add_ps(_mm_mul_ps(dy, inv), dirBias));
+			_mm_storeu_ps(&dirZ[i], _mm_mul_ps(dz, inv));
+
+			inRange[i    ] = ((inRangeBits & 1) != 0);
+			inRange[i + 1] = ((inRangeBits & 2) != 0);
+			inRange[i + 2] = ((inRangeBits & 4) != 0);
+			inRange[i + 3] = ((inRangeBits & 8) != 0);
+		}
+	#endif
+
+		for (; i < numUnits; ++i) {
+			const float volRad = volRads[i];
+			const float3 diffPos = float3(posX[i], posY[i], posZ[i]) - expPos;
+			const float dist = std::max(diffPos.Length(), volRad + 0.1f);
+			const float dist1 = std::min(dist, expRad);
+			      float dist2 = dist - volRad;
+
+			inRange[i] = !(dist2 > expRad);
+
+			if (underWaterPenalty && underWaterMask[i] > 0.0f) {
+				dist2 += volRad;
+				dist2 = std::min(dist2, expRad);
+			}
+
+			const float inv = 1.0f / dist;
+
+			expDist2[i] = dist2;
+			mod1[i] = std::max(0.01f, (expRad - dist1) / (expRad - (dist1 * edgeEffectiveness)));
+			mod2[i] = std::max(0.01f, (expRad - dist2) / (expRad - (dist2 * edgeEffectiveness)));
+			dirX[i] = diffPos.x * inv;
+			dirY[i] = diffPos.y * inv + 0.12f;
+			dirZ[i] = diffPos.z * inv;
+		}
+	}
+
+	/// false if the unit is too far away to take any damage
+	bool InRange(unsigned int i) const { return inRange[i]; }
+
+	float GetExpDist2(unsigned int i) const { return expDist2[i]; }
+	float GetMod1(unsigned int i) const { return mod1[i]; }
+	float GetMod2(unsigned int i) const { return mod2[i]; }
+	/// normalized direction from the explosion to the unit, tilted upwards
+	float3 GetImpulseDir(unsigned int i) const { return float3(dirX[i], dirY[i], dirZ[i]); }
+
+private:
+	unsigned int numUnits;
+
+	// inputs
+	std::vector<float> posX, posY, posZ;
+	std::vector<float> volRads;
+	std::vector<float> underWaterMask;
+
+	// outputs
+	std::vector<float> expDist2;
+	std::vector<float> mod1, mod2;
+	std::vector<float> dirX, dirY, dirZ;
+	std::vector<bool> inRange;
+};
+
+#endif /* EXPLOSION_DAMAGE_BATCH_H */
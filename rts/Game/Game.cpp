@@ -82,6 +82,7 @@
 #include "Lua/LuaRules.h"
 #include "Lua/LuaOpenGL.h"
 #include "Lua/LuaParser.h"
+#include "Lua/LuaProfiler.h"
 #include "Lua/LuaSyncedRead.h"
 #include "Lua/LuaUnsyncedCtrl.h"
 #include "Map/BaseGroundDrawer.h"
@@ -144,6 +145,8 @@
 #include "System/Util.h"
 #include "System/Input/KeyInput.h"
 #include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/VFSHandler.h"
 #include "System/FileSystem/SimpleParser.h"
@@ -179,6 +182,10 @@ CONFIG(int, ShowPlayerInfo).defaultValue(1);
 CONFIG(float, GuiOpacity).defaultValue(0.8f);
 CONFIG(std::string, InputTextGeo).defaultValue("");
 CONFIG(bool, LuaModUICtrl).defaultValue(true);
+CONFIG(int, LuaProfileInterval)
+	.defaultValue(0)
+	.minimumValue(0)
+	.description("Runs the Lua profiler for the whole game with this sample interval (in microseconds) and writes luaprofile.txt at its end, eg. for profiling replays headlessly. 0 disables.");
 
 
 CGame* game = NULL;
@@ -352,6 +359,14 @@ CGame::~CGame()
 	IVideoCapturing::FreeInstance();
 	ISound::Shutdown();
 
+	if (configHandler->GetInt("LuaProfileInterval") > 0) {
+		const std::string fileName = dataDirsAccess.LocateFile("luaprofile.txt", FileQueryFlags::WRITE);
+
+		luaProfiler.Stop();
+		luaProfiler.WriteFlameGraph(fileName);
+		LOG("Lua profile written to %s", fileName.c_str());
+	}
+
 	CLuaGaia::FreeHandler();
 	CLuaRules::FreeHandler();
 	LuaOpenGL::Free();
@@ -438,6 +453,23 @@ void CGame::LoadGame(const std::string& mapName)
 
 	Watchdog::RegisterThread(WDT_LOAD);
 
+	{
+		// decompress what the loaders below read on worker threads, ahead
+		// of them (only the solid blocks of 7z archives are kept just for
+		// this, everything else is cached by the archives anyway)
+		std::vector<std::string> prefetchDirs;
+		prefetchDirs.push_back("gamedata/");
+		prefetchDirs.push_back("units/");
+		prefetchDirs.push_back("weapons/");
+		prefetchDirs.push_back("features/");
+		prefetchDirs.push_back("scripts/");
+		prefetchDirs.push_back("objects3d/");
+		prefetchDirs.push_back("unittextures/");
+		prefetchDirs.push_back("luarules/");
+		prefetchDirs.push_back("luagaia/");
+		vfsHandler->Prefetch(prefetchDirs);
+	}
+
 	if (!gu->globalQuit) LoadDefs();
 	if (!gu->globalQuit) LoadSimulation(mapName);
 	if (!gu->globalQuit) LoadRendering();
@@ -450,6 +482,8 @@ void CGame::LoadGame(const std::string& mapName)
 		saveFile->LoadGame();
 	}
 
+	vfsHandler->ClearPrefetched();
+
 	Watchdog::DeregisterThread(WDT_LOAD);
 }
 
@@ -676,6 +710,10 @@ void CGame::LoadInterface()
 
 void CGame::LoadLua()
 {
+	if (configHandler->GetInt("LuaProfileInterval") > 0) {
+		luaProfiler.Start(configHandler->GetInt("LuaProfileInterval"));
+	}
+
 	// Lua components
 	loadscreen->SetLoadMessage("Loading LuaRules");
 	CLuaRules::LoadHandler();
@@ -868,6 +906,10 @@ bool CGame::Update()
 		}
 	}
 
+	// join the async path searches started by the previous Draw before
+	// anything (net, sim, Lua) gets to modify the state they are reading
+	pathManager->FinishPathRequests();
+
 	if (!skipping)
 	{
 		UpdateUI(false);
@@ -1044,6 +1086,9 @@ bool CGame::Draw() {
 	eventHandler.Update();
 	eventHandler.DrawGenesis();
 
+	// let the async path searches run while this frame is rendered
+	pathManager->StartPathRequests();
+
 	if (!globalRendering->active) {
 		SDL_Delay(10); // milliseconds
 		return true;
@@ -1241,6 +1286,8 @@ bool CGame::Draw() {
 
 	CTeamHighlight::Disable();
 
+	CLuaHandle::CollectGarbageDraw();
+
 	return true;
 }
 
@@ -1441,6 +1488,8 @@ void CGame::SimFrame() {
 
 	lastUpdate = SDL_GetTicks();
 
+	CLuaHandle::CollectGarbageSim(lastUpdate - lastFrameTime, skipping);
+
 	DumpState(-1, -1, 1);
 }
 
@@ -1622,11 +1671,11 @@ void CGame::DumpState(int newMinFrameNum, int newMaxFrameNum, int newFramePeriod
 	if ((gs->frameNum % gFramePeriod) != 0) { return; }
 
 	// we only care about the synced projectile data here
-	const std::list<CUnit*>& units = uh->activeUnits;
+	const std::vector<CUnit*>& units = uh->activeUnits;
 	const CFeatureSet& features = featureHandler->GetActiveFeatures();
 	      ProjectileContainer& projectiles = ph->syncedProjectiles;
 
-	std::list<CUnit*>::const_iterator unitsIt;
+	std::vector<CUnit*>::const_iterator unitsIt;
 	CFeatureSet::const_iterator featuresIt;
 	ProjectileContainer::iterator projectilesIt;
 	std::vector<LocalModelPiece*>::const_iterator piecesIt;
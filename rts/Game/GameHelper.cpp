@@ -2,7 +2,11 @@
 
 #include "GameHelper.h"
 
+#include <algorithm>
+#include <deque>
+
 #include "Camera.h"
+#include "ExplosionDamageBatch.h"
 #include "GameSetup.h"
 #include "Game/GlobalUnsynced.h"
 #include "UI/LuaUI.h"
@@ -33,6 +37,7 @@
 #include "Sim/Units/UnitHandler.h"
 #include "Sim/Weapons/WeaponDefHandler.h"
 #include "Sim/Weapons/Weapon.h"
+#include "Sim/Weapons/WeaponTargetList.h"
 #include "System/EventHandler.h"
 #include "System/mmgr.h"
 #include "System/myMath.h"
@@ -45,7 +50,7 @@
 CGameHelper* helper;
 
 
-CGameHelper::CGameHelper()
+CGameHelper::CGameHelper(): explosionDepth(0)
 {
 	stdExplosionGenerator = new CStdExplosionGenerator();
 }
@@ -54,6 +59,10 @@ CGameHelper::~CGameHelper()
 {
 	delete stdExplosionGenerator;
 
+	for (unsigned int n = 0; n < explosionBatches.size(); n++) {
+		delete explosionBatches[n];
+	}
+
 	for (int a = 0; a < 128; ++a) {
 		std::list<WaitingDamage*>* wd = &waitingDamages[a];
 		while (!wd->empty()) {
@@ -70,7 +79,8 @@ CGameHelper::~CGameHelper()
 //////////////////////////////////////////////////////////////////////
 
 void CGameHelper::DoExplosionDamage(
-	CUnit* unit,
+	CUnit* const* units,
+	unsigned int numUnits,
 	CUnit* owner,
 	const float3& expPos,
 	float expRad,
@@ -78,39 +88,50 @@ void CGameHelper::DoExplosionDamage(
 	bool ignoreOwner, float edgeEffectiveness,
 	const DamageArray& damages, int weaponDefID)
 {
-	if (ignoreOwner && (unit == owner)) {
+	if (numUnits == 0) {
 		return;
 	}
 
+	if (explosionDepth == explosionBatches.size()) {
+		explosionBatches.push_back(new CExplosionDamageBatch());
+	}
+
+	CExplosionDamageBatch& batch = *explosionBatches[explosionDepth++];
+	batch.Clear();
+
+	// first gather the volumes of all units, then compute the distance
+	// falloff for all of them at once and finally apply the damage in
+	// the original order
+	//
 	// dist is equal to the maximum of "distance from center
 	// of unit to center of explosion" and "unit radius + 0.1",
 	// where "center of unit" is determined by the relative
 	// position of its collision volume and "unit radius" by
 	// the volume's minimally-bounding sphere
 	//
-	const int damageFrame = unit->lastAttackedPieceFrame;
-	const LocalModelPiece* piece = unit->lastAttackedPiece;
-	const CollisionVolume* volume = NULL;
-
-	float3 basePos;
-	float3 diffPos;
-
-	if (piece != NULL && unit->unitDef->usePieceCollisionVolumes && damageFrame == gs->frameNum) {
-		volume = piece->GetCollisionVolume();
-		basePos = piece->GetAbsolutePos() + volume->GetOffsets();
-		basePos = unit->pos + 
-			unit->rightdir * basePos.x +
-			unit->updir    * basePos.y +
-			unit->frontdir * basePos.z;
-	} else {
-		volume = unit->collisionVolume;
-		basePos = unit->midPos + volume->GetOffsets();
-	}
-
-	diffPos = basePos - expPos;
+	for (unsigned int n = 0; n < numUnits; n++) {
+		const CUnit* unit = units[n];
+
+		const int damageFrame = unit->lastAttackedPieceFrame;
+		const LocalModelPiece* piece = unit->lastAttackedPiece;
+		const CollisionVolume* volume = NULL;
+
+		float3 basePos;
+
+		if (piece != NULL && unit->unitDef->usePieceCollisionVolumes && damageFrame == gs->frameNum) {
+			volume = piece->GetCollisionVolume();
+			basePos = piece->GetAbsolutePos() + volume->GetOffsets();
+			basePos = unit->pos + 
+				unit->rightdir * basePos.x +
+				unit->updir    * basePos.y +
+				unit->frontdir * basePos.z;
+		} else {
+			volume = unit->collisionVolume;
+			basePos = unit->midPos + volume->GetOffsets();
+		}
 
-	const float volRad = volume->GetBoundingRadius();
-	const float expDist = std::max(diffPos.Length(), volRad + 0.1f);
+		batch.Add(basePos, volume->GetBoundingRadius(), unit->isUnderWater);
+	}
 
 	// expDist2 is the distance from the boundary of the
 	// _volume's_ minimally-bounding sphere (!) to the
@@ -128,46 +149,44 @@ void CGameHelper::DoExplosionDamage(
 	// (because CQuadField is again based exclusively on
 	// unit->radius, so the iteration will include units
 	// that should not be touched)
-	// Clamp expDist to radius to prevent division by zero
-	// (expDist2 can never be > radius). We still need the
-	// original expDist later to normalize diffPos.
+	//
 	// expDist2 _can_ exceed radius when explosion is eg.
 	// on shield surface: in that case don't do any damage
-	float expDist2 = expDist - volRad;
-	float expDist1 = std::min(expDist, expRad);
+	batch.Compute(expPos, expRad, edgeEffectiveness);
 
-	if (expDist2 > expRad) {
-		return;
-	}
+	for (unsigned int n = 0; n < numUnits; n++) {
+		CUnit* unit = units[n];
 
-	if (unit->isUnderWater && (expPos.y > -1.0f)) {
-		// should make it harder to damage subs with above-water weapons
-		expDist2 += volRad;
-		expDist2 = std::min(expDist2, expRad);
-	}
+		if (ignoreOwner && (unit == owner)) {
+			continue;
+		}
+		if (!batch.InRange(n)) {
+			continue;
+		}
 
-	const float mod1 = std::max(0.01f, (expRad - expDist1) / (expRad - (expDist1 * edgeEffectiveness)));
-	const float mod2 = std::max(0.01f, (expRad - expDist2) / (expRad - (expDist2 * edgeEffectiveness)));
-
-	diffPos /= expDist;
-	diffPos.y += 0.12f;
-
-	// limit the impulse to prevent later FP overflow
-	// (several weapons have _default_ damage values in the order of 1e4,
-	// which make the simulation highly unstable because they can impart
-	// speeds of several thousand elmos/frame to units and throw them far
-	// outside the map)
-	const DamageArray damageDone = damages * mod2;
-	const float rawImpulseStrength = damages.impulseFactor * mod1 * (damages.GetDefaultDamage() + damages.impulseBoost) * 3.2f;
-	const float modImpulseStrength = Clamp(rawImpulseStrength, -MAX_EXPLOSION_IMPULSE, MAX_EXPLOSION_IMPULSE);
-	const float3 addedImpulse = diffPos * modImpulseStrength;
-
-	if (expDist2 < (expSpeed * 4.0f)) { // damage directly
-		unit->DoDamage(damageDone, owner, addedImpulse, weaponDefID);
-	} else { // damage later
-		WaitingDamage* wd = new WaitingDamage((owner? owner->id: -1), unit->id, damageDone, addedImpulse, weaponDefID);
-		waitingDamages[(gs->frameNum + int(expDist2 / expSpeed) - 3) & 127].push_front(wd);
+		const float expDist2 = batch.GetExpDist2(n);
+		const float mod1 = batch.GetMod1(n);
+		const float mod2 = batch.GetMod2(n);
+
+		// limit the impulse to prevent later FP overflow
+		// (several weapons have _default_ damage values in the order of 1e4,
+		// which make the simulation highly unstable because they can impart
+		// speeds of several thousand elmos/frame to units and throw them far
+		// outside the map)
+		const DamageArray damageDone = damages * mod2;
+		const float rawImpulseStrength = damages.impulseFactor * mod1 * (damages.GetDefaultDamage() + damages.impulseBoost) * 3.2f;
+		const float modImpulseStrength = Clamp(rawImpulseStrength, -MAX_EXPLOSION_IMPULSE, MAX_EXPLOSION_IMPULSE);
+		const float3 addedImpulse = batch.GetImpulseDir(n) * modImpulseStrength;
+
+		if (expDist2 < (expSpeed * 4.0f)) { // damage directly
+			unit->DoDamage(damageDone, owner, addedImpulse, weaponDefID);
+		} else { // damage later
+			WaitingDamage* wd = new WaitingDamage((owner? owner->id: -1), unit->id, damageDone, addedImpulse, weaponDefID);
+			waitingDamages[(gs->frameNum + int(expDist2 / expSpeed) - 3) & 127].push_front(wd);
+		}
 	}
+
+	explosionDepth--;
 }
 
 void CGameHelper::DoExplosionDamage(CFeature* feature,
@@ -199,6 +218,32 @@ void CGameHelper::DoExplosionDamage(CFeature* feature,
 
 
 
+namespace {
+	// explosions can set off others (eg. of the units they kill), so
+	// every nesting level of CGameHelper::Explosion has its own buffers
+	struct ExplosionBuffers {
+		vector<CUnit*> units;
+		vector<CFeature*> features;
+	};
+
+	// deque: growing it keeps the buffers of the outer levels in place
+	std::deque<ExplosionBuffers> explosionBuffers;
+	unsigned int explosionDepth = 0;
+
+	struct ExplosionBuffersScope {
+		ExplosionBuffersScope(): buffers(NULL) {
+			if (explosionDepth == explosionBuffers.size()) {
+				explosionBuffers.push_back(ExplosionBuffers());
+			}
+
+			buffers = &explosionBuffers[explosionDepth++];
+		}
+		~ExplosionBuffersScope() { explosionDepth--; }
+
+		ExplosionBuffers* buffers;
+	};
+}
+
 void CGameHelper::Explosion(const ExplosionParams& params) {
 	const float3& pos = params.pos;
 	const float3& dir = params.dir;
@@ -233,37 +278,37 @@ void CGameHelper::Explosion(const ExplosionParams& params) {
 
 	if (impactOnly) {
 		if (hitUnit) {
-			DoExplosionDamage(hitUnit, owner, expPos, expRad, expSpeed, ignoreOwner, edgeEffectiveness, damages, weaponDefID);
+			DoExplosionDamage(&hitUnit, 1, owner, expPos, expRad, expSpeed, ignoreOwner, edgeEffectiveness, damages, weaponDefID);
 		} else if (hitFeature) {
 			DoExplosionDamage(hitFeature, expPos, expRad, damages);
 		}
 	} else {
+		ExplosionBuffersScope buffersScope;
+
 		{
 			// damage all units within the explosion radius
-			const vector<CUnit*>& units = qf->GetUnitsExact(expPos, expRad);
-			bool hitUnitDamaged = false;
-
-			for (vector<CUnit*>::const_iterator ui = units.begin(); ui != units.end(); ++ui) {
-				CUnit* unit = *ui;
+			vector<CUnit*>& units = buffersScope.buffers->units;
+			qf->GetUnitsExact(expPos, expRad, true, units);
 
-				if (unit == hitUnit) {
-					hitUnitDamaged = true;
-				}
+			const bool hitUnitDamaged = (std::find(units.begin(), units.end(), hitUnit) != units.end());
 
-				DoExplosionDamage(unit, owner, expPos, expRad, expSpeed, ignoreOwner, edgeEffectiveness, damages, weaponDefID);
+			if (!units.empty()) {
+				DoExplosionDamage(&units[0], units.size(), owner, expPos, expRad, expSpeed, ignoreOwner, edgeEffectiveness, damages, weaponDefID);
 			}
 
 			// HACK: for a unit with an offset coldet volume, the explosion
 			// (from an impacting projectile) position might not correspond
 			// to its quadfield position so we need to damage it separately
 			if (hitUnit != NULL && !hitUnitDamaged) {
-				DoExplosionDamage(hitUnit, owner, expPos, expRad, expSpeed, ignoreOwner, edgeEffectiveness, damages, weaponDefID);
+				DoExplosionDamage(&hitUnit, 1, owner, expPos, expRad, expSpeed, ignoreOwner, edgeEffectiveness, damages, weaponDefID);
 			}
 		}
 
 		{
 			// damage all features within the explosion radius
-			const vector<CFeature*>& features = qf->GetFeaturesExact(expPos, expRad);
+			vector<CFeature*>& features = buffersScope.buffers->features;
+			qf->GetFeaturesExact(expPos, expRad, features);
+
 			bool hitFeatureDamaged = false;
 
 			for (vector<CFeature*>::const_iterator fi = features.begin(); fi != features.end(); ++fi) {
@@ -336,7 +381,9 @@ static inline void QueryUnits(TFilter filter, TQuery& query)
 {
 	GML_RECMUTEX_LOCK(qnum);
 
-	const vector<int> &quads = qf->GetQuads(query.pos, query.radius);
+	// protected by qnum
+	static vector<int> quads;
+	qf->GetQuads(query.pos, query.radius, quads);
 
 	const int tempNum = gs->tempNum++;
 	
@@ -346,8 +393,8 @@ static inline void QueryUnits(TFilter filter, TQuery& query)
 			if (!filter.Team(t)) {
 				continue;
 			}
-			std::list<CUnit*>::const_iterator ui;
-			const std::list<CUnit*>& allyTeamUnits = quad.teamUnits[t];
+			CQuadField::UnitList::const_iterator ui;
+			const CQuadField::UnitList& allyTeamUnits = quad.teamUnits[t];
 			for (ui = allyTeamUnits.begin(); ui != allyTeamUnits.end(); ++ui) {
 				if ((*ui)->tempNum != tempNum) {
 					(*ui)->tempNum = tempNum;
@@ -606,10 +653,72 @@ public:
 
 
 
-void CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* lastTargetUnit, std::multimap<float, CUnit*>& targets)
+/**
+ * Lets LuaRules decide about all enemy units in the weapon's quads with a
+ * single AllowWeaponTargets call (in the same order the per-unit call-in
+ * would see them, but every unit only once).
+ * @return false if the call-in is not defined or failed
+ */
+static bool GenerateLuaWeaponTargets(const CWeapon* weapon, const std::vector<int>& quads, CWeaponTargetList& targets)
+{
+	if (!luaRules->HaveAllowWeaponTargets())
+		return false;
+
+	const CUnit* attacker = weapon->owner;
+
+	// protected by qnum
+	static std::vector<CUnit*> candidates;
+	static std::vector<int> candidateIDs;
+	static std::vector<bool> candidatesAllowed;
+	static std::vector<float> candidatePriorities;
+
+	candidates.clear();
+	candidateIDs.clear();
+
+	const int tempNum = gs->tempNum++;
+
+	for (std::vector<int>::const_iterator qi = quads.begin(); qi != quads.end(); ++qi) {
+		for (int t = 0; t < teamHandler->ActiveAllyTeams(); ++t) {
+			if (teamHandler->Ally(attacker->allyteam, t)) {
+				continue;
+			}
+
+			const CQuadField::UnitList& allyTeamUnits = qf->GetQuad(*qi).teamUnits[t];
+
+			for (CQuadField::UnitList::const_iterator ui = allyTeamUnits.begin(); ui != allyTeamUnits.end(); ++ui) {
+				CUnit* targetUnit = *ui;
+
+				if (targetUnit->tempNum == tempNum)
+					continue;
+
+				targetUnit->tempNum = tempNum;
+				candidates.push_back(targetUnit);
+				candidateIDs.push_back(targetUnit->id);
+			}
+		}
+	}
+
+	if (candidates.empty())
+		return true;
+
+	if (luaRules->AllowWeaponTargets(attacker->id, weapon->weaponNum, weapon->weaponDef->id, candidateIDs, candidatesAllowed, candidatePriorities) < 0)
+		return false;
+
+	for (unsigned int n = 0; n < candidates.size(); ++n) {
+		if (candidatesAllowed[n]) {
+			targets.Add(candidatePriorities[n], candidates[n]);
+		}
+	}
+
+	return true;
+}
+
+void CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* lastTargetUnit, CWeaponTargetList& targets)
 {
 	GML_RECMUTEX_LOCK(qnum); // GenerateTargets
 
+	targets.Clear();
+
 	const CUnit* attacker = weapon->owner;
 	const float radius    = weapon->range;
 	const float3& pos     = attacker->pos;
@@ -620,20 +729,24 @@ void CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* last
 	const float secDamage = weapon->weaponDef->damages.GetDefaultDamage() * weapon->salvoSize / weapon->reloadTime * GAME_SPEED;
 	const bool paralyzer  = !!weapon->weaponDef->damages.paralyzeDamageTime;
 
-	const std::vector<int>& quads = qf->GetQuads(pos, radius + (aHeight - std::max(0.f, readmap->initMinHeight)) * heightMod);
+	// protected by qnum
+	static std::vector<int> quads;
+	qf->GetQuads(pos, radius + (aHeight - std::max(0.f, readmap->initMinHeight)) * heightMod, quads);
 
+	// if LuaRules handles all candidates in one go, skip the per-unit loop
+	const bool luaTargets = (luaRules != NULL && GenerateLuaWeaponTargets(weapon, quads, targets));
 	const int tempNum = gs->tempNum++;
 
 	typedef std::vector<int>::const_iterator VectorIt;
-	typedef std::list<CUnit*>::const_iterator ListIt;
+	typedef CQuadField::UnitList::const_iterator ListIt;
 	
-	for (VectorIt qi = quads.begin(); qi != quads.end(); ++qi) {
+	for (VectorIt qi = quads.begin(); qi != quads.end() && !luaTargets; ++qi) {
 		for (int t = 0; t < teamHandler->ActiveAllyTeams(); ++t) {
 			if (teamHandler->Ally(attacker->allyteam, t)) {
 				continue;
 			}
 
-			const std::list<CUnit*>& allyTeamUnits = qf->GetQuad(*qi).teamUnits[t];
+			const CQuadField::UnitList& allyTeamUnits = qf->GetQuad(*qi).teamUnits[t];
 
 			for (ListIt ui = allyTeamUnits.begin(); ui != allyTeamUnits.end(); ++ui) {
 				CUnit* targetUnit = *ui;
@@ -644,7 +757,7 @@ void CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* last
 
 					if (targetAllowed >= 0) {
 						if (targetAllowed > 0) {
-							targets.insert(std::pair<float, CUnit*>(targetPriority, targetUnit));
+							targets.Add(targetPriority, targetUnit);
 						}
 
 						continue;
@@ -712,7 +825,7 @@ void CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* last
 							}
 						}
 
-						targets.insert(std::pair<float, CUnit*>(targetPriority, targetUnit));
+						targets.Add(targetPriority, targetUnit);
 					}
 				}
 			}
@@ -723,8 +836,8 @@ void CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* last
 	{
 		tracefile << "[GenerateWeaponTargets] attackerID, attackRadius: " << attacker->id << ", " << radius << " ";
 
-		for (std::multimap<float, CUnit*>::const_iterator ti = targets.begin(); ti != targets.end(); ++ti)
-			tracefile << "\tpriority: " << (ti->first) <<  ", targetID: " << (ti->second)->id <<  " ";
+		for (unsigned int n = 0; n < targets.Size(); ++n)
+			tracefile << "\tpriority: " << targets.Get(n).priority <<  ", targetID: " << targets.Get(n).unit->id <<  " ";
 
 		tracefile << "\n";
 	}
@@ -819,7 +932,9 @@ float3 CGameHelper::GetUnitErrorPos(const CUnit* unit, int allyteam)
 
 void CGameHelper::BuggerOff(float3 pos, float radius, bool spherical, bool forced, int teamId, CUnit* excludeUnit)
 {
-	const std::vector<CUnit*> &units = qf->GetUnitsExact(pos, radius + SQUARE_SIZE, spherical);
+	static std::vector<CUnit*> units;
+	qf->GetUnitsExact(pos, radius + SQUARE_SIZE, spherical, units);
+
 	const int allyTeamId = teamHandler->AllyTeam(teamId);
 
 	for (std::vector<CUnit*>::const_iterator ui = units.begin(); ui != units.end(); ++ui) {
@@ -15,6 +15,7 @@
 class CGame;
 class CUnit;
 class CWeapon;
+class CWeaponTargetList;
 class CSolidObject;
 class CFeature;
 class CMobileCAI;
@@ -22,6 +23,7 @@ struct UnitDef;
 struct BuildInfo;
 class IExplosionGenerator;
 class CStdExplosionGenerator;
+class CExplosionDamageBatch;
 
 class CGameHelper : public CExplosionCreator
 {
@@ -74,9 +76,9 @@ public:
 	float3 ClosestBuildSite(int team, const UnitDef* unitDef, float3 pos, float searchRadius, int minDist, int facing = 0);
 
 	void Update();
-	void GenerateWeaponTargets(const CWeapon* weapon, const CUnit* lastTargetUnit, std::multimap<float, CUnit*>& targets);
+	void GenerateWeaponTargets(const CWeapon* weapon, const CUnit* lastTargetUnit, CWeaponTargetList& targets);
 
-	void DoExplosionDamage(CUnit* unit, CUnit* owner, const float3& expPos, float expRad, float expSpeed, bool ignoreOwner, float edgeEffectiveness, const DamageArray& damages, int weaponDefID);
+	void DoExplosionDamage(CUnit* const* units, unsigned int numUnits, CUnit* owner, const float3& expPos, float expRad, float expSpeed, bool ignoreOwner, float edgeEffectiveness, const DamageArray& damages, int weaponDefID);
 	void DoExplosionDamage(CFeature* feature, const float3& expPos, float expRad, const DamageArray& damages);
 
 	void Explosion(const ExplosionParams& params);
@@ -84,6 +86,10 @@ public:
 private:
 	CStdExplosionGenerator* stdExplosionGenerator;
 
+	/// one per nesting level of DoExplosionDamage (units killed by an explosion can explode right away)
+	std::vector<CExplosionDamageBatch*> explosionBatches;
+	unsigned int explosionDepth;
+
 	struct WaitingDamage{
 #if !defined(SYNCIFY) && !defined(USE_MMGR)
 		inline void* operator new(size_t size) {
@@ -954,7 +954,7 @@ void CGame::ClientReadNet()
 
 					// stop attacks against former foe
 					if (allied) {
-						for (std::list<CUnit*>::iterator it = uh->activeUnits.begin();
+						for (std::vector<CUnit*>::iterator it = uh->activeUnits.begin();
 								it != uh->activeUnits.end();
 								++it) {
 							if (teamHandler->Ally((*it)->allyteam, whichAllyTeam)) {
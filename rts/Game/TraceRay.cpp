@@ -127,14 +127,16 @@ float TraceRay(const float3& start, const float3& dir, float length, int collisi
 		GML_RECMUTEX_LOCK(quad); // TraceRay
 		CollisionQuery cq;
 
-		const vector<int>& quads = qf->GetQuadsOnRay(start, dir, length);
+		int quads[1000];
+		int* endQuad = quads;
+		qf->GetQuadsOnRay(start, dir, length, endQuad);
 
 		//! feature intersection
 		if (!ignoreFeatures) {
-			for (vector<int>::const_iterator qi = quads.begin(); qi != quads.end(); ++qi) {
+			for (int* qi = quads; qi != endQuad; ++qi) {
 				const CQuadField::Quad& quad = qf->GetQuad(*qi);
 
-				for (std::list<CFeature*>::const_iterator ui = quad.features.begin(); ui != quad.features.end(); ++ui) {
+				for (CQuadField::FeatureList::const_iterator ui = quad.features.begin(); ui != quad.features.end(); ++ui) {
 					CFeature* f = *ui;
 
 					if (!f->blocking || !f->collisionVolume) {
@@ -158,10 +160,10 @@ float TraceRay(const float3& start, const float3& dir, float length, int collisi
 
 		//! unit intersection
 		if (!ignoreUnits) {
-			for (vector<int>::const_iterator qi = quads.begin(); qi != quads.end(); ++qi) {
+			for (int* qi = quads; qi != endQuad; ++qi) {
 				const CQuadField::Quad& quad = qf->GetQuad(*qi);
 
-				for (std::list<CUnit*>::const_iterator ui = quad.units.begin(); ui != quad.units.end(); ++ui) {
+				for (CQuadField::UnitList::const_iterator ui = quad.units.begin(); ui != quad.units.end(); ++ui) {
 					CUnit* u = *ui;
 
 					if (u == owner)
@@ -219,11 +221,13 @@ float GuiTraceRay(const float3 &start, const float3 &dir, float length, bool use
 	{
 		GML_RECMUTEX_LOCK(quad); //! GuiTraceRay
 
-		const vector<int> &quads = qf->GetQuadsOnRay(start, dir, length);
-		std::list<CUnit*>::const_iterator ui;
-		std::list<CFeature*>::const_iterator fi;
+		int quads[1000];
+		int* endQuad = quads;
+		qf->GetQuadsOnRay(start, dir, length, endQuad);
+		CQuadField::UnitList::const_iterator ui;
+		CQuadField::FeatureList::const_iterator fi;
 
-		for (vector<int>::const_iterator qi = quads.begin(); qi != quads.end(); ++qi) {
+		for (int* qi = quads; qi != endQuad; ++qi) {
 			const CQuadField::Quad& quad = qf->GetQuad(*qi);
 
 			//! Unit Intersection
@@ -330,14 +334,16 @@ bool LineFeatureCol(const float3& start, const float3& dir, float length)
 {
 	GML_RECMUTEX_LOCK(quad); // GuiTraceRayFeature
 
-	const std::vector<int> &quads = qf->GetQuadsOnRay(start, dir, length);
+	int quads[1000];
+	int* endQuad = quads;
+	qf->GetQuadsOnRay(start, dir, length, endQuad);
 
 	CollisionQuery cq;
 
-	for (std::vector<int>::const_iterator qi = quads.begin(); qi != quads.end(); ++qi) {
+	for (int* qi = quads; qi != endQuad; ++qi) {
 		const CQuadField::Quad& quad = qf->GetQuad(*qi);
 
-		for (std::list<CFeature*>::const_iterator ui = quad.features.begin(); ui != quad.features.end(); ++ui) {
+		for (CQuadField::FeatureList::const_iterator ui = quad.features.begin(); ui != quad.features.end(); ++ui) {
 			CFeature* f = *ui;
 			CollisionVolume* cv = f->collisionVolume;
 
@@ -363,7 +369,7 @@ bool TestAllyCone(const float3& from, const float3& weaponDir, float length, flo
 
 	for (int* qi = quads; qi != endQuad; ++qi) {
 		const CQuadField::Quad& quad = qf->GetQuad(*qi);
-		for (std::list<CUnit*>::const_iterator ui = quad.teamUnits[allyteam].begin(); ui != quad.teamUnits[allyteam].end(); ++ui) {
+		for (CQuadField::UnitList::const_iterator ui = quad.teamUnits[allyteam].begin(); ui != quad.teamUnits[allyteam].end(); ++ui) {
 			CUnit* u = *ui;
 
 			if (u == owner)
@@ -385,7 +391,7 @@ bool TestNeutralCone(const float3& from, const float3& weaponDir, float length,
 	for (int* qi = quads; qi != endQuad; ++qi) {
 		const CQuadField::Quad& quad = qf->GetQuad(*qi);
 
-		for (std::list<CUnit*>::const_iterator ui = quad.units.begin(); ui != quad.units.end(); ++ui) {
+		for (CQuadField::UnitList::const_iterator ui = quad.units.begin(); ui != quad.units.end(); ++ui) {
 			CUnit* u = *ui;
 
 			if (u == owner)
@@ -409,7 +415,7 @@ bool TestTrajectoryAllyCone(const float3& from, const float3& flatdir, float len
 
 	for (int* qi = quads; qi != endQuad; ++qi) {
 		const CQuadField::Quad& quad = qf->GetQuad(*qi);
-		for (std::list<CUnit*>::const_iterator ui = quad.teamUnits[allyteam].begin(); ui != quad.teamUnits[allyteam].end(); ++ui) {
+		for (CQuadField::UnitList::const_iterator ui = quad.teamUnits[allyteam].begin(); ui != quad.teamUnits[allyteam].end(); ++ui) {
 			CUnit* u = *ui;
 
 			if (u == owner)
@@ -430,7 +436,7 @@ bool TestTrajectoryNeutralCone(const float3& from, const float3& flatdir, float
 
 	for (int* qi = quads; qi != endQuad; ++qi) {
 		const CQuadField::Quad& quad = qf->GetQuad(*qi);
-		for (std::list<CUnit*>::const_iterator ui = quad.units.begin(); ui != quad.units.end(); ++ui) {
+		for (CQuadField::UnitList::const_iterator ui = quad.units.begin(); ui != quad.units.end(); ++ui) {
 			CUnit* u = *ui;
 
 			if (u == owner)
@@ -14,6 +14,7 @@
 #include "Lua/LuaDefs.h"
 #include "Lua/LuaCallInCheck.h"
 #include "Lua/LuaConstGame.h"
+#include "Lua/LuaProfiler.h"
 #include "Lua/LuaUnitDefs.h"
 #include "Lua/LuaWeaponDefs.h"
 #include "Map/ReadMap.h"
@@ -114,7 +115,9 @@ bool CKeyAutoBinder::LoadCode(lua_State *L, const string& code, const string& de
 		lua_pop(L, 1);
 		return false;
 	}
+	const std::string* prevCallIn = luaProfiler.BeginCallIn(L, &debug);
 	error = lua_pcall(L, 0, 0, 0);
+	luaProfiler.EndCallIn(L, prevCallIn);
 	if (error != 0) {
 		LOG_L(L_ERROR, "Running: %s", lua_tostring(L, -1));
 		lua_pop(L, 1);
@@ -358,7 +361,9 @@ bool CKeyAutoBinder::HasRequirements(lua_State* L, int unitDefID)
 {
 	lua_getglobal(L, ReqFuncName.c_str());
 	lua_pushnumber(L, unitDefID);
+	const std::string* prevCallIn = luaProfiler.BeginCallIn(L, &ReqFuncName);
 	const int error = lua_pcall(L, 1, 1, 0);
+	luaProfiler.EndCallIn(L, prevCallIn);
 	if (error != 0) {
 		LOG_L(L_ERROR, "Running %s(%i)\n  %s",
 				ReqFuncName.c_str(), unitDefID, lua_tostring(L, -1));
@@ -376,7 +381,9 @@ bool CKeyAutoBinder::IsBetter(lua_State* L, int thisDefID, int thatDefID)
 	lua_getglobal(L, SortFuncName.c_str());
 	lua_pushnumber(L, thisDefID);
 	lua_pushnumber(L, thatDefID);
+	const std::string* prevCallIn = luaProfiler.BeginCallIn(L, &SortFuncName);
 	const int error = lua_pcall(L, 2, 1, 0);
+	luaProfiler.EndCallIn(L, prevCallIn);
 	if (error != 0) {
 		LOG_L(L_ERROR, "Running %s(%i, %i)\n  %s",
 				SortFuncName.c_str(), thisDefID, thatDefID, lua_tostring(L, -1));
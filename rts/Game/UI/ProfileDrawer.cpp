@@ -9,6 +9,7 @@
 #include "Rendering/glFont.h"
 #include "Rendering/GL/VertexArray.h"
 #include "Sim/Misc/GlobalConstants.h" // for GAME_SPEED
+#include "Sim/Path/IPathManager.h"
 
 ProfileDrawer* ProfileDrawer::instance = NULL;
 
@@ -83,6 +84,19 @@ void ProfileDrawer::Draw()
 		fStartX += 0.01f;
 		font->glFormat(fStartX, fStartY, 0.7f, FONT_BASELINE | FONT_SCALE | FONT_NORM, "%s", pi->first.c_str());
 	}
+
+	// print the path-cache statistics below the timers
+	if (pathManager != NULL) {
+		unsigned int numHits, numMisses, numItems, memFootPrint;
+		pathManager->GetPathCacheStats(numHits, numMisses, numItems, memFootPrint);
+
+		const unsigned int numLookups = numHits + numMisses;
+		const float hitRate = (numLookups != 0)? (float(numHits) / numLookups * 100.0f): 0.0f;
+		const float fStartY = end_y - profiler.profile.size() * 0.024f - 0.01f - 0.024f;
+
+		font->glFormat(start_x + 0.005f, fStartY, 0.7f, FONT_BASELINE | FONT_SCALE | FONT_NORM,
+			"PathCache: %.2f%% hits (%u/%u), %u paths, %.1fKB", hitRate, numHits, numLookups, numItems, memFootPrint / 1024.0f);
+	}
 	font->End();
 
 	// draw the Timer selection boxes
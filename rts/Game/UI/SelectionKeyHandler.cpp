@@ -269,8 +269,8 @@ void CSelectionKeyHandler::DoSelection(std::string selectString)
 			}
 		} else {
 			// all units
-			std::list<CUnit*>* au=&uh->activeUnits;
-			for (std::list<CUnit*>::iterator ui=au->begin();ui!=au->end();++ui){
+			std::vector<CUnit*>* au=&uh->activeUnits;
+			for (std::vector<CUnit*>::iterator ui=au->begin();ui!=au->end();++ui){
 				selection.push_back(*ui);
 			}
 		}
@@ -285,8 +285,8 @@ void CSelectionKeyHandler::DoSelection(std::string selectString)
 			}
 		} else {
 		  // all units in viewport
-			std::list<CUnit*>* au=&uh->activeUnits;
-			for (std::list<CUnit*>::iterator ui=au->begin();ui!=au->end();++ui){
+			std::vector<CUnit*>* au=&uh->activeUnits;
+			for (std::vector<CUnit*>::iterator ui=au->begin();ui!=au->end();++ui){
 				if (camera->InView((*ui)->midPos,(*ui)->radius)){
 					selection.push_back(*ui);
 				}
@@ -321,8 +321,8 @@ void CSelectionKeyHandler::DoSelection(std::string selectString)
 			}
 		} else {
 		  // all units in mouse range
-			std::list<CUnit*>* au=&uh->activeUnits;
-			for(std::list<CUnit*>::iterator ui=au->begin();ui!=au->end();++ui){
+			std::vector<CUnit*>* au=&uh->activeUnits;
+			for(std::vector<CUnit*>::iterator ui=au->begin();ui!=au->end();++ui){
 				float3 up = (*ui)->pos;
 				if (cylindrical) {
 					up.y = 0;
@@ -43,7 +43,10 @@
 #include "Rendering/TeamHighlight.h"
 #include "Rendering/UnitDrawer.h"
 #include "Rendering/VerticalSync.h"
+#include "Lua/LuaCallInStats.h"
+#include "Lua/LuaHandle.h"
 #include "Lua/LuaOpenGL.h"
+#include "Lua/LuaProfiler.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/Units/Scripts/UnitScript.h"
 #include "Sim/Units/Groups/GroupHandler.h"
@@ -69,6 +72,8 @@
 #include "System/GlobalConfig.h"
 #include "System/NetProtocol.h"
 #include "System/Input/KeyInput.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/SimpleParser.h"
 #include "System/Sound/ISound.h"
 #include "System/Sound/SoundChannels.h"
@@ -2814,15 +2819,54 @@ class DebugInfoActionExecutor : public IUnsyncedActionExecutor {
 public:
 	DebugInfoActionExecutor() : IUnsyncedActionExecutor("DebugInfo",
 			"Print debug info to the chat/log-file about either:"
-			" sound, profiling") {}
+			" sound, profiling, luacallins [csv|reset], luagc,"
+			" luaprofile [start [interval_us]|stop|write]") {}
 
 	void Execute(const UnsyncedAction& action) const {
+		const std::vector<std::string>& args = _local_strSpaceTokenize(action.GetArgs());
+
 		if (action.GetArgs() == "sound") {
 			sound->PrintDebugInfo();
 		} else if (action.GetArgs() == "profiling") {
 			profiler.PrintProfilingInfo();
+		} else if (!args.empty() && args[0] == "luacallins") {
+			if (args.size() < 2) {
+				luaCallInStats.PrintStats(30);
+			} else if (args[1] == "csv") {
+				const std::string fileName = dataDirsAccess.LocateFile("luacallins.csv", FileQueryFlags::WRITE);
+
+				if (luaCallInStats.WriteCSV(fileName)) {
+					LOG("Lua call-in stats written to %s", fileName.c_str());
+				} else {
+					LOG_L(L_WARNING, "Could not write Lua call-in stats to %s", fileName.c_str());
+				}
+			} else if (args[1] == "reset") {
+				luaCallInStats.Reset();
+			}
+		} else if (action.GetArgs() == "luagc") {
+			CLuaHandle::PrintGCStats();
+		} else if (!args.empty() && args[0] == "luaprofile") {
+			if (args.size() < 2) {
+				luaProfiler.PrintStats(30);
+			} else if (args[1] == "start") {
+				const int interval = std::max(1, (args.size() > 2)? atoi(args[2].c_str()): 1000);
+
+				luaProfiler.Start(interval);
+				LOG("Lua profiler started, sampling every %ius", interval);
+			} else if (args[1] == "stop") {
+				luaProfiler.Stop();
+				luaProfiler.PrintStats(30);
+			} else if (args[1] == "write") {
+				const std::string fileName = dataDirsAccess.LocateFile("luaprofile.txt", FileQueryFlags::WRITE);
+
+				if (luaProfiler.WriteFlameGraph(fileName)) {
+					LOG("Lua profile written to %s", fileName.c_str());
+				} else {
+					LOG_L(L_WARNING, "Could not write Lua profile to %s", fileName.c_str());
+				}
+			}
 		} else {
-			LOG_L(L_WARNING, "Give either of these as argument: sound, profiling");
+			LOG_L(L_WARNING, "Give either of these as argument: sound, profiling, luacallins [csv|reset], luagc, luaprofile [start [interval_us]|stop|write]");
 		}
 	}
 };
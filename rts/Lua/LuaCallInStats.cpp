@@ -0,0 +1,232 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "LuaCallInStats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#ifdef WIN32
+	#include <windows.h>
+#elif defined(__APPLE__)
+	#include <mach/mach_time.h>
+#else
+	#include <time.h>
+#endif
+
+#include "LuaHandle.h"
+#include "LuaHashString.h"
+#include "System/Log/ILog.h"
+#include "System/mmgr.h"
+
+
+CLuaCallInStats luaCallInStats;
+
+const float CLuaCallInStats::BUCKET_LIMITS[NUM_BUCKETS - 1] = {
+	10.0f, 30.0f, 100.0f, 300.0f, 1000.0f, 3000.0f, 10000.0f
+};
+
+
+CLuaCallInStats::CLuaCallInStats(): resetTime(GetTime())
+{
+}
+
+
+double CLuaCallInStats::GetTime()
+{
+#ifdef WIN32
+	static LARGE_INTEGER frequency = {{0, 0}};
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+
+	QueryPerformanceCounter(&counter);
+	return ((double(counter.QuadPart) * 1000000.0) / double(frequency.QuadPart));
+#elif defined(__APPLE__)
+	static mach_timebase_info_data_t timebase = {0, 0};
+
+	if (timebase.denom == 0) {
+		mach_timebase_info(&timebase);
+	}
+
+	return ((double(mach_absolute_time()) * timebase.numer) / (timebase.denom * 1000.0));
+#else
+	// not gettimeofday, that jumps with the wall clock
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double(ts.tv_sec) * 1000000.0) + (double(ts.tv_nsec) / 1000.0));
+#endif
+}
+
+
+void CLuaCallInStats::Entry::Add(const Entry& e)
+{
+	calls += e.calls;
+	totalTime += e.totalTime;
+	maxTime = std::max(maxTime, e.maxTime);
+
+	for (int n = 0; n < NUM_BUCKETS; n++) {
+		histogram[n] += e.histogram[n];
+	}
+}
+
+
+void CLuaCallInStats::StateStats::AddCall(const LuaHashString& callIn, float time)
+{
+	int bucket = 0;
+
+	while (bucket < (NUM_BUCKETS - 1) && time >= BUCKET_LIMITS[bucket]) {
+		bucket++;
+	}
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	NamedEntry& ne = entries[callIn.GetHash()];
+
+	if (ne.entry.calls == 0) {
+		ne.name = callIn.GetString();
+	}
+
+	Entry& e = ne.entry;
+	e.calls += 1;
+	e.totalTime += time;
+	e.maxTime = std::max(e.maxTime, time);
+	e.histogram[bucket] += 1;
+}
+
+
+void CLuaCallInStats::StateStats::Reset()
+{
+	boost::mutex::scoped_lock lock(mutex);
+	entries.clear();
+}
+
+
+void CLuaCallInStats::StateStats::GetStats(CallInMap& copy) const
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	std::map<unsigned int, NamedEntry>::const_iterator it;
+	for (it = entries.begin(); it != entries.end(); ++it) {
+		copy[it->second.name].Add(it->second.entry);
+	}
+}
+
+
+void CLuaCallInStats::Reset()
+{
+	std::vector<CLuaHandle*> handles;
+	CLuaHandle::GetGCHandles(handles);
+
+	for (size_t n = 0; n < handles.size(); n++) {
+		for (int draw = 0; draw <= int(handles[n]->HasDrawState()); draw++) {
+			handles[n]->GetCallInStats(draw).Reset();
+		}
+	}
+
+	resetTime = GetTime();
+}
+
+
+void CLuaCallInStats::GetStats(HandleMap& copy, double& elapsedTime) const
+{
+	std::vector<CLuaHandle*> handles;
+	CLuaHandle::GetGCHandles(handles);
+
+	// the sim and draw states of a handle are merged
+	for (size_t n = 0; n < handles.size(); n++) {
+		for (int draw = 0; draw <= int(handles[n]->HasDrawState()); draw++) {
+			handles[n]->GetCallInStats(draw).GetStats(copy[handles[n]->GetName()]);
+		}
+	}
+
+	elapsedTime = GetTime() - resetTime;
+}
+
+
+namespace {
+	struct SortedEntry {
+		SortedEntry(const std::string* h, const std::string* c, const CLuaCallInStats::Entry* e)
+			: handleName(h), callInName(c), entry(e) {}
+
+		bool operator < (const SortedEntry& s) const {
+			return (entry->totalTime > s.entry->totalTime);
+		}
+
+		const std::string* handleName;
+		const std::string* callInName;
+		const CLuaCallInStats::Entry* entry;
+	};
+}
+
+void CLuaCallInStats::PrintStats(unsigned int maxLines) const
+{
+	HandleMap copy;
+	double elapsedTime;
+	GetStats(copy, elapsedTime);
+
+	std::vector<SortedEntry> sorted;
+
+	for (HandleMap::const_iterator hi = copy.begin(); hi != copy.end(); ++hi) {
+		for (CallInMap::const_iterator ci = hi->second.begin(); ci != hi->second.end(); ++ci) {
+			sorted.push_back(SortedEntry(&hi->first, &ci->first, &ci->second));
+		}
+	}
+
+	std::sort(sorted.begin(), sorted.end());
+
+	LOG("Lua call-ins over the last %.1fs (inclusive times, sorted by total time):", elapsedTime / 1000000.0f);
+	LOG("%20s|%28s|%10s|%12s|%10s|%10s",
+			"Handle", "Call-in", "Calls", "Total [ms]", "Avg [us]", "Max [us]");
+
+	for (unsigned int n = 0; n < sorted.size() && n < maxLines; n++) {
+		const Entry& e = *sorted[n].entry;
+
+		LOG("%20s %28s %10u %12.2f %10.1f %10.1f",
+				sorted[n].handleName->c_str(),
+				sorted[n].callInName->c_str(),
+				e.calls,
+				e.totalTime / 1000.0,
+				e.totalTime / e.calls,
+				e.maxTime);
+	}
+}
+
+
+bool CLuaCallInStats::WriteCSV(const std::string& fileName) const
+{
+	std::ofstream file(fileName.c_str(), std::ios::out | std::ios::trunc);
+
+	if (!file.good()) {
+		return false;
+	}
+
+	HandleMap copy;
+	double elapsedTime;
+	GetStats(copy, elapsedTime);
+
+	file << "handle,callin,calls,total_us,max_us";
+	for (int n = 0; n < (NUM_BUCKETS - 1); n++) {
+		file << ",lt_" << int(BUCKET_LIMITS[n]) << "us";
+	}
+	file << ",ge_" << int(BUCKET_LIMITS[NUM_BUCKETS - 2]) << "us,elapsed_us\n";
+
+	file << std::fixed;
+	file.precision(1);
+
+	for (HandleMap::const_iterator hi = copy.begin(); hi != copy.end(); ++hi) {
+		for (CallInMap::const_iterator ci = hi->second.begin(); ci != hi->second.end(); ++ci) {
+			const Entry& e = ci->second;
+
+			file << '"' << hi->first << "\"," << ci->first << ',' << e.calls << ',' << e.totalTime << ',' << e.maxTime;
+			for (int n = 0; n < NUM_BUCKETS; n++) {
+				file << ',' << e.histogram[n];
+			}
+			file << ',' << elapsedTime << '\n';
+		}
+	}
+
+	return file.good();
+}
@@ -0,0 +1,99 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_CALLIN_STATS_H
+#define LUA_CALLIN_STATS_H
+
+#include <string>
+#include <map>
+#include <boost/thread/mutex.hpp>
+
+struct LuaHashString;
+
+
+/**
+ * Call count, total and maximum time and a time histogram for every
+ * call-in of every Lua handle, recorded by CLuaHandle::RunCallInTraceback
+ * (named call-ins and the functions of Lua unit scripts alike).
+ *
+ * Always enabled: every Lua state records into its own table (see
+ * StateStats), so a call-in costs two reads of a monotonic clock and one
+ * lookup by the precomputed hash of its name. Times are inclusive, a
+ * call-in that triggers another one (eg. through Spring.DestroyUnit) also
+ * contains the time of that one.
+ *
+ * Readable through Spring.GetLuaCallInStats, "/debuginfo luacallins"
+ * and "/debuginfo luacallins csv".
+ */
+class CLuaCallInStats
+{
+public:
+	/// upper bounds (in microseconds) of all but the last histogram bucket
+	static const int NUM_BUCKETS = 8;
+	static const float BUCKET_LIMITS[NUM_BUCKETS - 1];
+
+	struct Entry {
+		Entry(): calls(0), totalTime(0.0), maxTime(0.0f) {
+			for (int n = 0; n < NUM_BUCKETS; n++) {
+				histogram[n] = 0;
+			}
+		}
+
+		void Add(const Entry& e);
+
+		unsigned int calls;
+		double totalTime; ///< in microseconds
+		float maxTime;    ///< in microseconds
+		unsigned int histogram[NUM_BUCKETS];
+	};
+
+	typedef std::map<std::string, Entry> CallInMap;     ///< by call-in name
+	typedef std::map<std::string, CallInMap> HandleMap; ///< by handle name
+
+	/**
+	 * The call-ins of one Lua state, kept in its luaContextData.
+	 * Only written by the thread running the state, the lock is
+	 * for the readers (and uncontended otherwise).
+	 */
+	class StateStats {
+	public:
+		void AddCall(const LuaHashString& callIn, float time);
+		void Reset();
+		/// adds the entries to @c copy
+		void GetStats(CallInMap& copy) const;
+
+	private:
+		struct NamedEntry {
+			std::string name;
+			Entry entry;
+		};
+
+		mutable boost::mutex mutex;
+
+		/// by LuaHashString::GetHash of the call-in
+		std::map<unsigned int, NamedEntry> entries;
+	};
+
+	CLuaCallInStats();
+
+	/// returns a monotonic timestamp in microseconds for measuring a call-in
+	static double GetTime();
+
+	/// resets the stats of all Lua handles
+	void Reset();
+
+	/// returns a copy of the stats of all Lua handles
+	void GetStats(HandleMap& copy, double& elapsedTime) const;
+
+	/// logs the call-ins that took the most time so far
+	void PrintStats(unsigned int maxLines) const;
+	/// writes every entry, returns false if the file could not be written
+	bool WriteCSV(const std::string& fileName) const;
+
+private:
+	/// when the stats were last reset, see GetTime
+	double resetTime;
+};
+
+extern CLuaCallInStats luaCallInStats;
+
+#endif /* LUA_CALLIN_STATS_H */
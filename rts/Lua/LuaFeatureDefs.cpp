@@ -59,36 +59,7 @@ bool LuaFeatureDefs::PushEntries(lua_State* L)
 			continue;
 		}
 		lua_pushnumber(L, fd->id);
-		lua_newtable(L); { // the proxy table
-
-			lua_newtable(L); { // the metatable
-
-				HSTR_PUSH(L, "__index");
-				lua_pushlightuserdata(L, (void*)fd);
-				lua_pushcclosure(L, FeatureDefIndex, 1);
-				lua_rawset(L, -3); // closure
-
-				HSTR_PUSH(L, "__newindex");
-				lua_pushlightuserdata(L, (void*)fd);
-				lua_pushcclosure(L, FeatureDefNewIndex, 1);
-				lua_rawset(L, -3);
-
-				HSTR_PUSH(L, "__metatable");
-				lua_pushlightuserdata(L, (void*)fd);
-				lua_pushcclosure(L, FeatureDefMetatable, 1);
-				lua_rawset(L, -3);
-			}
-
-			lua_setmetatable(L, -2);
-		}
-
-		HSTR_PUSH(L, "pairs");
-		lua_pushcfunction(L, Pairs);
-		lua_rawset(L, -3);
-
-		HSTR_PUSH(L, "next");
-		lua_pushcfunction(L, Next);
-		lua_rawset(L, -3);
+		LuaUtils::PushDefProxy(L, "FeatureDefFuncs", fd, FeatureDefIndex, FeatureDefNewIndex, FeatureDefMetatable, Pairs, Next);
 
 		lua_rawset(L, -3); // proxy table into FeatureDefs
 	}
@@ -264,8 +235,7 @@ static int FeatureDefNewIndex(lua_State* L)
 
 static int FeatureDefMetatable(lua_State* L)
 {
-	/*const void* userData =*/ lua_touserdata(L, lua_upvalueindex(1));
-	//const FeatureDef* fd = (const FeatureDef*)userData;
+	// shared by all defs of a kind, see LuaUtils::PushDefProxy
 	return 0;
 }
 
@@ -6,9 +6,12 @@
 #include "LuaRules.h"
 
 #include "LuaCallInCheck.h"
+#include "LuaCallInStats.h"
 #include "LuaHashString.h"
 #include "LuaOpenGL.h"
 #include "LuaBitOps.h"
+#include "LuaPathFinder.h"
+#include "LuaProfiler.h"
 #include "LuaUtils.h"
 #include "LuaZip.h"
 #include "Game/GlobalUnsynced.h"
@@ -22,6 +25,7 @@
 #include "Rendering/GlobalRendering.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/TeamHandler.h"
+#include "Sim/Path/IPathManager.h"
 #include "Sim/Projectiles/Projectile.h"
 #include "Sim/Projectiles/WeaponProjectiles/WeaponProjectile.h"
 #include "Sim/Features/FeatureDef.h"
@@ -34,6 +38,7 @@
 #include "System/EventHandler.h"
 #include "System/GlobalConfig.h"
 #include "System/Rectangle.h"
+#include "System/TimeProfiler.h"
 #include "System/mmgr.h"
 #include "System/Log/ILog.h"
 #include "System/Input/KeyInput.h"
@@ -54,6 +59,18 @@ CLuaHandle::staticLuaContextData CLuaHandle::S_Draw;
 bool CLuaHandle::devMode = false;
 bool CLuaHandle::modUICtrl = true;
 bool CLuaHandle::useDualStates = false;
+float CLuaHandle::gcBudget = 0.0f;
+unsigned int CLuaHandle::gcDeferTime = 0;
+
+CONFIG(float, LuaGarbageCollectionBudget)
+	.defaultValue(1.0f)
+	.minimumValue(0.0f)
+	.description("Milliseconds per frame and Lua state for stepping the garbage collector at the end of each frame. 0 leaves the collection to Lua (during call-ins).");
+
+CONFIG(int, LuaGarbageCollectionDeferTime)
+	.defaultValue(25)
+	.minimumValue(0)
+	.description("Sim frames that took longer than this (in milliseconds) skip their garbage collection step, at most 30 frames in a row.");
 
 
 /******************************************************************************/
@@ -72,6 +89,9 @@ CLuaHandle::CLuaHandle(const string& _name, int _order, bool _userMode)
 {
 	UpdateThreading();
 
+	gcBudget = configHandler->GetFloat("LuaGarbageCollectionBudget");
+	gcDeferTime = configHandler->GetInt("LuaGarbageCollectionDeferTime");
+
 	SetSynced(false, true);
 	D_Sim.owner = this;
 	L_Sim = LUA_OPEN(&D_Sim, GetUserMode(), true);
@@ -120,6 +140,9 @@ void CLuaHandle::UpdateThreading() {
 
 void CLuaHandle::KillLua()
 {
+	if (pathManager != NULL) {
+		pathManager->CancelPathRequests(this);
+	}
 	if (L_Draw != NULL) {
 		CLuaHandle* orig = GetActiveHandle();
 		SetActiveHandle(L_Draw);
@@ -204,12 +227,16 @@ bool CLuaHandle::LoadCode(lua_State *L, const string& code, const string& debug)
 		CLuaHandle* orig = GetActiveHandle();
 		SetActiveHandle(L);
 
+		// sampled as a call-in named after the chunk
+		const std::string* prevCallIn = luaProfiler.BeginCallIn(L, &debug);
+
 		if ((callError = lua_pcall(L, 0, 0, 0)) != 0) {
 			LOG_L(L_ERROR, "Lua LoadCode pcall error = %i, %s, %s", loadError, debug.c_str(), lua_tostring(L, -1));
 			lua_pop(L, 1);
 			ret = false;
 		}
 
+		luaProfiler.EndCallIn(L, prevCallIn);
 		SetActiveHandle(orig);
 	} else {
 		LOG_L(L_ERROR, "Lua LoadCode loadbuffer error = %i, %s, %s", callError, debug.c_str(), lua_tostring(L, -1));
@@ -421,7 +448,7 @@ int CLuaHandle::SetupTraceback(lua_State *L)
 }
 
 
-int CLuaHandle::RunCallInTraceback(int inArgs, int outArgs, int errfuncIndex, std::string& traceback)
+int CLuaHandle::RunCallInTraceback(const LuaHashString& hs, int inArgs, int outArgs, int errfuncIndex, std::string& traceback)
 {
 #if defined(__SUPPORT_SNAN__) && !defined(USE_GML)
 	// do not signal floating point exceptions in user Lua code
@@ -436,11 +463,23 @@ int CLuaHandle::RunCallInTraceback(int inArgs, int outArgs, int errfuncIndex, st
 	//! limit gc just to the time the correct ActiveHandle is bound,
 	//! because some object could use __gc and try to access the ActiveHandle
 	//! outside of SetActiveHandle this can be an incorrect enviroment or even null -> crash
-	lua_gc(L,LUA_GCRESTART,0);
+	//! (with the GC scheduler this only happens if CollectGarbage fell behind)
+	const LuaGCStats& gcStats = L->lcd->gcStats;
+	const int gcHeapLimit = GC_HEAP_LIMIT_FACTOR * std::max(gcStats.cycleHeapSize, GC_MIN_HEAP_SIZE);
+	const bool runGC = !UseGCScheduler() || (lua_gc(L, LUA_GCCOUNT, 0) > gcHeapLimit);
+
+	const std::string* prevCallIn = luaProfiler.BeginCallIn(L, &hs.GetString());
+	const double startTime = CLuaCallInStats::GetTime();
+
+	if (runGC) lua_gc(L,LUA_GCRESTART,0);
 	const int error = lua_pcall(L, inArgs, outArgs, errfuncIndex);
-	lua_gc(L,LUA_GCSTOP,0);
+	if (runGC) lua_gc(L,LUA_GCSTOP,0);
 	SetActiveHandle(orig);
 
+	luaProfiler.EndCallIn(L, prevCallIn);
+
+	L->lcd->callInStats.AddCall(hs, CLuaCallInStats::GetTime() - startTime);
+
 	if (error == 0) {
 		// pop the error handler
 		if (errfuncIndex != 0) {
@@ -465,7 +504,8 @@ int CLuaHandle::RunCallInTraceback(int inArgs, int outArgs, int errfuncIndex, st
 bool CLuaHandle::RunCallInTraceback(const LuaHashString& hs, int inArgs, int outArgs, int errfuncIndex)
 {
 	std::string traceback;
-	const int error = RunCallInTraceback(inArgs, outArgs, errfuncIndex, traceback);
+
+	const int error = RunCallInTraceback(hs, inArgs, outArgs, errfuncIndex, traceback);
 
 	if (error != 0) {
 		LOG_L(L_ERROR, "%s::RunCallIn: error = %i, %s, %s", GetName().c_str(),
@@ -476,11 +516,122 @@ bool CLuaHandle::RunCallInTraceback(const LuaHashString& hs, int inArgs, int out
 }
 
 
-int CLuaHandle::RunCallIn(int inArgs, int outArgs, std::string& errormessage)
+int CLuaHandle::RunCallIn(const LuaHashString& hs, int inArgs, int outArgs, std::string& errormessage)
+{
+	return RunCallInTraceback(hs, inArgs, outArgs, 0, errormessage);
+}
+
+/******************************************************************************/
+
+void CLuaHandle::CollectGarbage(bool defer)
+{
+	if (!UseGCScheduler()) {
+		return;
+	}
+
+	LUA_CALL_IN_CHECK(L);
+
+	LuaGCStats& stats = L->lcd->gcStats;
+	stats.heapSize = lua_gc(L, LUA_GCCOUNT, 0);
+
+	// like Lua's own pause, a new cycle only starts once the heap doubled
+	if (!stats.inCycle && stats.heapSize < 2 * stats.cycleHeapSize) {
+		return;
+	}
+	if (defer && stats.deferredInRow < GC_MAX_DEFERRED_FRAMES) {
+		stats.deferredFrames++;
+		stats.deferredInRow++;
+		return;
+	}
+
+	ScopedTimer timer("Lua GC");
+
+	const double startTime = CLuaCallInStats::GetTime();
+	const double endTime = startTime + gcBudget * 1000.0;
+
+	CLuaHandle* orig = GetActiveHandle();
+	SetActiveHandle(L);
+
+	// one step is a small amount of work, except for the atomic phase
+	// at the end of the marking, which is done in a single step
+	do {
+		stats.inCycle = true;
+
+		if (lua_gc(L, LUA_GCSTEP, 0) != 0) {
+			stats.inCycle = false;
+			stats.cycles++;
+			stats.cycleHeapSize = lua_gc(L, LUA_GCCOUNT, 0);
+			break;
+		}
+	} while (CLuaCallInStats::GetTime() < endTime);
+
+	// stepping restarts the collector
+	lua_gc(L, LUA_GCSTOP, 0);
+	SetActiveHandle(orig);
+
+	const float stepTime = (CLuaCallInStats::GetTime() - startTime) / 1000.0;
+
+	stats.heapSize = lua_gc(L, LUA_GCCOUNT, 0);
+	stats.deferredInRow = 0;
+	stats.steps++;
+	stats.stepTime += stepTime;
+	stats.maxStepTime = std::max(stats.maxStepTime, stepTime);
+}
+
+
+void CLuaHandle::GetGCHandles(std::vector<CLuaHandle*>& handles)
+{
+	if (luaRules != NULL) { handles.push_back(luaRules); }
+	if (luaGaia  != NULL) { handles.push_back(luaGaia); }
+	if (luaUI    != NULL) { handles.push_back(luaUI); }
+}
+
+
+void CLuaHandle::CollectGarbageSim(unsigned int simFrameTime, bool skipping)
+{
+	const bool defer = (skipping || simFrameTime > gcDeferTime);
+
+	if (luaRules != NULL) { luaRules->CollectGarbage(defer); }
+	if (luaGaia  != NULL) { luaGaia->CollectGarbage(defer); }
+}
+
+
+void CLuaHandle::CollectGarbageDraw()
+{
+	// the synced handles are stepped by the sim, unless they have a draw state
+	if (luaRules != NULL && luaRules->HasDrawState()) { luaRules->CollectGarbage(); }
+	if (luaGaia  != NULL && luaGaia->HasDrawState())  { luaGaia->CollectGarbage(); }
+	if (luaUI    != NULL) { luaUI->CollectGarbage(); }
+}
+
+
+void CLuaHandle::PrintGCStats()
 {
-	return RunCallInTraceback(inArgs, outArgs, 0, errormessage);
+	if (!UseGCScheduler()) {
+		LOG("Lua garbage collection is left to Lua (LuaGarbageCollectionBudget = 0)");
+		return;
+	}
+
+	std::vector<CLuaHandle*> handles;
+	GetGCHandles(handles);
+
+	LOG("Lua garbage collection (budget %.2fms per frame and state):", gcBudget);
+	LOG("%20s|%6s|%10s|%10s|%8s|%10s|%12s|%10s",
+			"Handle", "State", "Heap [KB]", "Steps", "Cycles", "Deferred", "Total [ms]", "Max [ms]");
+
+	for (size_t n = 0; n < handles.size(); n++) {
+		for (int draw = 0; draw <= int(handles[n]->HasDrawState()); draw++) {
+			const LuaGCStats& stats = handles[n]->GetGCStats(draw);
+
+			LOG("%20s %6s %10d %10u %8u %10u %12.2f %10.2f",
+					handles[n]->GetName().c_str(), (draw? "draw": "sim"),
+					stats.heapSize, stats.steps, stats.cycles, stats.deferredFrames,
+					stats.stepTime, stats.maxStepTime);
+		}
+	}
 }
 
+
 /******************************************************************************/
 
 void CLuaHandle::Shutdown()
@@ -1950,7 +2101,21 @@ void CLuaHandle::UnsyncedHeightMapUpdate(const SRectangle& rect)
 void CLuaHandle::Update()
 {
 	LUA_CALL_IN_CHECK(L);
-	lua_checkstack(L, 2);
+	lua_checkstack(L, 4);
+
+	if (pathManager != NULL) {
+		static const LuaHashString pathStr("PathRequestCallback");
+		std::vector<IPathManager::FinishedPathRequest> finishedPaths;
+
+		pathManager->GetFinishedPathRequests(this, finishedPaths);
+
+		for (size_t n = 0; n < finishedPaths.size(); n++) {
+			if (LuaPathFinder::PushPathRequestCallback(L, finishedPaths[n].first, finishedPaths[n].second)) {
+				RunCallInUnsynced(pathStr, 2, 0);
+			}
+		}
+	}
+
 	static const LuaHashString cmdStr("Update");
 	if (!PushUnsyncedCallIn(L, cmdStr)) {
 		return;
@@ -7,6 +7,7 @@
 #include "System/EventClient.h"
 //FIXME#include "LuaArrays.h"
 #include "LuaCallInCheck.h"
+#include "LuaCallInStats.h"
 #include "LuaShaders.h"
 #include "LuaTextures.h"
 #include "LuaFBOs.h"
@@ -44,6 +45,28 @@ struct lua_State;
 class CLuaHandle;
 
 
+/// garbage collection of one Lua state, see CLuaHandle::CollectGarbage
+struct LuaGCStats {
+	LuaGCStats() : heapSize(0), cycleHeapSize(0), inCycle(false), steps(0), cycles(0),
+		deferredFrames(0), deferredInRow(0), stepTime(0.0), maxStepTime(0.0f) {}
+	int heapSize;      ///< in KB, after the last step
+	int cycleHeapSize; ///< in KB, after the last completed cycle
+	bool inCycle;
+	unsigned int steps;
+	unsigned int cycles; ///< completed by the steps
+	unsigned int deferredFrames;
+	unsigned int deferredInRow;
+	double stepTime;   ///< total, in milliseconds
+	float maxStepTime; ///< in milliseconds
+};
+
+/// Lua profiler bookkeeping of one Lua state, see CLuaProfiler
+struct LuaProfileState {
+	LuaProfileState() : callIn(NULL), sampleTime(0.0) {}
+	const std::string* callIn; ///< innermost running call-in, NULL outside of call-ins
+	double sampleTime;         ///< up to when samples were taken, 0 outside of call-ins
+};
+
 struct luaContextData {
 	luaContextData() : fullCtrl(false), fullRead(false), ctrlTeam(CEventClient::NoAccessTeam),
 		readTeam(0), readAllyTeam(0), selectTeam(CEventClient::NoAccessTeam), synced(false), owner(NULL) {}
@@ -62,6 +85,9 @@ struct luaContextData {
 	CLuaDisplayLists displayLists;
 	bool synced;
 	CLuaHandle *owner;
+	LuaGCStats gcStats;
+	LuaProfileState profileState;
+	CLuaCallInStats::StateStats callInStats;
 };
 
 class CLuaHandle : public CEventClient
@@ -280,6 +306,34 @@ class CLuaHandle : public CEventClient
 
 		void UpdateThreading();
 
+		/**
+		 * Steps the garbage collector of the state used by the calling thread
+		 * for up to LuaGarbageCollectionBudget milliseconds. While this is
+		 * enabled the collector is otherwise stopped, it only runs during
+		 * call-ins if the heap grew past GC_HEAP_LIMIT_FACTOR times its size
+		 * after the last cycle.
+		 * @param defer skip this frame, unless it was skipped
+		 *   GC_MAX_DEFERRED_FRAMES times in a row already
+		 */
+		void CollectGarbage(bool defer = false);
+		const LuaGCStats& GetGCStats(bool drawState) const { return (drawState? D_Draw: D_Sim).gcStats; }
+		bool HasDrawState() const { return !SingleState(); }
+
+		/// called at the end of each sim frame, for the synced handles
+		static void CollectGarbageSim(unsigned int simFrameTime, bool skipping);
+		/// called at the end of each draw frame, for LuaUI and the draw states
+		static void CollectGarbageDraw();
+		/// logs the GC stats of all handles
+		static void PrintGCStats();
+		/// the handles whose states are stepped, see CollectGarbage
+		static void GetGCHandles(std::vector<CLuaHandle*>& handles);
+
+		CLuaCallInStats::StateStats& GetCallInStats(bool drawState) { return (drawState? D_Draw: D_Sim).callInStats; }
+
+		static const unsigned int GC_MAX_DEFERRED_FRAMES = 30;
+		static const int GC_HEAP_LIMIT_FACTOR = 3;
+		static const int GC_MIN_HEAP_SIZE = 4096; ///< KB
+
 	protected:
 		CLuaHandle(const string& name, int order, bool userMode);
 		virtual ~CLuaHandle();
@@ -295,6 +349,9 @@ class CLuaHandle : public CEventClient
 		bool copyExportTable;
 		inline bool CopyExportTable() const { return (LUA_MT_OPT & LUA_STATE) && copyExportTable; } // Copy the table _G.EXPORT --> SYNCED.EXPORT between dual states?
 		static bool useDualStates;
+		static float gcBudget;
+		static unsigned int gcDeferTime;
+		static inline bool UseGCScheduler() { return (gcBudget > 0.0f); }
 		static inline bool UseDualStates() { return (LUA_MT_OPT & LUA_STATE) && useDualStates; } // Is Lua handle splitting enabled (globally)?
 		bool useEventBatch;
 		inline bool UseEventBatch() const { return (LUA_MT_OPT & LUA_BATCH) && useEventBatch; } // Use event batch to forward "synced" luaui events into draw thread?
@@ -318,12 +375,12 @@ class CLuaHandle : public CEventClient
 
 		/// returns stack index of traceback function
 		int SetupTraceback(lua_State *L);
-		/// returns error code and sets traceback on error
-		int  RunCallInTraceback(int inArgs, int outArgs, int errfuncIndex, std::string& traceback);
+		/// returns error code and sets traceback on error, records the call as @c hs
+		int  RunCallInTraceback(const LuaHashString& hs, int inArgs, int outArgs, int errfuncIndex, std::string& traceback);
 		/// returns false and prints message to log on error
 		bool RunCallInTraceback(const LuaHashString& hs, int inArgs, int outArgs, int errfuncIndex);
 		/// returns error code and sets errormessage on error
-		int  RunCallIn(int inArgs, int outArgs, std::string& errormessage);
+		int  RunCallIn(const LuaHashString& hs, int inArgs, int outArgs, std::string& errormessage);
 		/// returns false and prints message to log on error
 		bool RunCallIn(const LuaHashString& hs, int inArgs, int outArgs);
 		bool RunCallInUnsynced(const LuaHashString& hs, int inArgs, int outArgs);
@@ -29,6 +29,7 @@
 #include "LuaWeaponDefs.h"
 #include "LuaScream.h"
 #include "LuaOpenGL.h"
+#include "LuaProfiler.h"
 #include "LuaVFS.h"
 #include "LuaZip.h"
 
@@ -551,7 +552,9 @@ bool CLuaHandleSynced::LoadUnsyncedCode(lua_State *L, const string& code, const
 
 	CLuaHandle* orig = GetActiveHandle();
 	SetActiveHandle(L);
+	const std::string* prevCallIn = luaProfiler.BeginCallIn(L, &debug);
 	error = lua_pcall(L, 0, 0, 0);
+	luaProfiler.EndCallIn(L, prevCallIn);
 	SetActiveHandle(orig);
 
 	if (error != 0) {
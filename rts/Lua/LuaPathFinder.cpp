@@ -38,6 +38,9 @@ static std::map<unsigned int, NodeCostOverlay> costArrayMapUnsynced;
 
 static void CreatePathMetatable(lua_State* L);
 
+/// registry key of the table that maps async path request-ids to their callbacks
+static const char* PATH_REQUESTS_KEY = "PathRequestCallbacks";
+
 
 /******************************************************************************/
 /******************************************************************************/
@@ -52,12 +55,14 @@ bool LuaPathFinder::PushEntries(lua_State* L)
 	lua_rawset(L, -3)
                         
 	REGISTER_LUA_CFUNC(RequestPath);
+	REGISTER_LUA_CFUNC(RequestPathAsync);
 	REGISTER_LUA_CFUNC(InitPathNodeCostsArray);
 	REGISTER_LUA_CFUNC(FreePathNodeCostsArray);
 	REGISTER_LUA_CFUNC(SetPathNodeCosts);
 	REGISTER_LUA_CFUNC(GetPathNodeCosts);
 	REGISTER_LUA_CFUNC(SetPathNodeCost);
 	REGISTER_LUA_CFUNC(GetPathNodeCost);
+	REGISTER_LUA_CFUNC(GetPathCacheStats);
 
 	return true;
 }
@@ -201,20 +206,81 @@ static void CreatePathMetatable(lua_State* L)
 /******************************************************************************/
 /******************************************************************************/
 
-int LuaPathFinder::RequestPath(lua_State* L)
+static const MoveData* ParseMoveData(lua_State* L, const char* caller)
+{
+	if (lua_israwstring(L, 1))
+		return moveinfo->GetMoveDataFromName(lua_tostring(L, 1));
+
+	const int moveID = luaL_checkint(L, 1);
+
+	if ((moveID < 0) || ((size_t)moveID >= moveinfo->moveData.size())) {
+		luaL_error(L, "Invalid moveID passed to %s", caller);
+	}
+
+	return moveinfo->moveData[moveID];
+}
+
+static void PushPathRequestsTable(lua_State* L)
+{
+	lua_pushstring(L, PATH_REQUESTS_KEY);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+
+	if (lua_istable(L, -1))
+		return;
+
+	lua_pop(L, 1);
+	lua_newtable(L);
+	lua_pushstring(L, PATH_REQUESTS_KEY);
+	lua_pushvalue(L, -2);
+	lua_rawset(L, LUA_REGISTRYINDEX);
+}
+
+
+int LuaPathFinder::PushPath(lua_State* L, const int pathID)
+{
+	int* idPtr = (int*)lua_newuserdata(L, sizeof(int));
+	luaL_getmetatable(L, "Path");
+	lua_setmetatable(L, -2);
+
+	*idPtr = pathID;
+
+	return 1;
+}
+
+bool LuaPathFinder::PushPathRequestCallback(lua_State* L, unsigned int requestID, unsigned int pathID)
 {
-	const MoveData* moveData = NULL;
-	
-	if (lua_israwstring(L, 1)) {
-		moveData = moveinfo->GetMoveDataFromName(lua_tostring(L, 1));
+	PushPathRequestsTable(L);
+	lua_pushnumber(L, requestID);
+	lua_rawget(L, -2);
+
+	if (!lua_isfunction(L, -1)) {
+		lua_pop(L, 2);
+		pathManager->DeletePath(pathID);
+		return false;
+	}
+
+	// forget the request, leave only the callback on the stack
+	lua_pushnumber(L, requestID);
+	lua_pushnil(L);
+	lua_rawset(L, -4);
+	lua_remove(L, -2);
+
+	lua_pushnumber(L, requestID);
+
+	if (pathID != 0) {
+		PushPath(L, pathID);
 	} else {
-		const int moveID = luaL_checkint(L, 1);
-		if ((moveID < 0) || ((size_t)moveID >= moveinfo->moveData.size())) {
-			luaL_error(L, "Invalid moveID passed to RequestPath");
-		}
-		moveData = moveinfo->moveData[moveID];
+		lua_pushnil(L);
 	}
 
+	return true;
+}
+
+
+int LuaPathFinder::RequestPath(lua_State* L)
+{
+	const MoveData* moveData = ParseMoveData(L, __FUNCTION__);
+
 	if (moveData == NULL) {
 		return 0;
 	}
@@ -235,18 +301,56 @@ int LuaPathFinder::RequestPath(lua_State* L)
 	if (pathID == 0) {
 		return 0;
 	}
-	
-	int* idPtr = (int*)lua_newuserdata(L, sizeof(int));
-	luaL_getmetatable(L, "Path");
-	lua_setmetatable(L, -2);
 
-	*idPtr = pathID;
+	return PushPath(L, pathID);
+}
+
+/*
+ * Spring.RequestPathAsync(moveID, sx, sy, sz, ex, ey, ez, callback [, radius])
+ *   -> requestID
+ * callback(requestID, path) is called in a later frame (before Update);
+ * path is nil if none was found
+ */
+int LuaPathFinder::RequestPathAsync(lua_State* L)
+{
+	if (CLuaHandle::GetSynced(L)) {
+		luaL_error(L, "%s can only be used in unsynced code", __FUNCTION__);
+	}
+
+	const MoveData* moveData = ParseMoveData(L, __FUNCTION__);
 
+	if (moveData == NULL) {
+		return 0;
+	}
+
+	const float3 start(luaL_checkfloat(L, 2),
+	                   luaL_checkfloat(L, 3),
+	                   luaL_checkfloat(L, 4));
+
+	const float3   end(luaL_checkfloat(L, 5),
+	                   luaL_checkfloat(L, 6),
+	                   luaL_checkfloat(L, 7));
+
+	luaL_checktype(L, 8, LUA_TFUNCTION);
+
+	const float radius = luaL_optfloat(L, 9, 8.0f);
+	const unsigned int requestID = pathManager->RequestPathAsync(CLuaHandle::GetActiveHandle(), moveData, start, end, radius);
+
+	if (requestID == 0) {
+		return 0;
+	}
+
+	PushPathRequestsTable(L);
+	lua_pushnumber(L, requestID);
+	lua_pushvalue(L, 8);
+	lua_rawset(L, -3);
+	lua_pop(L, 1);
+
+	lua_pushnumber(L, requestID);
 	return 1;
 }
 
 
-
 int LuaPathFinder::InitPathNodeCostsArray(lua_State* L)
 {
 	const unsigned int array = luaL_checkint(L, 1);
@@ -347,6 +451,10 @@ int LuaPathFinder::SetPathNodeCost(lua_State* L)
 		// lua_pushboolean(L, pathManager->SetNodeExtraCost(hmx, hmz, cost, synced));
 		lua_pushboolean(L, false);
 	} else {
+		// the async searches read the active unsynced overlay
+		if (!synced && pathManager->GetNodeExtraCosts(false) == &overlay.costs[0])
+			pathManager->WaitForPathRequests();
+
 		// modify only the cost-overlay (whether it is active or not)
 		if (index < overlay.Size())
 			overlay.costs[index] = cost;
@@ -370,5 +478,21 @@ int LuaPathFinder::GetPathNodeCost(lua_State* L)
 	return 1;
 }
 
+int LuaPathFinder::GetPathCacheStats(lua_State* L)
+{
+	unsigned int numHits = 0;
+	unsigned int numMisses = 0;
+	unsigned int numItems = 0;
+	unsigned int memFootPrint = 0;
+
+	pathManager->GetPathCacheStats(numHits, numMisses, numItems, memFootPrint);
+
+	lua_pushnumber(L, numHits);
+	lua_pushnumber(L, numMisses);
+	lua_pushnumber(L, numItems);
+	lua_pushnumber(L, memFootPrint);
+	return 4;
+}
+
 /******************************************************************************/
 /******************************************************************************/
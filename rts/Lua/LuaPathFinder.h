@@ -9,15 +9,27 @@ class LuaPathFinder {
 public:
 	static bool PushEntries(lua_State* L);
 	static int PushPathNodes(lua_State* L, const int pathID);
+	static int PushPath(lua_State* L, const int pathID);
+
+	/**
+	 * Pushes the callback of a finished RequestPathAsync request and its
+	 * arguments (requestID and the path, nil if none was found) and
+	 * forgets about the request.
+	 * @return false (and nothing pushed, the path deleted) if the request
+	 *   was not made by <L>
+	 */
+	static bool PushPathRequestCallback(lua_State* L, unsigned int requestID, unsigned int pathID);
 
 private:
 	static int RequestPath(lua_State* L);
+	static int RequestPathAsync(lua_State* L);
 	static int InitPathNodeCostsArray(lua_State* L);
 	static int FreePathNodeCostsArray(lua_State* L);
 	static int SetPathNodeCosts(lua_State* L);
 	static int GetPathNodeCosts(lua_State* L);
 	static int SetPathNodeCost(lua_State* L);
 	static int GetPathNodeCost(lua_State* L);
+	static int GetPathCacheStats(lua_State* L);
 };
 
 
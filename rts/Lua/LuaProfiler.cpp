@@ -0,0 +1,249 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "LuaProfiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <vector>
+
+#include "LuaInclude.h"
+#include "LuaCallInStats.h"
+#include "LuaHandle.h"
+#include "System/Log/ILog.h"
+#include "System/maindefines.h"
+#include "System/mmgr.h"
+
+
+CLuaProfiler luaProfiler;
+
+
+CLuaProfiler::CLuaProfiler()
+	: numSamples(0)
+	, running(false)
+	, sampleInterval(1000.0)
+	, startTime(0.0)
+	, stopTime(0.0)
+{
+}
+
+
+void CLuaProfiler::Start(unsigned int interval)
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	stacks.clear();
+	sources.clear();
+	numSamples = 0;
+
+	sampleInterval = std::max(interval, 1u);
+	startTime = CLuaCallInStats::GetTime();
+	running = true;
+}
+
+
+void CLuaProfiler::Stop()
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	if (running) {
+		stopTime = CLuaCallInStats::GetTime();
+		running = false;
+	}
+}
+
+
+const std::string* CLuaProfiler::BeginCallIn(lua_State* L, const std::string* callIn)
+{
+	LuaProfileState& state = L->lcd->profileState;
+	const std::string* prevCallIn = state.callIn;
+	state.callIn = callIn;
+
+	// hook the states lazily, that also covers the ones created after Start,
+	// but leave hooks alone that were set through debug.sethook
+	const lua_Hook hook = lua_gethook(L);
+
+	if (running) {
+		if (hook == NULL) {
+			lua_sethook(L, Hook, LUA_MASKCOUNT, HOOK_COUNT);
+		}
+		if (prevCallIn == NULL) {
+			state.sampleTime = CLuaCallInStats::GetTime();
+		}
+	} else if (hook == Hook) {
+		lua_sethook(L, NULL, 0, 0);
+	}
+
+	return prevCallIn;
+}
+
+
+void CLuaProfiler::EndCallIn(lua_State* L, const std::string* prevCallIn)
+{
+	LuaProfileState& state = L->lcd->profileState;
+	state.callIn = prevCallIn;
+
+	// the time between call-ins does not belong to any of them
+	if (prevCallIn == NULL) {
+		state.sampleTime = 0.0;
+	}
+}
+
+
+void CLuaProfiler::Hook(lua_State* L, lua_Debug* ar)
+{
+	// coroutines inherit the hook of the state that created them
+	if (!luaProfiler.running) {
+		lua_sethook(L, NULL, 0, 0);
+		return;
+	}
+	if (L->lcd == NULL) {
+		return;
+	}
+
+	LuaProfileState& state = L->lcd->profileState;
+
+	if (state.sampleTime == 0.0) {
+		return;
+	}
+
+	const double interval = luaProfiler.sampleInterval;
+	const double elapsed = CLuaCallInStats::GetTime() - state.sampleTime;
+
+	if (elapsed < interval) {
+		return;
+	}
+
+	const unsigned int count = elapsed / interval;
+	state.sampleTime += (count * interval);
+
+	luaProfiler.AddSample(L, count);
+}
+
+
+static std::string GetFrameName(const lua_Debug& ar)
+{
+	const char* name = (ar.name != NULL)? ar.name: "?";
+	char buf[256];
+
+	switch (ar.what[0]) {
+		case 'C': { SNPRINTF(buf, sizeof(buf), "%s [C]", name); } break;
+		case 'm': { SNPRINTF(buf, sizeof(buf), "main chunk (%s)", ar.short_src); } break;
+		default:  { SNPRINTF(buf, sizeof(buf), "%s (%s:%d)", name, ar.short_src, ar.linedefined); } break;
+	}
+
+	// ';' separates the frames of a collapsed stack
+	std::string frame(buf);
+	std::replace(frame.begin(), frame.end(), ';', ',');
+	return frame;
+}
+
+
+void CLuaProfiler::AddSample(lua_State* L, unsigned int count)
+{
+	const luaContextData* lcd = L->lcd;
+
+	std::vector<std::string> frames;
+	std::set<std::string> files;
+	lua_Debug ar;
+
+	// level 0 is the innermost function
+	for (int level = 0; level < MAX_DEPTH && lua_getstack(L, level, &ar); level++) {
+		lua_getinfo(L, "Sn", &ar);
+		frames.push_back(GetFrameName(ar));
+
+		if (ar.what[0] != 'C') {
+			files.insert(ar.short_src);
+		}
+	}
+
+	const std::string handleName = (lcd->owner != NULL)? lcd->owner->GetName(): "?";
+	const std::string& callInName = (lcd->profileState.callIn != NULL)? *lcd->profileState.callIn: "?";
+
+	std::string stack = handleName + ';' + callInName;
+
+	for (std::vector<std::string>::reverse_iterator it = frames.rbegin(); it != frames.rend(); ++it) {
+		stack += ';';
+		stack += *it;
+	}
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	// the game thread may have stopped the profiler in the meantime
+	if (!running) {
+		return;
+	}
+
+	stacks[stack] += count;
+	numSamples += count;
+
+	std::map<std::string, unsigned int>& handleSources = sources[handleName];
+
+	for (std::set<std::string>::const_iterator it = files.begin(); it != files.end(); ++it) {
+		handleSources[*it] += count;
+	}
+}
+
+
+namespace {
+	struct SortedSource {
+		SortedSource(const std::string* h, const std::string* f, unsigned int s)
+			: handleName(h), fileName(f), samples(s) {}
+
+		bool operator < (const SortedSource& s) const {
+			return (samples > s.samples);
+		}
+
+		const std::string* handleName;
+		const std::string* fileName;
+		unsigned int samples;
+	};
+}
+
+void CLuaProfiler::PrintStats(unsigned int maxLines) const
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	const double elapsedTime = (running? CLuaCallInStats::GetTime(): stopTime) - startTime;
+
+	std::vector<SortedSource> sorted;
+
+	for (SourceMap::const_iterator hi = sources.begin(); hi != sources.end(); ++hi) {
+		for (std::map<std::string, unsigned int>::const_iterator fi = hi->second.begin(); fi != hi->second.end(); ++fi) {
+			sorted.push_back(SortedSource(&hi->first, &fi->first, fi->second));
+		}
+	}
+
+	std::sort(sorted.begin(), sorted.end());
+
+	LOG("Lua profiler (%s, %.0fus interval): %u samples over %.1fs (inclusive, sorted by samples):",
+			(running? "running": "stopped"), sampleInterval, numSamples, elapsedTime / 1000000.0);
+	LOG("%20s|%60s|%10s|%8s",
+			"Handle", "File", "Samples", "[%]");
+
+	for (unsigned int n = 0; n < sorted.size() && n < maxLines; n++) {
+		LOG("%20s %60s %10u %8.2f",
+				sorted[n].handleName->c_str(),
+				sorted[n].fileName->c_str(),
+				sorted[n].samples,
+				(sorted[n].samples * 100.0f) / numSamples);
+	}
+}
+
+
+bool CLuaProfiler::WriteFlameGraph(const std::string& fileName) const
+{
+	std::ofstream file(fileName.c_str(), std::ios::out | std::ios::trunc);
+
+	if (!file.good()) {
+		return false;
+	}
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	for (StackMap::const_iterator it = stacks.begin(); it != stacks.end(); ++it) {
+		file << it->first << ' ' << it->second << '\n';
+	}
+
+	return file.good();
+}
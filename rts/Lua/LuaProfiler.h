@@ -0,0 +1,85 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_PROFILER_H
+#define LUA_PROFILER_H
+
+#include <string>
+#include <map>
+#include <boost/thread/mutex.hpp>
+
+struct lua_State;
+struct lua_Debug;
+
+
+/**
+ * Sampling profiler for the Lua code of all handles.
+ *
+ * While running, every Lua state that enters a call-in gets a count hook,
+ * which reads the clock every HOOK_COUNT instructions and takes a sample
+ * of the Lua stack for each sample interval that passed. The samples are
+ * keyed by handle, call-in and the functions on the stack (with the file
+ * they are defined in), so the time of LuaRules can be attributed to the
+ * gadget that spends it. Time spent in C functions (eg. Spring.*) goes to
+ * the Lua function that called them.
+ *
+ * Only reads the stack, so it does not affect sync. Besides the call-ins
+ * (including the functions of Lua unit scripts) the loading of the Lua
+ * code is sampled, as a call-in named after the chunk. Coroutines created
+ * before the profiler was started are not sampled.
+ *
+ * Controlled by "/debuginfo luaprofile [start [interval]|stop|write]",
+ * the output of write is in the collapsed stack format of flamegraph.pl.
+ */
+class CLuaProfiler
+{
+public:
+	/// Lua instructions between two reads of the clock
+	static const int HOOK_COUNT = 1000;
+	/// stack levels beyond this are left out of a sample
+	static const int MAX_DEPTH = 64;
+
+	/// samples by collapsed stack ("handle;call-in;outermost;...;innermost")
+	typedef std::map<std::string, unsigned int> StackMap;
+	/// samples that contain a function of a file, by handle and file name
+	typedef std::map<std::string, std::map<std::string, unsigned int> > SourceMap;
+
+	CLuaProfiler();
+
+	/// discards all samples, the interval is in microseconds
+	void Start(unsigned int sampleInterval);
+	void Stop();
+	bool IsRunning() const { return running; }
+
+	/**
+	 * Called around every call-in, hooks the state while the profiler
+	 * runs and removes the hook otherwise.
+	 * @return the call-in that was running before, for EndCallIn
+	 */
+	const std::string* BeginCallIn(lua_State* L, const std::string* callIn);
+	void EndCallIn(lua_State* L, const std::string* prevCallIn);
+
+	/// logs the files that most samples were taken in, per handle
+	void PrintStats(unsigned int maxLines) const;
+	/// returns false if the file could not be written
+	bool WriteFlameGraph(const std::string& fileName) const;
+
+private:
+	static void Hook(lua_State* L, lua_Debug* ar);
+	void AddSample(lua_State* L, unsigned int count);
+
+	mutable boost::mutex mutex;
+
+	StackMap stacks;
+	SourceMap sources;
+	unsigned int numSamples;
+
+	/// set by the game thread, read by the hooks of all threads
+	volatile bool running;
+	double sampleInterval; ///< in microseconds
+	double startTime;      ///< see CLuaCallInStats::GetTime
+	double stopTime;
+};
+
+extern CLuaProfiler luaProfiler;
+
+#endif /* LUA_PROFILER_H */
@@ -112,6 +112,7 @@ CLuaRules::CLuaRules()
 	haveTerraformComplete      = HasCallIn(L, "TerraformComplete");
 	haveAllowWeaponTargetCheck = HasCallIn(L, "AllowWeaponTargetCheck");
 	haveAllowWeaponTarget      = HasCallIn(L, "AllowWeaponTarget");
+	haveAllowWeaponTargets     = HasCallIn(L, "AllowWeaponTargets");
 	haveUnitPreDamaged         = HasCallIn(L, "UnitPreDamaged");
 	haveShieldPreDamaged       = HasCallIn(L, "ShieldPreDamaged");
 
@@ -193,6 +194,7 @@ bool CLuaRules::SyncedUpdateCallIn(lua_State *L, const string& name)
 	else if (name == "ShieldPreDamaged"      ) { UPDATE_HAVE_CALLIN(ShieldPreDamaged); }
 	else if (name == "AllowWeaponTargetCheck") { UPDATE_HAVE_CALLIN(AllowWeaponTargetCheck); }
 	else if (name == "AllowWeaponTarget"     ) { UPDATE_HAVE_CALLIN(AllowWeaponTarget); }
+	else if (name == "AllowWeaponTargets"    ) { UPDATE_HAVE_CALLIN(AllowWeaponTargets); }
 	else {
 		return CLuaHandleSynced::SyncedUpdateCallIn(L, name);
 	}
@@ -918,6 +920,72 @@ int CLuaRules::AllowWeaponTarget(
 	return ret;
 }
 
+int CLuaRules::AllowWeaponTargets(
+	unsigned int attackerID,
+	unsigned int attackerWeaponNum,
+	unsigned int attackerWeaponDefID,
+	const std::vector<int>& targetIDs,
+	std::vector<bool>& targetAllowed,
+	std::vector<float>& targetPriorities)
+{
+	if (!haveAllowWeaponTargets) {
+		return -1;
+	}
+
+	LUA_CALL_IN_CHECK(L);
+	lua_checkstack(L, 4 + 3);
+
+	const int errfunc(SetupTraceback(L));
+	static const LuaHashString cmdStr("AllowWeaponTargets");
+
+	int ret = -1;
+
+	if (!cmdStr.GetGlobalFunc(L)) {
+		if (errfunc) { lua_pop(L, 1); }
+		return ret;
+	}
+
+	const int numTargets = targetIDs.size();
+
+	lua_pushnumber(L, attackerID);
+	lua_pushnumber(L, attackerWeaponNum);
+	lua_pushnumber(L, attackerWeaponDefID);
+	lua_createtable(L, numTargets, 0);
+
+	for (int n = 0; n < numTargets; n++) {
+		lua_pushnumber(L, targetIDs[n]);
+		lua_rawseti(L, -2, n + 1);
+	}
+
+	if (!RunCallInTraceback(cmdStr, 4, 2, errfunc)) {
+		return ret;
+	}
+
+	// same defaults as AllowWeaponTarget: not allowed, priority 1
+	targetAllowed.assign(numTargets, false);
+	targetPriorities.assign(numTargets, 1.0f);
+
+	if (lua_istable(L, -2)) {
+		for (int n = 0; n < numTargets; n++) {
+			lua_rawgeti(L, -2, n + 1);
+			targetAllowed[n] = (lua_isboolean(L, -1) && lua_toboolean(L, -1));
+			lua_pop(L, 1);
+		}
+	}
+	if (lua_istable(L, -1)) {
+		for (int n = 0; n < numTargets; n++) {
+			lua_rawgeti(L, -1, n + 1);
+			if (lua_isnumber(L, -1)) {
+				targetPriorities[n] = lua_tonumber(L, -1);
+			}
+			lua_pop(L, 1);
+		}
+	}
+
+	lua_pop(L, 2);
+	return 1;
+}
+
 /******************************************************************************/
 
 
@@ -68,6 +68,19 @@ class CLuaRules : public CLuaHandleSynced
 			unsigned int attackerWeaponNum,
 			unsigned int attackerWeaponDefID,
 			float* targetPriority);
+		/**
+		 * Batched version of AllowWeaponTarget, one call for all candidates
+		 * of a weapon. Returns -1 if the call-in is not defined, otherwise
+		 * fills targetAllowed and targetPriorities (one entry per targetID).
+		 */
+		int AllowWeaponTargets(
+			unsigned int attackerID,
+			unsigned int attackerWeaponNum,
+			unsigned int attackerWeaponDefID,
+			const std::vector<int>& targetIDs,
+			std::vector<bool>& targetAllowed,
+			std::vector<float>& targetPriorities);
+		bool HaveAllowWeaponTargets() const { return haveAllowWeaponTargets; }
 
 		bool UnitPreDamaged(const CUnit* unit, const CUnit* attacker,
                              float damage, int weaponID, bool paralyzer,
@@ -110,6 +123,7 @@ class CLuaRules : public CLuaHandleSynced
 		bool haveShieldPreDamaged;
 		bool haveAllowWeaponTargetCheck;
 		bool haveAllowWeaponTarget;
+		bool haveAllowWeaponTargets;
 
 		bool haveDrawUnit;
 		bool haveDrawFeature;
@@ -210,6 +210,7 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetUnitDirection);
 	REGISTER_LUA_CFUNC(GetUnitHeading);
 	REGISTER_LUA_CFUNC(GetUnitVelocity);
+	REGISTER_LUA_CFUNC(GetUnitArrays);
 	REGISTER_LUA_CFUNC(GetUnitBuildFacing);
 	REGISTER_LUA_CFUNC(GetUnitIsBuilding);
 	REGISTER_LUA_CFUNC(GetUnitTransporter);
@@ -1524,18 +1525,18 @@ int LuaSyncedRead::ArePlayersAllied(lua_State* L)
 
 int LuaSyncedRead::GetAllUnits(lua_State* L)
 {
-	CheckNoArgs(L, __FUNCTION__);
 	int count = 0;
-	std::list<CUnit*>::const_iterator uit;
+	int oldSize = 0;
+	std::vector<CUnit*>::const_iterator uit;
 	if (ActiveFullRead()) {
-		lua_createtable(L, uh->activeUnits.size(), 0);
+		oldSize = LuaPushListTable(L, 1, uh->activeUnits.size());
 		for (uit = uh->activeUnits.begin(); uit != uh->activeUnits.end(); ++uit) {
 			// t[count] = id
 			lua_pushnumber(L, (*uit)->id);
 			lua_rawseti(L, -2, ++count);
 		}
 	} else {
-		lua_newtable(L);
+		oldSize = LuaPushListTable(L, 1);
 		for (uit = uh->activeUnits.begin(); uit != uh->activeUnits.end(); ++uit) {
 			if (IsUnitVisible(*uit)) {
 				count++;
@@ -1546,6 +1547,7 @@ int LuaSyncedRead::GetAllUnits(lua_State* L)
 		}
 	}
 
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -1568,7 +1570,7 @@ int LuaSyncedRead::GetTeamUnits(lua_State* L)
 
 	// raw push for allies
 	if (IsAlliedTeam(teamID)) {
-		lua_newtable(L);
+		const int oldSize = LuaPushListTable(L, 2, units.size());
 		int count = 0;
 		for (uit = units.begin(); uit != units.end(); ++uit) {
 			count++;
@@ -1577,11 +1579,12 @@ int LuaSyncedRead::GetTeamUnits(lua_State* L)
 			lua_rawset(L, -3);
 		}
 
+		LuaTrimListTable(L, count, oldSize);
 		return 1;
 	}
 
 	// check visibility for enemies
-	lua_newtable(L);
+	const int oldSize = LuaPushListTable(L, 2);
 	int count = 0;
 	for (uit = units.begin(); uit != units.end(); ++uit) {
 		const CUnit* unit = *uit;
@@ -1593,6 +1596,7 @@ int LuaSyncedRead::GetTeamUnits(lua_State* L)
 		}
 	}
 
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -1806,7 +1810,7 @@ int LuaSyncedRead::GetTeamUnitsByDefs(lua_State* L)
 		luaL_error(L, "Incorrect arguments to GetTeamUnitsByDefs()");
 	}
 
-	lua_newtable(L);
+	const int oldSize = LuaPushListTable(L, 3);
 	int count = 0;
 
 	set<int>::const_iterator udit;
@@ -1824,6 +1828,7 @@ int LuaSyncedRead::GetTeamUnitsByDefs(lua_State* L)
 		}
 	}
 
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -1936,6 +1941,12 @@ int LuaSyncedRead::GetTeamUnitCount(lua_State* L)
 //  Spatial Unit Queries
 //
 
+// reused by the spatial queries below, which hold the qnum
+// lock for as long as the contents are needed (GML threads)
+static vector<CUnit*> queryUnits;
+static vector<CFeature*> queryFeatures;
+static vector<CProjectile*> queryProjectiles;
+
 // Macro Requirements:
 //   L, it, units, and count
 
@@ -2011,10 +2022,13 @@ int LuaSyncedRead::GetUnitsInRectangle(lua_State* L)
 
 #define RECTANGLE_TEST ; // no test, GetUnitsExact is sufficient
 
+	GML_RECMUTEX_LOCK(qnum);
+	qf->GetUnitsExact(mins, maxs, queryUnits);
+
 	vector<CUnit*>::const_iterator it;
-	const vector<CUnit*> &units = qf->GetUnitsExact(mins, maxs);
+	const vector<CUnit*>& units = queryUnits;
 
-	lua_newtable(L);
+	const int oldSize = LuaPushListTable(L, 6);
 	int count = 0;
 
 	if (allegiance >= 0) {
@@ -2038,6 +2052,7 @@ int LuaSyncedRead::GetUnitsInRectangle(lua_State* L)
 		LOOP_UNIT_CONTAINER(VISIBLE_TEST, RECTANGLE_TEST);
 	}
 
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -2062,10 +2077,13 @@ int LuaSyncedRead::GetUnitsInBox(lua_State* L)
 		continue;                     \
 	}
 
+	GML_RECMUTEX_LOCK(qnum);
+	qf->GetUnitsExact(mins, maxs, queryUnits);
+
 	vector<CUnit*>::const_iterator it;
-	const vector<CUnit*> &units = qf->GetUnitsExact(mins, maxs);
+	const vector<CUnit*>& units = queryUnits;
 
-	lua_newtable(L);
+	const int oldSize = LuaPushListTable(L, 8);
 	int count = 0;
 
 	if (allegiance >= 0) {
@@ -2089,6 +2107,7 @@ int LuaSyncedRead::GetUnitsInBox(lua_State* L)
 		LOOP_UNIT_CONTAINER(VISIBLE_TEST, BOX_TEST);
 	}
 
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -2114,10 +2133,13 @@ int LuaSyncedRead::GetUnitsInCylinder(lua_State* L)
 		continue;                                 \
 	}                                           \
 
+	GML_RECMUTEX_LOCK(qnum);
+	qf->GetUnitsExact(mins, maxs, queryUnits);
+
 	vector<CUnit*>::const_iterator it;
-	const vector<CUnit*> &units = qf->GetUnitsExact(mins, maxs);
+	const vector<CUnit*>& units = queryUnits;
 
-	lua_newtable(L);
+	const int oldSize = LuaPushListTable(L, 5);
 	int count = 0;
 
 	if (allegiance >= 0) {
@@ -2141,6 +2163,7 @@ int LuaSyncedRead::GetUnitsInCylinder(lua_State* L)
 		LOOP_UNIT_CONTAINER(VISIBLE_TEST, CYLINDER_TEST);
 	}
 
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -2170,10 +2193,13 @@ int LuaSyncedRead::GetUnitsInSphere(lua_State* L)
 		continue;                                 \
 	}                                           \
 
+	GML_RECMUTEX_LOCK(qnum);
+	qf->GetUnitsExact(mins, maxs, queryUnits);
+
 	vector<CUnit*>::const_iterator it;
-	const vector<CUnit*> &units = qf->GetUnitsExact(mins, maxs);
+	const vector<CUnit*>& units = queryUnits;
 
-	lua_newtable(L);
+	const int oldSize = LuaPushListTable(L, 6);
 	int count = 0;
 
 	if (allegiance >= 0) {
@@ -2197,6 +2223,7 @@ int LuaSyncedRead::GetUnitsInSphere(lua_State* L)
 		LOOP_UNIT_CONTAINER(VISIBLE_TEST, SPHERE_TEST);
 	}
 
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -2228,7 +2255,7 @@ int LuaSyncedRead::GetUnitsInPlanes(lua_State* L)
 
 	// parse the planes
 	vector<Plane> planes;
-	const int table = lua_gettop(L);
+	const int table = 1;
 	for (lua_pushnil(L); lua_next(L, table) != 0; lua_pop(L, 1)) {
 		if (lua_istable(L, -1)) {
 			float values[4];
@@ -2262,7 +2289,7 @@ int LuaSyncedRead::GetUnitsInPlanes(lua_State* L)
 		continue;                        \
 	}
 
-	lua_newtable(L);
+	const int oldSize = LuaPushListTable(L, 3);
 	int count = 0;
 
 	const int readTeam = CLuaHandle::GetReadTeam(L);
@@ -2304,6 +2331,7 @@ int LuaSyncedRead::GetUnitsInPlanes(lua_State* L)
 		}
 	}
 
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -2353,11 +2381,11 @@ int LuaSyncedRead::GetUnitNearestEnemy(lua_State* L)
 
 /******************************************************************************/
 
-inline void ProcessFeatures(lua_State* L, const vector<CFeature*>& features) {
+inline void ProcessFeatures(lua_State* L, const vector<CFeature*>& features, int destIndex) {
 	const unsigned int featureCount = features.size();
 	unsigned int arrayIndex = 1;
 
-	lua_createtable(L, featureCount, 0);
+	const int oldSize = LuaPushListTable(L, destIndex, featureCount);
 
 	if (ActiveReadAllyTeam() < 0) {
 		if (ActiveFullRead()) {
@@ -2382,6 +2410,8 @@ inline void ProcessFeatures(lua_State* L, const vector<CFeature*>& features) {
 			lua_rawset(L, -3);
 		}
 	}
+
+	LuaTrimListTable(L, arrayIndex - 1, oldSize);
 }
 
 int LuaSyncedRead::GetFeaturesInRectangle(lua_State* L)
@@ -2394,8 +2424,9 @@ int LuaSyncedRead::GetFeaturesInRectangle(lua_State* L)
 	const float3 mins(xmin, 0.0f, zmin);
 	const float3 maxs(xmax, 0.0f, zmax);
 
-	const vector<CFeature*>& rectFeatures = qf->GetFeaturesExact(mins, maxs);
-	ProcessFeatures(L, rectFeatures);
+	GML_RECMUTEX_LOCK(qnum);
+	qf->GetFeaturesExact(mins, maxs, queryFeatures);
+	ProcessFeatures(L, queryFeatures, 5);
 	return 1;
 }
 
@@ -2408,8 +2439,9 @@ int LuaSyncedRead::GetFeaturesInSphere(lua_State* L)
 
 	const float3 pos(x, y, z);
 
-	const vector<CFeature*>& sphFeatures = qf->GetFeaturesExact(pos, rad, true);
-	ProcessFeatures(L, sphFeatures);
+	GML_RECMUTEX_LOCK(qnum);
+	qf->GetFeaturesExact(pos, rad, true, queryFeatures);
+	ProcessFeatures(L, queryFeatures, 5);
 	return 1;
 }
 
@@ -2421,8 +2453,9 @@ int LuaSyncedRead::GetFeaturesInCylinder(lua_State* L)
 
 	const float3 pos(x, 0, z);
 
-	const vector<CFeature*>& cylFeatures = qf->GetFeaturesExact(pos, rad, false);
-	ProcessFeatures(L, cylFeatures);
+	GML_RECMUTEX_LOCK(qnum);
+	qf->GetFeaturesExact(pos, rad, false, queryFeatures);
+	ProcessFeatures(L, queryFeatures, 4);
 	return 1;
 }
 
@@ -2439,11 +2472,14 @@ int LuaSyncedRead::GetProjectilesInRectangle(lua_State* L)
 	const float3 mins(xmin, 0.0f, zmin);
 	const float3 maxs(xmax, 0.0f, zmax);
 
-	const vector<CProjectile*>& rectProjectiles = qf->GetProjectilesExact(mins, maxs);
+	GML_RECMUTEX_LOCK(qnum);
+	qf->GetProjectilesExact(mins, maxs, queryProjectiles);
+
+	const vector<CProjectile*>& rectProjectiles = queryProjectiles;
 	const unsigned int rectProjectileCount = rectProjectiles.size();
 	unsigned int arrayIndex = 1;
 
-	lua_createtable(L, rectProjectileCount, 0);
+	const int oldSize = LuaPushListTable(L, 7, rectProjectileCount);
 
 	if (ActiveReadAllyTeam() < 0) {
 		if (ActiveFullRead()) {
@@ -2477,6 +2513,7 @@ int LuaSyncedRead::GetProjectilesInRectangle(lua_State* L)
 		}
 	}
 
+	LuaTrimListTable(L, arrayIndex - 1, oldSize);
 	return 1;
 }
 
@@ -2929,6 +2966,237 @@ int LuaSyncedRead::GetUnitVelocity(lua_State* L)
 }
 
 
+/******************************************************************************/
+
+namespace {
+	enum UnitArrayField {
+		UA_DEF_ID,
+		UA_TEAM,
+		UA_ALLY_TEAM,
+		UA_POS_X,
+		UA_POS_Y,
+		UA_POS_Z,
+		UA_BASE_POS_X,
+		UA_BASE_POS_Y,
+		UA_BASE_POS_Z,
+		UA_VEL_X,
+		UA_VEL_Y,
+		UA_VEL_Z,
+		UA_HEADING,
+		UA_HEALTH,
+		UA_MAX_HEALTH,
+		UA_PARALYZE_DAMAGE,
+		UA_CAPTURE_PROGRESS,
+		UA_BUILD_PROGRESS,
+		UA_NUM_FIELDS
+	};
+
+	const char* unitArrayFieldNames[UA_NUM_FIELDS] = {
+		"defID",
+		"team",
+		"allyTeam",
+		"posX",
+		"posY",
+		"posZ",
+		"basePosX",
+		"basePosY",
+		"basePosZ",
+		"velX",
+		"velY",
+		"velZ",
+		"heading",
+		"health",
+		"maxHealth",
+		"paralyzeDamage",
+		"captureProgress",
+		"buildProgress"
+	};
+
+	/// what the reading handle may see of one unit, evaluated once per unit
+	struct UnitArrayEntry {
+		UnitArrayEntry(): unit(NULL), ally(false), inLos(false), typed(false) {}
+
+		const CUnit* unit; ///< NULL if the unit does not exist or is not visible
+		bool ally;
+		bool inLos;
+		bool typed;
+		float3 pos;        ///< midPos, or the radar position for non-allies
+	};
+}
+
+
+static void PushUnitArrayValue(lua_State* L, const UnitArrayEntry& e, int field)
+{
+	const CUnit* unit = e.unit;
+
+	if (unit == NULL) {
+		lua_pushboolean(L, false);
+		return;
+	}
+
+	// the rules are those of the single-unit getters
+	switch (field) {
+		case UA_DEF_ID: {
+			if (!e.ally && !e.typed) { break; }
+			lua_pushnumber(L, EffectiveUnitDef(unit)->id);
+		} return;
+		case UA_TEAM: {
+			lua_pushnumber(L, unit->team);
+		} return;
+		case UA_ALLY_TEAM: {
+			lua_pushnumber(L, unit->allyteam);
+		} return;
+
+		case UA_POS_X: { lua_pushnumber(L, e.pos.x); } return;
+		case UA_POS_Y: { lua_pushnumber(L, e.pos.y); } return;
+		case UA_POS_Z: { lua_pushnumber(L, e.pos.z); } return;
+
+		case UA_BASE_POS_X: { lua_pushnumber(L, e.ally? unit->pos.x: e.pos.x - (unit->midPos.x - unit->pos.x)); } return;
+		case UA_BASE_POS_Y: { lua_pushnumber(L, e.ally? unit->pos.y: e.pos.y - (unit->midPos.y - unit->pos.y)); } return;
+		case UA_BASE_POS_Z: { lua_pushnumber(L, e.ally? unit->pos.z: e.pos.z - (unit->midPos.z - unit->pos.z)); } return;
+
+		case UA_VEL_X: { if (!e.inLos) { break; } lua_pushnumber(L, unit->speed.x); } return;
+		case UA_VEL_Y: { if (!e.inLos) { break; } lua_pushnumber(L, unit->speed.y); } return;
+		case UA_VEL_Z: { if (!e.inLos) { break; } lua_pushnumber(L, unit->speed.z); } return;
+
+		case UA_HEADING: {
+			if (!e.inLos) { break; }
+			lua_pushnumber(L, unit->heading);
+		} return;
+
+		case UA_HEALTH:
+		case UA_MAX_HEALTH:
+		case UA_PARALYZE_DAMAGE:
+		case UA_CAPTURE_PROGRESS:
+		case UA_BUILD_PROGRESS: {
+			if (!e.inLos) { break; }
+
+			const UnitDef* ud = unit->unitDef;
+			const bool enemyUnit = IsEnemyUnit(unit);
+
+			if (ud->hideDamage && enemyUnit) { break; }
+
+			const float scale = (!enemyUnit || (ud->decoyDef == NULL))? 1.0f: (ud->decoyDef->health / ud->health);
+
+			switch (field) {
+				case UA_HEALTH:            { lua_pushnumber(L, scale * unit->health); } break;
+				case UA_MAX_HEALTH:        { lua_pushnumber(L, scale * unit->maxHealth); } break;
+				case UA_PARALYZE_DAMAGE:   { lua_pushnumber(L, scale * unit->paralyzeDamage); } break;
+				case UA_CAPTURE_PROGRESS:  { lua_pushnumber(L, unit->captureProgress); } break;
+				case UA_BUILD_PROGRESS:    { lua_pushnumber(L, unit->buildProgress); } break;
+			}
+		} return;
+	}
+
+	lua_pushboolean(L, false);
+}
+
+
+int LuaSyncedRead::GetUnitArrays(lua_State* L)
+{
+	// Spring.GetUnitArrays(unitIDs, {"posX", "posZ", "health"} [, dest])
+	//
+	// returns dest (or a new table) holding one array per requested field,
+	// parallel to unitIDs, and the number of units; the entries of units that
+	// do not exist or whose field is not accessible to the caller are false.
+	// a table returned by an earlier call can be passed back in as dest, its
+	// arrays are then refilled in place instead of being allocated again
+	luaL_checktype(L, 1, LUA_TTABLE);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	std::vector<int> fields;
+	bool needPos = false;
+
+	for (int i = 1; /**/; i++) {
+		lua_rawgeti(L, 2, i);
+
+		if (lua_isnil(L, -1)) {
+			lua_pop(L, 1);
+			break;
+		}
+		if (!lua_israwstring(L, -1)) {
+			luaL_error(L, "%s(): field names must be strings", __FUNCTION__);
+		}
+
+		const std::string name = lua_tostring(L, -1);
+		int field = 0;
+
+		while (field < UA_NUM_FIELDS && name != unitArrayFieldNames[field]) {
+			field++;
+		}
+		if (field == UA_NUM_FIELDS) {
+			luaL_error(L, "%s(): unknown field \"%s\"", __FUNCTION__, name.c_str());
+		}
+
+		fields.push_back(field);
+		needPos |= (field >= UA_POS_X && field <= UA_BASE_POS_Z);
+		lua_pop(L, 1);
+	}
+
+	const int numUnits = lua_objlen(L, 1);
+	std::vector<UnitArrayEntry> entries(numUnits);
+
+	for (int i = 0; i < numUnits; i++) {
+		lua_rawgeti(L, 1, i + 1);
+		const CUnit* unit = ParseUnit(L, __FUNCTION__, -1);
+		lua_pop(L, 1);
+
+		if (unit == NULL) {
+			continue;
+		}
+
+		UnitArrayEntry& e = entries[i];
+		e.unit  = unit;
+		e.ally  = IsAllyUnit(unit);
+		e.inLos = IsUnitInLos(unit);
+		e.typed = IsUnitTyped(unit);
+
+		if (needPos) {
+			e.pos = e.ally? float3(unit->midPos): helper->GetUnitErrorPos(unit, ActiveReadAllyTeam());
+		}
+	}
+
+	if (lua_istable(L, 3)) {
+		lua_settop(L, 3);
+	} else {
+		lua_settop(L, 2);
+		lua_createtable(L, 0, fields.size());
+	}
+
+	const int dest = lua_gettop(L);
+
+	for (size_t f = 0; f < fields.size(); f++) {
+		const char* name = unitArrayFieldNames[fields[f]];
+
+		lua_getfield(L, dest, name);
+
+		if (!lua_istable(L, -1)) {
+			lua_pop(L, 1);
+			lua_createtable(L, numUnits, 0);
+			lua_pushvalue(L, -1);
+			lua_setfield(L, dest, name);
+		}
+
+		const int oldSize = lua_objlen(L, -1);
+
+		for (int i = 0; i < numUnits; i++) {
+			PushUnitArrayValue(L, entries[i], fields[f]);
+			lua_rawseti(L, -2, i + 1);
+		}
+		// shrink arrays that were filled for more units before
+		for (int i = numUnits; i < oldSize; i++) {
+			lua_pushnil(L);
+			lua_rawseti(L, -2, i + 1);
+		}
+
+		lua_pop(L, 1);
+	}
+
+	lua_pushnumber(L, numUnits);
+	return 2;
+}
+
+
 int LuaSyncedRead::GetUnitBuildFacing(lua_State* L)
 {
 	CUnit* unit = ParseInLosUnit(L, __FUNCTION__, 1);
@@ -4066,19 +4334,19 @@ int LuaSyncedRead::ValidFeatureID(lua_State* L)
 
 int LuaSyncedRead::GetAllFeatures(lua_State* L)
 {
-	CheckNoArgs(L, __FUNCTION__);
 	int count = 0;
+	int oldSize = 0;
 	const CFeatureSet& activeFeatures = featureHandler->GetActiveFeatures();
 	CFeatureSet::const_iterator fit;
 	if (ActiveFullRead()) {
-		lua_createtable(L, activeFeatures.size(), 0);
+		oldSize = LuaPushListTable(L, 1, activeFeatures.size());
 		for (fit = activeFeatures.begin(); fit != activeFeatures.end(); ++fit) {
 			lua_pushnumber(L, (*fit)->id);
 			lua_rawseti(L, -2, ++count);
 		}
 	}
 	else {
-		lua_newtable(L);
+		oldSize = LuaPushListTable(L, 1);
 		for (fit = activeFeatures.begin(); fit != activeFeatures.end(); ++fit) {
 			if (IsFeatureVisible(*fit)) {
 				lua_pushnumber(L, (*fit)->id);
@@ -4086,6 +4354,7 @@ int LuaSyncedRead::GetAllFeatures(lua_State* L)
 			}
 		}
 	}
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -92,36 +92,7 @@ bool LuaUnitDefs::PushEntries(lua_State* L)
 	  	continue;
 		}
 		lua_pushnumber(L, ud->id);
-		lua_newtable(L); { // the proxy table
-
-			lua_newtable(L); { // the metatable
-
-				HSTR_PUSH(L, "__index");
-				lua_pushlightuserdata(L, (void*)ud);
-				lua_pushcclosure(L, UnitDefIndex, 1);
-				lua_rawset(L, -3); // closure
-
-				HSTR_PUSH(L, "__newindex");
-				lua_pushlightuserdata(L, (void*)ud);
-				lua_pushcclosure(L, UnitDefNewIndex, 1);
-				lua_rawset(L, -3);
-
-				HSTR_PUSH(L, "__metatable");
-				lua_pushlightuserdata(L, (void*)ud);
-				lua_pushcclosure(L, UnitDefMetatable, 1);
-				lua_rawset(L, -3);
-			}
-
-			lua_setmetatable(L, -2);
-		}
-
-		HSTR_PUSH(L, "pairs");
-		lua_pushcfunction(L, Pairs);
-		lua_rawset(L, -3);
-
-		HSTR_PUSH(L, "next");
-		lua_pushcfunction(L, Next);
-		lua_rawset(L, -3);
+		LuaUtils::PushDefProxy(L, "UnitDefFuncs", ud, UnitDefIndex, UnitDefNewIndex, UnitDefMetatable, Pairs, Next);
 
 		lua_rawset(L, -3); // proxy table into UnitDefs
 	}
@@ -257,9 +228,7 @@ static int UnitDefNewIndex(lua_State* L)
 
 static int UnitDefMetatable(lua_State* L)
 {
-	lua_touserdata(L, lua_upvalueindex(1));
-	// const void* userData = lua_touserdata(L, lua_upvalueindex(1));
-	// const UnitDef* ud = (const UnitDef*)userData;
+	// shared by all defs of a kind, see LuaUtils::PushDefProxy
 	return 0;
 }
 
@@ -3,6 +3,7 @@
 #include "LuaUnsyncedRead.h"
 
 #include "LuaInclude.h"
+#include "LuaCallInStats.h"
 #include "LuaHandle.h"
 #include "LuaHashString.h"
 #include "LuaUtils.h"
@@ -150,6 +151,9 @@ bool LuaUnsyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetSoundStreamTime);
 	REGISTER_LUA_CFUNC(GetSoundEffectParams);
 
+	REGISTER_LUA_CFUNC(GetLuaCallInStats);
+	REGISTER_LUA_CFUNC(GetLuaGCStats);
+
 	// moved from LuaUI
 
 	REGISTER_LUA_CFUNC(GetFPS);
@@ -646,7 +650,7 @@ public:
 	CUnitQuads() : count(0) {};
 
 	int count;
-	std::vector<const std::list<CUnit*>*> visunits;
+	std::vector<const CQuadField::UnitList*> visunits;
 
 	void DrawQuad(int x, int y)
 	{
@@ -664,7 +668,7 @@ public:
 	CFeatureQuads() : count(0) {};
 
 	int count;
-	std::vector<const std::list<CFeature*>*> visfeatures;
+	std::vector<const CQuadField::FeatureList*> visfeatures;
 
 	void DrawQuad(int x, int y)
 	{
@@ -717,13 +721,14 @@ int LuaUnsyncedRead::GetVisibleUnits(lua_State* L)
 
 	CUnitQuads quadIter;
 	int count = 0;
+	int oldSize = 0;
 
 	{
 		GML_RECMUTEX_LOCK(quad); // GetVisibleUnits
 
 		readmap->GridVisibility(camera, CQuadField::QUAD_SIZE / SQUARE_SIZE, 1e9, &quadIter, INT_MAX);
 
-		lua_createtable(L, quadIter.count, 0);
+		oldSize = LuaPushListTable(L, 4, quadIter.count);
 
 		//! setup the list of unit sets
 		if (quadIter.count > uh->activeUnits.size()/3) {
@@ -743,9 +748,9 @@ int LuaUnsyncedRead::GetVisibleUnits(lua_State* L)
 		} else {
 			//! features can exist in multiple quads, so we need to do a duplication check
 			visQuadUnits.clear();
-			std::vector<const std::list<CUnit*>*>::iterator sit;
+			std::vector<const CQuadField::UnitList*>::iterator sit;
 			for (sit = quadIter.visunits.begin(); sit != quadIter.visunits.end(); ++sit) {
-				std::list<CUnit*>::const_iterator unitIt;
+				CQuadField::UnitList::const_iterator unitIt;
 				for (unitIt = (*sit)->begin(); unitIt != (*sit)->end(); ++unitIt) {
 					CUnit* unit = *unitIt;
 					if ((teamID == AllUnits) ||
@@ -803,6 +808,7 @@ int LuaUnsyncedRead::GetVisibleUnits(lua_State* L)
 		}
 	}
 
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -843,13 +849,14 @@ int LuaUnsyncedRead::GetVisibleFeatures(lua_State* L)
 
 	CFeatureQuads quadIter;
 	int count = 0;
+	int oldSize = 0;
 
 	{
 		GML_RECMUTEX_LOCK(quad); // GetVisibleFeatures
 
 		readmap->GridVisibility(camera, CQuadField::QUAD_SIZE / SQUARE_SIZE, 3000.0f * 2.0f, &quadIter, INT_MAX);
 
-		lua_createtable(L, quadIter.count, 0);
+		oldSize = LuaPushListTable(L, 5, quadIter.count);
 
 		//! setup the list of features
 		if (quadIter.count > featureHandler->GetActiveFeatures().size()/3) {
@@ -858,9 +865,9 @@ int LuaUnsyncedRead::GetVisibleFeatures(lua_State* L)
 		} else {
 			//! features can exist in multiple quads, so we need to do a duplication check
 			visQuadFeatures.clear();
-			std::vector<const std::list<CFeature*>*>::iterator it;
+			std::vector<const CQuadField::FeatureList*>::iterator it;
 			for (it = quadIter.visfeatures.begin(); it != quadIter.visfeatures.end(); ++it) {
-				std::list<CFeature*>::const_iterator featureIt;
+				CQuadField::FeatureList::const_iterator featureIt;
 				for (featureIt = (*it)->begin(); featureIt != (*it)->end(); ++featureIt) {
 					visQuadFeatures.insert(*featureIt);
 				}
@@ -903,6 +910,7 @@ int LuaUnsyncedRead::GetVisibleFeatures(lua_State* L)
 		lua_rawset(L, -3);
 	}
 
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -951,10 +959,9 @@ int LuaUnsyncedRead::GetSelectedUnits(lua_State* L)
 {
 	GML_RECMUTEX_LOCK(sel); // GetSelectedUnits
 
-	CheckNoArgs(L, __FUNCTION__);
-	lua_newtable(L);
-	int count = 0;
 	const CUnitSet& selUnits = selectedUnits.selectedUnits;
+	const int oldSize = LuaPushListTable(L, 1, selUnits.size());
+	int count = 0;
 	CUnitSet::const_iterator it;
 	for (it = selUnits.begin(); it != selUnits.end(); ++it) {
 		count++;
@@ -962,6 +969,7 @@ int LuaUnsyncedRead::GetSelectedUnits(lua_State* L)
 		lua_pushnumber(L, (*it)->id);
 		lua_rawset(L, -3);
 	}
+	LuaTrimListTable(L, count, oldSize);
 	return 1;
 }
 
@@ -1565,6 +1573,111 @@ int LuaUnsyncedRead::GetSoundEffectParams(lua_State* L)
 }
 
 
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+ * returns the seconds since the stats were reset, a table
+ * {[handleName] = {[callInName] = {calls, totalTime, maxTime, histogram}}}
+ * (times in milliseconds, histogram holds the call counts per bucket) and
+ * the upper bounds of the histogram buckets (but the last) in milliseconds
+ */
+int LuaUnsyncedRead::GetLuaCallInStats(lua_State* L)
+{
+	CheckNoArgs(L, __FUNCTION__);
+
+	CLuaCallInStats::HandleMap stats;
+	double elapsedTime;
+	luaCallInStats.GetStats(stats, elapsedTime);
+
+	lua_pushnumber(L, elapsedTime / 1000000.0);
+	lua_createtable(L, 0, stats.size());
+
+	CLuaCallInStats::HandleMap::const_iterator hi;
+	for (hi = stats.begin(); hi != stats.end(); ++hi) {
+		lua_pushsstring(L, hi->first);
+		lua_createtable(L, 0, hi->second.size());
+
+		CLuaCallInStats::CallInMap::const_iterator ci;
+		for (ci = hi->second.begin(); ci != hi->second.end(); ++ci) {
+			const CLuaCallInStats::Entry& e = ci->second;
+
+			lua_pushsstring(L, ci->first);
+			lua_createtable(L, 0, 4);
+			HSTR_PUSH_NUMBER(L, "calls",     e.calls);
+			HSTR_PUSH_NUMBER(L, "totalTime", e.totalTime / 1000.0);
+			HSTR_PUSH_NUMBER(L, "maxTime",   e.maxTime / 1000.0f);
+
+			HSTR_PUSH(L, "histogram");
+			lua_createtable(L, CLuaCallInStats::NUM_BUCKETS, 0);
+			for (int n = 0; n < CLuaCallInStats::NUM_BUCKETS; n++) {
+				lua_pushnumber(L, e.histogram[n]);
+				lua_rawseti(L, -2, n + 1);
+			}
+			lua_rawset(L, -3);
+
+			lua_rawset(L, -3);
+		}
+
+		lua_rawset(L, -3);
+	}
+
+	lua_createtable(L, CLuaCallInStats::NUM_BUCKETS - 1, 0);
+	for (int n = 0; n < (CLuaCallInStats::NUM_BUCKETS - 1); n++) {
+		lua_pushnumber(L, CLuaCallInStats::BUCKET_LIMITS[n] / 1000.0f);
+		lua_rawseti(L, -2, n + 1);
+	}
+
+	return 3;
+}
+
+
+static void PushLuaGCStats(lua_State* L, const LuaGCStats& stats)
+{
+	lua_createtable(L, 0, 6);
+	HSTR_PUSH_NUMBER(L, "heapSize",       stats.heapSize);
+	HSTR_PUSH_NUMBER(L, "steps",          stats.steps);
+	HSTR_PUSH_NUMBER(L, "cycles",         stats.cycles);
+	HSTR_PUSH_NUMBER(L, "deferredFrames", stats.deferredFrames);
+	HSTR_PUSH_NUMBER(L, "stepTime",       stats.stepTime);
+	HSTR_PUSH_NUMBER(L, "maxStepTime",    stats.maxStepTime);
+}
+
+/*
+ * returns {[handleName] = {sim = stats, draw = stats}} with the stats of the
+ * garbage collection steps, see CLuaHandle::CollectGarbage (heap sizes in
+ * KB, times in milliseconds, draw only for handles with a separate draw state)
+ */
+int LuaUnsyncedRead::GetLuaGCStats(lua_State* L)
+{
+	CheckNoArgs(L, __FUNCTION__);
+
+	std::vector<CLuaHandle*> handles;
+	CLuaHandle::GetGCHandles(handles);
+
+	lua_createtable(L, 0, handles.size());
+
+	for (size_t n = 0; n < handles.size(); n++) {
+		lua_pushsstring(L, handles[n]->GetName());
+		lua_createtable(L, 0, 2);
+
+		HSTR_PUSH(L, "sim");
+		PushLuaGCStats(L, handles[n]->GetGCStats(false));
+		lua_rawset(L, -3);
+
+		if (handles[n]->HasDrawState()) {
+			HSTR_PUSH(L, "draw");
+			PushLuaGCStats(L, handles[n]->GetGCStats(true));
+			lua_rawset(L, -3);
+		}
+
+		lua_rawset(L, -3);
+	}
+
+	return 1;
+}
+
+
 /******************************************************************************/
 /******************************************************************************/
 //
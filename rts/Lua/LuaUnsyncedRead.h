@@ -83,6 +83,9 @@ class LuaUnsyncedRead {
 
 		static int GetSoundStreamTime(lua_State* L);
 		static int GetSoundEffectParams(lua_State* L);
+
+		static int GetLuaCallInStats(lua_State* L);
+		static int GetLuaGCStats(lua_State* L);
 	
 		// moved from LuaUI
 		static int GetFPS(lua_State* L);
@@ -668,6 +668,71 @@ int LuaUtils::ParseFacing(lua_State* L, const char* caller, int index)
 /******************************************************************************/
 
 
+void LuaUtils::PushDefProxy(lua_State* L, const char* regName, const void* def,
+                            lua_CFunction indexFunc, lua_CFunction newIndexFunc,
+                            lua_CFunction metatableFunc,
+                            lua_CFunction pairsFunc, lua_CFunction nextFunc)
+{
+	lua_newtable(L); // the proxy table
+
+	// the functions that do not need the def, created once per state and kind
+	lua_getfield(L, LUA_REGISTRYINDEX, regName);
+	if (lua_isnil(L, -1)) {
+		lua_pop(L, 1);
+		lua_newtable(L);
+
+		HSTR_PUSH(L, "__metatable");
+		lua_pushcfunction(L, metatableFunc);
+		lua_rawset(L, -3);
+
+		HSTR_PUSH(L, "pairs");
+		lua_pushcfunction(L, pairsFunc);
+		lua_rawset(L, -3);
+
+		HSTR_PUSH(L, "next");
+		lua_pushcfunction(L, nextFunc);
+		lua_rawset(L, -3);
+
+		lua_pushvalue(L, -1);
+		lua_setfield(L, LUA_REGISTRYINDEX, regName);
+	}
+
+	lua_newtable(L); { // the metatable
+
+		// the def is an upvalue, so __index needs no lookup to find it
+		HSTR_PUSH(L, "__index");
+		lua_pushlightuserdata(L, const_cast<void*>(def));
+		lua_pushcclosure(L, indexFunc, 1);
+		lua_rawset(L, -3);
+
+		HSTR_PUSH(L, "__newindex");
+		lua_pushlightuserdata(L, const_cast<void*>(def));
+		lua_pushcclosure(L, newIndexFunc, 1);
+		lua_rawset(L, -3);
+
+		HSTR_PUSH(L, "__metatable");
+		HSTR_PUSH(L, "__metatable");
+		lua_rawget(L, -4);
+		lua_rawset(L, -3);
+	}
+
+	lua_setmetatable(L, -3);
+
+	// ud:pairs() and ud:next()
+	HSTR_PUSH(L, "pairs");
+	HSTR_PUSH(L, "pairs");
+	lua_rawget(L, -3);
+	lua_rawset(L, -4);
+
+	HSTR_PUSH(L, "next");
+	HSTR_PUSH(L, "next");
+	lua_rawget(L, -3);
+	lua_rawset(L, -4);
+
+	lua_pop(L, 1);
+}
+
+
 int LuaUtils::Next(const ParamMap& paramMap, lua_State* L)
 {
 	luaL_checktype(L, 1, LUA_TTABLE);
@@ -73,6 +73,15 @@ class LuaUtils {
 		// (helper for the Next() iteration routine)
 		static int Next(const ParamMap& paramMap, lua_State* L);
 
+		// from LuaFeatureDefs.cpp / LuaUnitDefs.cpp / LuaWeaponDefs.cpp
+		// (pushes a new proxy table for def, indexFunc and newIndexFunc get
+		// def as upvalue, the other functions are shared by all proxies of
+		// one kind per state and registered under regName)
+		static void PushDefProxy(lua_State* L, const char* regName, const void* def,
+		                         lua_CFunction indexFunc, lua_CFunction newIndexFunc,
+		                         lua_CFunction metatableFunc,
+		                         lua_CFunction pairsFunc, lua_CFunction nextFunc);
+
 		// from LuaParser.cpp / LuaUnsyncedCtrl.cpp
 		// (implementation copied from lua/src/lib/lbaselib.c)
 		static int Echo(lua_State* L);
@@ -112,6 +121,35 @@ class LuaUtils {
 };
 
 
+/**
+ * The list queries take an optional table as their last argument, which is
+ * cleared and refilled instead of creating a new one. Widgets that poll them
+ * every frame then produce no garbage for the Lua GC.
+ *
+ * Pushes the table at index, or a new one if there is none there, and
+ * returns the number of entries it had.
+ */
+inline int LuaPushListTable(lua_State* L, int index, int sizeHint = 0)
+{
+	if (lua_istable(L, index)) {
+		lua_pushvalue(L, index);
+		return lua_objlen(L, -1);
+	}
+	lua_createtable(L, sizeHint, 0);
+	return 0;
+}
+
+
+/// clears the entries of a reused list table after the new ones
+inline void LuaTrimListTable(lua_State* L, int count, int oldSize)
+{
+	for (int i = count + 1; i <= oldSize; i++) {
+		lua_pushnil(L);
+		lua_rawseti(L, -2, i);
+	}
+}
+
+
 inline void LuaPushNamedBool(lua_State* L,
                              const string& key, bool value)
 {
@@ -70,36 +70,7 @@ bool LuaWeaponDefs::PushEntries(lua_State* L)
 	  	continue;
 		}
 		lua_pushnumber(L, wd->id);
-		lua_newtable(L); { // the proxy table
-
-			lua_newtable(L); { // the metatable
-
-				HSTR_PUSH(L, "__index");
-				lua_pushlightuserdata(L, (void*)wd);
-				lua_pushcclosure(L, WeaponDefIndex, 1);
-				lua_rawset(L, -3); // closure
-
-				HSTR_PUSH(L, "__newindex");
-				lua_pushlightuserdata(L, (void*)wd);
-				lua_pushcclosure(L, WeaponDefNewIndex, 1);
-				lua_rawset(L, -3);
-
-				HSTR_PUSH(L, "__metatable");
-				lua_pushlightuserdata(L, (void*)wd);
-				lua_pushcclosure(L, WeaponDefMetatable, 1);
-				lua_rawset(L, -3);
-			}
-
-			lua_setmetatable(L, -2);
-		}
-
-		HSTR_PUSH(L, "pairs");
-		lua_pushcfunction(L, Pairs);
-		lua_rawset(L, -3);
-
-		HSTR_PUSH(L, "next");
-		lua_pushcfunction(L, Next);
-		lua_rawset(L, -3);
+		LuaUtils::PushDefProxy(L, "WeaponDefFuncs", wd, WeaponDefIndex, WeaponDefNewIndex, WeaponDefMetatable, Pairs, Next);
 
 		lua_rawset(L, -3); // proxy table into WeaponDefs
 	}
@@ -226,8 +197,7 @@ static int WeaponDefNewIndex(lua_State* L)
 
 static int WeaponDefMetatable(lua_State* L)
 {
-	//const void* userData = lua_touserdata(L, lua_upvalueindex(1));
-	//const WeaponDef* wd = (const WeaponDef*)userData;
+	// shared by all defs of a kind, see LuaUtils::PushDefProxy
 	return 0;
 }
 
@@ -200,6 +200,9 @@ void CBasicMapDamage::RecalcArea(int x1, int x2, int y1, int y2)
 		}
 	}
 
+	// pending LOS ray-casts must still see the old terrain
+	loshandler->FlushLosUpdateBatch();
+
 	readmap->UpdateHeightMapSynced(x1, y1, x2, y2);
 	pathManager->TerrainChange(x1, y1, x2, y2);
 	featureHandler->TerrainChanged(x1, y1, x2, y2);
@@ -274,9 +277,9 @@ void CBasicMapDamage::UpdateLos()
 		}
 
 		RelosSquare* rs = &relosQue.front();
-		const std::list<CUnit*>& units = qf->GetQuadAt(rs->x, rs->y).units;
+		const CQuadField::UnitList& units = qf->GetQuadAt(rs->x, rs->y).units;
 
-		std::list<CUnit*>::const_iterator ui;
+		CQuadField::UnitList::const_iterator ui;
 		for (ui = units.begin(); ui != units.end(); ++ui) {
 			relosUnits.push_back((*ui)->id);
 		}
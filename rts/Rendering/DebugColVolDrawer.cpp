@@ -173,11 +173,11 @@ public:
 	{
 		const CQuadField::Quad& q = qf->GetQuadAt(x, y);
 
-		for (std::list<CFeature*>::const_iterator fi = q.features.begin(); fi != q.features.end(); ++fi) {
+		for (CQuadField::FeatureList::const_iterator fi = q.features.begin(); fi != q.features.end(); ++fi) {
 			DrawFeatureColVol(*fi);
 		}
 
-		for (std::list<CUnit*>::const_iterator ui = q.units.begin(); ui != q.units.end(); ++ui) {
+		for (CQuadField::UnitList::const_iterator ui = q.units.begin(); ui != q.units.end(); ++ui) {
 			DrawUnitColVol(*ui);
 		}
 
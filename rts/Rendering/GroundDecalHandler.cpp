@@ -802,6 +802,16 @@ void CGroundDecalHandler::UnitMoved(const CUnit* unit)
 		moveUnits.push_back(const_cast<CUnit*>(unit));
 }
 
+void CGroundDecalHandler::UnitsMoved(const std::vector<const CUnit*>& units)
+{
+	if (decalLevel == 0)
+		return;
+
+	for (std::vector<const CUnit*>::const_iterator it = units.begin(); it != units.end(); ++it) {
+		UnitMoved(*it);
+	}
+}
+
 void CGroundDecalHandler::UnitMovedNow(CUnit* unit)
 {
 	const int zp = (int(unit->pos.z) / SQUARE_SIZE * 2);
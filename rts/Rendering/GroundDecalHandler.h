@@ -124,6 +124,7 @@ public:
 	void SunChanged(const float3& sunDir);
 
 	void UnitMoved(const CUnit*);
+	void UnitsMoved(const std::vector<const CUnit*>& units);
 	void UnitMovedNow(CUnit* unit);
 	void RemoveUnit(CUnit* unit);
 	int GetTrackType(const std::string& name);
@@ -140,7 +141,7 @@ public:
 
 	bool WantsEvent(const std::string& eventName) {
 		return 
-			(eventName == "UnitMoved") ||
+			(eventName == "UnitsMoved") ||
 			(eventName == "SunChanged");
 	}
 	bool GetFullRead() const { return true; }
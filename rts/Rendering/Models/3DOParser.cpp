@@ -127,21 +127,17 @@ C3DOParser::C3DOParser()
 S3DModel* C3DOParser::Load(const std::string& name)
 {
 	CFileHandler file(name);
-	if (!file.FileExists()) {
+	CFileView fileView;
+	if (!file.GetView(fileView)) {
 		throw content_error("[3DOParser] could not find model-file " + name);
 	}
 
-	fileBuf = new unsigned char[file.FileSize()];
-	assert(fileBuf);
-
-	const int readn = file.Read(fileBuf, file.FileSize());
-
-	if (readn == 0) {
-		delete[] fileBuf;
-		fileBuf = NULL;
+	if (fileView.GetSize() == 0) {
 		throw content_error("[3DOParser] Failed to read file " + name);
 	}
 
+	fileBuf = fileView.GetData();
+
 	S3DModel* model = new S3DModel;
 		model->name = name;
 		model->type = MODELTYPE_3DO;
@@ -166,7 +162,6 @@ S3DModel* C3DOParser::Load(const std::string& name)
 	model->relMidPos.x = 0.0f; // ?
 	model->relMidPos.z = 0.0f; // ?
 
-	delete[] fileBuf;
 	fileBuf = NULL;
 	return model;
 }
@@ -111,7 +111,8 @@ private:
 	std::set<std::string> teamtex;
 
 	int curOffset;
-	unsigned char* fileBuf;
+	/// the model file being loaded (read-only, it may be mapped into memory)
+	const unsigned char* fileBuf;
 	void SimStreamRead(void* buf, int length);
 };
 
@@ -23,12 +23,13 @@ static const float3 DEF_MAX_SIZE(-10000.0f, -10000.0f, -10000.0f);
 S3DModel* CS3OParser::Load(const std::string& name)
 {
 	CFileHandler file(name);
-	if (!file.FileExists()) {
+	CFileView fileView;
+	if (!file.GetView(fileView)) {
 		throw content_error("[S3OParser] could not find model-file " + name);
 	}
 
-	unsigned char* fileBuf = new unsigned char[file.FileSize()];
-	file.Read(fileBuf, file.FileSize());
+	// read-only, the file may be mapped into memory
+	const unsigned char* fileBuf = fileView.GetData();
 	S3OHeader header;
 	memcpy(&header, fileBuf, sizeof(header));
 	header.swap();
@@ -37,8 +38,8 @@ S3DModel* CS3OParser::Load(const std::string& name)
 		model->name = name;
 		model->type = MODELTYPE_S3O;
 		model->numPieces = 0;
-		model->tex1 = (char*) &fileBuf[header.texture1];
-		model->tex2 = (char*) &fileBuf[header.texture2];
+		model->tex1 = (const char*) &fileBuf[header.texture1];
+		model->tex2 = (const char*) &fileBuf[header.texture2];
 		model->mins = DEF_MIN_SIZE;
 		model->maxs = DEF_MAX_SIZE;
 	texturehandlerS3O->LoadS3OTexture(model);
@@ -52,49 +53,55 @@ S3DModel* CS3OParser::Load(const std::string& name)
 	model->relMidPos = float3(header.midx, header.midy, header.midz);
 	model->relMidPos.y = std::max(model->relMidPos.y, 1.0f); // ?
 
-	delete[] fileBuf;
 	return model;
 }
 
-SS3OPiece* CS3OParser::LoadPiece(S3DModel* model, SS3OPiece* parent, unsigned char* buf, int offset)
+SS3OPiece* CS3OParser::LoadPiece(S3DModel* model, SS3OPiece* parent, const unsigned char* buf, int offset)
 {
 	model->numPieces++;
 
-	Piece* fp = (Piece*)&buf[offset];
-	fp->swap(); // Does it matter we mess with the original buffer here? Don't hope so.
+	// the structs are swapped in copies, buf is read-only
+	Piece fp;
+	memcpy(&fp, &buf[offset], sizeof(Piece));
+	fp.swap();
 
 	SS3OPiece* piece = new SS3OPiece();
 		piece->type = MODELTYPE_S3O;
 		piece->mins = DEF_MIN_SIZE;
 		piece->maxs = DEF_MAX_SIZE;
-		piece->offset.x = fp->xoffset;
-		piece->offset.y = fp->yoffset;
-		piece->offset.z = fp->zoffset;
-		piece->primitiveType = fp->primitiveType;
-		piece->name = (char*) &buf[fp->name];
+		piece->offset.x = fp.xoffset;
+		piece->offset.y = fp.yoffset;
+		piece->offset.z = fp.zoffset;
+		piece->primitiveType = fp.primitiveType;
+		piece->name = (const char*) &buf[fp.name];
 		piece->parent = parent;
-		piece->vertices.reserve(fp->numVertices);
-		piece->vertexDrawOrder.reserve((size_t)(fp->vertexTableSize * 1.1f)); //1.1f is just a guess (check below)
+		piece->vertices.reserve(fp.numVertices);
+		piece->vertexDrawOrder.reserve((size_t)(fp.vertexTableSize * 1.1f)); //1.1f is just a guess (check below)
 
 	// retrieve each vertex
-	int vertexOffset = fp->vertices;
-
-	for (int a = 0; a < fp->numVertices; ++a) {
-		Vertex* v = reinterpret_cast<Vertex*>(&buf[vertexOffset]);
-			v->swap();
-		SS3OVertex* sv = reinterpret_cast<SS3OVertex*>(&buf[vertexOffset]);
-			sv->normal.SafeANormalize();
-
-		piece->vertices.push_back(*sv);
+	int vertexOffset = fp.vertices;
+
+	for (int a = 0; a < fp.numVertices; ++a) {
+		Vertex v;
+		memcpy(&v, &buf[vertexOffset], sizeof(Vertex));
+			v.swap();
+		SS3OVertex sv;
+			sv.pos = float3(v.xpos, v.ypos, v.zpos);
+			sv.normal = float3(v.xnormal, v.ynormal, v.znormal);
+			sv.normal.SafeANormalize();
+			sv.textureX = v.texu;
+			sv.textureY = v.texv;
+
+		piece->vertices.push_back(sv);
 		vertexOffset += sizeof(Vertex);
 	}
 
 
 	// retrieve the draw order for the vertices
-	int vertexTableOffset = fp->vertexTable;
+	int vertexTableOffset = fp.vertexTable;
 
-	for (int a = 0; a < fp->vertexTableSize; ++a) {
-		const int vertexDrawIdx = swabDWord(*(int*) &buf[vertexTableOffset]);
+	for (int a = 0; a < fp.vertexTableSize; ++a) {
+		const int vertexDrawIdx = swabDWord(*(const int*) &buf[vertexTableOffset]);
 
 		piece->vertexDrawOrder.push_back(vertexDrawIdx);
 		vertexTableOffset += sizeof(int);
@@ -122,10 +129,10 @@ SS3OPiece* CS3OParser::LoadPiece(S3DModel* model, SS3OPiece* parent, unsigned ch
 	piece->SetCollisionVolume(new CollisionVolume("box", cvScales, cvOffset * 0.5f, CollisionVolume::COLVOL_HITTEST_CONT));
 
 
-	int childTableOffset = fp->childs;
+	int childTableOffset = fp.childs;
 
-	for (int a = 0; a < fp->numChilds; ++a) {
-		int childOffset = swabDWord(*(int*) &buf[childTableOffset]);
+	for (int a = 0; a < fp.numChilds; ++a) {
+		int childOffset = swabDWord(*(const int*) &buf[childTableOffset]);
 
 		SS3OPiece* childPiece = LoadPiece(model, piece, buf, childOffset);
 		piece->childs.push_back(childPiece);
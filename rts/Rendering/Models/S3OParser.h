@@ -51,7 +51,7 @@ public:
 	S3DModel* Load(const std::string& name);
 
 private:
-	SS3OPiece* LoadPiece(S3DModel*, SS3OPiece*, unsigned char* buf, int offset);
+	SS3OPiece* LoadPiece(S3DModel*, SS3OPiece*, const unsigned char* buf, int offset);
 };
 
 #endif /* S3O_PARSER_H */
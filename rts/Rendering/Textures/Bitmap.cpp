@@ -204,14 +204,12 @@ bool CBitmap::Load(std::string const& filename, unsigned char defaultAlpha)
 	channels = 4;
 
 	CFileHandler file(filename);
-	if (file.FileExists() == false) {
+	CFileView view;
+	if (!file.GetView(view)) {
 		Alloc(1, 1);
 		return false;
 	}
 
-	unsigned char* buffer = new unsigned char[file.FileSize() + 2];
-	file.Read(buffer, file.FileSize());
-
 	boost::mutex::scoped_lock lck(devilMutex);
 	ilOriginFunc(IL_ORIGIN_UPPER_LEFT);
 	ilEnable(IL_ORIGIN_SET);
@@ -220,9 +218,9 @@ bool CBitmap::Load(std::string const& filename, unsigned char defaultAlpha)
 	ilGenImages(1, &ImageName);
 	ilBindImage(ImageName);
 
-	const bool success = !!ilLoadL(IL_TYPE_UNKNOWN, buffer, file.FileSize());
+	// DevIL only reads from the lump
+	const bool success = !!ilLoadL(IL_TYPE_UNKNOWN, const_cast<boost::uint8_t*>(view.GetData()), view.GetSize());
 	ilDisable(IL_ORIGIN_SET);
-	delete[] buffer;
 
 	if (success == false) {
 		xsize = 1;
@@ -264,13 +262,11 @@ bool CBitmap::LoadGrayscale(const std::string& filename)
 	channels = 1;
 
 	CFileHandler file(filename);
-	if (!file.FileExists()) {
+	CFileView view;
+	if (!file.GetView(view)) {
 		return false;
 	}
 
-	unsigned char* buffer = new unsigned char[file.FileSize() + 1];
-	file.Read(buffer, file.FileSize());
-
 	boost::mutex::scoped_lock lck(devilMutex);
 	ilOriginFunc(IL_ORIGIN_UPPER_LEFT);
 	ilEnable(IL_ORIGIN_SET);
@@ -279,9 +275,9 @@ bool CBitmap::LoadGrayscale(const std::string& filename)
 	ilGenImages(1, &ImageName);
 	ilBindImage(ImageName);
 
-	const bool success = !!ilLoadL(IL_TYPE_UNKNOWN, buffer, file.FileSize());
+	// DevIL only reads from the lump
+	const bool success = !!ilLoadL(IL_TYPE_UNKNOWN, const_cast<boost::uint8_t*>(view.GetData()), view.GetSize());
 	ilDisable(IL_ORIGIN_SET);
-	delete[] buffer;
 
 	if (success == false) {
 		return false;
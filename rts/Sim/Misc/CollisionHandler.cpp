@@ -17,12 +17,12 @@
 
 CR_BIND(CCollisionHandler, );
 
-unsigned int CCollisionHandler::numCollisionTests = 0;
-unsigned int CCollisionHandler::numIntersectionTests = 0;
-
-
-
 bool CCollisionHandler::DetectHit(const CUnit* u, const float3& p0, const float3& p1, CollisionQuery* q)
+{
+	return (CCollisionHandler::DetectHit(u, u->collisionVolume, p0, p1, q));
+}
+
+bool CCollisionHandler::DetectHit(const CUnit* u, const CollisionVolume* v, const float3& p0, const float3& p1, CollisionQuery* q)
 {
 	bool r = false;
 
@@ -31,11 +31,11 @@ bool CCollisionHandler::DetectHit(const CUnit* u, const float3& p0, const float3
 		return (CCollisionHandler::IntersectPieceTree(u, p0, p1, q));
 	}
 
-	if (!u->collisionVolume->IsDisabled()) {
-		switch (u->collisionVolume->GetTestType()) {
+	if (!v->IsDisabled()) {
+		switch (v->GetTestType()) {
 			// Collision(CUnit*) does not need p1 or q
-			case CollisionVolume::COLVOL_HITTEST_DISC: { r = CCollisionHandler::Collision(u, p0       ); numCollisionTests    += 1; } break;
-			case CollisionVolume::COLVOL_HITTEST_CONT: { r = CCollisionHandler::Intersect(u, p0, p1, q); numIntersectionTests += 1; } break;
+			case CollisionVolume::COLVOL_HITTEST_DISC: { r = CCollisionHandler::Collision(u, v, p0       ); } break;
+			case CollisionVolume::COLVOL_HITTEST_CONT: { r = CCollisionHandler::Intersect(u, v, p0, p1, q); } break;
 		}
 	}
 
@@ -49,8 +49,8 @@ bool CCollisionHandler::DetectHit(const CFeature* f, const float3& p0, const flo
 	if (!f->collisionVolume->IsDisabled()) {
 		switch (f->collisionVolume->GetTestType()) {
 			// Collision(CFeature*) does not need p1 or q
-			case CollisionVolume::COLVOL_HITTEST_DISC: { r = CCollisionHandler::Collision(f, p0       ); numCollisionTests    += 1; } break;
-			case CollisionVolume::COLVOL_HITTEST_CONT: { r = CCollisionHandler::Intersect(f, p0, p1, q); numIntersectionTests += 1; } break;
+			case CollisionVolume::COLVOL_HITTEST_DISC: { r = CCollisionHandler::Collision(f, p0       ); } break;
+			case CollisionVolume::COLVOL_HITTEST_CONT: { r = CCollisionHandler::Intersect(f, p0, p1, q); } break;
 		}
 	}
 
@@ -62,15 +62,13 @@ bool CCollisionHandler::DetectHit(const CFeature* f, const float3& p0, const flo
 
 
 
-bool CCollisionHandler::Collision(const CUnit* u, const float3& p)
+bool CCollisionHandler::Collision(const CUnit* u, const CollisionVolume* v, const float3& p)
 {
-	const CollisionVolume* v = u->collisionVolume;
-
 	if (((u->midPos + v->GetOffsets()) - p).SqLength() > v->GetBoundingRadiusSq()) {
 		return false;
 	}
 
-	switch (u->collisionVolume->GetVolumeType()) {
+	switch (v->GetVolumeType()) {
 		case CollisionVolume::COLVOL_TYPE_SPHERE: {
 			return true;
 		}
@@ -270,8 +268,11 @@ bool CCollisionHandler::IntersectPieceTree(const CUnit* u, const float3& p0, con
 
 bool CCollisionHandler::Intersect(const CUnit* u, const float3& p0, const float3& p1, CollisionQuery* q)
 {
-	const CollisionVolume* v = u->collisionVolume;
+	return (CCollisionHandler::Intersect(u, u->collisionVolume, p0, p1, q));
+}
 
+bool CCollisionHandler::Intersect(const CUnit* u, const CollisionVolume* v, const float3& p0, const float3& p1, CollisionQuery* q)
+{
 	CMatrix44f m = u->GetTransformMatrix(true);
 	m.Translate(u->relMidPos * float3(-1.0f, 1.0f, 1.0f));
 	m.Translate(v->GetOffsets());
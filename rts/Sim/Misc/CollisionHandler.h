@@ -46,13 +46,19 @@ class CCollisionHandler {
 
 		static bool DetectHit(const CUnit* u, const float3& p0, const float3& p1, CollisionQuery* q = NULL);
 		static bool DetectHit(const CFeature* f, const float3& p0, const float3& p1, CollisionQuery* q = NULL);
+		/**
+		 * Like DetectHit(CUnit*, ...), but tests against volume @c v instead
+		 * of the unit's own one (without modifying the unit, so it is safe
+		 * to call from several threads at once).
+		 */
+		static bool DetectHit(const CUnit* u, const CollisionVolume* v, const float3& p0, const float3& p1, CollisionQuery* q = NULL);
 		static bool MouseHit(const CUnit* u, const float3& p0, const float3& p1, const CollisionVolume* v, CollisionQuery* q);
 
 		static bool Intersect(const CUnit* u, const float3& p0, const float3& p1, CollisionQuery* q);
 		static bool Intersect(const CFeature* f, const float3& p0, const float3& p1, CollisionQuery* q);
 
 	private:
-		static bool Collision(const CUnit* u, const float3& p);
+		static bool Collision(const CUnit* u, const CollisionVolume* v, const float3& p);
 		static bool Collision(const CFeature* f, const float3& p);
 		/**
 		 * Test if a point lies inside a volume.
@@ -71,15 +77,13 @@ class CCollisionHandler {
 		 * @param p1 end of ray (in world-coords)
 		 */
 		static bool Intersect(const CollisionVolume* v, const CMatrix44f& m, const float3& p0, const float3& p1, CollisionQuery* q);
+		static bool Intersect(const CUnit* u, const CollisionVolume* v, const float3& p0, const float3& p1, CollisionQuery* q);
 		static bool IntersectPieceTree(const CUnit* u, const float3& p0, const float3& p1, CollisionQuery* q);
 		static void IntersectPieceTreeHelper(LocalModelPiece* lmp, CMatrix44f mat, const float3& p0, const float3& p1, std::list<CollisionQuery>* hits);
 
 		static bool IntersectEllipsoid(const CollisionVolume* v, const float3& pi0, const float3& pi1, CollisionQuery* q);
 		static bool IntersectCylinder(const CollisionVolume* v, const float3& pi0, const float3& pi1, CollisionQuery* q);
 		static bool IntersectBox(const CollisionVolume* v, const float3& pi0, const float3& pi1, CollisionQuery* q);
-
-		static unsigned int numCollisionTests;
-		static unsigned int numIntersectionTests;
 };
 
 #endif
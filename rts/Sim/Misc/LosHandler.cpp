@@ -3,6 +3,7 @@
 #include "System/mmgr.h"
 
 #include <list>
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
@@ -86,7 +87,8 @@ CLosHandler::CLosHandler() :
 	losSizeX(std::max(1, gs->mapx >> losMipLevel)),
 	losSizeY(std::max(1, gs->mapy >> losMipLevel)),
 	requireSonarUnderWater(modInfo.requireSonarUnderWater),
-	losAlgo(int2(losSizeX, losSizeY), -1e6f, 15, readmap->GetMIPHeightMapSynced(losMipLevel))
+	losAlgo(int2(losSizeX, losSizeY), -1e6f, 15, readmap->GetMIPHeightMapSynced(losMipLevel)),
+	batchLosUpdates(false)
 {
 	for (int a = 0; a < teamHandler->ActiveAllyTeams(); ++a) {
 		losMaps[a].SetSize(losSizeX, losSizeY);
@@ -190,9 +192,19 @@ void CLosHandler::LosAdd(LosInstance* instance)
 	assert(instance);
 	assert(teamHandler->IsValidAllyTeam(instance->allyteam));
 
-	losAlgo.LosAdd(instance->basePos, instance->losSize, instance->baseHeight, instance->losSquares);
+	if (batchLosUpdates && instance->losSize > 0) {
+		// ray-cast later, together with all other instances that
+		// get added before the batch is flushed (see EndLosUpdateBatch)
+		if (!instance->losQueued) {
+			instance->losQueued = true;
+			queuedUpdates.push_back(LosUpdate(instance, instance->allyteam, 0, 0));
+		}
+	} else {
+		losAlgo.LosAdd(instance->basePos, instance->losSize, instance->baseHeight, instance->losSquares);
+
+		if (instance->losSize > 0) { losMaps[instance->allyteam].AddMapSquares(instance->losSquares, instance->allyteam, 1); }
+	}
 
-	if (instance->losSize > 0) { losMaps[instance->allyteam].AddMapSquares(instance->losSquares, instance->allyteam, 1); }
 	if (instance->airLosSize > 0) { airLosMaps[instance->allyteam].AddMapArea(instance->baseAirPos, instance->allyteam, instance->airLosSize, 1); }
 }
 
@@ -269,11 +281,82 @@ void CLosHandler::AllocInstance(LosInstance* instance)
 
 void CLosHandler::CleanupInstance(LosInstance* instance)
 {
-	if (instance->losSize > 0) { losMaps[instance->allyteam].AddMapSquares(instance->losSquares, instance->allyteam, -1); }
+	if (instance->losQueued) {
+		// its squares were never added to the LOS map, just cancel the addition
+		std::vector<LosUpdate>::reverse_iterator it;
+		for (it = queuedUpdates.rbegin(); it != queuedUpdates.rend(); ++it) {
+			if (it->instance == instance) {
+				it->instance = NULL;
+				break;
+			}
+		}
+		instance->losQueued = false;
+	} else if (instance->losSize > 0) {
+		if (batchLosUpdates) {
+			// removed in order with the queued additions (see FlushLosUpdateBatch),
+			// so nothing sees the LOS of a moved unit vanish before its new one shows
+			queuedUpdates.push_back(LosUpdate(NULL, instance->allyteam, removedSquares.size(), instance->losSquares.size()));
+			removedSquares.insert(removedSquares.end(), instance->losSquares.begin(), instance->losSquares.end());
+		} else {
+			losMaps[instance->allyteam].AddMapSquares(instance->losSquares, instance->allyteam, -1);
+		}
+	}
+
 	if (instance->airLosSize > 0) { airLosMaps[instance->allyteam].AddMapArea(instance->baseAirPos, instance->allyteam, instance->airLosSize, -1); }
 }
 
 
+void CLosHandler::BeginLosUpdateBatch()
+{
+	assert(!batchLosUpdates);
+	batchLosUpdates = true;
+}
+
+
+void CLosHandler::EndLosUpdateBatch()
+{
+	FlushLosUpdateBatch();
+	batchLosUpdates = false;
+}
+
+
+void CLosHandler::FlushLosUpdateBatch()
+{
+	if (queuedUpdates.empty())
+		return;
+
+	SCOPED_TIMER("LOSHandler::FlushLosUpdateBatch");
+
+	std::vector<LosUpdate>::const_iterator it;
+
+	for (it = queuedUpdates.begin(); it != queuedUpdates.end(); ++it) {
+		if (it->instance != NULL) {
+			queuedInstances.push_back(it->instance);
+		}
+	}
+
+	// the ray-casts only read the (unchanged) heightmap and write to the
+	// instance's own squares, so they can run in any order and in parallel
+	losAlgo.LosAdd(queuedInstances);
+
+	// the LOS maps are updated in queue order, same as the serial path does
+	for (it = queuedUpdates.begin(); it != queuedUpdates.end(); ++it) {
+		LosInstance* instance = it->instance;
+
+		if (instance != NULL) {
+			instance->losQueued = false;
+			losMaps[it->allyteam].AddMapSquares(instance->losSquares, it->allyteam, 1);
+		} else if (it->numSquares > 0) {
+			losMaps[it->allyteam].AddMapSquares(&removedSquares[it->firstSquare], it->numSquares, it->allyteam, -1);
+		}
+	}
+
+	queuedUpdates.clear();
+	queuedInstances.clear();
+	removedSquares.clear();
+}
+
+
 void CLosHandler::Update(void)
 {
 	while (!delayQue.empty() && delayQue.front().timeoutTime < gs->frameNum) {
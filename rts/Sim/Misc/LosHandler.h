@@ -48,6 +48,7 @@ private:
 		, hashNum(-1)
 		, baseHeight(0.0f)
 		, toBeDeleted(false)
+		, losQueued(false)
 	{}
 
 public:
@@ -63,6 +64,7 @@ public:
 		, hashNum(hashNum)
 		, baseHeight(baseHeight)
 		, toBeDeleted(false)
+		, losQueued(false)
 	{}
 
  	std::vector<int> losSquares;
@@ -76,6 +78,8 @@ public:
 	int hashNum;
 	float baseHeight;
 	bool toBeDeleted;
+	/// true while the terrain ray-cast is pending in a LOS update batch
+	bool losQueued;
 };
 
 /**
@@ -98,6 +102,13 @@ public:
  * LOS is not removed immediately when a unit gets killed. Instead,
  * DelayedFreeInstance is called. This keeps the LosInstance (including the
  * actual sight) alive until 1.5 game seconds after the unit got killed.
+ *
+ * Between BeginLosUpdateBatch and EndLosUpdateBatch the ground LOS map
+ * changes (additions by LosAdd, removals by CleanupInstance) are queued. When
+ * the batch is flushed, the terrain ray-casts of all queued additions are done
+ * in parallel (CLosAlgorithm), then the additions and removals are applied in
+ * queue order. Until then the LOS maps still show the ground LOS from before
+ * the batch. Air LOS does not need a ray-cast and is always applied at once.
  */
 class CLosHandler : public boost::noncopyable
 {
@@ -109,6 +120,11 @@ public:
 	void MoveUnit(CUnit* unit, bool redoCurrent);
 	void FreeInstance(LosInstance* instance);
 
+	void BeginLosUpdateBatch();
+	void EndLosUpdateBatch();
+	/// ray-casts and applies the queued instances now (e.g. before the terrain changes)
+	void FlushLosUpdateBatch();
+
 	inline bool InLos(const CWorldObject* object, int allyTeam) const {
 		if (object->alwaysVisible || gs->globalLOS) {
 			return true;
@@ -209,6 +225,28 @@ private:
 
 	std::deque<DelayedInstance> delayQue;
 
+	/// ground LOS map change waiting for the end of a batch
+	struct LosUpdate {
+		LosUpdate(LosInstance* i, int a, int first, int num)
+			: instance(i), allyteam(a), firstSquare(first), numSquares(num) {}
+
+		/// to be ray-casted and added, NULL for removals and cancelled additions
+		LosInstance* instance;
+		int allyteam;
+		/// range of the squares to remove in removedSquares
+		int firstSquare;
+		int numSquares;
+	};
+
+	/// pending changes, in the order the serial path would have made them
+	std::vector<LosUpdate> queuedUpdates;
+	/// the squares of all queued removals, their instances may be reused
+	/// or deleted before the batch is flushed
+	std::vector<int> removedSquares;
+	/// the instances to ray-cast when flushing
+	std::vector<LosInstance*> queuedInstances;
+	bool batchLosUpdates;
+
 public:
 	void Update();
 	void DelayedFreeInstance(LosInstance* instance);
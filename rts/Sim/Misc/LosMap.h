@@ -21,7 +21,10 @@ public:
 	void AddMapArea(int2 pos, int allyteam, int radius, int amount);
 
 	/// arbitrary area, for losMap, non-circular radar maps, ...
-	void AddMapSquares(const std::vector<int>& squares, int allyteam, int amount);
+	void AddMapSquares(const int* squares, int numSquares, int allyteam, int amount);
+	void AddMapSquares(const std::vector<int>& squares, int allyteam, int amount) {
+		if (!squares.empty()) { AddMapSquares(&squares[0], squares.size(), allyteam, amount); }
+	}
 
 	int operator[] (int square) const { return map[square]; }
 
@@ -41,7 +44,10 @@ protected:
 };
 
 
-/// algorithm to calculate LOS squares using raycasting, taking terrain into account
+/**
+ * algorithm to calculate LOS squares using raycasting, taking terrain into account
+ * (implemented in LosAlgorithm.cpp)
+ */
 class CLosAlgorithm
 {
 public:
@@ -50,6 +56,24 @@ public:
 
 	void LosAdd(int2 pos, int radius, float baseHeight, std::vector<int>& squares);
 
+	/**
+	 * Batched form of LosAdd, ray-casts all given instances at once (in
+	 * parallel when built with OpenMP). Every instance only writes to its
+	 * own square list, so the result is identical to calling LosAdd for
+	 * each of them in turn.
+	 * T needs the members basePos, losSize, baseHeight and losSquares.
+	 */
+	template<typename T> void LosAdd(const std::vector<T*>& instances) {
+		const int numInstances = instances.size();
+
+		int n;
+		#pragma omp parallel for private(n) schedule(dynamic, 16)
+		for (n = 0; n < numInstances; ++n) {
+			T* i = instances[n];
+			LosAdd(i->basePos, i->losSize, i->baseHeight, i->losSquares);
+		}
+	}
+
 private:
 	void UnsafeLosAdd(int2 pos, int radius, float baseHeight, std::vector<int>& squares);
 	void SafeLosAdd(int2 pos, int radius, float baseHeight, std::vector<int>& squares);
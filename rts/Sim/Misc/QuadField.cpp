@@ -12,7 +12,7 @@
 #include "Sim/Projectiles/Projectile.h"
 #include "System/creg/STL_List.h"
 
-#define REMOVE_PROJECTILE_FAST
+#include <algorithm>
 
 CR_BIND(CQuadField, );
 CR_REG_METADATA(CQuadField, (
@@ -74,10 +74,17 @@ CQuadField::~CQuadField()
 
 
 std::vector<int> CQuadField::GetQuads(float3 pos, float radius) const
+{
+	std::vector<int> ret;
+	GetQuads(pos, radius, ret);
+	return ret;
+}
+
+void CQuadField::GetQuads(float3 pos, float radius, std::vector<int>& dst) const
 {
 	pos.CheckInBounds();
 
-	std::vector<int> ret;
+	dst.clear();
 
 	const int maxx = std::min(((int)(pos.x + radius)) / QUAD_SIZE + 1, numQuadsX - 1);
 	const int maxz = std::min(((int)(pos.z + radius)) / QUAD_SIZE + 1, numQuadsZ - 1);
@@ -86,20 +93,18 @@ std::vector<int> CQuadField::GetQuads(float3 pos, float radius) const
 	const int minz = std::max(((int)(pos.z - radius)) / QUAD_SIZE, 0);
 
 	if (maxz < minz || maxx < minx) {
-		return ret;
+		return;
 	}
 
 	const float maxSqLength = (radius + QUAD_SIZE * 0.72f) * (radius + QUAD_SIZE * 0.72f);
-	ret.reserve((maxz - minz) * (maxx - minx));
+	dst.reserve((maxz - minz + 1) * (maxx - minx + 1));
 	for (int z = minz; z <= maxz; ++z) {
 		for (int x = minx; x <= maxx; ++x) {
 			if ((pos - float3(x * QUAD_SIZE + QUAD_SIZE * 0.5f, 0, z * QUAD_SIZE + QUAD_SIZE * 0.5f)).SqLength2D() < maxSqLength) {
-				ret.push_back(z * numQuadsX + x);
+				dst.push_back(z * numQuadsX + x);
 			}
 		}
 	}
-
-	return ret;
 }
 
 
@@ -133,6 +138,13 @@ void CQuadField::GetQuads(float3 pos, float radius, int*& dst) const
 
 
 std::vector<CUnit*> CQuadField::GetUnits(const float3& pos, float radius)
+{
+	std::vector<CUnit*> units;
+	GetUnits(pos, radius, units);
+	return units;
+}
+
+void CQuadField::GetUnits(const float3& pos, float radius, std::vector<CUnit*>& dst)
 {
 	GML_RECMUTEX_LOCK(qnum); // GetUnits
 
@@ -141,8 +153,9 @@ std::vector<CUnit*> CQuadField::GetUnits(const float3& pos, float radius)
 	int* endQuad = tempQuads;
 	GetQuads(pos, radius, endQuad);
 
-	std::vector<CUnit*> units;
-	std::list<CUnit*>::iterator ui;
+	dst.clear();
+
+	UnitList::iterator ui;
 
 	for (int* a = tempQuads; a != endQuad; ++a) {
 		Quad& quad = baseQuads[*a];
@@ -151,60 +164,93 @@ std::vector<CUnit*> CQuadField::GetUnits(const float3& pos, float radius)
 			if ((*ui)->tempNum == tempNum) { continue; }
 
 			(*ui)->tempNum = tempNum;
-			units.push_back(*ui);
+			dst.push_back(*ui);
 		}
 	}
+}
 
+std::vector<CUnit*> CQuadField::GetUnitsExact(const float3& pos, float radius, bool spherical)
+{
+	std::vector<CUnit*> units;
+	GetUnitsExact(pos, radius, spherical, units);
 	return units;
 }
 
-std::vector<CUnit*> CQuadField::GetUnitsExact(const float3& pos, float radius, bool spherical)
+namespace {
+	// backs the buffer variants of the queries that also have a visitor one
+	struct UnitCollectVisitor: public CQuadField::UnitVisitor {
+		UnitCollectVisitor(std::vector<CUnit*>& dst): units(dst) {}
+		bool operator() (CUnit* unit) { units.push_back(unit); return true; }
+
+		std::vector<CUnit*>& units;
+	};
+	struct FeatureCollectVisitor: public CQuadField::FeatureVisitor {
+		FeatureCollectVisitor(std::vector<CFeature*>& dst): features(dst) {}
+		bool operator() (CFeature* feature) { features.push_back(feature); return true; }
+
+		std::vector<CFeature*>& features;
+	};
+	struct ProjectileCollectVisitor: public CQuadField::ProjectileVisitor {
+		ProjectileCollectVisitor(std::vector<CProjectile*>& dst): projectiles(dst) {}
+		bool operator() (CProjectile* projectile) { projectiles.push_back(projectile); return true; }
+
+		std::vector<CProjectile*>& projectiles;
+	};
+	struct SolidCollectVisitor: public CQuadField::SolidVisitor {
+		SolidCollectVisitor(std::vector<CSolidObject*>& dst): solids(dst) {}
+		bool operator() (CSolidObject* solid) { solids.push_back(solid); return true; }
+
+		std::vector<CSolidObject*>& solids;
+	};
+}
+
+void CQuadField::GetUnitsExact(const float3& pos, float radius, bool spherical, std::vector<CUnit*>& dst)
 {
-	GML_RECMUTEX_LOCK(qnum); // GetUnitsExact
+	UnitCollectVisitor visitor(dst);
+
+	dst.clear();
+	VisitUnitsExact(pos, radius, spherical, visitor);
+}
+
+void CQuadField::VisitUnitsExact(const float3& pos, float radius, bool spherical, UnitVisitor& visitor)
+{
+	GML_RECMUTEX_LOCK(qnum); // VisitUnitsExact
 
 	const int tempNum = gs->tempNum++;
 
 	int* endQuad = tempQuads;
 	GetQuads(pos, radius, endQuad);
 
-	std::vector<CUnit*> units;
-	std::list<CUnit*>::iterator ui;
-
-	for (int* a = tempQuads; a != endQuad; ++a) {
-		Quad& quad = baseQuads[*a];
-
-		for (ui = quad.units.begin(); ui != quad.units.end(); ++ui) {
-			if ((*ui)->tempNum == tempNum) { continue; }
-
-			const float totRad       = radius + (*ui)->radius;
-			const float totRadSq     = totRad * totRad;
-			const float posUnitDstSq = spherical?
-				(pos - (*ui)->midPos).SqLength():
-				(pos - (*ui)->midPos).SqLength2D();
+	QuadFieldStorage::VisitUnitsExact(baseQuads, tempQuads, endQuad, pos, radius, spherical, tempNum, visitor);
+}
 
-			if (posUnitDstSq >= totRadSq) { continue; }
+std::vector<CUnit*> CQuadField::GetUnitsExact(const float3& mins, const float3& maxs)
+{
+	std::vector<CUnit*> units;
+	GetUnitsExact(mins, maxs, units);
+	return units;
+}
 
-			(*ui)->tempNum = tempNum;
-			units.push_back(*ui);
-		}
-	}
+void CQuadField::GetUnitsExact(const float3& mins, const float3& maxs, std::vector<CUnit*>& dst)
+{
+	UnitCollectVisitor visitor(dst);
 
-	return units;
+	dst.clear();
+	VisitUnitsExact(mins, maxs, visitor);
 }
 
-std::vector<CUnit*> CQuadField::GetUnitsExact(const float3& mins, const float3& maxs)
+void CQuadField::VisitUnitsExact(const float3& mins, const float3& maxs, UnitVisitor& visitor)
 {
-	GML_RECMUTEX_LOCK(qnum); // GetUnitsExact
+	GML_RECMUTEX_LOCK(qnum); // VisitUnitsExact
 
-	const std::vector<int>& quads = GetQuadsRectangle(mins, maxs);
 	const int tempNum = gs->tempNum++;
 
-	std::vector<CUnit*> units;
-	std::vector<int>::const_iterator qi;
+	int* endQuad = tempQuads;
+	GetQuadsRectangle(mins, maxs, endQuad);
 
-	for (qi = quads.begin(); qi != quads.end(); ++qi) {
-		std::list<CUnit*>& quadUnits = baseQuads[*qi].units;
-		std::list<CUnit*>::iterator ui;
+	for (int* a = tempQuads; a != endQuad; ++a) {
+		UnitList& quadUnits = baseQuads[*a].units;
+		UnitList::iterator ui;
 
 		for (ui = quadUnits.begin(); ui != quadUnits.end(); ++ui) {
 			CUnit* unit = *ui;
@@ -213,23 +259,29 @@ std::vector<CUnit*> CQuadField::GetUnitsExact(const float3& mins, const float3&
 			if (unit->tempNum == tempNum) { continue; }
 			if (pos.x < mins.x || pos.x > maxs.x) { continue; }
 			if (pos.z < mins.z || pos.z > maxs.z) { continue; }
-			
+
 			unit->tempNum = tempNum;
-			units.push_back(unit);
+
+			if (!visitor(unit)) { return; }
 		}
 	}
-
-	return units;
 }
 
 
 
 std::vector<int> CQuadField::GetQuadsOnRay(const float3& start, float3 dir, float length)
+{
+	std::vector<int> ret;
+	GetQuadsOnRay(start, dir, length, ret);
+	return ret;
+}
+
+void CQuadField::GetQuadsOnRay(const float3& start, const float3& dir, float length, std::vector<int>& dst)
 {
 	int* end = tempQuads;
 	GetQuadsOnRay(start, dir, length, end);
 
-	return std::vector<int>(tempQuads, end);
+	dst.assign(tempQuads, end);
 }
 
 void CQuadField::GetQuadsOnRay(float3 start, float3 dir, float length, int*& dst)
@@ -375,69 +427,26 @@ void CQuadField::GetQuadsOnRay(float3 start, float3 dir, float length, int*& dst
 
 void CQuadField::MovedUnit(CUnit* unit)
 {
-	const std::vector<int>& newQuads = GetQuads(unit->pos,unit->radius);
+	// NOTE: only called from the sim-thread, so this buffer
+	// does not need to be protected like tempQuads (qnum)
+	std::vector<int>& newQuads = tempMovedQuads;
+	GetQuads(unit->pos, unit->radius, newQuads);
 
 	//! compare if the quads have changed, if not stop here
-	if (newQuads.size() == unit->quads.size()) {
-		std::vector<int>::const_iterator qi1, qi2;
-		qi1 = unit->quads.begin();
-		for (qi2 = newQuads.begin(); qi2 != newQuads.end(); ++qi2) {
-			if (*qi1 != *qi2) {
-				break;
-			}
-			++qi1;
-		}
-		if (qi2 == newQuads.end()) {
-			return;
-		}
+	if (newQuads == unit->quads) {
+		return;
 	}
 
 	GML_RECMUTEX_LOCK(quad); // MovedUnit - possible performance hog
 
-	std::vector<int>::const_iterator qi;
-	for (qi = unit->quads.begin(); qi != unit->quads.end(); ++qi) {
-		std::list<CUnit*>::iterator ui;
-		for (ui = baseQuads[*qi].units.begin(); ui != baseQuads[*qi].units.end(); ++ui) {
-			if (*ui == unit) {
-				baseQuads[*qi].units.erase(ui);
-				break;
-			}
-		}
-		for (ui = baseQuads[*qi].teamUnits[unit->allyteam].begin(); ui != baseQuads[*qi].teamUnits[unit->allyteam].end(); ++ui) {
-			if (*ui == unit) {
-				baseQuads[*qi].teamUnits[unit->allyteam].erase(ui);
-				break;
-			}
-		}
-	}
-	for (qi = newQuads.begin(); qi != newQuads.end(); ++qi) {
-		baseQuads[*qi].units.push_front(unit);
-		baseQuads[*qi].teamUnits[unit->allyteam].push_front(unit);
-	}
-	unit->quads = newQuads;
+	QuadFieldStorage::MoveUnit(baseQuads, unit, newQuads);
 }
 
 void CQuadField::RemoveUnit(CUnit* unit)
 {
 	GML_RECMUTEX_LOCK(quad); // RemoveUnit
 
-	std::vector<int>::const_iterator qi;
-	for (qi = unit->quads.begin(); qi != unit->quads.end(); ++qi) {
-		std::list<CUnit*>::iterator ui;
-		for (ui = baseQuads[*qi].units.begin(); ui != baseQuads[*qi].units.end(); ++ui) {
-			if (*ui == unit) {
-				baseQuads[*qi].units.erase(ui);
-				break;
-			}
-		}
-		for (ui = baseQuads[*qi].teamUnits[unit->allyteam].begin(); ui != baseQuads[*qi].teamUnits[unit->allyteam].end(); ++ui) {
-			if (*ui == unit) {
-				baseQuads[*qi].teamUnits[unit->allyteam].erase(ui);
-				break;
-			}
-		}
-	}
-	unit->quads.clear();
+	QuadFieldStorage::RemoveUnit(baseQuads, unit);
 }
 
 
@@ -446,11 +455,12 @@ void CQuadField::AddFeature(CFeature* feature)
 {
 	GML_RECMUTEX_LOCK(quad); // AddFeature
 
-	const std::vector<int>& newQuads = GetQuads(feature->pos, feature->radius);
+	std::vector<int>& newQuads = tempMovedQuads;
+	GetQuads(feature->pos, feature->radius, newQuads);
 
 	std::vector<int>::const_iterator qi;
 	for (qi = newQuads.begin(); qi != newQuads.end(); ++qi) {
-		baseQuads[*qi].features.push_front(feature);
+		QuadFieldStorage::Insert(baseQuads[*qi].features, feature);
 	}
 }
 
@@ -458,11 +468,12 @@ void CQuadField::RemoveFeature(CFeature* feature)
 {
 	GML_RECMUTEX_LOCK(quad); // RemoveFeature
 
-	const std::vector<int>& quads = GetQuads(feature->pos, feature->radius);
+	std::vector<int>& quads = tempMovedQuads;
+	GetQuads(feature->pos, feature->radius, quads);
 
 	std::vector<int>::const_iterator qi;
 	for (qi = quads.begin(); qi != quads.end(); ++qi) {
-		baseQuads[*qi].features.remove(feature);
+		QuadFieldStorage::Remove(baseQuads[*qi].features, feature);
 	}
 }
 
@@ -497,10 +508,10 @@ void CQuadField::AddProjectile(CProjectile* p)
 	GML_RECMUTEX_LOCK(quad);
 
 	Quad& q = baseQuads[numQuadsX * cellCoors.y + cellCoors.x];
-	std::list<CProjectile*>& projectiles = q.projectiles;
 
 	p->SetQuadFieldCellCoors(cellCoors);
-	p->SetQuadFieldCellIter(projectiles.insert(projectiles.end(), p));
+
+	QuadFieldStorage::AddProjectile(q.projectiles, p);
 }
 
 void CQuadField::RemoveProjectile(CProjectile* p)
@@ -514,71 +525,82 @@ void CQuadField::RemoveProjectile(CProjectile* p)
 
 	Quad& q = baseQuads[cellIdx];
 
-	std::list<CProjectile*>& projectiles = q.projectiles;
-	std::list<CProjectile*>::iterator pi = p->GetQuadFieldCellIter();
-
-	#ifdef REMOVE_PROJECTILE_FAST
-	if (pi != projectiles.end()) {
-		// this is O(1) instead of O(n) and crucially
-		// important for projectiles, but less clean
-		projectiles.erase(pi);
-	} else {
+	if (!QuadFieldStorage::RemoveProjectile(q.projectiles, p)) {
 		assert(false);
 	}
-	#else
-	for (pi = projectiles.begin(); pi != projectiles.end(); ++pi) {
-		if ((*pi) == p) {
-			projectiles.erase(pi);
-			break;
-		}
-	}
-	#endif
-
-	p->SetQuadFieldCellIter(projectiles.end());
 }
 
 
 
 std::vector<CFeature*> CQuadField::GetFeaturesExact(const float3& pos, float radius)
 {
-	GML_RECMUTEX_LOCK(qnum); // GetFeaturesExact
+	std::vector<CFeature*> features;
+	GetFeaturesExact(pos, radius, features);
+	return features;
+}
+
+void CQuadField::GetFeaturesExact(const float3& pos, float radius, std::vector<CFeature*>& dst)
+{
+	FeatureCollectVisitor visitor(dst);
+
+	dst.clear();
+	VisitFeaturesExact(pos, radius, visitor);
+}
+
+void CQuadField::VisitFeaturesExact(const float3& pos, float radius, FeatureVisitor& visitor)
+{
+	GML_RECMUTEX_LOCK(qnum); // VisitFeaturesExact
 
-	const std::vector<int>& quads = GetQuads(pos, radius);
 	const int tempNum = gs->tempNum++;
 
-	std::vector<CFeature*> features;
-	std::vector<int>::const_iterator qi;
-	std::list<CFeature*>::iterator fi;
+	int* endQuad = tempQuads;
+	GetQuads(pos, radius, endQuad);
 
-	for (qi = quads.begin(); qi != quads.end(); ++qi) {
-		for (fi = baseQuads[*qi].features.begin(); fi != baseQuads[*qi].features.end(); ++fi) {
+	FeatureList::iterator fi;
+
+	for (int* a = tempQuads; a != endQuad; ++a) {
+		for (fi = baseQuads[*a].features.begin(); fi != baseQuads[*a].features.end(); ++fi) {
 			const float totRad = radius + (*fi)->radius;
 
 			if ((*fi)->tempNum == tempNum) { continue; }
 			if ((pos - (*fi)->midPos).SqLength() >= (totRad * totRad)) { continue; }
 
 			(*fi)->tempNum = tempNum;
-			features.push_back(*fi);
+
+			if (!visitor(*fi)) { return; }
 		}
 	}
+}
 
+std::vector<CFeature*> CQuadField::GetFeaturesExact(const float3& pos, float radius, bool spherical)
+{
+	std::vector<CFeature*> features;
+	GetFeaturesExact(pos, radius, spherical, features);
 	return features;
 }
 
-std::vector<CFeature*> CQuadField::GetFeaturesExact(const float3& pos, float radius, bool spherical)
+void CQuadField::GetFeaturesExact(const float3& pos, float radius, bool spherical, std::vector<CFeature*>& dst)
 {
-	GML_RECMUTEX_LOCK(qnum); // GetFeaturesExact
+	FeatureCollectVisitor visitor(dst);
+
+	dst.clear();
+	VisitFeaturesExact(pos, radius, spherical, visitor);
+}
+
+void CQuadField::VisitFeaturesExact(const float3& pos, float radius, bool spherical, FeatureVisitor& visitor)
+{
+	GML_RECMUTEX_LOCK(qnum); // VisitFeaturesExact
 
-	const std::vector<int>& quads = GetQuads(pos, radius);
 	const int tempNum = gs->tempNum++;
 
-	std::vector<CFeature*> features;
-	std::vector<int>::const_iterator qi;
-	std::list<CFeature*>::iterator fi;
+	int* endQuad = tempQuads;
+	GetQuads(pos, radius, endQuad);
+
+	FeatureList::iterator fi;
 	const float totRadSq = radius * radius;
 
-	for (qi = quads.begin(); qi != quads.end(); ++qi) {
-		for (fi = baseQuads[*qi].features.begin(); fi != baseQuads[*qi].features.end(); ++fi) {
+	for (int* a = tempQuads; a != endQuad; ++a) {
+		for (fi = baseQuads[*a].features.begin(); fi != baseQuads[*a].features.end(); ++fi) {
 
 			if ((*fi)->tempNum == tempNum) { continue; }
 			if ((spherical ?
@@ -586,26 +608,40 @@ std::vector<CFeature*> CQuadField::GetFeaturesExact(const float3& pos, float rad
 				(pos - (*fi)->midPos).SqLength2D()) >= totRadSq) { continue; }
 
 			(*fi)->tempNum = tempNum;
-			features.push_back(*fi);
+
+			if (!visitor(*fi)) { return; }
 		}
 	}
+}
 
+std::vector<CFeature*> CQuadField::GetFeaturesExact(const float3& mins, const float3& maxs)
+{
+	std::vector<CFeature*> features;
+	GetFeaturesExact(mins, maxs, features);
 	return features;
 }
 
-std::vector<CFeature*> CQuadField::GetFeaturesExact(const float3& mins, const float3& maxs)
+void CQuadField::GetFeaturesExact(const float3& mins, const float3& maxs, std::vector<CFeature*>& dst)
 {
-	GML_RECMUTEX_LOCK(qnum); // GetFeaturesExact
+	FeatureCollectVisitor visitor(dst);
+
+	dst.clear();
+	VisitFeaturesExact(mins, maxs, visitor);
+}
+
+void CQuadField::VisitFeaturesExact(const float3& mins, const float3& maxs, FeatureVisitor& visitor)
+{
+	GML_RECMUTEX_LOCK(qnum); // VisitFeaturesExact
 
-	const std::vector<int>& quads = GetQuadsRectangle(mins, maxs);
 	const int tempNum = gs->tempNum++;
 
-	std::vector<CFeature*> features;
-	std::vector<int>::const_iterator qi;
-	std::list<CFeature*>::iterator fi;
+	int* endQuad = tempQuads;
+	GetQuadsRectangle(mins, maxs, endQuad);
 
-	for (qi = quads.begin(); qi != quads.end(); ++qi) {
-		std::list<CFeature*>& quadFeatures = baseQuads[*qi].features;
+	FeatureList::iterator fi;
+
+	for (int* a = tempQuads; a != endQuad; ++a) {
+		FeatureList& quadFeatures = baseQuads[*a].features;
 
 		for (fi = quadFeatures.begin(); fi != quadFeatures.end(); ++fi) {
 			CFeature* feature = *fi;
@@ -616,54 +652,65 @@ std::vector<CFeature*> CQuadField::GetFeaturesExact(const float3& mins, const fl
 			if (pos.z < mins.z || pos.z > maxs.z) { continue; }
 
 			feature->tempNum = tempNum;
-			features.push_back(feature);
+
+			if (!visitor(feature)) { return; }
 		}
 	}
-
-	return features;
 }
 
 
 
 std::vector<CProjectile*> CQuadField::GetProjectilesExact(const float3& pos, float radius)
 {
-	GML_RECMUTEX_LOCK(qnum);
-
-	const std::vector<int>& quads = GetQuads(pos, radius);
-
 	std::vector<CProjectile*> projectiles;
-	std::vector<int>::const_iterator qi;
-	std::list<CProjectile*>::iterator pi;
+	GetProjectilesExact(pos, radius, projectiles);
+	return projectiles;
+}
 
-	for (qi = quads.begin(); qi != quads.end(); ++qi) {
-		std::list<CProjectile*>& quadProjectiles = baseQuads[*qi].projectiles;
+void CQuadField::GetProjectilesExact(const float3& pos, float radius, std::vector<CProjectile*>& dst)
+{
+	ProjectileCollectVisitor visitor(dst);
 
-		for (pi = quadProjectiles.begin(); pi != quadProjectiles.end(); ++pi) {
-			const float totRad = radius + (*pi)->radius;
+	dst.clear();
+	VisitProjectilesExact(pos, radius, visitor);
+}
 
-			if ((pos - (*pi)->pos).SqLength() >= (totRad * totRad)) {
-				continue;
-			}
+void CQuadField::VisitProjectilesExact(const float3& pos, float radius, ProjectileVisitor& visitor)
+{
+	GML_RECMUTEX_LOCK(qnum); // VisitProjectilesExact
 
-			projectiles.push_back(*pi);
-		}
-	}
+	int* endQuad = tempQuads;
+	GetQuads(pos, radius, endQuad);
 
-	return projectiles;
+	QuadFieldStorage::VisitProjectilesExact(baseQuads, tempQuads, endQuad, pos, radius, visitor);
 }
 
 std::vector<CProjectile*> CQuadField::GetProjectilesExact(const float3& mins, const float3& maxs)
 {
-	GML_RECMUTEX_LOCK(qnum);
+	std::vector<CProjectile*> projectiles;
+	GetProjectilesExact(mins, maxs, projectiles);
+	return projectiles;
+}
 
-	const std::vector<int>& quads = GetQuadsRectangle(mins, maxs);
+void CQuadField::GetProjectilesExact(const float3& mins, const float3& maxs, std::vector<CProjectile*>& dst)
+{
+	ProjectileCollectVisitor visitor(dst);
 
-	std::vector<CProjectile*> projectiles;
-	std::vector<int>::const_iterator qi;
-	std::list<CProjectile*>::iterator pi;
+	dst.clear();
+	VisitProjectilesExact(mins, maxs, visitor);
+}
 
-	for (qi = quads.begin(); qi != quads.end(); ++qi) {
-		std::list<CProjectile*>& quadProjectiles = baseQuads[*qi].projectiles;
+void CQuadField::VisitProjectilesExact(const float3& mins, const float3& maxs, ProjectileVisitor& visitor)
+{
+	GML_RECMUTEX_LOCK(qnum); // VisitProjectilesExact
+
+	int* endQuad = tempQuads;
+	GetQuadsRectangle(mins, maxs, endQuad);
+
+	ProjectileList::iterator pi;
+
+	for (int* a = tempQuads; a != endQuad; ++a) {
+		ProjectileList& quadProjectiles = baseQuads[*a].projectiles;
 
 		for (pi = quadProjectiles.begin(); pi != quadProjectiles.end(); ++pi) {
 			CProjectile* projectile = *pi;
@@ -672,28 +719,44 @@ std::vector<CProjectile*> CQuadField::GetProjectilesExact(const float3& mins, co
 			if (pos.x < mins.x || pos.x > maxs.x) { continue; }
 			if (pos.z < mins.z || pos.z > maxs.z) { continue; }
 
-			projectiles.push_back(projectile);
+			if (!visitor(projectile)) { return; }
 		}
 	}
-
-	return projectiles;
 }
 
 
 
 std::vector<CSolidObject*> CQuadField::GetSolidsExact(const float3& pos, float radius)
 {
-	GML_RECMUTEX_LOCK(qnum); // GetSolidsExact
+	std::vector<CSolidObject*> solids;
+	GetSolidsExact(pos, radius, solids);
+	return solids;
+}
+
+void CQuadField::GetSolidsExact(const float3& pos, float radius, std::vector<CSolidObject*>& dst)
+{
+	SolidCollectVisitor visitor(dst);
+
+	dst.clear();
+	VisitSolidsExact(pos, radius, visitor);
+}
+
+void CQuadField::VisitSolidsExact(const float3& pos, float radius, SolidVisitor& visitor)
+{
+	GML_RECMUTEX_LOCK(qnum); // VisitSolidsExact
 
-	const std::vector<int>& quads = GetQuads(pos, radius);
 	const int tempNum = gs->tempNum++;
 
-	std::vector<CSolidObject*> solids;
-	std::vector<int>::const_iterator qi;
-	std::list<CUnit*>::iterator ui;
+	int* endQuad = tempQuads;
+	GetQuads(pos, radius, endQuad);
 
-	for (qi = quads.begin(); qi != quads.end(); ++qi) {
-		for (ui = baseQuads[*qi].units.begin(); ui != baseQuads[*qi].units.end(); ++ui) {
+	UnitList::iterator ui;
+	FeatureList::iterator fi;
+
+	for (int* a = tempQuads; a != endQuad; ++a) {
+		Quad& quad = baseQuads[*a];
+
+		for (ui = quad.units.begin(); ui != quad.units.end(); ++ui) {
 			const float totRad = radius + (*ui)->radius;
 
 			if (!(*ui)->blocking) { continue; }
@@ -701,11 +764,11 @@ std::vector<CSolidObject*> CQuadField::GetSolidsExact(const float3& pos, float r
 			if ((pos - (*ui)->midPos).SqLength() >= (totRad * totRad)) { continue; }
 
 			(*ui)->tempNum = tempNum;
-			solids.push_back(*ui);
+
+			if (!visitor(*ui)) { return; }
 		}
 
-		std::list<CFeature*>::iterator fi;
-		for (fi = baseQuads[*qi].features.begin(); fi != baseQuads[*qi].features.end(); ++fi) {
+		for (fi = quad.features.begin(); fi != quad.features.end(); ++fi) {
 			const float totRad = radius + (*fi)->radius;
 
 			if (!(*fi)->blocking) { continue; }
@@ -713,18 +776,62 @@ std::vector<CSolidObject*> CQuadField::GetSolidsExact(const float3& pos, float r
 			if ((pos - (*fi)->midPos).SqLength() >= (totRad * totRad)) { continue; }
 
 			(*fi)->tempNum = tempNum;
-			solids.push_back(*fi);
+
+			if (!visitor(*fi)) { return; }
 		}
 	}
+}
 
-	return solids;
+void CQuadField::GetSolidsExactThreadSafe(const float3& pos, float radius, std::vector<CSolidObject*>& dst, std::vector<int>& quads) const
+{
+	GetQuads(pos, radius, quads);
+
+	dst.clear();
+
+	UnitList::const_iterator ui;
+	FeatureList::const_iterator fi;
+
+	for (std::vector<int>::const_iterator a = quads.begin(); a != quads.end(); ++a) {
+		const Quad& quad = baseQuads[*a];
+
+		// objects can be in more than one of the quads, keep only the
+		// first occurrence (which is the one GetSolidsExact would take)
+		const size_t numPrevSolids = dst.size();
+
+		for (ui = quad.units.begin(); ui != quad.units.end(); ++ui) {
+			const float totRad = radius + (*ui)->radius;
+
+			if (!(*ui)->blocking) { continue; }
+			if ((pos - (*ui)->midPos).SqLength() >= (totRad * totRad)) { continue; }
+			if ((*ui)->quads.size() > 1 && std::find(dst.begin(), dst.begin() + numPrevSolids, *ui) != dst.begin() + numPrevSolids) { continue; }
+
+			dst.push_back(*ui);
+		}
+
+		for (fi = quad.features.begin(); fi != quad.features.end(); ++fi) {
+			const float totRad = radius + (*fi)->radius;
+
+			if (!(*fi)->blocking) { continue; }
+			if ((pos - (*fi)->midPos).SqLength() >= (totRad * totRad)) { continue; }
+			if (std::find(dst.begin(), dst.begin() + numPrevSolids, *fi) != dst.begin() + numPrevSolids) { continue; }
+
+			dst.push_back(*fi);
+		}
+	}
 }
 
 
 
-std::vector<int> CQuadField::GetQuadsRectangle(const float3& pos,const float3& pos2) const
+std::vector<int> CQuadField::GetQuadsRectangle(const float3& pos, const float3& pos2) const
 {
 	std::vector<int> ret;
+	GetQuadsRectangle(pos, pos2, ret);
+	return ret;
+}
+
+void CQuadField::GetQuadsRectangle(const float3& pos, const float3& pos2, std::vector<int>& dst) const
+{
+	dst.clear();
 
 	const int maxx = std::max(0, std::min(((int)(pos2.x)) / QUAD_SIZE + 1, numQuadsX - 1));
 	const int maxz = std::max(0, std::min(((int)(pos2.z)) / QUAD_SIZE + 1, numQuadsZ - 1));
@@ -733,16 +840,33 @@ std::vector<int> CQuadField::GetQuadsRectangle(const float3& pos,const float3& p
 	const int minz = std::max(0, std::min(((int)(pos.z)) / QUAD_SIZE, numQuadsZ - 1));
 
 	if (maxz < minz || maxx < minx)
-		return ret;
+		return;
 
-	ret.reserve((maxz - minz) * (maxx - minx));
+	dst.reserve((maxz - minz + 1) * (maxx - minx + 1));
 	for (int z = minz; z <= maxz; ++z) {
 		for (int x = minx; x <= maxx; ++x) {
-			ret.push_back(z * numQuadsX + x);
+			dst.push_back(z * numQuadsX + x);
 		}
 	}
+}
 
-	return ret;
+void CQuadField::GetQuadsRectangle(const float3& pos, const float3& pos2, int*& dst) const
+{
+	const int maxx = std::max(0, std::min(((int)(pos2.x)) / QUAD_SIZE + 1, numQuadsX - 1));
+	const int maxz = std::max(0, std::min(((int)(pos2.z)) / QUAD_SIZE + 1, numQuadsZ - 1));
+
+	const int minx = std::max(0, std::min(((int)(pos.x)) / QUAD_SIZE, numQuadsX - 1));
+	const int minz = std::max(0, std::min(((int)(pos.z)) / QUAD_SIZE, numQuadsZ - 1));
+
+	if (maxz < minz || maxx < minx)
+		return;
+
+	for (int z = minz; z <= maxz; ++z) {
+		for (int x = minx; x <= maxx; ++x) {
+			*dst = z * numQuadsX + x;
+			++dst;
+		}
+	}
 }
 
 
@@ -757,8 +881,8 @@ void CQuadField::GetUnitsAndFeaturesExact(const float3& pos, float radius, CUnit
 	int* endQuad = tempQuads;
 	GetQuads(pos, radius, endQuad);
 
-	std::list<CUnit*>::iterator ui;
-	std::list<CFeature*>::iterator fi;
+	UnitList::iterator ui;
+	FeatureList::iterator fi;
 
 	for (int* a = tempQuads; a != endQuad; ++a) {
 		Quad& quad = baseQuads[*a];
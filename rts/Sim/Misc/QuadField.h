@@ -8,6 +8,7 @@
 #include <list>
 #include <boost/noncopyable.hpp>
 
+#include "QuadFieldStorage.h"
 #include "System/creg/creg_cond.h"
 #include "System/float3.h"
 
@@ -24,6 +25,10 @@ class CQuadField : boost::noncopyable
 	const static int QUAD_SIZE = 256;
 
 public:
+	typedef QuadFieldStorage::Container<CUnit>::type UnitList;
+	typedef QuadFieldStorage::Container<CFeature>::type FeatureList;
+	typedef QuadFieldStorage::Container<CProjectile>::type ProjectileList;
+
 	CQuadField();
 	~CQuadField();
 
@@ -33,6 +38,7 @@ public:
 
 	// optimized functions, somewhat less userfriendly
 	void GetQuads(float3 pos, float radius, int*& dst) const;
+	void GetQuadsRectangle(const float3& pos, const float3& pos2, int*& dst) const;
 	void GetQuadsOnRay(float3 start, float3 dir, float length, int*& dst);
 	void GetUnitsAndFeaturesExact(const float3& pos, float radius, CUnit**& dstUnit, CFeature**& dstFeature);
 
@@ -74,6 +80,78 @@ public:
 
 	std::vector<CSolidObject*> GetSolidsExact(const float3& pos, float radius);
 
+	/**
+	 * @name buffer variants
+	 * Same as the queries above, but these clear @c dst and fill it
+	 * instead of returning a new vector; callers that keep @c dst around
+	 * (as a member or static) do not allocate once it has grown large
+	 * enough.
+	 */
+	//@{
+	void GetQuads(float3 pos, float radius, std::vector<int>& dst) const;
+	void GetQuadsRectangle(const float3& pos, const float3& pos2, std::vector<int>& dst) const;
+	void GetQuadsOnRay(const float3& start, const float3& dir, float length, std::vector<int>& dst);
+
+	void GetUnits(const float3& pos, float radius, std::vector<CUnit*>& dst);
+	void GetUnitsExact(const float3& pos, float radius, bool spherical, std::vector<CUnit*>& dst);
+	void GetUnitsExact(const float3& mins, const float3& maxs, std::vector<CUnit*>& dst);
+
+	void GetFeaturesExact(const float3& pos, float radius, std::vector<CFeature*>& dst);
+	void GetFeaturesExact(const float3& pos, float radius, bool spherical, std::vector<CFeature*>& dst);
+	void GetFeaturesExact(const float3& mins, const float3& maxs, std::vector<CFeature*>& dst);
+
+	void GetProjectilesExact(const float3& pos, float radius, std::vector<CProjectile*>& dst);
+	void GetProjectilesExact(const float3& mins, const float3& maxs, std::vector<CProjectile*>& dst);
+
+	void GetSolidsExact(const float3& pos, float radius, std::vector<CSolidObject*>& dst);
+	//@}
+
+	/**
+	 * @name visitor variants
+	 * Call the visitor for each object the matching Get*Exact query
+	 * would return, in the same order, without collecting them anywhere;
+	 * returning false from the visitor ends the query early. A visitor
+	 * must not run other queries or add, move or remove objects.
+	 */
+	//@{
+	struct UnitVisitor {
+		virtual ~UnitVisitor() {}
+		virtual bool operator() (CUnit* unit) = 0;
+	};
+	struct FeatureVisitor {
+		virtual ~FeatureVisitor() {}
+		virtual bool operator() (CFeature* feature) = 0;
+	};
+	struct ProjectileVisitor {
+		virtual ~ProjectileVisitor() {}
+		virtual bool operator() (CProjectile* projectile) = 0;
+	};
+	struct SolidVisitor {
+		virtual ~SolidVisitor() {}
+		virtual bool operator() (CSolidObject* solid) = 0;
+	};
+
+	void VisitUnitsExact(const float3& pos, float radius, bool spherical, UnitVisitor& visitor);
+	void VisitUnitsExact(const float3& mins, const float3& maxs, UnitVisitor& visitor);
+
+	void VisitFeaturesExact(const float3& pos, float radius, FeatureVisitor& visitor);
+	void VisitFeaturesExact(const float3& pos, float radius, bool spherical, FeatureVisitor& visitor);
+	void VisitFeaturesExact(const float3& mins, const float3& maxs, FeatureVisitor& visitor);
+
+	void VisitProjectilesExact(const float3& pos, float radius, ProjectileVisitor& visitor);
+	void VisitProjectilesExact(const float3& mins, const float3& maxs, ProjectileVisitor& visitor);
+
+	void VisitSolidsExact(const float3& pos, float radius, SolidVisitor& visitor);
+	//@}
+
+	/**
+	 * Same result (and order) as GetSolidsExact, but does not mark the
+	 * visited objects with gs->tempNum, so several threads can run it at
+	 * once while nothing is added, moved or removed.
+	 * @param quads scratch buffer for the overlapped quads
+	 */
+	void GetSolidsExactThreadSafe(const float3& pos, float radius, std::vector<CSolidObject*>& dst, std::vector<int>& quads) const;
+
 	void MovedUnit(CUnit* unit);
 	void RemoveUnit(CUnit* unit);
 
@@ -87,10 +165,10 @@ public:
 	struct Quad {
 		CR_DECLARE_STRUCT(Quad);
 		Quad();
-		std::list<CUnit*> units;
-		std::vector< std::list<CUnit*> > teamUnits;
-		std::list<CFeature*> features;
-		std::list<CProjectile*> projectiles;
+		UnitList units;
+		std::vector<UnitList> teamUnits;
+		FeatureList features;
+		ProjectileList projectiles;
 	};
 
 	const Quad& GetQuad(int i) const {
@@ -111,6 +189,7 @@ private:
 	int numQuadsX;
 	int numQuadsZ;
 	int* tempQuads;
+	std::vector<int> tempMovedQuads;
 };
 
 extern CQuadField* qf;
@@ -0,0 +1,213 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef QUAD_FIELD_STORAGE_H
+#define QUAD_FIELD_STORAGE_H
+
+#include <algorithm>
+#include <list>
+#include <vector>
+#include <cassert>
+
+#include "System/float3.h"
+
+/**
+ * Per-quad object containers used by CQuadField.
+ *
+ * By default every quad keeps its objects in contiguous arrays, so the
+ * *Exact queries walk linear memory instead of chasing list nodes across
+ * the heap. Removal swaps the last element into the freed slot, which makes
+ * the iteration order depend on the insert/remove history (but it is still
+ * the same on every client, so this is sync-safe).
+ *
+ * Define QUADFIELD_LIST_STORAGE to get the old std::list layout back,
+ * e.g. for comparing against it.
+ *
+ * The functions below the containers are what CQuadField does with them,
+ * for any quad type that has the same members as CQuadField::Quad (which
+ * is what test_QuadFieldStorage runs both layouts through).
+ */
+namespace QuadFieldStorage {
+	template<typename T> struct List  { typedef std::list<T*>   type; };
+	template<typename T> struct Array { typedef std::vector<T*> type; };
+
+#ifdef QUADFIELD_LIST_STORAGE
+	template<typename T> struct Container: public List<T> {};
+#else
+	template<typename T> struct Container: public Array<T> {};
+#endif
+
+
+	template<typename T> inline void Insert(std::list<T*>& c, T* o) { c.push_front(o); }
+	template<typename T> inline void Insert(std::vector<T*>& c, T* o) { c.push_back(o); }
+
+	/// removes the first occurrence of @c o, returns false if not found
+	template<typename T> inline bool Remove(std::list<T*>& c, T* o) {
+		typename std::list<T*>::iterator it = std::find(c.begin(), c.end(), o);
+
+		if (it == c.end())
+			return false;
+
+		c.erase(it);
+		return true;
+	}
+
+	/// removes the first occurrence of @c o, returns false if not found
+	template<typename T> inline bool Remove(std::vector<T*>& c, T* o) {
+		typename std::vector<T*>::iterator it = std::find(c.begin(), c.end(), o);
+
+		if (it == c.end())
+			return false;
+
+		*it = c.back();
+		c.pop_back();
+		return true;
+	}
+
+	/**
+	 * Swap-removes the element in slot @c idx (for objects that track
+	 * their own slot index).
+	 * @return the element that was moved into slot @c idx, or NULL if
+	 *   the removed element was the last one
+	 */
+	template<typename T> inline T* RemoveAt(std::vector<T*>& c, unsigned int idx) {
+		assert(idx < c.size());
+
+		T* moved = c.back();
+		c.pop_back();
+
+		if (idx == c.size())
+			return NULL;
+
+		c[idx] = moved;
+		return moved;
+	}
+
+
+
+	/**
+	 * Moves unit @c u from the quads it is in (u->quads) to @c newQuads,
+	 * in the per-quad and in the per-quad-and-allyteam containers.
+	 */
+	template<typename Quad, typename T>
+	inline void MoveUnit(std::vector<Quad>& quads, T* u, const std::vector<int>& newQuads) {
+		std::vector<int>::const_iterator qi;
+
+		for (qi = u->quads.begin(); qi != u->quads.end(); ++qi) {
+			Remove(quads[*qi].units, u);
+			Remove(quads[*qi].teamUnits[u->allyteam], u);
+		}
+		for (qi = newQuads.begin(); qi != newQuads.end(); ++qi) {
+			Insert(quads[*qi].units, u);
+			Insert(quads[*qi].teamUnits[u->allyteam], u);
+		}
+
+		u->quads = newQuads;
+	}
+
+	template<typename Quad, typename T>
+	inline void RemoveUnit(std::vector<Quad>& quads, T* u) {
+		MoveUnit(quads, u, std::vector<int>());
+	}
+
+
+	/// projectiles remember their slot, see RemoveProjectile
+	template<typename C, typename T>
+	inline void AddProjectile(C& c, T* p) {
+		p->SetQuadFieldCellIdx(c.size());
+		Insert(c, p);
+	}
+
+	/// returns false if @c p was not in @c c
+	template<typename T>
+	inline bool RemoveProjectile(std::list<T*>& c, T* p) {
+		p->SetQuadFieldCellIdx(-1);
+		return Remove(c, p);
+	}
+
+	/// O(1) instead of O(n) (crucially important given their number and churn)
+	template<typename T>
+	inline bool RemoveProjectile(std::vector<T*>& c, T* p) {
+		const int slotIdx = p->GetQuadFieldCellIdx();
+
+		p->SetQuadFieldCellIdx(-1);
+
+		if (slotIdx < 0 || slotIdx >= c.size() || c[slotIdx] != p)
+			return false;
+
+		T* moved = RemoveAt(c, slotIdx);
+
+		if (moved != NULL)
+			moved->SetQuadFieldCellIdx(slotIdx);
+
+		return true;
+	}
+
+
+	template<typename C, typename Visitor>
+	inline bool VisitUnitsExact(C& units, const float3& pos, float radius, bool spherical, int tempNum, Visitor& visitor) {
+		for (typename C::iterator ui = units.begin(); ui != units.end(); ++ui) {
+			if ((*ui)->tempNum == tempNum) { continue; }
+
+			const float totRad       = radius + (*ui)->radius;
+			const float totRadSq     = totRad * totRad;
+			const float posUnitDstSq = spherical?
+				(pos - (*ui)->midPos).SqLength():
+				(pos - (*ui)->midPos).SqLength2D();
+
+			if (posUnitDstSq >= totRadSq) { continue; }
+
+			(*ui)->tempNum = tempNum;
+
+			if (!visitor(*ui)) { return false; }
+		}
+
+		return true;
+	}
+
+	/**
+	 * Calls @c visitor for the units in the quads [@c begin, @c end) that
+	 * touch the sphere (or cylinder) of @c radius around @c pos, each unit
+	 * once (those in several of the quads are marked with @c tempNum).
+	 * Stops when the visitor returns false.
+	 */
+	template<typename Quad, typename Visitor>
+	inline void VisitUnitsExact(std::vector<Quad>& quads, const int* begin, const int* end, const float3& pos, float radius, bool spherical, int tempNum, Visitor& visitor) {
+		for (const int* a = begin; a != end; ++a) {
+			if (!VisitUnitsExact(quads[*a].units, pos, radius, spherical, tempNum, visitor)) {
+				return;
+			}
+		}
+	}
+
+
+	template<typename C, typename Visitor>
+	inline bool VisitProjectilesExact(C& projectiles, const float3& pos, float radius, Visitor& visitor) {
+		for (typename C::iterator pi = projectiles.begin(); pi != projectiles.end(); ++pi) {
+			const float totRad = radius + (*pi)->radius;
+
+			if ((pos - (*pi)->pos).SqLength() >= (totRad * totRad)) {
+				continue;
+			}
+
+			if (!visitor(*pi)) { return false; }
+		}
+
+		return true;
+	}
+
+	/**
+	 * Calls @c visitor for the projectiles in the quads [@c begin, @c end)
+	 * within @c radius of @c pos (a projectile is only ever in one quad).
+	 * Stops when the visitor returns false.
+	 */
+	template<typename Quad, typename Visitor>
+	inline void VisitProjectilesExact(std::vector<Quad>& quads, const int* begin, const int* end, const float3& pos, float radius, Visitor& visitor) {
+		for (const int* a = begin; a != end; ++a) {
+			if (!VisitProjectilesExact(quads[*a].projectiles, pos, radius, visitor)) {
+				return;
+			}
+		}
+	}
+}
+
+#endif /* QUAD_FIELD_STORAGE_H */
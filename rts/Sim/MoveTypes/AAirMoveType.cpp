@@ -116,7 +116,10 @@ void AAirMoveType::CheckForCollision()
 	const SyncedFloat3& forward = owner->frontdir;
 
 	const float3 midTestPos = pos + forward * 121.0f;
-	const std::vector<CUnit*>& others = qf->GetUnitsExact(midTestPos, 115.0f);
+
+	// reused by all aircraft, the loops below do not query the quadfield
+	static std::vector<CUnit*> others;
+	qf->GetUnitsExact(midTestPos, 115.0f, true, others);
 
 	float dist = 200.0f;
 
@@ -117,6 +117,12 @@ CR_REG_METADATA(CGroundMoveType, (
 
 std::vector<int2> CGroundMoveType::lineTable[LINETABLE_SIZE][LINETABLE_SIZE];
 
+// reused by the quadfield queries of all ground units (none
+// of the functions that use them can recurse into another)
+static std::vector<CUnit*> nearUnits;
+static std::vector<CFeature*> nearFeatures;
+static std::vector<CSolidObject*> nearSolids;
+
 CGroundMoveType::CGroundMoveType(CUnit* owner):
 	AMoveType(owner),
 
@@ -163,7 +169,13 @@ CGroundMoveType::CGroundMoveType(CUnit* owner):
 	numIdlingSlowUpdates(0),
 
 	lastAvoid(ZeroVector),
-	wantedHeading(0)
+	wantedHeading(0),
+
+	plannedAvoidFrame(-1),
+	plannedAvoidDir(ZeroVector),
+	plannedAvoidPos(ZeroVector),
+	plannedAvoidSpeed(ZeroVector),
+	plannedAvoidVec(ZeroVector)
 {
 	assert(owner != NULL);
 
@@ -186,6 +198,35 @@ void CGroundMoveType::PostLoad()
 	}
 }
 
+void CGroundMoveType::UpdatePlan()
+{
+	// only the obstacle avoidance is planned ahead, and only
+	// when Update is going to run it this frame (see there)
+	if (owner->transporter != NULL) { return; }
+	if (skidding || owner->falling) { return; }
+	if (owner->stunned || owner->beingBuilt) { return; }
+	if (owner->fpsControlPlayer != NULL) { return; }
+	if (pathId == 0) { return; }
+	if (gs->frameNum < nextObstacleAvoidanceUpdate) { return; }
+
+	// runs in parallel with the plans of other units, so no
+	// shared buffers and no tempNum-marking quadfield query
+	std::vector<CSolidObject*> solids;
+	std::vector<int> quads;
+
+	float3 desiredDir = waypoint - owner->pos;
+	desiredDir.y = 0.0f;
+	desiredDir.SafeNormalize();
+
+	qf->GetSolidsExactThreadSafe(owner->pos, GetObstacleAvoidanceRadius(), solids, quads);
+
+	plannedAvoidFrame = gs->frameNum;
+	plannedAvoidDir = desiredDir;
+	plannedAvoidPos = owner->pos;
+	plannedAvoidSpeed = owner->speed;
+	plannedAvoidVec = GetObstacleAvoidanceVec(desiredDir, solids);
+}
+
 bool CGroundMoveType::Update()
 {
 	ASSERT_SYNCED(owner->pos);
@@ -770,8 +811,8 @@ void CGroundMoveType::CheckCollisionSkid()
 	SyncedFloat3& midPos = owner->midPos;
 
 	const UnitDef* ownerUD = owner->unitDef;
-	const vector<CUnit*>& nearUnits = qf->GetUnitsExact(midPos, owner->radius);
-	const vector<CFeature*>& nearFeatures = qf->GetFeaturesExact(midPos, owner->radius);
+	qf->GetUnitsExact(midPos, owner->radius, true, nearUnits);
+	qf->GetFeaturesExact(midPos, owner->radius, nearFeatures);
 
 	vector<CUnit*>::const_iterator ui;
 	vector<CFeature*>::const_iterator fi;
@@ -913,10 +954,13 @@ void CGroundMoveType::CalcSkidRot()
  * Dynamic obstacle avoidance, helps the unit to
  * follow the path even when it's not perfect.
  */
-float3 CGroundMoveType::ObstacleAvoidance(const float3& desiredDir) {
-	// multiplier for how strongly an object should be avoided
-	static const float AVOIDANCE_STRENGTH = 2000.0f;
+static bool SameVector(const float3& a, const float3& b)
+{
+	// exact comparison, float3::operator== has a tolerance
+	return (a.x == b.x && a.y == b.y && a.z == b.z);
+}
 
+float3 CGroundMoveType::ObstacleAvoidance(const float3& desiredDir) {
 	// NOTE: based on the requirement that all objects have symetrical footprints.
 	// If this is false, then radius has to be calculated in a different way!
 
@@ -930,83 +974,20 @@ float3 CGroundMoveType::ObstacleAvoidance(const float3& desiredDir) {
 			lastAvoid = desiredDir;
 			nextObstacleAvoidanceUpdate = gs->frameNum + 4;
 
-			// now we do the obstacle avoidance proper
-			const float currentDistanceToGoal = owner->pos.distance2D(goalPos);
-			const float currentDistanceToGoalSq = currentDistanceToGoal * currentDistanceToGoal;
-			const float3 rightOfPath = desiredDir.cross(float3(0.0f, 1.0f, 0.0f));
-			const float speedf = owner->speed.Length2D();
-
-			float avoidLeft = 0.0f;
-			float avoidRight = 0.0f;
-
-			MoveData* moveData = owner->mobility;
-			CMoveMath* moveMath = moveData->moveMath;
-			moveData->tempOwner = owner;
+			const bool usePlan =
+				(plannedAvoidFrame == gs->frameNum) &&
+				SameVector(plannedAvoidDir, desiredDir) &&
+				SameVector(plannedAvoidPos, owner->pos) &&
+				SameVector(plannedAvoidSpeed, owner->speed);
 
-			const vector<CSolidObject*> &nearbyObjects = qf->GetSolidsExact(owner->pos, speedf * 35 + 30 + owner->xsize / 2);
-
-			for (vector<CSolidObject*>::const_iterator oi = nearbyObjects.begin(); oi != nearbyObjects.end(); ++oi) {
-				CSolidObject* o = *oi;
-
-				if (moveMath->IsNonBlocking(*moveData, o)) {
-					// no need to avoid this obstacle
-					continue;
-				}
-
-				// basic blocking-check (test if the obstacle cannot be overrun), also includes objects that are slightly behind us
-				if (o != owner && moveMath->CrushResistant(*moveData, o) && desiredDir.dot(o->pos - owner->pos) + 0.25f > 0) {
-					float3 objectToUnit = (owner->pos - o->pos - o->speed * 30);
-					float distanceToObjectSq = objectToUnit.SqLength();
-					float radiusSum = (owner->xsize + o->xsize) * SQUARE_SIZE / 2;
-					float distanceLimit = speedf * 35 + 10 + radiusSum;
-					float distanceLimitSq = distanceLimit * distanceLimit;
-
-					// if object is close enough
-					if (distanceToObjectSq < distanceLimitSq && distanceToObjectSq < currentDistanceToGoalSq
-							&& distanceToObjectSq > 1.0f) {
-						// Don't divide by zero. (TODO: figure out why this can
-						// actually happen.) Positive value means "to the right".
-						float objectDistToAvoidDirCenter = objectToUnit.dot(rightOfPath);
-
-						// If object and unit in relative motion are closing in on one another
-						// (or not yet fully apart), then the object is on the path of the unit
-						// and they are not collided.
-						if (objectToUnit.dot(avoidanceDir) < radiusSum &&
-							math::fabs(objectDistToAvoidDirCenter) < radiusSum &&
-							(o->mobility || Distance2D(owner, o, SQUARE_SIZE) >= 0)) {
-
-							// Avoid collision by turning the heading to left or right.
-							// Using the object thats needs the most adjustment.
-
-							#if (DEBUG_OUTPUT == 1)
-							GML_RECMUTEX_LOCK(sel); // ObstacleAvoidance
-
-							if (selectedUnits.selectedUnits.find(owner) != selectedUnits.selectedUnits.end())
-								geometricObjects->AddLine(owner->pos + UpVector * 20, o->pos + UpVector * 20, 3, 1, 4);
-							#endif
-
-							const float iSqrtObjDist = math::isqrt2(distanceToObjectSq);
-							if (objectDistToAvoidDirCenter > 0.0f) {
-								avoidRight +=
-									(radiusSum - objectDistToAvoidDirCenter) *
-									AVOIDANCE_STRENGTH * iSqrtObjDist * iSqrtObjDist * iSqrtObjDist;
-							} else {
-								avoidLeft +=
-									(radiusSum - math::fabs(objectDistToAvoidDirCenter)) *
-									AVOIDANCE_STRENGTH * iSqrtObjDist * iSqrtObjDist * iSqrtObjDist;
-							}
-						}
-					}
-
-				}
+			if (usePlan) {
+				// UpdatePlan already did the work (with the same input)
+				avoidanceVec = plannedAvoidVec;
+			} else {
+				qf->GetSolidsExact(owner->pos, GetObstacleAvoidanceRadius(), nearSolids);
+				avoidanceVec = GetObstacleAvoidanceVec(desiredDir, nearSolids);
 			}
 
-			moveData->tempOwner = NULL;
-
-
-			// Sum up avoidance.
-			avoidanceVec = (desiredDir.cross(UpVector) * (avoidRight - avoidLeft));
-
 			#if (DEBUG_OUTPUT == 1)
 			GML_RECMUTEX_LOCK(sel); //ObstacleAvoidance
 
@@ -1038,6 +1019,89 @@ float3 CGroundMoveType::ObstacleAvoidance(const float3& desiredDir) {
 	}
 }
 
+float CGroundMoveType::GetObstacleAvoidanceRadius() const
+{
+	return (owner->speed.Length2D() * 35 + 30 + owner->xsize / 2);
+}
+
+/*
+ * Sums up how strongly the owner should steer away from the blocking
+ * objects in <solids> when it wants to move along <desiredDir>.
+ * Reads only, so it can be called from UpdatePlan.
+ */
+float3 CGroundMoveType::GetObstacleAvoidanceVec(const float3& desiredDir, const std::vector<CSolidObject*>& solids)
+{
+	// multiplier for how strongly an object should be avoided
+	static const float AVOIDANCE_STRENGTH = 2000.0f;
+
+	const float currentDistanceToGoal = owner->pos.distance2D(goalPos);
+	const float currentDistanceToGoalSq = currentDistanceToGoal * currentDistanceToGoal;
+	const float3 rightOfPath = desiredDir.cross(float3(0.0f, 1.0f, 0.0f));
+	const float speedf = owner->speed.Length2D();
+
+	float avoidLeft = 0.0f;
+	float avoidRight = 0.0f;
+
+	// note: owner->mobility is the owner's own copy, so
+	// setting tempOwner does not affect any other unit
+	MoveData* moveData = owner->mobility;
+	CMoveMath* moveMath = moveData->moveMath;
+	moveData->tempOwner = owner;
+
+	for (vector<CSolidObject*>::const_iterator oi = solids.begin(); oi != solids.end(); ++oi) {
+		CSolidObject* o = *oi;
+
+		if (moveMath->IsNonBlocking(*moveData, o)) {
+			// no need to avoid this obstacle
+			continue;
+		}
+
+		// basic blocking-check (test if the obstacle cannot be overrun), also includes objects that are slightly behind us
+		if (o != owner && moveMath->CrushResistant(*moveData, o) && desiredDir.dot(o->pos - owner->pos) + 0.25f > 0) {
+			float3 objectToUnit = (owner->pos - o->pos - o->speed * 30);
+			float distanceToObjectSq = objectToUnit.SqLength();
+			float radiusSum = (owner->xsize + o->xsize) * SQUARE_SIZE / 2;
+			float distanceLimit = speedf * 35 + 10 + radiusSum;
+			float distanceLimitSq = distanceLimit * distanceLimit;
+
+			// if object is close enough
+			if (distanceToObjectSq < distanceLimitSq && distanceToObjectSq < currentDistanceToGoalSq
+					&& distanceToObjectSq > 1.0f) {
+				// Don't divide by zero. (TODO: figure out why this can
+				// actually happen.) Positive value means "to the right".
+				float objectDistToAvoidDirCenter = objectToUnit.dot(rightOfPath);
+
+				// If object and unit in relative motion are closing in on one another
+				// (or not yet fully apart), then the object is on the path of the unit
+				// and they are not collided.
+				if (objectToUnit.dot(desiredDir) < radiusSum &&
+					math::fabs(objectDistToAvoidDirCenter) < radiusSum &&
+					(o->mobility || Distance2D(owner, o, SQUARE_SIZE) >= 0)) {
+
+					// Avoid collision by turning the heading to left or right.
+					// Using the object thats needs the most adjustment.
+					const float iSqrtObjDist = math::isqrt2(distanceToObjectSq);
+					if (objectDistToAvoidDirCenter > 0.0f) {
+						avoidRight +=
+							(radiusSum - objectDistToAvoidDirCenter) *
+							AVOIDANCE_STRENGTH * iSqrtObjDist * iSqrtObjDist * iSqrtObjDist;
+					} else {
+						avoidLeft +=
+							(radiusSum - math::fabs(objectDistToAvoidDirCenter)) *
+							AVOIDANCE_STRENGTH * iSqrtObjDist * iSqrtObjDist * iSqrtObjDist;
+					}
+				}
+			}
+
+		}
+	}
+
+	moveData->tempOwner = NULL;
+
+	// Sum up avoidance.
+	return (desiredDir.cross(UpVector) * (avoidRight - avoidLeft));
+}
+
 
 // Calculates an aproximation of the physical 2D-distance between given two objects.
 float CGroundMoveType::Distance2D(CSolidObject* object1, CSolidObject* object2, float marginal)
@@ -1291,8 +1355,8 @@ void CGroundMoveType::HandleObjectCollisions()
 			FOOTPRINT_RADIUS(colliderMD->xsize, colliderMD->zsize):
 			FOOTPRINT_RADIUS(colliderUD->xsize, colliderUD->zsize);
 
-		const std::vector<CUnit*>& nearUnits = qf->GetUnitsExact(colliderCurPos, colliderRadius * 2.0f);
-		const std::vector<CFeature*>& nearFeatures = qf->GetFeaturesExact(colliderCurPos, colliderRadius * 2.0f);
+		qf->GetUnitsExact(colliderCurPos, colliderRadius * 2.0f, true, nearUnits);
+		qf->GetFeaturesExact(colliderCurPos, colliderRadius * 2.0f, nearFeatures);
 
 		std::vector<CUnit*>::const_iterator uit;
 		std::vector<CFeature*>::const_iterator fit;
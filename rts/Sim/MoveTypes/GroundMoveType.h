@@ -18,6 +18,7 @@ public:
 
 	void PostLoad();
 
+	void UpdatePlan();
 	bool Update();
 	void SlowUpdate();
 
@@ -68,6 +69,8 @@ public:
 
 protected:
 	float3 ObstacleAvoidance(const float3& desiredDir);
+	float3 GetObstacleAvoidanceVec(const float3& desiredDir, const std::vector<CSolidObject*>& solids);
+	float GetObstacleAvoidanceRadius() const;
 	float Distance2D(CSolidObject* object1, CSolidObject* object2, float marginal = 0.0f);
 
 	void GetNewPath();
@@ -139,6 +142,14 @@ protected:
 
 	float3 lastAvoid;
 	short wantedHeading;
+
+	/// frame in which UpdatePlan computed the members below (not saved)
+	int plannedAvoidFrame;
+	/// input UpdatePlan computed the avoidance vector for
+	float3 plannedAvoidDir;
+	float3 plannedAvoidPos;
+	float3 plannedAvoidSpeed;
+	float3 plannedAvoidVec;
 };
 
 #endif // GROUNDMOVETYPE_H
@@ -959,7 +959,9 @@ bool CHoverAirMoveType::HandleCollisions()
 			(aircraftState != AIRCRAFT_TAKEOFF);
 
 		if (checkCollisions) {
-			const vector<CUnit*>& nearUnits = qf->GetUnitsExact(pos, owner->radius + 6);
+			// reused by all aircraft, the loop below does not query the quadfield
+			static vector<CUnit*> nearUnits;
+			qf->GetUnitsExact(pos, owner->radius + 6, true, nearUnits);
 
 			for (vector<CUnit*>::const_iterator ui = nearUnits.begin(); ui != nearUnits.end(); ++ui) {
 				CUnit* unit = *ui;
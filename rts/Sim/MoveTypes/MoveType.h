@@ -31,6 +31,14 @@ public:
 	virtual void SetWantedMaxSpeed(float speed);
 	virtual void LeaveTransport() {}
 
+	/**
+	 * Optional read-only part of Update, called for all active units
+	 * (possibly in parallel) before any of them runs Update in the same
+	 * frame. It must not change any state except the move-type's own
+	 * bookkeeping of what it planned, which Update may use if its input
+	 * did not change in the meantime.
+	 */
+	virtual void UpdatePlan() {}
 	virtual bool Update() = 0;
 	virtual void SlowUpdate();
 
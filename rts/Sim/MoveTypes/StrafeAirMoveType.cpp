@@ -266,7 +266,10 @@ bool CStrafeAirMoveType::HandleCollisions() {
 
 		if (checkCollisions) {
 			bool hitBuilding = false;
-			const vector<CUnit*>& nearUnits = qf->GetUnitsExact(pos, owner->radius + 6);
+			// reused by all aircraft; DoDamage below can kill units, but
+			// their explosions do not run this function again
+			static vector<CUnit*> nearUnits;
+			qf->GetUnitsExact(pos, owner->radius + 6, true, nearUnits);
 
 			for (vector<CUnit*>::const_iterator ui = nearUnits.begin(); ui != nearUnits.end(); ++ui) {
 				CUnit* unit = *ui;
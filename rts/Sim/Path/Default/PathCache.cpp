@@ -1,6 +1,9 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include "System/mmgr.h"
 
 #include "PathCache.h"
@@ -8,76 +11,181 @@
 #include "Sim/Misc/GlobalSynced.h"
 #include "System/Log/ILog.h"
 
-using namespace std;
-
-CPathCache::CPathCache(int blocksX,int blocksZ)
-: blocksX(blocksX),
-	blocksZ(blocksZ)
+static const unsigned int MAX_CACHE_ITEMS = 512;
+static const int CACHE_ITEM_LIFETIME = 200;
+
+// the requested goal block is tried first, then its neighbors
+// (the order matters for sync, see GetCachedPath)
+static const int2 GOAL_BLOCK_OFFSETS[] = {
+	int2( 0,  0),
+	int2( 1,  0), int2(-1,  0), int2( 0,  1), int2( 0, -1),
+	int2( 1,  1), int2(-1,  1), int2( 1, -1), int2(-1, -1),
+};
+static const int NUM_GOAL_BLOCK_OFFSETS = sizeof(GOAL_BLOCK_OFFSETS) / sizeof(GOAL_BLOCK_OFFSETS[0]);
+
+// the memory footprint is readable by synced Lua, so it is counted with
+// fixed sizes (those of a 64-bit build) instead of the sizeof's of this one
+static const unsigned int ITEM_MEM_SIZE = 152; // item, list node and bucket entry
+static const unsigned int PATH_POINT_MEM_SIZE = 12; // float3
+static const unsigned int PATH_SQUARE_MEM_SIZE = 8; // int2
+
+
+CPathCache::CPathCache(int blocksX, int blocksZ)
+	: blocksX(blocksX)
+	, blocksZ(blocksZ)
+	, numCacheHits(0)
+	, numCacheMisses(0)
+	, numItems(0)
+	, memFootPrint(0)
 {
-	numCacheHits=0;
-	numCacheMisses=0;
 }
 
-CPathCache::~CPathCache(void)
+CPathCache::~CPathCache()
 {
-	LOG("Path cache hits %i %.0f%%",
+	LOG("Path cache hits %u %.0f%%",
 			numCacheHits, ((numCacheHits + numCacheMisses) != 0)
 			? (float(numCacheHits) / float(numCacheHits + numCacheMisses) * 100.0f)
 			: 0.0f);
-	for(std::map<unsigned int,CacheItem*>::iterator ci=cachedPaths.begin();ci!=cachedPaths.end();++ci)
-		delete ci->second;
 }
 
-void CPathCache::AddPath(IPath::Path* path, IPath::SearchResult result, int2 startBlock,int2 goalBlock,float goalRadius,int pathType)
+
+unsigned int CPathCache::GetBucketHash(int2 goalBlock, float goalRadius, int pathType) const
+{
+	unsigned int radiusBits = 0;
+	std::memcpy(&radiusBits, &goalRadius, sizeof(float));
+
+	return ((goalBlock.y * blocksX + goalBlock.x) * 31 + pathType) ^ (radiusBits * 2654435761u);
+}
+
+unsigned int CPathCache::GetItemMemFootPrint(const CacheItem& item)
+{
+	return (ITEM_MEM_SIZE +
+		item.path.path.size() * PATH_POINT_MEM_SIZE +
+		item.path.squares.size() * PATH_SQUARE_MEM_SIZE);
+}
+
+
+void CPathCache::AddPath(IPath::Path* path, IPath::SearchResult result, int2 startBlock, int2 goalBlock, float goalRadius, int pathType)
 {
-	if(cacheQue.size()>100)
-		RemoveFrontQueItem();
+	const unsigned int hash = GetBucketHash(goalBlock, goalRadius, pathType);
+	const CacheBucketMap::const_iterator bmi = buckets.find(hash);
 
-	unsigned int hash=(unsigned int)(((((goalBlock.y)*blocksX+goalBlock.x)*blocksZ+startBlock.y)*blocksX)+startBlock.x*(pathType+1)*max(1.0f,goalRadius));
+	if (bmi != buckets.end()) {
+		const CacheBucket& bucket = bmi->second;
 
-	if(cachedPaths.find(hash)!=cachedPaths.end()){
-		return;
+		for (CacheBucket::const_iterator bi = bucket.begin(); bi != bucket.end(); ++bi) {
+			const CacheItem& ci = **bi;
+
+			if (ci.startBlock.x == startBlock.x && ci.startBlock.y == startBlock.y && ci.goalBlock.x == goalBlock.x && ci.goalBlock.y == goalBlock.y && ci.goalRadius == goalRadius && ci.pathType == pathType) {
+				return;
+			}
+		}
 	}
 
-	CacheItem* ci=new CacheItem;
-	ci->path=*path;
-	ci->result=result;
-	ci->startBlock=startBlock;
-	ci->goalBlock=goalBlock;
-	ci->goalRadius=goalRadius;
-	ci->pathType=pathType;
+	if (numItems >= MAX_CACHE_ITEMS)
+		RemoveItem(--cachedItems.end());
+
+	cachedItems.push_front(CacheItem());
 
-	cachedPaths[hash]=ci;
+	CacheItem& ci = cachedItems.front();
+	ci.path = *path;
+	ci.result = result;
+	ci.startBlock = startBlock;
+	ci.goalBlock = goalBlock;
+	ci.goalRadius = goalRadius;
+	ci.pathType = pathType;
+	ci.timeout = gs->frameNum + CACHE_ITEM_LIFETIME;
 
-	CacheQue cq;
-	cq.hash=hash;
-	cq.timeout=gs->frameNum+200;
+	// looked up again, the eviction above may have erased the bucket
+	buckets[hash].push_back(cachedItems.begin());
 
-	cacheQue.push_back(cq);
+	numItems += 1;
+	memFootPrint += GetItemMemFootPrint(ci);
 }
 
-CPathCache::CacheItem* CPathCache::GetCachedPath(int2 startBlock,int2 goalBlock,float goalRadius,int pathType)
+CPathCache::CacheItem* CPathCache::GetCachedPath(int2 startBlock, int2 goalBlock, float goalRadius, int pathType)
 {
-	unsigned int hash=(unsigned int)(((((goalBlock.y)*blocksX+goalBlock.x)*blocksZ+startBlock.y)*blocksX)+startBlock.x*(pathType+1)*max(1.0f,goalRadius));
+	CacheItemList::iterator bestItem = cachedItems.end();
+	int bestDist = 3;
+
+	// find the closest match (start-block distance plus goal-block distance,
+	// at most one block each); candidates are visited in a fixed order and
+	// only strictly closer ones replace the current best
+	for (int n = 0; n < NUM_GOAL_BLOCK_OFFSETS && bestDist > 0; n++) {
+		const int2 gb(goalBlock.x + GOAL_BLOCK_OFFSETS[n].x, goalBlock.y + GOAL_BLOCK_OFFSETS[n].y);
+		const int goalDist = (n == 0)? 0: 1;
+
+		if (goalDist >= bestDist)
+			break;
+
+		const CacheBucketMap::const_iterator bmi = buckets.find(GetBucketHash(gb, goalRadius, pathType));
+
+		if (bmi == buckets.end())
+			continue;
 
-	std::map<unsigned int,CacheItem*>::iterator ci=cachedPaths.find(hash);
-	if(ci!=cachedPaths.end() && ci->second->startBlock.x==startBlock.x && ci->second->startBlock.y==startBlock.y && ci->second->goalBlock.x==goalBlock.x && ci->second->pathType==pathType){
-		++numCacheHits;
-		return ci->second;
+		const CacheBucket& bucket = bmi->second;
+
+		for (CacheBucket::const_iterator bi = bucket.begin(); bi != bucket.end(); ++bi) {
+			const CacheItem& ci = **bi;
+
+			if (ci.goalBlock.x != gb.x || ci.goalBlock.y != gb.y || ci.goalRadius != goalRadius || ci.pathType != pathType)
+				continue;
+			if (ci.timeout < gs->frameNum)
+				continue;
+
+			const int startDist = std::max(std::abs(ci.startBlock.x - startBlock.x), std::abs(ci.startBlock.y - startBlock.y));
+
+			if (startDist > 1)
+				continue;
+
+			if ((startDist + goalDist) < bestDist) {
+				bestDist = startDist + goalDist;
+				bestItem = *bi;
+			}
+		}
+	}
+
+	if (bestItem == cachedItems.end()) {
+		++numCacheMisses;
+		return NULL;
 	}
-	++numCacheMisses;
-	return 0;
+
+	// mark as most recently used
+	cachedItems.splice(cachedItems.begin(), cachedItems, bestItem);
+
+	++numCacheHits;
+	return &(*bestItem);
 }
 
-void CPathCache::Update(void)
+void CPathCache::Update()
 {
-	while(!cacheQue.empty() && cacheQue.front().timeout<gs->frameNum)
-		RemoveFrontQueItem();
+	// items that are used keep moving to the front, so the stale
+	// ones end up at the back (those that do not are skipped by
+	// GetCachedPath until they get there)
+	while (!cachedItems.empty() && cachedItems.back().timeout < gs->frameNum)
+		RemoveItem(--cachedItems.end());
 }
 
-void CPathCache::RemoveFrontQueItem(void)
+void CPathCache::RemoveItem(CacheItemList::iterator it)
 {
-	delete cachedPaths[cacheQue.front().hash];
-	cachedPaths.erase(cacheQue.front().hash);
-	cacheQue.pop_front();
+	const unsigned int hash = GetBucketHash(it->goalBlock, it->goalRadius, it->pathType);
+	const CacheBucketMap::iterator bmi = buckets.find(hash);
+
+	assert(bmi != buckets.end());
+
+	CacheBucket& bucket = bmi->second;
+	CacheBucket::iterator bi = std::find(bucket.begin(), bucket.end(), it);
+
+	assert(bi != bucket.end());
+
+	// keep the insertion order of the remaining items
+	bucket.erase(bi);
+
+	if (bucket.empty())
+		buckets.erase(bmi);
+
+	numItems -= 1;
+	memFootPrint -= GetItemMemFootPrint(*it);
+
+	cachedItems.erase(it);
 }
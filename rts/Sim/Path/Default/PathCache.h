@@ -3,17 +3,35 @@
 #ifndef PATHCACHE_H
 #define PATHCACHE_H
 
-#include <map>
 #include <list>
+#include <vector>
 
 #include "IPath.h"
 #include "System/Vec2.h"
+#include "System/creg/STL_Map.h"
 
+/**
+ * Cache for PathEstimator paths (synced context only).
+ *
+ * Items are grouped by goal block, goal radius and path-type. A request is
+ * also answered by a path whose start block is next to the requested one,
+ * or whose goal block is next to the requested one, so units coming from
+ * the same place and going to the same place (e.g. from a factory to its
+ * rally point) share paths even if they are not on the exact same block.
+ * The closest match wins, ties are broken by a fixed search order, so the
+ * result is the same on every client.
+ * Only complete (IPath::Ok) paths are added, so a near-match never
+ * hands out a partial path.
+ *
+ * Items are evicted when they get older than CACHE_ITEM_LIFETIME frames
+ * (the terrain may have changed) or, least recently used first, when there
+ * are more than MAX_CACHE_ITEMS.
+ */
 class CPathCache
 {
 public:
-	CPathCache(int blocksX,int blocksZ);
-	~CPathCache(void);
+	CPathCache(int blocksX, int blocksZ);
+	~CPathCache();
 
 	struct CacheItem {
 		IPath::SearchResult result;
@@ -22,26 +40,41 @@ public:
 		int2 goalBlock;
 		float goalRadius;
 		int pathType;
+		/// frame after which the path is considered stale
+		int timeout;
 	};
 
-	void AddPath(IPath::Path* path, IPath::SearchResult result, int2 startBlock,int2 goalBlock,float goalRadius,int pathType);
-	CacheItem* GetCachedPath(int2 startBlock,int2 goalBlock,float goalRadius,int pathType);
-	void Update(void);
+	void AddPath(IPath::Path* path, IPath::SearchResult result, int2 startBlock, int2 goalBlock, float goalRadius, int pathType);
+	CacheItem* GetCachedPath(int2 startBlock, int2 goalBlock, float goalRadius, int pathType);
+	void Update();
 
-	std::map<unsigned int,CacheItem*> cachedPaths;
+	unsigned int GetNumCacheHits() const { return numCacheHits; }
+	unsigned int GetNumCacheMisses() const { return numCacheMisses; }
+	unsigned int GetNumItems() const { return numItems; }
+	/// approximate memory used by the cached paths, in bytes (the same on all platforms)
+	unsigned int GetMemFootPrint() const { return memFootPrint; }
 
-	struct CacheQue {
-		int timeout;
-		unsigned int hash;
-	};
-	std::list<CacheQue> cacheQue;
-	void RemoveFrontQueItem(void);
+private:
+	/// most recently used item first
+	typedef std::list<CacheItem> CacheItemList;
+	typedef std::vector<CacheItemList::iterator> CacheBucket;
+	typedef SPRING_HASH_MAP<unsigned int, CacheBucket> CacheBucketMap;
+
+	unsigned int GetBucketHash(int2 goalBlock, float goalRadius, int pathType) const;
+	static unsigned int GetItemMemFootPrint(const CacheItem& item);
+
+	void RemoveItem(CacheItemList::iterator it);
+
+	CacheItemList cachedItems;
+	CacheBucketMap buckets;
 
 	int blocksX;
 	int blocksZ;
 
-	int numCacheHits;
-	int numCacheMisses;
+	unsigned int numCacheHits;
+	unsigned int numCacheMisses;
+	unsigned int numItems;
+	unsigned int memFootPrint;
 };
 
 #endif
@@ -23,6 +23,10 @@ const float MIN_DETAILED_DISTANCE = 12;
 
 const unsigned int PATHESTIMATOR_VERSION = 49;
 const unsigned int SQUARES_TO_UPDATE = 600;
+// upper bound for SQUARES_TO_UPDATE when the PE's have a large backlog
+// (the rate still has to be the same for all clients, so it can not
+// depend on the number of local PE threads)
+const unsigned int MAX_SQUARES_TO_UPDATE = SQUARES_TO_UPDATE * 16;
 const unsigned int MAX_SEARCHED_NODES_ON_REFINE = 2000;
 
 
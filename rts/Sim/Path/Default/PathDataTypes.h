@@ -3,6 +3,8 @@
 #ifndef PATH_DATATYPES_H
 #define PATH_DATATYPES_H
 
+#include <algorithm>
+#include <cassert>
 #include <queue>
 #include <vector>
 
@@ -73,10 +75,15 @@ struct PathNodeState {
 
 
 
-/// functor to define node priority
+/**
+ * functor to define node priority
+ * ties in fCost are broken on nodeNum (a node can only be queued again
+ * with a lower fCost, so the order is total) to make every open-list
+ * implementation pop the nodes in the same order
+ */
 struct lessCost: public std::binary_function<PathNode*, PathNode*, bool> {
 	inline bool operator() (const PathNode* x, const PathNode* y) const {
-		return (x->fCost > y->fCost);
+		return (x->fCost > y->fCost) || (x->fCost == y->fCost && x->nodeNum > y->nodeNum);
 	}
 };
 
@@ -264,10 +271,134 @@ private:
 	PathNode* buf[MAX_SEARCHED_NODES];
 };
 
-class PathPriorityQueue: public std::priority_queue<PathNode*, PathVector, lessCost> {
+/// open-list as binary heap (std::priority_queue)
+class PathBinaryHeap: public std::priority_queue<PathNode*, PathVector, lessCost> {
 public:
 	/// faster than "while (!q.empty()) { q.pop(); }"
 	void Clear() { c.clear(); }
 };
 
+/**
+ * open-list as 4-ary heap
+ * The sort keys are kept in their own array (next to the node pointers)
+ * so sifting compares adjacent keys instead of dereferencing PathNode's
+ * spread over the node buffer, and the tree is half as deep as a binary
+ * heap. Pops nodes in exactly the same order as PathBinaryHeap.
+ */
+class PathDAryHeap {
+public:
+	PathDAryHeap(): numNodes(0) {}
+
+	inline bool empty() const { return (numNodes == 0); }
+	inline int size() const { return numNodes; }
+	inline const PathNode* top() const { return nodes[0]; }
+
+	/// faster than "while (!q.empty()) { q.pop(); }"
+	void Clear() { numNodes = 0; }
+
+	void push(PathNode* node) {
+		assert(numNodes < MAX_SEARCHED_NODES);
+
+		const SortKey key(node->fCost, node->nodeNum);
+
+		int i = numNodes++;
+
+		// move parents down until the hole is at the right place
+		while (i > 0) {
+			const int p = (i - 1) / D;
+
+			if (!(key < keys[p]))
+				break;
+
+			keys[i] = keys[p];
+			nodes[i] = nodes[p];
+			i = p;
+		}
+
+		keys[i] = key;
+		nodes[i] = node;
+	}
+
+	void pop() {
+		assert(numNodes > 0);
+
+		if ((--numNodes) == 0)
+			return;
+
+		// re-insert the last node starting from the root
+		const SortKey key = keys[numNodes];
+		PathNode* node = nodes[numNodes];
+
+		int i = 0;
+		int c = 1;
+
+		// all children present
+		while ((c + D) <= numNodes) {
+			int b = c;
+
+			for (int n = 1; n < D; n++) {
+				b = (keys[c + n] < keys[b])? (c + n): b;
+			}
+
+			if (!(keys[b] < key))
+				break;
+
+			keys[i] = keys[b];
+			nodes[i] = nodes[b];
+			i = b;
+			c = i * D + 1;
+		}
+
+		// last, incomplete group of children
+		if (c < numNodes && (c + D) > numNodes) {
+			int b = c;
+
+			for (int n = c + 1; n < numNodes; n++) {
+				b = (keys[n] < keys[b])? n: b;
+			}
+
+			if (keys[b] < key) {
+				keys[i] = keys[b];
+				nodes[i] = nodes[b];
+				i = b;
+			}
+		}
+
+		keys[i] = key;
+		nodes[i] = node;
+	}
+
+private:
+	static const int D = 4;
+
+	struct SortKey {
+		SortKey() {}
+		SortKey(float f, int n): fCost(f), nodeNum(n) {}
+
+		/// same order as lessCost: true if this node has to be popped first
+		inline bool operator < (const SortKey& k) const {
+			return (fCost < k.fCost) || (fCost == k.fCost && nodeNum < k.nodeNum);
+		}
+
+		float fCost;
+		int nodeNum;
+	};
+
+	int numNodes;
+
+	SortKey keys[MAX_SEARCHED_NODES];
+	PathNode* nodes[MAX_SEARCHED_NODES];
+};
+
+/**
+ * the open-list used by CPathFinder and CPathEstimator
+ * define PATH_BINARY_HEAP_OPENLIST to get the std::priority_queue
+ * based one back, e.g. for comparing against it
+ */
+#ifdef PATH_BINARY_HEAP_OPENLIST
+class PathPriorityQueue: public PathBinaryHeap {};
+#else
+class PathPriorityQueue: public PathDAryHeap {};
+#endif
+
 #endif // PATH_DATATYPES_H
@@ -6,12 +6,12 @@
 
 #include "PathEstimator.h"
 
+#include <cstdio>
 #include <fstream>
+#include <memory>
 #include <boost/bind.hpp>
 #include <boost/version.hpp>
-#include <boost/version.hpp>
 
-#include "minizip/zip.h"
 #include "System/mmgr.h"
 
 #include "PathAllocator.h"
@@ -20,18 +20,22 @@
 #include "PathFinderDef.h"
 #include "PathLog.h"
 #include "Map/ReadMap.h"
+#include "Game/GameSetup.h"
 #include "Game/LoadScreen.h"
 #include "Sim/MoveTypes/MoveInfo.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitDef.h"
-#include "System/FileSystem/IArchive.h"
-#include "System/FileSystem/ArchiveLoader.h"
+#include "System/CRC.h"
+#include "System/Util.h"
+#include "System/FileSystem/ArchiveScanner.h"
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/MappedFile.h"
 #include "System/Config/ConfigHandler.h"
 #include "System/NetProtocol.h"
+#include "System/Platform/Misc.h"
 
 CONFIG(int, MaxPathCostsMemoryFootPrint).defaultValue(512 * 1024 * 1024);
 
@@ -48,13 +52,25 @@ CPathEstimator::CPathEstimator(CPathFinder* pf, unsigned int BSIZE, const std::s
 	BLOCK_SIZE(BSIZE),
 	BLOCK_PIXEL_SIZE(BSIZE * SQUARE_SIZE),
 	BLOCKS_TO_UPDATE(SQUARES_TO_UPDATE / (BLOCK_SIZE * BLOCK_SIZE) + 1),
+	MAX_BLOCKS_TO_UPDATE(MAX_SQUARES_TO_UPDATE / (BLOCK_SIZE * BLOCK_SIZE) + 1),
 	nbrOfBlocksX(gs->mapx / BLOCK_SIZE),
 	nbrOfBlocksZ(gs->mapy / BLOCK_SIZE),
 	blockStates(int2(nbrOfBlocksX, nbrOfBlocksZ), int2(gs->mapx, gs->mapy)),
+	numVertices(moveinfo->moveData.size() * blockStates.GetSize() * PATH_DIRECTION_VERTICES),
+	vertices(NULL),
+	cacheFile(NULL),
 	pathFinder(pf),
+	master(this),
 	pathChecksum(0),
+	pathBarrier(NULL),
 	offsetBlockNum(nbrOfBlocksX * nbrOfBlocksZ),
 	costBlockNum(nbrOfBlocksX * nbrOfBlocksZ),
+	updateOffsetNum(0),
+	updateCostNum(0),
+	updateOffsetBase(0),
+	updateCostBase(0),
+	stopThreads(false),
+	threadedUpdate(false),
 	nextOffsetMessage(-1),
 	nextCostMessage(-1)
 {
@@ -80,7 +96,8 @@ CPathEstimator::CPathEstimator(CPathFinder* pf, unsigned int BSIZE, const std::s
 	goalSqrOffset.x = BLOCK_SIZE / 2;
 	goalSqrOffset.y = BLOCK_SIZE / 2;
 
-	vertices.resize(moveinfo->moveData.size() * blockStates.GetSize() * PATH_DIRECTION_VERTICES, 0.0f);
+	vertexBuffer.resize(numVertices, 0.0f);
+	vertices = &vertexBuffer[0];
 
 	// load precalculated data if it exists
 	InitEstimator(cacheFileName, map);
@@ -101,15 +118,68 @@ CPathEstimator::CPathEstimator(CPathFinder* pf, unsigned int BSIZE, const std::s
 	pathCache = new CPathCache(nbrOfBlocksX, nbrOfBlocksZ);
 }
 
+CPathEstimator::CPathEstimator(const CPathEstimator* masterPE, CPathFinder* pf):
+	BLOCK_SIZE(masterPE->BLOCK_SIZE),
+	BLOCK_PIXEL_SIZE(masterPE->BLOCK_PIXEL_SIZE),
+	BLOCKS_TO_UPDATE(masterPE->BLOCKS_TO_UPDATE),
+	MAX_BLOCKS_TO_UPDATE(masterPE->MAX_BLOCKS_TO_UPDATE),
+	nbrOfBlocksX(masterPE->nbrOfBlocksX),
+	nbrOfBlocksZ(masterPE->nbrOfBlocksZ),
+	blockStates(int2(nbrOfBlocksX, nbrOfBlocksZ), int2(gs->mapx, gs->mapy)),
+	numVertices(masterPE->numVertices),
+	vertices(NULL),
+	cacheFile(NULL),
+	pathFinder(pf),
+	master(masterPE),
+	pathChecksum(masterPE->pathChecksum),
+	pathBarrier(NULL),
+	offsetBlockNum(0),
+	costBlockNum(0),
+	updateOffsetNum(0),
+	updateCostNum(0),
+	updateOffsetBase(0),
+	updateCostBase(0),
+	stopThreads(false),
+	threadedUpdate(false),
+	nextOffsetMessage(-1),
+	nextCostMessage(-1)
+{
+	for (int n = 0; n < PATH_DIRECTIONS; n++) {
+		directionVector[n] = masterPE->directionVector[n];
+		directionVertex[n] = masterPE->directionVertex[n];
+	}
+
+	goalSqrOffset = masterPE->goalSqrOffset;
+
+	// only used by synced searches
+	pathCache = new CPathCache(nbrOfBlocksX, nbrOfBlocksZ);
+}
+
 CPathEstimator::~CPathEstimator()
 {
+	if (master == this) {
+		// wake up the helper threads one last time so they can exit
+		stopThreads = true;
+		pathBarrier->wait();
+
+		for (unsigned int i = 1; i < threads.size(); i++) {
+			threads[i]->join();
+			delete threads[i];
+		}
+
+		FreeHelperPathFinders();
+		delete pathBarrier;
+	}
+
 	for (int i = 0; i < blockStates.GetSize(); i++)
 		blockStates[i].nodeOffsets.clear();
 
 	delete pathCache;
 
 	blockStates.Clear();
-	vertices.clear();
+	vertexBuffer.clear();
+
+	delete cacheFile;
 }
 
 
@@ -128,25 +198,33 @@ void CPathEstimator::InitEstimator(const std::string& cacheFileName, const std::
 		#endif
 	}
 
-	if (threads.size() != numThreads) {
-		threads.resize(numThreads);
-		pathFinders.resize(numThreads);
-	}
-
+	// start extra threads if applicable, but always keep the total
+	// memory-footprint made by CPathFinder instances within bounds
+	//
+	// the threads are kept alive for the whole game, Update() uses them
+	// to work off large numbers of blocks made obsolete by map changes
+	// (their CPathFinder instances only exist while there is such work)
+	const unsigned int minMemFootPrint = sizeof(CPathFinder) + pathFinder->GetMemFootPrint();
+	const unsigned int maxMemFootPrint = configHandler->GetInt("MaxPathCostsMemoryFootPrint");
+	const unsigned int numExtraThreads = std::min(int(numThreads - 1), std::max(0, int(maxMemFootPrint / minMemFootPrint) - 1));
+	const unsigned int reqMemFootPrint = minMemFootPrint * (numExtraThreads + 1);
+
+	threads.resize(numExtraThreads + 1, NULL);
+	pathFinders.resize(numExtraThreads + 1, NULL);
 	pathFinders[0] = pathFinder;
 
+	// note: only really needed if numExtraThreads > 0
+	pathBarrier = new boost::barrier(numExtraThreads + 1);
+
+	for (unsigned int i = 1; i <= numExtraThreads; i++) {
+		threads[i] = new boost::thread(boost::bind(&CPathEstimator::RunThread, this, i));
+	}
+
 	// Not much point in multithreading these...
 	InitVertices();
 	InitBlocks();
 
 	if (!ReadFile(cacheFileName, map)) {
-		// start extra threads if applicable, but always keep the total
-		// memory-footprint made by CPathFinder instances within bounds
-		const unsigned int minMemFootPrint = sizeof(CPathFinder) + pathFinder->GetMemFootPrint();
-		const unsigned int maxMemFootPrint = configHandler->GetInt("MaxPathCostsMemoryFootPrint");
-		const unsigned int numExtraThreads = std::min(int(numThreads - 1), std::max(0, int(maxMemFootPrint / minMemFootPrint) - 1));
-		const unsigned int reqMemFootPrint = minMemFootPrint * (numExtraThreads + 1);
-
 		{
 			char calcMsg[512];
 			const char* fmtString = (numExtraThreads > 0)?
@@ -157,24 +235,12 @@ void CPathEstimator::InitEstimator(const std::string& cacheFileName, const std::
 			loadscreen->SetLoadMessage(calcMsg);
 		}
 
-		// note: only really needed if numExtraThreads > 0
-		pathBarrier = new boost::barrier(numExtraThreads + 1);
-
-		for (unsigned int i = 1; i <= numExtraThreads; i++) {
-			pathFinders[i] = new CPathFinder();
-			threads[i] = new boost::thread(boost::bind(&CPathEstimator::CalcOffsetsAndPathCosts, this, i));
-		}
-
 		// Use the current thread as thread zero
+		AllocHelperPathFinders();
+		pathBarrier->wait();
 		CalcOffsetsAndPathCosts(0);
-
-		for (unsigned int i = 1; i <= numExtraThreads; i++) {
-			threads[i]->join();
-			delete threads[i];
-			delete pathFinders[i];
-		}
-
-		delete pathBarrier;
+		pathBarrier->wait();
+		FreeHelperPathFinders();
 
 		loadscreen->SetLoadMessage("PathCosts: writing", true);
 		WriteFile(cacheFileName, map);
@@ -184,7 +250,7 @@ void CPathEstimator::InitEstimator(const std::string& cacheFileName, const std::
 
 
 void CPathEstimator::InitVertices() {
-	for (unsigned int i = 0; i < vertices.size(); i++)
+	for (unsigned int i = 0; i < numVertices; i++)
 		vertices[i] = PATHCOST_INFINITY;
 }
 
@@ -199,6 +265,44 @@ void CPathEstimator::InitBlocks() {
 }
 
 
+void CPathEstimator::AllocHelperPathFinders() {
+	for (unsigned int i = 1; i < pathFinders.size(); i++) {
+		if (pathFinders[i] == NULL) {
+			pathFinders[i] = new CPathFinder(pathFinder);
+		}
+	}
+}
+
+void CPathEstimator::FreeHelperPathFinders() {
+	for (unsigned int i = 1; i < pathFinders.size(); i++) {
+		delete pathFinders[i];
+		pathFinders[i] = NULL;
+	}
+}
+
+
+void CPathEstimator::RunThread(int thread) {
+	//! reset FPU state for synced computations
+	streflop_init<streflop::Simple>();
+
+	while (true) {
+		// wait until there is work (or the estimator is deleted)
+		pathBarrier->wait();
+
+		if (stopThreads)
+			break;
+
+		if (updateBlocks.empty()) {
+			CalcOffsetsAndPathCosts(thread);
+		} else {
+			UpdateOffsetsAndPathCosts(thread);
+		}
+
+		pathBarrier->wait();
+	}
+}
+
+
 void CPathEstimator::CalcOffsetsAndPathCosts(int thread) {
 	//! reset FPU state for synced computations
 	streflop_init<streflop::Simple>();
@@ -220,6 +324,30 @@ void CPathEstimator::CalcOffsetsAndPathCosts(int thread) {
 }
 
 
+void CPathEstimator::UpdateOffsetsAndPathCosts(int thread) {
+	// same split as in CalcOffsetsAndPathCosts(): a block's vertices depend
+	// on the offsets of its neighbors, so all offsets must be updated first
+	// (this makes the results independent of how the blocks are distributed
+	// over the threads)
+	const long numBlocks = updateBlocks.size();
+	long i;
+
+	while ((i = (++updateOffsetNum) - updateOffsetBase - 1) < numBlocks) {
+		const SingleBlock& sb = updateBlocks[i];
+		FindOffset(*sb.moveData, sb.block.x, sb.block.y);
+	}
+
+	if (threadedUpdate) {
+		pathBarrier->wait();
+	}
+
+	while ((i = (++updateCostNum) - updateCostBase - 1) < numBlocks) {
+		const SingleBlock& sb = updateBlocks[i];
+		CalculateVertices(*sb.moveData, sb.block.x, sb.block.y, thread);
+	}
+}
+
+
 void CPathEstimator::CalculateBlockOffsets(int idx, int thread)
 {
 	const int x = idx % nbrOfBlocksX;
@@ -433,7 +561,14 @@ void CPathEstimator::MapChanged(unsigned int x1, unsigned int z1, unsigned int x
 void CPathEstimator::Update() {
 	pathCache->Update();
 
-	for (unsigned int n = 0; !needUpdate.empty() && n < BLOCKS_TO_UPDATE; ) {
+	if (needUpdate.empty())
+		return;
+
+	// normally BLOCKS_TO_UPDATE per frame, but work off a large backlog
+	// (heavy terraforming, mass building placement) within about a second
+	const unsigned int blocksToUpdate = std::max(BLOCKS_TO_UPDATE, std::min(MAX_BLOCKS_TO_UPDATE, (unsigned int) needUpdate.size() / GAME_SPEED));
+
+	for (unsigned int n = 0; !needUpdate.empty() && n < blocksToUpdate; ) {
 		// copy the next block in line
 		const SingleBlock sb = needUpdate.front();
 
@@ -448,9 +583,8 @@ void CPathEstimator::Update() {
 			const MoveData* currBlockMD = sb.moveData;
 			const MoveData* nextBlockMD = (needUpdate.empty())? NULL: (needUpdate.front()).moveData;
 
-			// no, update the block
-			FindOffset(*currBlockMD, blockX, blockZ);
-			CalculateVertices(*currBlockMD, blockX, blockZ);
+			// no, update the block (below)
+			updateBlocks.push_back(sb);
 
 			// each MapChanged() call adds AT MOST <moveData.size()> SingleBlock's
 			// in ascending pathType order per (x, z) PE-block, therefore when the
@@ -464,6 +598,33 @@ void CPathEstimator::Update() {
 			n++;
 		}
 	}
+
+	if (updateBlocks.empty())
+		return;
+
+	updateOffsetBase = updateOffsetNum;
+	updateCostBase = updateCostNum;
+
+	// the normal rate is done faster here than with the overhead of waking
+	// the other threads, and needs no helper CPathFinder instances
+	threadedUpdate = (threads.size() > 1 && updateBlocks.size() > BLOCKS_TO_UPDATE);
+
+	if (threadedUpdate) {
+		// recalculate the picked blocks with all threads, the current one is thread zero
+		AllocHelperPathFinders();
+		pathBarrier->wait();
+		UpdateOffsetsAndPathCosts(0);
+		pathBarrier->wait();
+	} else {
+		UpdateOffsetsAndPathCosts(0);
+	}
+
+	updateBlocks.clear();
+
+	if (needUpdate.empty()) {
+		// backlog done
+		FreeHelperPathFinders();
+	}
 }
 
 
@@ -537,8 +698,8 @@ IPath::SearchResult CPathEstimator::GetPath(
 // set up the starting point of the search
 IPath::SearchResult CPathEstimator::InitSearch(const MoveData& moveData, const CPathFinderDef& peDef, bool synced) {
 	// is starting square inside goal area?
-	const int xSquare = blockStates[startBlocknr].nodeOffsets[moveData.pathType].x;
-	const int zSquare = blockStates[startBlocknr].nodeOffsets[moveData.pathType].y;
+	const int xSquare = master->blockStates[startBlocknr].nodeOffsets[moveData.pathType].x;
+	const int zSquare = master->blockStates[startBlocknr].nodeOffsets[moveData.pathType].y;
 
 	if (peDef.IsGoal(xSquare, zSquare))
 		return IPath::CantGetCloser;
@@ -599,8 +760,8 @@ IPath::SearchResult CPathEstimator::DoSearch(const MoveData& moveData, const CPa
 			continue;
 
 		// no, check if the goal is already reached
-		const int xBSquare = blockStates[ob->nodeNum].nodeOffsets[moveData.pathType].x;
-		const int zBSquare = blockStates[ob->nodeNum].nodeOffsets[moveData.pathType].y;
+		const int xBSquare = master->blockStates[ob->nodeNum].nodeOffsets[moveData.pathType].x;
+		const int zBSquare = master->blockStates[ob->nodeNum].nodeOffsets[moveData.pathType].y;
 		const int xGSquare = ob->nodePos.x * BLOCK_SIZE + goalSqrOffset.x;
 		const int zGSquare = ob->nodePos.y * BLOCK_SIZE + goalSqrOffset.y;
 
@@ -673,18 +834,18 @@ void CPathEstimator::TestBlock(
 		return;
 	}
 
-	if (vertexIdx < 0 || (unsigned int)vertexIdx >= vertices.size())
+	if (vertexIdx < 0 || (unsigned int)vertexIdx >= numVertices)
 		return;
 
-	if (vertices[vertexIdx] >= PATHCOST_INFINITY)
+	if (master->vertices[vertexIdx] >= PATHCOST_INFINITY)
 		return;
 
 	// check if the block is unavailable
 	if (blockStates[blockIdx].nodeMask & (PATHOPT_FORBIDDEN | PATHOPT_BLOCKED | PATHOPT_CLOSED))
 		return;
 
-	const int xSquare = blockStates[blockIdx].nodeOffsets[moveData.pathType].x;
-	const int zSquare = blockStates[blockIdx].nodeOffsets[moveData.pathType].y;
+	const int xSquare = master->blockStates[blockIdx].nodeOffsets[moveData.pathType].x;
+	const int zSquare = master->blockStates[blockIdx].nodeOffsets[moveData.pathType].y;
 
 	// check if the block is blocked or out of constraints
 	if (!peDef.WithinConstraints(xSquare, zSquare)) {
@@ -694,8 +855,8 @@ void CPathEstimator::TestBlock(
 	}
 
 	// evaluate this node (NOTE the max-res. indexing for extraCost)
-	const float extraCost = blockStates.GetNodeExtraCost(xSquare, zSquare, synced);
-	const float nodeCost = vertices[vertexIdx] + extraCost;
+	const float extraCost = master->blockStates.GetNodeExtraCost(xSquare, zSquare, synced);
+	const float nodeCost = master->vertices[vertexIdx] + extraCost;
 
 	const float gCost = parentOpenBlock.gCost + nodeCost;  // g
 	const float hCost = peDef.Heuristic(xSquare, zSquare); // h
@@ -751,8 +912,8 @@ void CPathEstimator::FinishSearch(const MoveData& moveData, IPath::Path& foundPa
 
 		{
 			// use offset defined by the block
-			const int xBSquare = blockStates[blockIdx].nodeOffsets[moveData.pathType].x;
-			const int zBSquare = blockStates[blockIdx].nodeOffsets[moveData.pathType].y;
+			const int xBSquare = master->blockStates[blockIdx].nodeOffsets[moveData.pathType].x;
+			const int zBSquare = master->blockStates[blockIdx].nodeOffsets[moveData.pathType].y;
 			const float3& pos = SquareToFloat3(xBSquare, zBSquare);
 
 			foundPath.path.push_back(pos);
@@ -791,71 +952,128 @@ void CPathEstimator::ResetSearch() {
 }
 
 
+/**
+ * Header of the PE cache files. It is followed by the same data the
+ * zipped "pathinfo" files used to contain (hash, block offsets, vertex
+ * costs), but uncompressed and in native byte order, so the file can be
+ * mapped and its vertex costs used in place.
+ */
+struct CPathEstimator::CacheFileHeader {
+	char magic[8];
+	boost::uint32_t version;
+	boost::uint32_t hash;
+	boost::uint32_t mapChecksum;
+	boost::uint32_t modChecksum;
+	boost::uint32_t moveInfoChecksum;
+	boost::uint32_t blockSize;
+	boost::uint32_t numBlocksX;
+	boost::uint32_t numBlocksZ;
+	boost::uint32_t numMoveData;
+	/// CRC32 over the data following the header, becomes the pathChecksum
+	boost::uint32_t dataChecksum;
+};
+
+static const char CACHE_FILE_MAGIC[] = "SpringPE";
+static const boost::uint32_t CACHE_FILE_VERSION = 1;
+
+
+/**
+ * The name of the cache file depends on everything the estimator data
+ * depends on, so different maps, games and game versions do not overwrite
+ * each other's files.
+ */
+std::string CPathEstimator::GetCacheFileName(const std::string& cacheFileName, const std::string& map) const
+{
+	char hashString[64] = {0};
+	sprintf(hashString, "%u-%08x", Hash(), GetModChecksum());
+
+	return (std::string(PATH_CACHE_DIR) + map + hashString + "." + cacheFileName + ".pecache");
+}
+
+unsigned int CPathEstimator::GetModChecksum() const
+{
+	return archiveScanner->GetArchiveCompleteChecksum(archiveScanner->ArchiveFromName(gameSetup->modName));
+}
+
+void CPathEstimator::GetCacheFileHeader(CacheFileHeader& header) const
+{
+	std::memset(&header, 0, sizeof(CacheFileHeader));
+	std::memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic));
+
+	header.version          = CACHE_FILE_VERSION;
+	header.hash             = Hash();
+	header.mapChecksum      = readmap->mapChecksum;
+	header.modChecksum      = GetModChecksum();
+	header.moveInfoChecksum = moveinfo->moveInfoChecksum;
+	header.blockSize        = BLOCK_SIZE;
+	header.numBlocksX       = nbrOfBlocksX;
+	header.numBlocksZ       = nbrOfBlocksZ;
+	header.numMoveData      = moveinfo->moveData.size();
+}
+
+
 /**
  * Try to read offset and vertices data from file, return false on failure
- * TODO: Read-error-check.
+ *
+ * The file is mapped (copy-on-write, Update() modifies the vertices), so
+ * only the block offsets are copied and the vertex pages are shared with
+ * other engine processes using the same cache file.
  */
 bool CPathEstimator::ReadFile(const std::string& cacheFileName, const std::string& map)
 {
-	const unsigned int hash = Hash();
-	char hashString[50];
-	sprintf(hashString, "%u", hash);
+	const std::string filename = GetCacheFileName(cacheFileName, map);
 
-	std::string filename = std::string(PATH_CACHE_DIR) + map + hashString + "." + cacheFileName + ".zip";
 	if (!FileSystem::FileExists(filename))
 		return false;
-	// open file for reading from a suitable location (where the file exists)
-	IArchive* pfile = archiveLoader.OpenArchive(dataDirsAccess.LocateFile(filename), "sdz");
-
-	if (!pfile || !pfile->IsOpen()) {
-		delete pfile;
-		return false;
-	}
 
 	char calcMsg[512];
 	sprintf(calcMsg, "Reading Estimate PathCosts [%d]", BLOCK_SIZE);
 	loadscreen->SetLoadMessage(calcMsg);
 
-	std::auto_ptr<IArchive> auto_pfile(pfile);
-	IArchive& file(*pfile);
+	std::auto_ptr<CMappedFile> file(new CMappedFile(dataDirsAccess.LocateFile(filename), true));
 
-	const unsigned fid = file.FindFile("pathinfo");
+	if (!file->IsOpen())
+		return false;
 
-	if (fid < file.NumFiles()) {
-		pathChecksum = file.GetCrc32(fid);
+	const unsigned int hash = Hash();
+	const size_t offsetsSize = moveinfo->moveData.size() * sizeof(int2);
+	const size_t dataSize = sizeof(hash) + offsetsSize * blockStates.GetSize() + numVertices * sizeof(float);
 
-		std::vector<boost::uint8_t> buffer;
-		file.GetFile(fid, buffer);
+	if (file->GetSize() != (sizeof(CacheFileHeader) + dataSize))
+		return false;
 
-		if (buffer.size() < 4)
-			return false;
+	CacheFileHeader header;
+	CacheFileHeader fileHeader;
+	GetCacheFileHeader(header);
+	std::memcpy(&fileHeader, file->GetData(), sizeof(CacheFileHeader));
 
-		unsigned filehash = *((unsigned*)&buffer[0]);
-		if (filehash != hash)
-			return false;
+	header.dataChecksum = fileHeader.dataChecksum;
 
-		unsigned pos = sizeof(unsigned);
+	if (std::memcmp(&header, &fileHeader, sizeof(CacheFileHeader)) != 0)
+		return false;
 
-		// Read block-center-offset data.
-		const unsigned blockSize = moveinfo->moveData.size() * sizeof(int2);
-		if (buffer.size() < pos + blockSize * blockStates.GetSize())
-			return false;
+	const boost::uint8_t* data = file->GetData() + sizeof(CacheFileHeader);
 
-		for (int blocknr = 0; blocknr < blockStates.GetSize(); blocknr++) {
-			std::memcpy(&blockStates[blocknr].nodeOffsets[0], &buffer[pos], blockSize);
-			pos += blockSize;
-		}
+	if (*((const unsigned int*) data) != hash)
+		return false;
 
-		// Read vertices data.
-		if (buffer.size() < pos + vertices.size() * sizeof(float))
-			return false;
-		std::memcpy(&vertices[0], &buffer[pos], vertices.size() * sizeof(float));
+	data += sizeof(hash);
 
-		// File read successful.
-		return true;
-	} else {
-		return false;
+	// Read block-center-offset data.
+	for (int blocknr = 0; blocknr < blockStates.GetSize(); blocknr++) {
+		std::memcpy(&blockStates[blocknr].nodeOffsets[0], data, offsetsSize);
+		data += offsetsSize;
 	}
+
+	// Use the vertices data in place.
+	vertices = (float*) data;
+	std::vector<float>().swap(vertexBuffer);
+
+	cacheFile = file.release();
+	pathChecksum = header.dataChecksum;
+
+	// File read successful.
+	return true;
 }
 
 
@@ -869,47 +1087,57 @@ void CPathEstimator::WriteFile(const std::string& cacheFileName, const std::stri
 		return;
 
 	const unsigned int hash = Hash();
-	char hashString[64] = {0};
+	const size_t offsetsSize = moveinfo->moveData.size() * sizeof(int2);
 
-	sprintf(hashString, "%u", hash);
+	CRC crc;
+	crc.Update(&hash, sizeof(hash));
 
-	const std::string filename = std::string(PATH_CACHE_DIR) + map + hashString + "." + cacheFileName + ".zip";
-	zipFile file;
+	for (int blocknr = 0; blocknr < blockStates.GetSize(); blocknr++)
+		crc.Update(&blockStates[blocknr].nodeOffsets[0], offsetsSize);
 
-	// open file for writing in a suitable location
-	file = zipOpen(dataDirsAccess.LocateFile(filename, FileQueryFlags::WRITE).c_str(), APPEND_STATUS_CREATE);
+	crc.Update(vertices, numVertices * sizeof(float));
 
-	if (file) {
-		zipOpenNewFileInZip(file, "pathinfo", NULL, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_BEST_COMPRESSION);
+	CacheFileHeader header;
+	GetCacheFileHeader(header);
+	header.dataChecksum = crc.GetDigest();
 
-		// Write hash.
-		zipWriteInFileInZip(file, (void*) &hash, 4);
+	// write to a temporary file first and rename it when complete, other
+	// engine processes might be reading (mapping) the cache file right now
+	const std::string filePath = dataDirsAccess.LocateFile(GetCacheFileName(cacheFileName, map), FileQueryFlags::WRITE);
+	const std::string tempFilePath = filePath + ".tmp" + IntToString(Platform::GetProcessId());
 
-		// Write block-center-offsets.
-		for (int blocknr = 0; blocknr < blockStates.GetSize(); blocknr++)
-			zipWriteInFileInZip(file, (void*) &blockStates[blocknr].nodeOffsets[0], moveinfo->moveData.size() * sizeof(int2));
+	std::ofstream file(tempFilePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
 
-		// Write vertices.
-		zipWriteInFileInZip(file, &vertices[0], vertices.size() * sizeof(float));
+	if (!file.good())
+		return;
 
-		zipCloseFileInZip(file);
-		zipClose(file, NULL);
+	// Write header and hash.
+	file.write((const char*) &header, sizeof(CacheFileHeader));
+	file.write((const char*) &hash, sizeof(hash));
 
+	// Write block-center-offsets.
+	for (int blocknr = 0; blocknr < blockStates.GetSize(); blocknr++)
+		file.write((const char*) &blockStates[blocknr].nodeOffsets[0], offsetsSize);
 
-		// get the CRC over the written path data
-		IArchive* pfile = archiveLoader.OpenArchive(dataDirsAccess.LocateFile(filename), "sdz");
+	// Write vertices.
+	file.write((const char*) vertices, numVertices * sizeof(float));
+	file.close();
 
-		if (!pfile || !pfile->IsOpen()) {
-			delete pfile;
-			return;
-		}
+	// same value the CRC of the zipped "pathinfo" file used to have
+	pathChecksum = header.dataChecksum;
+
+	if (file.fail() || !FileSystem::RenameFile(tempFilePath, filePath)) {
+		// (on Windows also if another process has the old file mapped)
+		FileSystem::Remove(tempFilePath);
+		return;
+	}
 
-		std::auto_ptr<IArchive> auto_pfile(pfile);
-		IArchive& file(*pfile);
+	// the zipped caches of older engine versions are never read again
+	// (absolute directory: only looks in the writable data-dir)
+	const std::vector<std::string> oldFiles = dataDirsAccess.FindFiles(FileSystem::GetDirectory(filePath), "*.zip");
 
-		const unsigned fid = file.FindFile("pathinfo");
-		assert(fid < file.NumFiles());
-		pathChecksum = file.GetCrc32(fid);
+	for (std::vector<std::string>::const_iterator it = oldFiles.begin(); it != oldFiles.end(); ++it) {
+		FileSystem::Remove(*it);
 	}
 }
 
@@ -5,6 +5,7 @@
 
 #include <string>
 #include <list>
+#include <deque>
 #include <queue>
 
 #include "IPath.h"
@@ -23,6 +24,7 @@ class CPathFinder;
 class CPathEstimatorDef;
 class CPathFinderDef;
 class CPathCache;
+class CMappedFile;
 
 class CPathEstimator {
 public:
@@ -41,6 +43,14 @@ public:
 	 *   Ex. PE-name "pe" + Mapname "Desert" => "Desert.pe"
 	 */
 	CPathEstimator(CPathFinder* pathFinder, unsigned int BLOCK_SIZE, const std::string& cacheFileName, const std::string& map);
+	/**
+	 * Creates an estimator that searches on the block offsets, vertex
+	 * costs and extra costs of <master>, but with its own node-states,
+	 * so it can run searches while <master> is used by another thread.
+	 * It never recalculates blocks itself (Update must not be called),
+	 * so its searches must not overlap with master->Update().
+	 */
+	CPathEstimator(const CPathEstimator* master, CPathFinder* pathFinder);
 	~CPathEstimator();
 
 #if !defined(USE_MMGR)
@@ -96,7 +106,8 @@ public:
 
 
 	/**
-	 * called every frame
+	 * called every frame, recalculates the next obsolete blocks (using
+	 * all PathEstimator threads)
 	 */
 	void Update();
 
@@ -111,18 +122,24 @@ public:
 	unsigned int GetNumBlocksZ() const { return nbrOfBlocksZ; }
 
 	PathNodeStateBuffer& GetNodeStateBuffer() { return blockStates; }
+	const CPathCache* GetPathCache() const { return pathCache; }
 
 private:
 	void InitEstimator(const std::string& cacheFileName, const std::string& map);
 	void InitVertices();
 	void InitBlocks();
+	void AllocHelperPathFinders();
+	void FreeHelperPathFinders();
+	void RunThread(int thread);
 	void CalcOffsetsAndPathCosts(int thread);
+	void UpdateOffsetsAndPathCosts(int thread);
 	void CalculateBlockOffsets(int, int);
 	void EstimatePathCosts(int, int);
 
 	const unsigned int BLOCK_SIZE;
 	const unsigned int BLOCK_PIXEL_SIZE;
 	const unsigned int BLOCKS_TO_UPDATE;
+	const unsigned int MAX_BLOCKS_TO_UPDATE;
 
 
 
@@ -131,6 +148,8 @@ private:
 		const MoveData* moveData;
 	};
 
+	struct CacheFileHeader;
+
 
 	void FindOffset(const MoveData&, int, int);
 	void CalculateVertices(const MoveData&, int, int, int thread = 0);
@@ -144,6 +163,9 @@ private:
 
 	bool ReadFile(const std::string& cacheFileName, const std::string& map);
 	void WriteFile(const std::string& cacheFileName, const std::string& map);
+	std::string GetCacheFileName(const std::string& cacheFileName, const std::string& map) const;
+	void GetCacheFileHeader(CacheFileHeader& header) const;
+	unsigned int GetModChecksum() const;
 	unsigned int Hash() const;
 
 	/// Number of blocks on the X axis of the map.
@@ -156,11 +178,17 @@ private:
 	/// The priority-queue used to select next block to be searched.
 	PathPriorityQueue openBlocks;
 
-	std::vector<float> vertices;
+	const unsigned int numVertices;
+	/// vertex costs, either in <vertexBuffer> or in the mapped <cacheFile>
+	float* vertices;
+	std::vector<float> vertexBuffer;
+	CMappedFile* cacheFile;
 	/// List of blocks changed in last search.
 	std::list<int> dirtyBlocks;
 	/// Blocks that may need an update due to map changes.
-	std::list<SingleBlock> needUpdate;
+	std::deque<SingleBlock> needUpdate;
+	/// Blocks being recalculated by the current Update() call.
+	std::vector<SingleBlock> updateBlocks;
 
 	static const int PATH_DIRECTIONS = 8;
 	static const int PATH_DIRECTION_VERTICES = PATH_DIRECTIONS / 2;
@@ -183,6 +211,8 @@ private:
 
 	CPathFinder* pathFinder;
 	CPathCache* pathCache;
+	/// source of block offsets, vertex costs and extra costs (this if none given)
+	const CPathEstimator* master;
 
 	/// currently crc from the zip
 	boost::uint32_t pathChecksum;
@@ -191,6 +221,14 @@ private:
 	boost::barrier* pathBarrier;
 	boost::detail::atomic_count offsetBlockNum;
 	boost::detail::atomic_count costBlockNum;
+	/// atomic_count can not be reset, so every Update() remembers where its indices start
+	boost::detail::atomic_count updateOffsetNum;
+	boost::detail::atomic_count updateCostNum;
+	long updateOffsetBase;
+	long updateCostBase;
+	bool stopThreads;
+	/// whether the current Update() runs on all threads
+	bool threadedUpdate;
 
 	int nextOffsetMessage;
 	int nextCostMessage;
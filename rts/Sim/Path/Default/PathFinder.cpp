@@ -24,8 +24,9 @@ void CPathFinder::operator delete(void* p, size_t size) { PathAllocator::Free(p,
 
 
 
-CPathFinder::CPathFinder()
-	: heatMapOffset(0)
+CPathFinder::CPathFinder(const CPathFinder* masterPF)
+	: master((masterPF != NULL)? masterPF: this)
+	, heatMapOffset(0)
 	, heatMapping(true)
 	, start(ZeroVector)
 	, startxSqr(0)
@@ -41,7 +42,9 @@ CPathFinder::CPathFinder()
 	, maxNodeCost(0.0f)
 	, squareStates(int2(gs->mapx, gs->mapy) , int2(gs->mapx, gs->mapy))
 {
-	InitHeatMap();
+	if (master == this) {
+		InitHeatMap();
+	}
 
 	// Precalculated vectors.
 	directionVector[PATHOPT_RIGHT].x = -2;
@@ -313,14 +316,14 @@ bool CPathFinder::TestSquare(
 
 	// Include heatmap cost adjustment.
 	float heatCostMod = 1.0f;
-	if (heatMapping && moveData.heatMapping && GetHeatOwner(square.x, square.y) != ownerId) {
-		heatCostMod += (moveData.heatMod * GetHeatValue(square.x,square.y));
+	if (master->heatMapping && moveData.heatMapping && master->GetHeatOwner(square.x, square.y) != ownerId) {
+		heatCostMod += (moveData.heatMod * master->GetHeatValue(square.x,square.y));
 	}
 
 
 
 	const float dirMoveCost = (heatCostMod * moveCost[enterDirection]);
-	const float extraCost = squareStates.GetNodeExtraCost(square.x, square.y, synced);
+	const float extraCost = master->squareStates.GetNodeExtraCost(square.x, square.y, synced);
 	const float nodeCost = (dirMoveCost / squareSpeedMod) + extraCost;
 
 	const float gCost = parentOpenSquare->gCost + nodeCost;  // g
@@ -580,7 +583,7 @@ void CPathFinder::UpdateHeatMap()
 	++heatMapOffset;
 }
 
-int CPathFinder::GetHeatMapIndex(int x, int y)
+int CPathFinder::GetHeatMapIndex(int x, int y) const
 {
 	assert(!heatmap.empty());
 
@@ -17,7 +17,14 @@ class CPathFinderDef;
 
 class CPathFinder {
 public:
-	CPathFinder();
+	/**
+	 * @param master
+	 *   if given, this instance reads the heat-map and the node extra-costs
+	 *   of <master> instead of keeping its own (for the helper instances of
+	 *   the PathEstimator threads, which must produce the same costs as the
+	 *   main instance)
+	 */
+	CPathFinder(const CPathFinder* master = NULL);
 	~CPathFinder();
 
 #if !defined(USE_MMGR)
@@ -83,13 +90,13 @@ public:
 		}
 	}
 
-	const int GetHeatOwner(const int& x, const int& y)
+	const int GetHeatOwner(const int& x, const int& y) const
 	{
 		const int i = GetHeatMapIndex(x, y);
 		return heatmap[i].ownerId;
 	}
 
-	const int GetHeatValue(const int& x, const int& y)
+	const int GetHeatValue(const int& x, const int& y) const
 	{
 		const int i = GetHeatMapIndex(x, y);
 		return std::max(0, heatmap[i].value - heatMapOffset);
@@ -103,7 +110,7 @@ public:
 
 private:
 	// Heat mapping
-	int GetHeatMapIndex(int x, int y);
+	int GetHeatMapIndex(int x, int y) const;
 
 	/**
 	 * Clear things up from last search.
@@ -152,6 +159,8 @@ private:
 		int ownerId;
 	};
 
+	const CPathFinder* master;         ///< source of heat-map and extra-costs (this if none given)
+
 	std::vector<HeatMapValue> heatmap; ///< resolution is hmapx*hmapy
 	int heatMapOffset;                 ///< heatmap values are relative to this
 	bool heatMapping;
@@ -1,11 +1,14 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include "lib/gml/gml.h"
 #include "System/mmgr.h"
 
 #include "PathManager.h"
 #include "PathConstants.h"
 #include "PathFinder.h"
 #include "PathEstimator.h"
+#include "PathCache.h"
+#include "PathSearchWorker.h"
 #include "Map/MapInfo.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/MoveTypes/MoveInfo.h"
@@ -14,13 +17,19 @@
 #include "System/myMath.h"
 #include "System/TimeProfiler.h"
 
+#include <boost/bind.hpp>
+
 #define PM_UNCONSTRAINED_MAXRES_FALLBACK_SEARCH 0
 #define PM_UNCONSTRAINED_MEDRES_FALLBACK_SEARCH 1
 #define PM_UNCONSTRAINED_LOWRES_FALLBACK_SEARCH 1
 
 
 
-CPathManager::CPathManager(): nextPathId(0)
+CPathManager::CPathManager()
+	: nextPathId(0)
+	, asyncPathManager(NULL)
+	, asyncWorker(NULL)
+	, nextRequestId(0)
 {
 	maxResPF = new CPathFinder();
 	medResPE = new CPathEstimator(maxResPF,  8, "pe",  mapInfo->map.name);
@@ -38,8 +47,32 @@ CPathManager::CPathManager(): nextPathId(0)
 	#endif
 }
 
+CPathManager::CPathManager(const CPathManager* master)
+	: nextPathId(0)
+	, asyncPathManager(NULL)
+	, asyncWorker(NULL)
+	, nextRequestId(0)
+{
+	maxResPF = new CPathFinder(master->maxResPF);
+	medResPE = new CPathEstimator(master->medResPE, maxResPF);
+	lowResPE = new CPathEstimator(master->lowResPE, maxResPF);
+}
+
 CPathManager::~CPathManager()
 {
+	// waits for a running search
+	delete asyncWorker;
+
+	// (the definitions of searched requests ended up in their paths)
+	for (std::vector<AsyncPathRequest>::iterator it = queuedRequests.begin(); it != queuedRequests.end(); ++it) {
+		delete it->pfDef;
+	}
+	for (std::vector<AsyncPathRequest>::iterator it = searchedRequests.begin(); it != searchedRequests.end(); ++it) {
+		delete it->pfDef;
+	}
+
+	delete asyncPathManager;
+
 	delete lowResPE;
 	delete medResPE;
 	delete maxResPF;
@@ -59,6 +92,8 @@ unsigned int CPathManager::RequestPath(
 	CSolidObject* caller,
 	bool synced
 ) {
+	SCOPED_TIMER("PathManager::RequestPath");
+
 	float3 sp(startPos); sp.CheckInBounds();
 	float3 gp(goalPos); gp.CheckInBounds();
 
@@ -80,8 +115,6 @@ unsigned int CPathManager::RequestPath(
 	CSolidObject* caller,
 	bool synced
 ) {
-	SCOPED_TIMER("PathManager::RequestPath");
-
 	MoveData* moveData = moveinfo->moveData[md->pathType];
 	moveData->tempOwner = caller;
 
@@ -176,6 +209,171 @@ unsigned int CPathManager::RequestPath(
 }
 
 
+
+
+unsigned int CPathManager::RequestPathAsync(
+	const void* owner,
+	const MoveData* moveData,
+	const float3& startPos,
+	const float3& goalPos,
+	float goalRadius
+) {
+	boost::mutex::scoped_lock lock(asyncMutex);
+
+	if (asyncPathManager == NULL) {
+		asyncPathManager = new CPathManager(this);
+
+		#if defined(USE_GML) && GML_ENABLE_SIM
+		// the sim thread is not paused while drawing, so the searches are
+		// deferred to the start of its next update (see FinishPathRequests)
+		asyncWorker = new CPathSearchWorker(boost::bind(&CPathManager::SearchAsyncPaths, this), false);
+		#else
+		asyncWorker = new CPathSearchWorker(boost::bind(&CPathManager::SearchAsyncPaths, this), true);
+		#endif
+	}
+
+	AsyncPathRequest request;
+	request.requestId = ++nextRequestId;
+	request.owner = owner;
+	request.moveData = moveData;
+	request.startPos = startPos; request.startPos.CheckInBounds();
+	request.goalPos = goalPos; request.goalPos.CheckInBounds();
+	request.pfDef = new CRangedGoalWithCircularConstraint(request.startPos, request.goalPos, goalRadius, 3.0f, 2000);
+	request.pathId = 0;
+
+	queuedRequests.push_back(request);
+	return request.requestId;
+}
+
+void CPathManager::GetFinishedPathRequests(const void* owner, std::vector<FinishedPathRequest>& requests)
+{
+	boost::mutex::scoped_lock lock(asyncMutex);
+
+	for (size_t n = 0; n < finishedRequests.size(); ) {
+		const AsyncPathRequest& request = finishedRequests[n];
+
+		if (request.owner != owner) {
+			++n;
+			continue;
+		}
+
+		requests.push_back(FinishedPathRequest(request.requestId, request.pathId));
+		finishedRequests.erase(finishedRequests.begin() + n);
+	}
+}
+
+void CPathManager::CancelPathRequests(const void* owner)
+{
+	std::vector<unsigned int> pathIds;
+
+	{
+		boost::mutex::scoped_lock lock(asyncMutex);
+
+		if (asyncWorker != NULL && asyncWorker->Wait())
+			JoinPathRequests();
+
+		for (size_t n = 0; n < queuedRequests.size(); ) {
+			if (queuedRequests[n].owner != owner) {
+				++n;
+				continue;
+			}
+
+			delete queuedRequests[n].pfDef;
+			queuedRequests.erase(queuedRequests.begin() + n);
+		}
+
+		// deferred ones, not searched yet (FinishPathRequests is
+		// blocked by <asyncMutex> meanwhile)
+		for (size_t n = 0; n < searchedRequests.size(); ) {
+			if (searchedRequests[n].owner != owner) {
+				++n;
+				continue;
+			}
+
+			delete searchedRequests[n].pfDef;
+			searchedRequests.erase(searchedRequests.begin() + n);
+		}
+
+		for (size_t n = 0; n < finishedRequests.size(); ) {
+			if (finishedRequests[n].owner != owner) {
+				++n;
+				continue;
+			}
+
+			pathIds.push_back(finishedRequests[n].pathId);
+			finishedRequests.erase(finishedRequests.begin() + n);
+		}
+	}
+
+	for (std::vector<unsigned int>::const_iterator it = pathIds.begin(); it != pathIds.end(); ++it) {
+		DeletePath(*it);
+	}
+}
+
+void CPathManager::StartPathRequests()
+{
+	boost::mutex::scoped_lock lock(asyncMutex);
+
+	// the previous ones are not joined yet (or still deferred)
+	if (queuedRequests.empty() || !asyncWorker->IsIdle())
+		return;
+
+	searchedRequests.swap(queuedRequests);
+	asyncWorker->Start();
+}
+
+void CPathManager::WaitForPathRequests()
+{
+	boost::mutex::scoped_lock lock(asyncMutex);
+
+	if (asyncWorker != NULL && asyncWorker->Wait())
+		JoinPathRequests();
+}
+
+void CPathManager::FinishPathRequests()
+{
+	// held while the deferred searches run, which keeps Lua and
+	// AIs on the draw thread from changing the unsynced costs
+	boost::mutex::scoped_lock lock(asyncMutex);
+
+	if (asyncWorker != NULL && asyncWorker->Finish())
+		JoinPathRequests();
+}
+
+void CPathManager::JoinPathRequests()
+{
+	// take over the found paths
+	for (std::vector<AsyncPathRequest>::iterator it = searchedRequests.begin(); it != searchedRequests.end(); ++it) {
+		AsyncPathRequest& request = *it;
+
+		if (request.pathId != 0) {
+			const std::map<unsigned int, MultiPath*>::iterator pi = asyncPathManager->pathMap.find(request.pathId);
+
+			request.pathId = Store(pi->second);
+			asyncPathManager->pathMap.erase(pi);
+		}
+
+		finishedRequests.push_back(request);
+	}
+
+	searchedRequests.clear();
+}
+
+
+void CPathManager::SearchAsyncPaths()
+{
+	//! reset FPU state for synced computations
+	streflop_init<streflop::Simple>();
+
+	for (std::vector<AsyncPathRequest>::iterator it = searchedRequests.begin(); it != searchedRequests.end(); ++it) {
+		AsyncPathRequest& request = *it;
+
+		// the search takes over the definition (it ends up in the path)
+		request.pathId = asyncPathManager->RequestPath(request.moveData, request.startPos, request.goalPos, request.pfDef, NULL, false);
+		request.pfDef = NULL;
+	}
+}
+
 /*
 Store a new multipath into the pathmap.
 */
@@ -523,6 +721,10 @@ bool CPathManager::SetNodeExtraCost(unsigned int x, unsigned int z, float cost,
 	if (x >= gs->mapx) { return false; }
 	if (z >= gs->mapy) { return false; }
 
+	// the async searches read the unsynced costs
+	if (!synced)
+		WaitForPathRequests();
+
 	PathNodeStateBuffer& maxResBuf = maxResPF->GetNodeStateBuffer();
 	PathNodeStateBuffer& medResBuf = medResPE->GetNodeStateBuffer();
 	PathNodeStateBuffer& lowResBuf = lowResPE->GetNodeStateBuffer();
@@ -537,6 +739,10 @@ bool CPathManager::SetNodeExtraCosts(const float* costs, unsigned int sizex, uns
 	if (sizex < 1 || sizex > gs->mapx) { return false; }
 	if (sizez < 1 || sizez > gs->mapy) { return false; }
 
+	// the async searches read the unsynced costs
+	if (!synced)
+		WaitForPathRequests();
+
 	PathNodeStateBuffer& maxResBuf = maxResPF->GetNodeStateBuffer();
 	PathNodeStateBuffer& medResBuf = medResPE->GetNodeStateBuffer();
 	PathNodeStateBuffer& lowResBuf = lowResPE->GetNodeStateBuffer();
@@ -562,3 +768,16 @@ const float* CPathManager::GetNodeExtraCosts(bool synced) const {
 	const float* costs = buf.GetNodeExtraCosts(synced);
 	return costs;
 }
+
+void CPathManager::GetPathCacheStats(unsigned int& numHits, unsigned int& numMisses, unsigned int& numItems, unsigned int& memFootPrint) const {
+	const CPathCache* caches[2] = {medResPE->GetPathCache(), lowResPE->GetPathCache()};
+
+	numHits = numMisses = numItems = memFootPrint = 0;
+
+	for (int n = 0; n < 2; n++) {
+		numHits += caches[n]->GetNumCacheHits();
+		numMisses += caches[n]->GetNumCacheMisses();
+		numItems += caches[n]->GetNumItems();
+		memFootPrint += caches[n]->GetMemFootPrint();
+	}
+}
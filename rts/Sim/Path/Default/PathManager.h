@@ -4,7 +4,9 @@
 #define PATHMANAGER_H
 
 #include <map>
+#include <vector>
 #include <boost/cstdint.hpp> /* Replace with <stdint.h> if appropriate */
+#include <boost/thread/mutex.hpp>
 
 #include "Sim/Path/IPathManager.h"
 #include "IPath.h"
@@ -16,6 +18,7 @@ class CPathEstimator;
 class CPathFinderDef;
 struct MoveData;
 class CMoveMath;
+class CPathSearchWorker;
 
 class CPathManager: public IPathManager {
 public:
@@ -76,6 +79,22 @@ public:
 	float GetNodeExtraCost(unsigned int, unsigned int, bool) const;
 	const float* GetNodeExtraCosts(bool) const;
 
+	void GetPathCacheStats(unsigned int& numHits, unsigned int& numMisses, unsigned int& numItems, unsigned int& memFootPrint) const;
+
+	unsigned int RequestPathAsync(
+		const void* owner,
+		const MoveData* moveData,
+		const float3& startPos,
+		const float3& goalPos,
+		float goalRadius = 8.0f
+	);
+
+	void GetFinishedPathRequests(const void* owner, std::vector<FinishedPathRequest>& requests);
+	void CancelPathRequests(const void* owner);
+	void StartPathRequests();
+	void WaitForPathRequests();
+	void FinishPathRequests();
+
 
 	/** Enable/disable heat mapping */
 	void SetHeatMappingEnabled(bool enabled);
@@ -85,6 +104,12 @@ public:
 	const int GetHeatOnSquare(int x, int y);
 
 private:
+	/**
+	 * Creates the path manager used by the async path thread: it searches
+	 * with its own PF and PE node-states on the data of <master>.
+	 */
+	CPathManager(const CPathManager* master);
+
 	unsigned int RequestPath(
 		const MoveData* moveData,
 		const float3& startPos,
@@ -131,6 +156,39 @@ private:
 
 	std::map<unsigned int, MultiPath*> pathMap;
 	unsigned int nextPathId;
+
+
+	struct AsyncPathRequest {
+		unsigned int requestId;
+		const void* owner;
+
+		const MoveData* moveData;
+		float3 startPos;
+		float3 goalPos;
+		CPathFinderDef* pfDef;
+
+		/// the result; in <asyncPathManager> until the request is finished
+		unsigned int pathId;
+	};
+
+	void SearchAsyncPaths();
+	/// takes over the requests searched by <asyncWorker>
+	void JoinPathRequests();
+
+	/// both created by the first async request
+	CPathManager* asyncPathManager;
+	CPathSearchWorker* asyncWorker;
+
+	boost::mutex asyncMutex;
+
+	/// not yet started by StartPathRequests
+	std::vector<AsyncPathRequest> queuedRequests;
+	/// handed to <asyncWorker> (only touched by it until it is done with them)
+	std::vector<AsyncPathRequest> searchedRequests;
+	/// waiting to be collected by GetFinishedPathRequests
+	std::vector<AsyncPathRequest> finishedRequests;
+
+	unsigned int nextRequestId;
 };
 
 #endif
@@ -0,0 +1,120 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "PathSearchWorker.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+
+CPathSearchWorker::CPathSearchWorker(const boost::function<void()>& search, bool threaded)
+	: search(search)
+	, thread(NULL)
+	, state(STATE_IDLE)
+	, stopThread(false)
+{
+	if (threaded) {
+		thread = new boost::thread(boost::bind(&CPathSearchWorker::Run, this));
+	}
+}
+
+CPathSearchWorker::~CPathSearchWorker()
+{
+	if (thread == NULL)
+		return;
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+
+		while (state == STATE_SEARCHING) {
+			cond.wait(lock);
+		}
+
+		stopThread = true;
+	}
+
+	cond.notify_all();
+	thread->join();
+	delete thread;
+}
+
+
+bool CPathSearchWorker::Start()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex);
+
+		if (state != STATE_IDLE)
+			return false;
+
+		state = (thread != NULL)? STATE_SEARCHING: STATE_DEFERRED;
+	}
+
+	cond.notify_all();
+	return true;
+}
+
+bool CPathSearchWorker::Wait()
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	while (state == STATE_SEARCHING) {
+		cond.wait(lock);
+	}
+
+	if (state != STATE_DONE)
+		return false;
+
+	state = STATE_IDLE;
+	return true;
+}
+
+bool CPathSearchWorker::Finish()
+{
+	bool deferred = false;
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+
+		if (state == STATE_DEFERRED) {
+			state = STATE_SEARCHING;
+			deferred = true;
+		}
+	}
+
+	if (deferred) {
+		// concurrent Wait's block until this is done
+		search();
+
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			state = STATE_DONE;
+		}
+
+		cond.notify_all();
+	}
+
+	return Wait();
+}
+
+
+void CPathSearchWorker::Run()
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	while (true) {
+		// wait until there is work (or the worker is deleted)
+		while (state != STATE_SEARCHING && !stopThread) {
+			cond.wait(lock);
+		}
+
+		if (stopThread)
+			break;
+
+		lock.unlock();
+		search();
+		lock.lock();
+
+		state = STATE_DONE;
+		cond.notify_all();
+	}
+}
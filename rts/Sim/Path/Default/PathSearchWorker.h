@@ -0,0 +1,64 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PATH_SEARCH_WORKER_H
+#define PATH_SEARCH_WORKER_H
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace boost {
+	class thread;
+}
+
+/**
+ * Runs the async path searches of CPathManager outside of the sim.
+ *
+ * Threaded, the searches started by Start run on a thread of their own
+ * (while the frame is drawn) and Wait joins them. Otherwise they are
+ * deferred until Finish is called, which runs them on the calling thread;
+ * that is for GML builds, where the sim has a thread of its own and can
+ * change the data the searches read while the frame is drawn.
+ */
+class CPathSearchWorker
+{
+public:
+	CPathSearchWorker(const boost::function<void()>& search, bool threaded);
+	/// waits for a running search, deferred ones are dropped
+	~CPathSearchWorker();
+
+	/// returns false (and does nothing) if the previous search is not joined yet
+	bool Start();
+	/**
+	 * Waits until a running search is done, deferred ones stay deferred.
+	 * @return true if the search handed out by Start is done, it then
+	 *   needs to be joined by the caller before the next Start
+	 */
+	bool Wait();
+	/// runs a deferred search (on the calling thread), then Wait
+	bool Finish();
+
+	bool IsThreaded() const { return (thread != NULL); }
+	bool IsIdle() const { return (state == STATE_IDLE); }
+
+private:
+	enum State {
+		STATE_IDLE,      ///< nothing handed out by Start
+		STATE_DEFERRED,  ///< started, but not threaded, see Finish
+		STATE_SEARCHING,
+		STATE_DONE       ///< not yet joined by Wait
+	};
+
+	void Run();
+
+	boost::function<void()> search;
+	boost::thread* thread;
+
+	boost::mutex mutex;
+	boost::condition_variable cond;
+
+	volatile State state;
+	bool stopThread;
+};
+
+#endif // PATH_SEARCH_WORKER_H
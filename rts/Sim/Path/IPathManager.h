@@ -3,6 +3,7 @@
 #ifndef I_PATH_MANAGER_H
 #define I_PATH_MANAGER_H
 
+#include <vector>
 #include <boost/cstdint.hpp> /* Replace with <stdint.h> if appropriate */
 #include "System/float3.h"
 
@@ -115,6 +116,52 @@ public:
 		bool synced = true
 	) { return 0; }
 
+	/**
+	 * Queues an unsynced path request (see RequestPath). It is searched
+	 * on the async path thread, with node-state buffers of its own, while
+	 * the current frame is drawn; the result can be collected from the
+	 * next frame on with GetFinishedPathRequests.
+	 *
+	 * @param owner
+	 *     Identifies the requester (e.g. a Lua state or an AI callback),
+	 *     only used to hand the results back to it.
+	 * @return
+	 *     a request-id >= 1, or 0 if async requests are not supported
+	 */
+	virtual unsigned int RequestPathAsync(
+		const void* owner,
+		const MoveData* moveData,
+		const float3& startPos,
+		const float3& goalPos,
+		float goalRadius = 8.0f
+	) { return 0; }
+
+	typedef std::pair<unsigned int, unsigned int> FinishedPathRequest;
+
+	/**
+	 * Moves the finished async requests of <owner> into <requests>, as
+	 * (request-id, path-id) pairs. The path-id is 0 if no path was found,
+	 * otherwise it is owned by the caller (see DeletePath).
+	 */
+	virtual void GetFinishedPathRequests(const void* owner, std::vector<FinishedPathRequest>& requests) {}
+	/// drops all queued and finished async requests of <owner>
+	virtual void CancelPathRequests(const void* owner) {}
+	/// hands the queued async requests to the async path thread (or defers them, see FinishPathRequests)
+	virtual void StartPathRequests() {}
+	/**
+	 * Waits until the async path thread is done with the requests handed
+	 * to it by StartPathRequests. Must be called before anything the
+	 * searches read (map, blocking-map, estimators, ...) is changed.
+	 */
+	virtual void WaitForPathRequests() {}
+	/**
+	 * Like WaitForPathRequests, but first runs the searches that were
+	 * deferred (GML builds with a sim thread, where they cannot run while
+	 * the frame is drawn) on the calling thread. Called by the sim at the
+	 * start of each update.
+	 */
+	virtual void FinishPathRequests() {}
+
 	/**
 	 * Whenever there are any changes in the terrain
 	 * (examples: explosions, new buildings, etc.)
@@ -138,6 +185,14 @@ public:
 	virtual bool SetNodeExtraCost(unsigned int x, unsigned int z, float cost, bool synced) { return false; }
 	virtual float GetNodeExtraCost(unsigned int x, unsigned int z, bool synced) const { return 0.0f; }
 	virtual const float* GetNodeExtraCosts(bool synced) const { return NULL; }
+
+	/**
+	 * Statistics of the (synced) path caches, summed over all estimators.
+	 * @param memFootPrint approximate memory used by the cached paths, in bytes
+	 */
+	virtual void GetPathCacheStats(unsigned int& numHits, unsigned int& numMisses, unsigned int& numItems, unsigned int& memFootPrint) const {
+		numHits = numMisses = numItems = memFootPrint = 0;
+	}
 };
 
 extern IPathManager* pathManager;
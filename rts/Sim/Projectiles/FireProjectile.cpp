@@ -100,13 +100,17 @@ void CFireProjectile::Update()
 		}
 		if (!(ttl & 31)) {
 			//! synced code
-			const std::vector<CFeature*>& f = qf->GetFeaturesExact(emitPos + wind.GetCurrentWind()*0.7f, emitRadius * 2);
+			//! (reused by all fires, the loops do not create or update any)
+			static std::vector<CFeature*> f;
+			static std::vector<CUnit*> units;
+
+			qf->GetFeaturesExact(emitPos + wind.GetCurrentWind()*0.7f, emitRadius * 2, f);
 			for (std::vector<CFeature*>::const_iterator fi = f.begin(); fi != f.end(); ++fi) {
 				if (gs->randFloat() > 0.8f) {
 					(*fi)->StartFire();
 				}
 			}
-			const std::vector<CUnit*>& units = qf->GetUnitsExact(emitPos + wind.GetCurrentWind()*0.7f, emitRadius * 2);
+			qf->GetUnitsExact(emitPos + wind.GetCurrentWind()*0.7f, emitRadius * 2, true, units);
 			for (std::vector<CUnit*>::const_iterator ui = units.begin(); ui != units.end(); ++ui) {
 				(*ui)->DoDamage(DamageArray(30), 0, ZeroVector);
 			}
@@ -34,6 +34,7 @@ CR_REG_METADATA(CProjectile,
 	CR_MEMBER(collisionFlags),
 
 	CR_MEMBER(quadFieldCellCoors),
+	CR_MEMBER(quadFieldCellIdx),
 
 	CR_MEMBER(mygravity),
 	CR_MEMBER_BEGINFLAG(CM_Config),
@@ -62,7 +63,8 @@ CProjectile::CProjectile():
 	mygravity(mapInfo? mapInfo->map.gravity: 0.0f),
 	ownerId(0),
 	projectileType(-1U),
-	collisionFlags(0)
+	collisionFlags(0),
+	quadFieldCellIdx(-1)
 {
 	GML_GET_TICKS(lastProjUpdate);
 }
@@ -81,7 +83,8 @@ CProjectile::CProjectile(const float3& pos, const float3& spd, CUnit* owner, boo
 	mygravity(mapInfo? mapInfo->map.gravity: 0.0f),
 	ownerId(0),
 	projectileType(-1U),
-	collisionFlags(0)
+	collisionFlags(0),
+	quadFieldCellIdx(-1)
 {
 	Init(ZeroVector, owner);
 	GML_GET_TICKS(lastProjUpdate);
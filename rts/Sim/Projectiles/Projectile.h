@@ -53,8 +53,8 @@ public:
 	void SetQuadFieldCellCoors(const int2& cell) { quadFieldCellCoors = cell; }
 	int2 GetQuadFieldCellCoors() const { return quadFieldCellCoors; }
 
-	void SetQuadFieldCellIter(const std::list<CProjectile*>::iterator& it) { quadFieldCellIter = it; }
-	const std::list<CProjectile*>::iterator& GetQuadFieldCellIter() { return quadFieldCellIter; }
+	void SetQuadFieldCellIdx(int idx) { quadFieldCellIdx = idx; }
+	int GetQuadFieldCellIdx() const { return quadFieldCellIdx; }
 
 	unsigned int GetProjectileType() const { return projectileType; }
 	unsigned int GetCollisionFlags() const { return collisionFlags; }
@@ -91,7 +91,7 @@ protected:
 	unsigned int collisionFlags;
 
 	int2 quadFieldCellCoors;
-	std::list<CProjectile*>::iterator quadFieldCellIter;
+	int quadFieldCellIdx; ///< slot in the projectile array of our quadfield cell
 };
 
 #endif /* PROJECTILE_H */
@@ -0,0 +1,91 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef ACTIVE_UNIT_ARRAY_H
+#define ACTIVE_UNIT_ARRAY_H
+
+#include <vector>
+#include <cassert>
+
+/**
+ * Helpers for the dense array of active units kept by CUnitHandler.
+ *
+ * The objects are stored contiguously, slots[object->id] holds the index
+ * of every object so it can be removed in O(1). Passes over the array
+ * walk it by index; a pass that is in progress is described by a cursor
+ * (the first index it has not visited yet). Insert and Remove keep every
+ * visited object in front of that cursor and every unvisited one behind
+ * it, so no object is visited twice or skipped by the pass.
+ *
+ * Everything here only depends on its arguments, so the resulting order
+ * is the same on every client.
+ */
+namespace ActiveUnitArray {
+	template<typename T> inline void Move(std::vector<T*>& objs, std::vector<unsigned int>& slots, unsigned int from, unsigned int to) {
+		objs[to] = objs[from];
+		slots[objs[to]->id] = to;
+	}
+
+	/**
+	 * Puts @c o at index @c pos, the object that was there moves to the
+	 * end. Inserting at or behind a cursor does not disturb its pass.
+	 */
+	template<typename T> inline void Insert(std::vector<T*>& objs, std::vector<unsigned int>& slots, T* o, unsigned int pos) {
+		assert(pos <= objs.size());
+
+		if (pos < objs.size()) {
+			objs.push_back(objs[pos]);
+			slots[objs.back()->id] = objs.size() - 1;
+			objs[pos] = o;
+		} else {
+			objs.push_back(o);
+		}
+
+		slots[o->id] = pos;
+	}
+
+	/**
+	 * Removes @c o; if it was in front of @c cursor (already visited),
+	 * its place is taken by the last visited object and the cursor moves
+	 * back by one, otherwise the last object takes its place.
+	 */
+	template<typename T> inline void Remove(std::vector<T*>& objs, std::vector<unsigned int>& slots, T* o, unsigned int& cursor) {
+		assert(!objs.empty());
+		assert(cursor <= objs.size());
+
+		const unsigned int idx = slots[o->id];
+		const unsigned int last = objs.size() - 1;
+
+		assert(idx <= last);
+		assert(objs[idx] == o);
+
+		if (idx < cursor) {
+			Move(objs, slots, cursor - 1, idx);
+
+			// if the cursor is at the end, the last object already took idx
+			if (cursor - 1 != last) {
+				Move(objs, slots, last, cursor - 1);
+			}
+
+			cursor -= 1;
+		} else {
+			Move(objs, slots, last, idx);
+		}
+
+		objs.pop_back();
+	}
+
+	/// returns true if @c o is in the array
+	template<typename T> inline bool Contains(const std::vector<T*>& objs, const std::vector<unsigned int>& slots, const T* o) {
+		const unsigned int idx = slots[o->id];
+		return (idx < objs.size() && objs[idx] == o);
+	}
+
+	/// recalculates all slots (eg. after loading the array)
+	template<typename T> inline void UpdateSlots(const std::vector<T*>& objs, std::vector<unsigned int>& slots) {
+		for (unsigned int n = 0; n < objs.size(); n++) {
+			slots[objs[n]->id] = n;
+		}
+	}
+}
+
+#endif /* ACTIVE_UNIT_ARRAY_H */
@@ -63,6 +63,11 @@ CUnitSet CBuilderCAI::reclaimers;
 CUnitSet CBuilderCAI::featureReclaimers;
 CUnitSet CBuilderCAI::resurrecters;
 
+// reused by the Find*Target* searches (these only scan
+// the query results, and never call into each other)
+static std::vector<CUnit*> nearUnits;
+static std::vector<CFeature*> nearFeatures;
+
 
 CBuilderCAI::CBuilderCAI():
 	CMobileCAI(),
@@ -1340,8 +1345,8 @@ bool CBuilderCAI::FindReclaimTargetAndReclaim(const float3& pos,
 	int rid = -1;
 
 	if(recUnits || recEnemy || recEnemyOnly) {
-		const std::vector<CUnit*> &units = qf->GetUnitsExact(pos, radius);
-		for (std::vector<CUnit*>::const_iterator ui = units.begin(); ui != units.end(); ++ui) {
+		qf->GetUnitsExact(pos, radius, true, nearUnits);
+		for (std::vector<CUnit*>::const_iterator ui = nearUnits.begin(); ui != nearUnits.end(); ++ui) {
 			const CUnit* u = *ui;
 			if (u != owner
 			    && u->unitDef->reclaimable
@@ -1374,8 +1379,8 @@ bool CBuilderCAI::FindReclaimTargetAndReclaim(const float3& pos,
 	if((!best || !stationary) && !recEnemyOnly) {
 		const CTeam* team = teamHandler->Team(owner->team);
 		best = NULL;
-		const std::vector<CFeature*> &features = qf->GetFeaturesExact(pos, radius);
-		for (std::vector<CFeature*>::const_iterator fi = features.begin(); fi != features.end(); ++fi) {
+		qf->GetFeaturesExact(pos, radius, nearFeatures);
+		for (std::vector<CFeature*>::const_iterator fi = nearFeatures.begin(); fi != nearFeatures.end(); ++fi) {
 			const CFeature* f = *fi;
 			if (f->def->reclaimable && (recSpecial || f->def->autoreclaim) && 
 				(!recNonRez || !(f->def->destructable && f->udef != NULL))) {
@@ -1433,12 +1438,12 @@ bool CBuilderCAI::FindResurrectableFeatureAndResurrect(const float3& pos,
                                                        unsigned char options,
 													   bool freshOnly)
 {
-	const std::vector<CFeature*> &features = qf->GetFeaturesExact(pos, radius);
+	qf->GetFeaturesExact(pos, radius, nearFeatures);
 
 	const CFeature* best = NULL;
 	float bestDist = 1.0e30f;
 
-	for (std::vector<CFeature*>::const_iterator fi = features.begin(); fi != features.end(); ++fi) {
+	for (std::vector<CFeature*>::const_iterator fi = nearFeatures.begin(); fi != nearFeatures.end(); ++fi) {
 		const CFeature* f = *fi;
 		if (f->def->destructable && f->udef != NULL) {
 			if (!f->IsInLosForAllyTeam(owner->allyteam)) {
@@ -1477,14 +1482,14 @@ bool CBuilderCAI::FindCaptureTargetAndCapture(const float3& pos, float radius,
                                               unsigned char options,
 											  bool healthyOnly)
 {
-	const std::vector<CUnit*> &cu = qf->GetUnits(pos, radius);
+	qf->GetUnits(pos, radius, nearUnits);
 	std::vector<CUnit*>::const_iterator ui;
 
 	const CUnit* best = NULL;
 	float bestDist = 1.0e30f;
 	bool stationary = false;
 
-	for (ui = cu.begin(); ui != cu.end(); ++ui) {
+	for (ui = nearUnits.begin(); ui != nearUnits.end(); ++ui) {
 		CUnit* unit = *ui;
 
 		if ((((options & CONTROL_KEY) && owner->team != unit->team) ||
@@ -1527,7 +1532,7 @@ bool CBuilderCAI::FindRepairTargetAndRepair(const float3& pos, float radius,
                                             bool attackEnemy,
 											bool builtOnly)
 {
-	const std::vector<CUnit*> &cu = qf->GetUnitsExact(pos, radius);
+	qf->GetUnitsExact(pos, radius, true, nearUnits);
 
 	const CUnit* best = NULL;
 	float bestDist = 1.0e30f;
@@ -1535,7 +1540,7 @@ bool CBuilderCAI::FindRepairTargetAndRepair(const float3& pos, float radius,
 	bool trySelfRepair = false;
 	bool stationary = false;
 
-	for (std::vector<CUnit*>::const_iterator ui = cu.begin(); ui != cu.end(); ++ui) {
+	for (std::vector<CUnit*>::const_iterator ui = nearUnits.begin(); ui != nearUnits.end(); ++ui) {
 		CUnit* unit = *ui;
 		if (teamHandler->Ally(owner->allyteam, unit->allyteam)) {
 			if (!haveEnemy && (unit->health < unit->maxHealth)) {
@@ -39,6 +39,10 @@ CR_REG_METADATA(CTransportCAI, (
 				CR_RESERVED(16)
 				));
 
+// reused by the unload-spot and transportee searches
+static std::vector<CUnit*> nearUnits;
+
+
 CTransportCAI::CTransportCAI()
 	: CMobileCAI()
 	, unloadType(-1)
@@ -333,8 +337,8 @@ bool CTransportCAI::FindEmptySpot(float3 center, float radius, float emptyRadius
 					&& ground->GetSlope(pos.x, pos.z) > unitToUnload->unitDef->movedata->maxSlope) {
 				continue;
 			}
-			const std::vector<CUnit*> &units = qf->GetUnitsExact(pos, emptyRadius + 8);
-			if (units.size() > 1 || (units.size() == 1 && units[0] != owner)) {
+			qf->GetUnitsExact(pos, emptyRadius + 8, true, nearUnits);
+			if (nearUnits.size() > 1 || (nearUnits.size() == 1 && nearUnits[0] != owner)) {
 				continue;
 			}
 
@@ -369,7 +373,9 @@ bool CTransportCAI::FindEmptySpot(float3 center, float radius, float emptyRadius
 					continue;
 				}
 
-				if (!qf->GetUnitsExact(pos, emptyRadius + 8).empty()) {
+				qf->GetUnitsExact(pos, emptyRadius + 8, true, nearUnits);
+
+				if (!nearUnits.empty()) {
 					continue;
 				}
 
@@ -390,7 +396,9 @@ bool CTransportCAI::SpotIsClear(float3 pos, CUnit* unitToUnload)
 	if (unitToUnload->unitDef->movedata && ground->GetSlope(pos.x,pos.z) > unitToUnload->unitDef->movedata->maxSlope) {
 		return false;
 	}
-	if (!qf->GetUnitsExact(pos,unitToUnload->radius + 8).empty()) {
+	qf->GetUnitsExact(pos, unitToUnload->radius + 8, true, nearUnits);
+
+	if (!nearUnits.empty()) {
 		return false;
 	}
 
@@ -407,9 +415,10 @@ bool CTransportCAI::SpotIsClearIgnoreSelf(float3 pos, CUnit* unitToUnload)
 		return false;
 	}
 
-	const std::vector<CUnit*>& units = qf->GetUnitsExact(pos,unitToUnload->radius + 8);
+	qf->GetUnitsExact(pos, unitToUnload->radius + 8, true, nearUnits);
+
 	CTransportUnit* me = (CTransportUnit*) owner;
-	for (std::vector<CUnit*>::const_iterator it = units.begin(); it != units.end(); ++it) {
+	for (std::vector<CUnit*>::const_iterator it = nearUnits.begin(); it != nearUnits.end(); ++it) {
 		// check if the units are in the transport
 		bool found = false;
 		for (std::list<CTransportUnit::TransportedUnit>::const_iterator it2 = me->GetTransportedUnits().begin();
@@ -873,8 +882,8 @@ CUnit* CTransportCAI::FindUnitToTransport(float3 center, float radius)
 {
 	CUnit* best = NULL;
 	float bestDist = 100000000.0f;
-	const std::vector<CUnit*>& units = qf->GetUnitsExact(center, radius);
-	for (std::vector<CUnit*>::const_iterator ui = units.begin(); ui != units.end(); ++ui) {
+	qf->GetUnitsExact(center, radius, true, nearUnits);
+	for (std::vector<CUnit*>::const_iterator ui = nearUnits.begin(); ui != nearUnits.end(); ++ui) {
 		CUnit* unit = (*ui);
 		float dist = unit->pos.SqDistance2D(owner->pos);
 		if (CanTransport(unit) && dist<bestDist && !unit->toBeTransported &&
@@ -11,6 +11,7 @@
 #include "LuaScriptNames.h"
 #include "Lua/LuaCallInCheck.h"
 #include "Lua/LuaHandleSynced.h"
+#include "Lua/LuaHashString.h"
 #include "Sim/Units/UnitHandler.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Weapons/PlasmaRepulser.h"
@@ -198,7 +199,7 @@ CLuaUnitScript::~CLuaUnitScript()
 
 void CLuaUnitScript::HandleFreed(CLuaHandle* handle)
 {
-	std::list<CUnit*>::iterator ui;
+	std::vector<CUnit*>::iterator ui;
 	for (ui = uh->activeUnits.begin(); ui != uh->activeUnits.end(); ++ui) {
 		CLuaUnitScript* script = dynamic_cast<CLuaUnitScript*>((*ui)->script);
 
@@ -381,9 +382,26 @@ inline void CLuaUnitScript::PushUnit(const CUnit* targetUnit)
 }
 
 
+// the LUAFN_* names, hashed once
+static const LuaHashString& GetCallInName(int id)
+{
+	static std::vector<LuaHashString> callInNames;
+
+	if (callInNames.empty()) {
+		const std::vector<std::string>& scriptNames = CLuaUnitScriptNames::GetScriptNames();
+
+		for (size_t n = 0; n < scriptNames.size(); ++n) {
+			callInNames.push_back(LuaHashString(scriptNames[n]));
+		}
+	}
+
+	return callInNames[id];
+}
+
+
 inline bool CLuaUnitScript::RunCallIn(int id, int inArgs, int outArgs)
 {
-	return RawRunCallIn(scriptIndex[id], inArgs, outArgs);
+	return RawRunCallIn(scriptIndex[id], GetCallInName(id), inArgs, outArgs);
 }
 
 
@@ -446,6 +464,21 @@ int CLuaUnitScript::RunQueryCallIn(int fn, float arg1)
 }
 
 
+void CLuaUnitScript::Call(int fn)
+{
+	if (!HasFunction(fn)) {
+		return;
+	}
+
+	LUA_CALL_IN_CHECK(L);
+	lua_checkstack(L, 1);
+
+	PushFunction(fn);
+
+	RunCallIn(fn, 0, 0);
+}
+
+
 void CLuaUnitScript::Call(int fn, float arg1)
 {
 	if (!HasFunction(fn)) {
@@ -827,7 +860,7 @@ void CLuaUnitScript::RawCall(int functionId)
 	lua_checkstack(L, 1);
 
 	RawPushFunction(functionId);
-	RawRunCallIn(functionId, 0, 0);
+	RawRunCallIn(functionId, LuaHashString(GetScriptName(functionId)), 0, 0);
 }
 
 
@@ -844,19 +877,19 @@ string CLuaUnitScript::GetScriptName(int functionId) const
 }
 
 
-bool CLuaUnitScript::RawRunCallIn(int functionId, int inArgs, int outArgs)
+bool CLuaUnitScript::RawRunCallIn(int functionId, const LuaHashString& callIn, int inArgs, int outArgs)
 {
 	activeUnit = unit;
 	activeScript = this;
 
 	std::string err;
-	const int error = handle->RunCallIn(inArgs, outArgs, err);
+	const int error = handle->RunCallIn(callIn, inArgs, outArgs, err);
 
 	activeUnit = NULL;
 	activeScript = NULL;
 
 	if (error != 0) {
-		const string& fname = GetScriptName(functionId);
+		const string& fname = callIn.GetString();
 
 		LOG_L(L_ERROR, "%s::RunCallIn: error = %i, %s::%s, %s",
 				handle->GetName().c_str(), error, "CLuaUnitScript",
@@ -8,6 +8,7 @@
 
 class CUnit;
 class CLuaHandle;
+struct LuaHashString;
 struct lua_State;
 
 class CLuaUnitScript : public CUnitScript, CUnitScript::IAnimListener
@@ -46,7 +47,7 @@ protected:
 
 	int  RunQueryCallIn(int fn);
 	int  RunQueryCallIn(int fn, float arg1);
-	void Call(int fn) { RawCall(scriptIndex[fn]); }
+	void Call(int fn);
 	void Call(int fn, float arg1);
 	void Call(int fn, float arg1, float arg2);
 	void Call(int fn, float arg1, float arg2, float arg3);
@@ -57,7 +58,8 @@ protected:
 
 	bool RunCallIn(int id, int inArgs, int outArgs);
 	std::string GetScriptName(int functionId) const;
-	bool RawRunCallIn(int functionId, int inArgs, int outArgs);
+	/// @param callIn name of the function, for the call-in stats
+	bool RawRunCallIn(int functionId, const LuaHashString& callIn, int inArgs, int outArgs);
 
 public:
 
@@ -1699,7 +1699,7 @@ void CUnitScript::BenchmarkScript(CUnitScript* script)
 
 void CUnitScript::BenchmarkScript(const std::string& unitname)
 {
-	std::list<CUnit*>::iterator ui = uh->activeUnits.begin();
+	std::vector<CUnit*>::iterator ui = uh->activeUnits.begin();
 	for (; ui != uh->activeUnits.end(); ++ui) {
 		CUnit* unit = *ui;
 		if (unit->unitDef->name == unitname) {
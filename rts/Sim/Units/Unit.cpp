@@ -1045,12 +1045,19 @@ void CUnit::SlowUpdateWeapons() {
 
 			w->SlowUpdate();
 
-			if (w->targetType == Target_None && fireState > FIRESTATE_HOLDFIRE && lastAttacker && (lastAttack + 200 > gs->frameNum))
-				w->AttackUnit(lastAttacker, false);
+			// otherwise done by CUnitHandler once the new target is picked
+			if (!w->pendingAutoTarget) {
+				RetaliateWithWeapon(w);
+			}
 		}
 	}
 }
 
+void CUnit::RetaliateWithWeapon(CWeapon* w) {
+	if (w->targetType == Target_None && fireState > FIRESTATE_HOLDFIRE && lastAttacker && (lastAttack + 200 > gs->frameNum))
+		w->AttackUnit(lastAttacker, false);
+}
+
 
 
 void CUnit::DoWaterDamage()
@@ -78,6 +78,8 @@ public:
 
 	virtual void SlowUpdate();
 	virtual void SlowUpdateWeapons();
+	/// makes <w> attack the last attacker if it found nothing else to shoot at
+	void RetaliateWithWeapon(CWeapon* w);
 	virtual void Update();
 
 	virtual void DoDamage(const DamageArray& damages, CUnit* attacker,
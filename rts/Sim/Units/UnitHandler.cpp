@@ -1,10 +1,12 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <cassert>
 #include "System/mmgr.h"
 
 #include "lib/gml/gml.h"
 #include "UnitHandler.h"
+#include "ActiveUnitArray.h"
 #include "Unit.h"
 #include "UnitDefHandler.h"
 #include "CommandAI/BuilderCAI.h"
@@ -17,14 +19,17 @@
 #include "Sim/Features/FeatureDef.h"
 #include "Sim/Misc/AirBaseHandler.h"
 #include "Sim/Misc/GroundBlockingObjectMap.h"
+#include "Sim/Misc/LosHandler.h"
 #include "Sim/Misc/QuadField.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/MoveType.h"
+#include "Sim/Weapons/Weapon.h"
 #include "System/EventHandler.h"
 #include "System/EventBatchHandler.h"
 #include "System/Log/ILog.h"
 #include "System/TimeProfiler.h"
 #include "System/myMath.h"
+#include "System/OpenMP_cond.h"
 #include "System/Sync/SyncTracer.h"
 #include "System/creg/STL_Deque.h"
 #include "System/creg/STL_List.h"
@@ -57,7 +62,12 @@ CR_REG_METADATA(CUnitHandler, (
 void CUnitHandler::PostLoad()
 {
 	// reset any synced stuff that is not saved
-	slowUpdateIterator = activeUnits.end();
+	activeSlots.clear();
+	activeSlots.resize(units.size(), 0);
+	ActiveUnitArray::UpdateSlots(activeUnits, activeSlots);
+
+	slowUpdateIndex = activeUnits.size();
+	updateIndex = 0;
 }
 
 
@@ -65,6 +75,9 @@ CUnitHandler::CUnitHandler()
 :
 	maxUnitRadius(0.0f),
 	morphUnitToFeature(true),
+	slowUpdateIndex(0),
+	updateIndex(0),
+	stageWeaponTargets(false),
 	maxUnits(0)
 {
 	// note: the number of active teams can change at run-time, so
@@ -75,6 +88,8 @@ CUnitHandler::CUnitHandler()
 	}
 
 	units.resize(maxUnits, NULL);
+	activeSlots.resize(maxUnits, 0);
+	activeUnits.reserve(maxUnits);
 	unitsByDefs.resize(teamHandler->ActiveTeams(), std::vector<CUnitSet>(unitDefHandler->unitDefs.size()));
 
 	{
@@ -96,14 +111,13 @@ CUnitHandler::CUnitHandler()
 		std::copy(freeIDs.begin(), freeIDs.end(), std::front_inserter(freeUnitIDs));
 	}
 
-	slowUpdateIterator = activeUnits.end();
 	airBaseHandler = new CAirBaseHandler();
 }
 
 
 CUnitHandler::~CUnitHandler()
 {
-	for (std::list<CUnit*>::iterator usi = activeUnits.begin(); usi != activeUnits.end(); ++usi) {
+	for (std::vector<CUnit*>::iterator usi = activeUnits.begin(); usi != activeUnits.end(); ++usi) {
 		// ~CUnit dereferences featureHandler which is destroyed already
 		(*usi)->delayedWreckLevel = -1;
 		delete (*usi);
@@ -126,19 +140,20 @@ bool CUnitHandler::AddUnit(CUnit *unit)
 	unit->id = freeUnitIDs.front();
 	units[unit->id] = unit;
 
-	std::list<CUnit*>::iterator ui = activeUnits.begin();
+	unsigned int insertionPos = activeUnits.size();
 
-	if (ui != activeUnits.end()) {
+	if (!activeUnits.empty()) {
 		// randomize this to make the slow-update order random (good if one
 		// builds say many buildings at once and then many mobile ones etc)
-		const unsigned int insertionPos = gs->randFloat() * activeUnits.size();
+		// but never put the unit in front of a pass that is in progress,
+		// that would make the pass visit the unit it displaces twice
+		const unsigned int minPos = std::max(slowUpdateIndex, updateIndex);
 
-		for (unsigned int n = 0; n < insertionPos; ++n) {
-			++ui;
-		}
+		insertionPos = minPos + gs->randFloat() * (activeUnits.size() - minPos);
+		insertionPos = std::min(insertionPos, (unsigned int) activeUnits.size());
 	}
 
-	activeUnits.insert(ui, unit);
+	ActiveUnitArray::Insert(activeUnits, activeSlots, unit, insertionPos);
 	freeUnitIDs.pop_front();
 
 	teamHandler->Team(unit->team)->AddUnit(unit, CTeam::AddBuilt);
@@ -157,45 +172,34 @@ void CUnitHandler::DeleteUnit(CUnit* unit)
 
 void CUnitHandler::DeleteUnitNow(CUnit* delUnit)
 {
-	int delTeam = 0;
-	int delType = 0;
-
-	std::list<CUnit*>::iterator usi;
-	for (usi = activeUnits.begin(); usi != activeUnits.end(); ++usi) {
-		if (*usi == delUnit) {
-			if (slowUpdateIterator != activeUnits.end() && *usi == *slowUpdateIterator) {
-				++slowUpdateIterator;
-			}
-			delTeam = delUnit->team;
-			delType = delUnit->unitDef->id;
+	if (!ActiveUnitArray::Contains(activeUnits, activeSlots, delUnit)) {
+		LOG_L(L_ERROR, "Tried to delete a unit that is not active");
+		return;
+	}
 
-			#if defined(USE_GML) && GML_ENABLE_SIM
-			GML_STDMUTEX_LOCK(dque); // DeleteUnitNow
-			#endif
+	const int delTeam = delUnit->team;
+	const int delType = delUnit->unitDef->id;
+	const int delID = delUnit->id;
 
-			int delID = delUnit->id;
-			activeUnits.erase(usi);
-			units[delID] = 0;
-			freeUnitIDs.push_back(delID);
-			teamHandler->Team(delTeam)->RemoveUnit(delUnit, CTeam::RemoveDied);
+	#if defined(USE_GML) && GML_ENABLE_SIM
+	GML_STDMUTEX_LOCK(dque); // DeleteUnitNow
+	#endif
 
-			unitsByDefs[delTeam][delType].erase(delUnit);
+	ActiveUnitArray::Remove(activeUnits, activeSlots, delUnit, slowUpdateIndex);
 
-			CSolidObject::SetDeletingRefID(delID);
-			delete delUnit;
-			CSolidObject::SetDeletingRefID(-1);
-			break;
-		}
-	}
+	units[delID] = 0;
+	freeUnitIDs.push_back(delID);
+	teamHandler->Team(delTeam)->RemoveUnit(delUnit, CTeam::RemoveDied);
+
+	unitsByDefs[delTeam][delType].erase(delUnit);
+
+	CSolidObject::SetDeletingRefID(delID);
+	delete delUnit;
+	CSolidObject::SetDeletingRefID(-1);
 
 #ifdef _DEBUG
-	for (usi = activeUnits.begin(); usi != activeUnits.end(); /* no post-op */) {
-		if (*usi == delUnit) {
-			LOG_L(L_ERROR, "Duplicated unit found in active units on erase");
-			usi = activeUnits.erase(usi);
-		} else {
-			++usi;
-		}
+	if (std::find(activeUnits.begin(), activeUnits.end(), delUnit) != activeUnits.end()) {
+		LOG_L(L_ERROR, "Duplicated unit found in active units on erase");
 	}
 #endif
 }
@@ -255,16 +259,36 @@ void CUnitHandler::Update()
 		VECTOR_SANITY_CHECK(unit->frontdir);        \
 		MAPPOS_SANITY_CHECK(unit);
 
+	{
+		SCOPED_TIMER("Unit::MoveType::UpdatePlan");
+
+		// the plans only read the state of this frame (as it is before
+		// any unit moves) and write to their own move-type, so they can
+		// run in any order and in parallel; the commits below stay in
+		// activeUnits order, which makes the result independent of the
+		// number of threads
+		const int numActiveUnits = activeUnits.size();
+
+		int n;
+		#pragma omp parallel for private(n) schedule(dynamic, 32)
+		for (n = 0; n < numActiveUnits; ++n) {
+			activeUnits[n]->moveType->UpdatePlan();
+		}
+	}
+
+	// note: units can be added while the passes below run (but
+	// not removed), AddUnit never inserts them in front of the
+	// unit that is being updated
 	{
 		SCOPED_TIMER("Unit::MoveType::Update");
-		std::list<CUnit*>::iterator usi;
-		for (usi = activeUnits.begin(); usi != activeUnits.end(); ++usi) {
-			CUnit* unit = *usi;
+
+		for (updateIndex = 0; updateIndex < activeUnits.size(); ) {
+			CUnit* unit = activeUnits[updateIndex++];
 			AMoveType* moveType = unit->moveType;
 
 			UNIT_SANITY_CHECK(unit);
 
-			if (moveType->Update()) {
+			if (moveType->Update() && eventHandler.HaveUnitMoved()) {
 				eventHandler.UnitMoved(unit);
 			}
 			if (!unit->pos.IsInBounds() && (unit->speed.SqLength() > (MAX_UNIT_SPEED * MAX_UNIT_SPEED))) {
@@ -276,13 +300,19 @@ void CUnitHandler::Update()
 			UNIT_SANITY_CHECK(unit);
 			GML_GET_TICKS(unit->lastUnitUpdate);
 		}
+
+		updateIndex = 0;
+
+		// units killed above are only deleted next frame, so
+		// the batch can not contain any dangling pointers
+		eventHandler.FlushUnitsMoved();
 	}
 
 	{
 		SCOPED_TIMER("Unit::Update");
-		std::list<CUnit*>::iterator usi;
-		for (usi = activeUnits.begin(); usi != activeUnits.end(); ++usi) {
-			CUnit* unit = *usi;
+
+		for (updateIndex = 0; updateIndex < activeUnits.size(); ) {
+			CUnit* unit = activeUnits[updateIndex++];
 
 			UNIT_SANITY_CHECK(unit);
 
@@ -300,21 +330,29 @@ void CUnitHandler::Update()
 
 			UNIT_SANITY_CHECK(unit);
 		}
+
+		updateIndex = 0;
 	}
 
 	{
 		SCOPED_TIMER("Unit::SlowUpdate");
 
-		// reset the iterator every <UNIT_SLOWUPDATE_RATE> frames
+		// restart the round every <UNIT_SLOWUPDATE_RATE> frames
 		if ((gs->frameNum & (UNIT_SLOWUPDATE_RATE - 1)) == 0) {
-			slowUpdateIterator = activeUnits.begin();
+			slowUpdateIndex = 0;
 		}
 
 		// stagger the SlowUpdate's
 		int n = (activeUnits.size() / UNIT_SLOWUPDATE_RATE) + 1;
 
-		for (; slowUpdateIterator != activeUnits.end() && n != 0; ++slowUpdateIterator) {
-			CUnit* unit = *slowUpdateIterator;
+		// units that moved to a new LOS square get their ground LOS
+		// ray-casted all at once when the batch ends, instead of one
+		// by one from AMoveType::SlowUpdate
+		loshandler->BeginLosUpdateBatch();
+		stageWeaponTargets = true;
+
+		for (; slowUpdateIndex < activeUnits.size() && n != 0; ) {
+			CUnit* unit = activeUnits[slowUpdateIndex++];
 
 			UNIT_SANITY_CHECK(unit);
 			unit->SlowUpdate();
@@ -322,10 +360,69 @@ void CUnitHandler::Update()
 
 			n--;
 		}
+
+		stageWeaponTargets = false;
+		loshandler->EndLosUpdateBatch();
+	}
+
+	{
+		SCOPED_TIMER("Unit::SlowUpdate::PickWeaponTargets");
+		PickWeaponTargets();
 	}
 }
 
 
+bool CUnitHandler::StageWeaponTarget(CWeapon* weapon)
+{
+	if (!stageWeaponTargets)
+		return false;
+
+	stagedWeapons.push_back(weapon);
+	return true;
+}
+
+static bool WeaponTargetOrder(const CWeapon* a, const CWeapon* b)
+{
+	if (a->owner->id != b->owner->id)
+		return (a->owner->id < b->owner->id);
+
+	return (a->weaponNum < b->weaponNum);
+}
+
+void CUnitHandler::PickWeaponTargets()
+{
+	if (stagedWeapons.empty())
+		return;
+
+	// the candidates of every staged weapon were generated during the
+	// SlowUpdate pass (that part uses the synced RNG and LuaRules, so it
+	// stays serial); checking them with TryTarget only reads the sim state
+	// and writes to the weapon itself, so the weapons can be done in any
+	// order and in parallel. The new targets are applied in unit-ID order,
+	// so the result does not depend on the number of threads.
+	std::sort(stagedWeapons.begin(), stagedWeapons.end(), WeaponTargetOrder);
+
+	const int numWeapons = stagedWeapons.size();
+
+	int n;
+	#pragma omp parallel for private(n) schedule(dynamic, 16)
+	for (n = 0; n < numWeapons; ++n) {
+		if (stagedWeapons[n]->pendingAutoTarget) {
+			stagedWeapons[n]->PickAutoTarget();
+		}
+	}
+
+	for (n = 0; n < numWeapons; ++n) {
+		CWeapon* w = stagedWeapons[n];
+
+		w->FinishSlowUpdate();
+		w->owner->RetaliateWithWeapon(w);
+	}
+
+	stagedWeapons.clear();
+}
+
+
 
 
 // find the reference height for a build-position
@@ -393,6 +490,26 @@ float CUnitHandler::GetBuildHeight(const float3& pos, const UnitDef* unitdef, bo
 }
 
 
+namespace {
+	// looks for a geothermal feature close enough to a build square
+	struct GeoFeatureVisitor: public CQuadField::FeatureVisitor {
+		GeoFeatureVisitor(const float3& p, int xs, int zs): pos(p), xsize(xs), zsize(zs), found(false) {}
+
+		bool operator() (CFeature* f) {
+			found =
+				f->def->geoThermal &&
+				fabs(f->pos.x - pos.x) < (xsize * 4 - 4) &&
+				fabs(f->pos.z - pos.z) < (zsize * 4 - 4);
+			return !found;
+		}
+
+		const float3& pos;
+		const int xsize;
+		const int zsize;
+		bool found;
+	};
+}
+
 int CUnitHandler::TestUnitBuildSquare(
 	const BuildInfo& buildInfo,
 	CFeature*& feature,
@@ -418,18 +535,12 @@ int CUnitHandler::TestUnitBuildSquare(
 	int canBuild = 2;
 
 	if (buildInfo.def->needGeo) {
-		canBuild = 0;
-		const std::vector<CFeature*>& features = qf->GetFeaturesExact(pos, std::max(xsize, zsize) * 6);
-
 		// look for a nearby geothermal feature if we need one
-		for (std::vector<CFeature*>::const_iterator fi = features.begin(); fi != features.end(); ++fi) {
-			if ((*fi)->def->geoThermal
-				&& fabs((*fi)->pos.x - pos.x) < (xsize * 4 - 4)
-				&& fabs((*fi)->pos.z - pos.z) < (zsize * 4 - 4)) {
-				canBuild = 2;
-				break;
-			}
-		}
+		// (no buffer: this also runs unsynced, eg. for the build preview)
+		GeoFeatureVisitor geoVisitor(pos, xsize, zsize);
+		qf->VisitFeaturesExact(pos, std::max(xsize, zsize) * 6, geoVisitor);
+
+		canBuild = (geoVisitor.found)? 2: 0;
 	}
 
 	if (commands != NULL) {
@@ -576,7 +687,7 @@ Command CUnitHandler::GetBuildCommand(const float3& pos, const float3& dir) {
 	GML_STDMUTEX_LOCK(cai); // GetBuildCommand
 
 	CCommandQueue::iterator ci;
-	for (std::list<CUnit*>::const_iterator ui = activeUnits.begin(); ui != activeUnits.end(); ++ui) {
+	for (std::vector<CUnit*>::const_iterator ui = activeUnits.begin(); ui != activeUnits.end(); ++ui) {
 		const CUnit* unit = *ui;
 
 		if (unit->team != gu->myTeam) {
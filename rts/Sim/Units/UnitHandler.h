@@ -5,12 +5,14 @@
 
 #include <vector>
 #include <list>
+#include <deque>
 
 #include "UnitDef.h"
 #include "UnitSet.h"
 #include "CommandAI/Command.h"
 
 class CUnit;
+class CWeapon;
 class CBuilderCAI;
 class CFeature;
 class CLoadSaveInterface;
@@ -60,6 +62,9 @@ public:
 
 	Command GetBuildCommand(const float3& pos, const float3& dir);
 
+	/// called by CWeapon::SlowUpdate, returns false if the weapon has to pick its new target itself
+	bool StageWeaponTarget(CWeapon* weapon);
+
 
 	// note: negative ID's are implicitly converted
 	CUnit* GetUnitUnsafe(unsigned int unitID) const { return units[unitID]; }
@@ -68,7 +73,7 @@ public:
 
 	std::vector< std::vector<CUnitSet> > unitsByDefs; ///< units sorted by team and unitDef
 
-	std::list<CUnit*> activeUnits;                    ///< used to get all active units
+	std::vector<CUnit*> activeUnits;                  ///< used to get all active units (dense, see ActiveUnitArray.h)
 	std::vector<CUnit*> units;                        ///< used to get units from IDs (0 if not created)
 	std::list<CBuilderCAI*> builderCAIs;
 
@@ -76,9 +81,18 @@ public:
 	bool morphUnitToFeature;
 
 private:
-	std::list<unsigned int> freeUnitIDs;
+	void PickWeaponTargets();
+
+private:
+	std::deque<unsigned int> freeUnitIDs;
 	std::vector<CUnit*> unitsToBeRemoved;            ///< units that will be removed at start of next update
-	std::list<CUnit*>::iterator slowUpdateIterator;
+	std::vector<unsigned int> activeSlots;           ///< index of each unit in activeUnits, by unit ID
+
+	unsigned int slowUpdateIndex;                    ///< first unit in activeUnits not slow-updated yet in this round
+	unsigned int updateIndex;                        ///< first unit in activeUnits not visited yet by the running per-frame pass (0 if none runs)
+
+	std::vector<CWeapon*> stagedWeapons;             ///< weapons that get their new target after the SlowUpdate pass (see PickWeaponTargets)
+	bool stageWeaponTargets;                         ///< true while the SlowUpdate pass runs
 
 	///< global unit-limit (derived from the per-team limit)
 	unsigned int maxUnits;
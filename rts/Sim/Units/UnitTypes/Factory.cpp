@@ -258,6 +258,9 @@ void CFactory::DependentDied(CObject* o)
 
 void CFactory::SendToEmptySpot(CUnit* unit)
 {
+	// reused by all factories
+	static std::vector<CSolidObject*> solids;
+
 	float r = radius * 1.7f + unit->radius * 4;
 	float3 foundPos = pos + frontdir * r;
 
@@ -265,7 +268,9 @@ void CFactory::SendToEmptySpot(CUnit* unit)
 		float3 testPos = pos + frontdir * r * cos(a * PI / 10) + rightdir * r * sin(a * PI / 10);
 		testPos.y = ground->GetHeightAboveWater(testPos.x, testPos.z);
 
-		if (qf->GetSolidsExact(testPos, unit->radius * 1.5f).empty()) {
+		qf->GetSolidsExact(testPos, unit->radius * 1.5f, solids);
+
+		if (solids.empty()) {
 			foundPos = testPos;
 			break;
 		}
@@ -21,6 +21,7 @@
 #include "Sim/Units/Scripts/CobInstance.h"
 #include "Sim/Units/CommandAI/CommandAI.h"
 #include "Sim/Units/Unit.h"
+#include "Sim/Units/UnitHandler.h"
 #include "System/EventHandler.h"
 #include "System/float3.h"
 #include "System/myMath.h"
@@ -173,7 +174,10 @@ CWeapon::CWeapon(CUnit* owner):
 	minIntensity(0.f),
 	heightBoostFactor(-1.f),
 	collisionFlags(0),
-	fuelUsage(0)
+	fuelUsage(0),
+	autoTargetUnit(NULL),
+	autoTargetPos(ZeroVector),
+	pendingAutoTarget(false)
 {
 }
 
@@ -480,6 +484,7 @@ bool CWeapon::AttackGround(float3 pos, bool userTarget)
 	haveUserTarget = userTarget;
 	targetType = Target_Pos;
 	targetPos = pos;
+	pendingAutoTarget = false;
 
 	return true;
 }
@@ -541,6 +546,7 @@ bool CWeapon::AttackUnit(CUnit* unit, bool userTarget)
 
 	AddDeathDependence(targetUnit, DEPENDENCE_TARGETUNIT);
 	avoidTarget = false;
+	pendingAutoTarget = false;
 	return true;
 }
 
@@ -553,6 +559,8 @@ void CWeapon::HoldFire()
 	}
 	targetType = Target_None;
 	haveUserTarget = false;
+	// a target chosen later would have been dropped here
+	pendingAutoTarget = false;
 }
 
 
@@ -701,55 +709,74 @@ void CWeapon::SlowUpdate(bool noAutoTargetOverride)
 	if (!noAutoTargetOverride && AllowWeaponTargetCheck()) {
 		lastTargetRetry = gs->frameNum;
 
-		std::multimap<float, CUnit*> targets;
-		std::multimap<float, CUnit*>::const_iterator nextTargetIt;
-		std::multimap<float, CUnit*>::const_iterator lastTargetIt;
+		helper->GenerateWeaponTargets(this, targetUnit, autoTargets);
 
-		helper->GenerateWeaponTargets(this, targetUnit, targets);
+		// weapons slaved to this one need the new target right away
+		if (!HaveSlavedWeapons() && uh->StageWeaponTarget(this)) {
+			pendingAutoTarget = true;
+			return;
+		}
 
-		if (!targets.empty())
-			lastTargetIt = --targets.end();
+		PickAutoTarget();
+	}
 
-		for (nextTargetIt = targets.begin(); nextTargetIt != targets.end(); ++nextTargetIt) {
-			CUnit* nextTargetUnit = nextTargetIt->second;
+	FinishSlowUpdate();
+}
 
-			if (nextTargetUnit->neutral && (owner->fireState <= FIRESTATE_FIREATWILL)) {
-				continue;
-			}
+void CWeapon::PickAutoTarget()
+{
+	autoTargetUnit = NULL;
 
-			// when only one target is available, <nextTarget> can equal <targetUnit>
-			// and we want to attack whether it is in our bad target category or not
-			// (if only bad targets are available and this is the last, just pick it)
-			if (nextTargetUnit != targetUnit && (nextTargetUnit->category & badTargetCategory)) {
-				if (nextTargetIt != lastTargetIt) {
-					continue;
-				}
+	for (unsigned int n = 0; n < autoTargets.Size(); ++n) {
+		CUnit* nextTargetUnit = autoTargets.Get(n).unit;
+
+		if (nextTargetUnit->neutral && (owner->fireState <= FIRESTATE_FIREATWILL)) {
+			continue;
+		}
+
+		// when only one target is available, <nextTarget> can equal <targetUnit>
+		// and we want to attack whether it is in our bad target category or not
+		// (if only bad targets are available and this is the last, just pick it)
+		if (nextTargetUnit != targetUnit && (nextTargetUnit->category & badTargetCategory)) {
+			if (n != (autoTargets.Size() - 1)) {
+				continue;
 			}
+		}
 
-			const float weaponLead = weaponDef->targetMoveError * GAME_SPEED * nextTargetUnit->speed.Length();
-			const float weaponError = weaponLead * (1.0f - owner->limExperience);
+		const float weaponLead = weaponDef->targetMoveError * GAME_SPEED * nextTargetUnit->speed.Length();
+		const float weaponError = weaponLead * (1.0f - owner->limExperience);
 
-			float3 nextTargetPos = nextTargetUnit->midPos + (errorVector * weaponError);
+		float3 nextTargetPos = nextTargetUnit->midPos + (errorVector * weaponError);
 
-			const float appHeight = ground->GetApproximateHeight(nextTargetPos.x, nextTargetPos.z) + 2.0f;
+		const float appHeight = ground->GetApproximateHeight(nextTargetPos.x, nextTargetPos.z) + 2.0f;
 
-			if (nextTargetPos.y < appHeight) {
-				nextTargetPos.y = appHeight;
-			}
+		if (nextTargetPos.y < appHeight) {
+			nextTargetPos.y = appHeight;
+		}
 
-			if (TryTarget(nextTargetPos, false, nextTargetUnit)) {
-				if (targetUnit) {
-					DeleteDeathDependence(targetUnit, DEPENDENCE_TARGETUNIT);
-				}
+		if (TryTarget(nextTargetPos, false, nextTargetUnit)) {
+			autoTargetUnit = nextTargetUnit;
+			autoTargetPos = nextTargetPos;
+			break;
+		}
+	}
+}
 
-				targetType = Target_Unit;
-				targetUnit = nextTargetUnit;
-				targetPos = nextTargetPos;
+void CWeapon::FinishSlowUpdate()
+{
+	pendingAutoTarget = false;
 
-				AddDeathDependence(targetUnit, DEPENDENCE_TARGETUNIT);
-				break;
-			}
+	if (autoTargetUnit != NULL) {
+		if (targetUnit) {
+			DeleteDeathDependence(targetUnit, DEPENDENCE_TARGETUNIT);
 		}
+
+		targetType = Target_Unit;
+		targetUnit = autoTargetUnit;
+		targetPos = autoTargetPos;
+
+		AddDeathDependence(targetUnit, DEPENDENCE_TARGETUNIT);
+		autoTargetUnit = NULL;
 	}
 
 	if (targetType != Target_None) {
@@ -785,6 +812,17 @@ void CWeapon::DependentDied(CObject *o)
 	}
 }
 
+bool CWeapon::HaveSlavedWeapons() const
+{
+	for (std::vector<CWeapon*>::const_iterator wi = owner->weapons.begin(); wi != owner->weapons.end(); ++wi) {
+		if ((*wi)->slavedTo == this) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool CWeapon::HaveFreeLineOfFire(const float3& pos, const float3& dir, float length, const CUnit* target) const {
 	CUnit* unit = NULL;
 	CFeature* feature = NULL;
@@ -804,19 +842,17 @@ const {
 	bool retCode = false;
 	const float tbScale = math::fabsf(targetBorder);
 
-	CollisionVolume* cvOld = targetUnit->collisionVolume;
-	CollisionVolume  cvNew = CollisionVolume(targetUnit->collisionVolume);
-	CollisionQuery   cq;
+	CollisionVolume cvNew = CollisionVolume(targetUnit->collisionVolume);
+	CollisionQuery  cq;
 
 	// test for "collision" with a temporarily volume
 	// (scaled uniformly by the absolute target-border
-	// factor)
+	// factor); the unit itself is not touched, so this
+	// can run for many weapons at once
 	cvNew.RescaleAxes(tbScale, tbScale, tbScale);
 	cvNew.SetTestType(CollisionVolume::COLVOL_HITTEST_DISC);
 
-	targetUnit->collisionVolume = &cvNew;
-
-	if (CCollisionHandler::DetectHit(targetUnit, weaponMuzzlePos, ZeroVector, NULL)) {
+	if (CCollisionHandler::DetectHit(targetUnit, &cvNew, weaponMuzzlePos, ZeroVector, NULL)) {
 		// our weapon muzzle is inside the target unit's volume; this
 		// means we do not need to make any adjustments to targetVec
 		targetVec = ZeroVector;
@@ -839,7 +875,7 @@ const {
 		const float3 targetOffset = targetDir * (cvNew.GetBoundingRadius() * 2.0f);
 		const float3 targetRayPos = targetPos + targetOffset;
 
-		if (CCollisionHandler::DetectHit(targetUnit, weaponMuzzlePos, targetRayPos, &cq)) {
+		if (CCollisionHandler::DetectHit(targetUnit, &cvNew, weaponMuzzlePos, targetRayPos, &cq)) {
 			if (targetBorder > 0.0f) { targetVec -= (targetDir * ((targetPos - cq.p0).Length())); }
 			if (targetBorder < 0.0f) { targetVec += (targetDir * ((cq.p1 - targetPos).Length())); }
 		}
@@ -847,8 +883,6 @@ const {
 		retCode = true;
 	}
 
-	targetUnit->collisionVolume = cvOld;
-
 	// true indicates we took the else-branch and targetDir is now normalized
 	return retCode;
 }
@@ -7,6 +7,7 @@
 
 #include "System/Object.h"
 #include "Sim/Misc/DamageArray.h"
+#include "Sim/Weapons/WeaponTargetList.h"
 #include "System/float3.h"
 
 class CUnit;
@@ -43,6 +44,14 @@ public:
 	float TargetWeight(const CUnit* unit) const;
 	void SlowUpdate(bool noAutoTargetOverride);
 	virtual void SlowUpdate();
+	/**
+	 * If SlowUpdate left the choice of a new target to CUnitHandler
+	 * (pendingAutoTarget), it calls PickAutoTarget for many weapons in
+	 * parallel and then FinishSlowUpdate for each of them serially.
+	 * PickAutoTarget does not change anything outside of this weapon.
+	 */
+	void PickAutoTarget();
+	void FinishSlowUpdate();
 	virtual void Update();
 	virtual float GetRange2D(float yDiff) const;
 	virtual void UpdateRange(float val) { range = val; }
@@ -156,6 +165,14 @@ public:
 
 	float fuelUsage;
 
+	bool HaveSlavedWeapons() const;
+
+	// not saved, only used between SlowUpdate and FinishSlowUpdate
+	CWeaponTargetList autoTargets;			// candidates for a new target, see CGameHelper::GenerateWeaponTargets
+	CUnit* autoTargetUnit;					// the candidate chosen by PickAutoTarget, if any
+	float3 autoTargetPos;
+	bool pendingAutoTarget;					// set while CUnitHandler still has to call PickAutoTarget and FinishSlowUpdate
+
 private:
 	virtual void FireImpl() {};
 };
@@ -0,0 +1,86 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef WEAPON_TARGET_LIST_H
+#define WEAPON_TARGET_LIST_H
+
+#include <algorithm>
+#include <vector>
+#include <cassert>
+
+class CUnit;
+
+/**
+ * Target candidates of a weapon, filled by CGameHelper::GenerateWeaponTargets.
+ *
+ * Replaces the std::multimap<float, CUnit*> that was allocated for every
+ * target search: the candidates are appended to a buffer that keeps its
+ * memory between searches, and are only sorted as far as the caller reads
+ * them (most searches stop at one of the first candidates).
+ *
+ * The order is the one of the multimap: ascending priority, candidates with
+ * equal priority in the order they were added.
+ */
+class CWeaponTargetList
+{
+public:
+	struct Candidate {
+		Candidate(float p, unsigned int i, CUnit* u): priority(p), index(i), unit(u) {}
+
+		bool operator < (const Candidate& c) const {
+			if (priority < c.priority) return true;
+			if (c.priority < priority) return false;
+			return (index < c.index);
+		}
+
+		float priority;
+		unsigned int index; ///< insertion order, breaks ties like std::multimap does
+		CUnit* unit;
+	};
+
+	CWeaponTargetList(): numSorted(0) {}
+
+	void Clear() {
+		candidates.clear();
+		numSorted = 0;
+	}
+
+	void Add(float priority, CUnit* unit) {
+		assert(numSorted == 0);
+		candidates.push_back(Candidate(priority, candidates.size(), unit));
+	}
+
+	bool Empty() const { return candidates.empty(); }
+	unsigned int Size() const { return candidates.size(); }
+
+	/// returns the n-th candidate in priority order
+	const Candidate& Get(unsigned int n) {
+		assert(n < candidates.size());
+
+		if (n >= numSorted) {
+			SortUpTo(n);
+		}
+
+		return candidates[n];
+	}
+
+private:
+	/// sorts the next batch of candidates (at least up to and including n)
+	void SortUpTo(unsigned int n) {
+		// the batch doubles each time, so reading all candidates costs
+		// about as much as one full sort
+		unsigned int newSorted = std::max(n + 1, std::max(numSorted * 2, 8u));
+		newSorted = std::min(newSorted, (unsigned int) candidates.size());
+
+		// everything in front of numSorted is smaller than the rest
+		std::partial_sort(candidates.begin() + numSorted, candidates.begin() + newSorted, candidates.end());
+		numSorted = newSorted;
+	}
+
+private:
+	std::vector<Candidate> candidates;
+
+	/// the first numSorted candidates are in their final order
+	unsigned int numSorted;
+};
+
+#endif /* WEAPON_TARGET_LIST_H */
@@ -130,6 +130,18 @@ class CEventClient
 		virtual void UnitMoved(const CUnit* unit) {}
 		virtual void UnitMoveFailed(const CUnit* unit) {}
 
+		/**
+		 * Batched form of UnitMoved, delivered once per frame after the
+		 * MoveType pass with all units the client may read. Clients that
+		 * register for it instead of UnitMoved cost one virtual call per
+		 * frame rather than one per moving unit.
+		 */
+		virtual void UnitsMoved(const std::vector<const CUnit*>& units) {
+			for (std::vector<const CUnit*>::const_iterator it = units.begin(); it != units.end(); ++it) {
+				UnitMoved(*it);
+			}
+		}
+
 		virtual void FeatureCreated(const CFeature* feature) {}
 		virtual void FeatureDestroyed(const CFeature* feature) {}
 		virtual void FeatureMoved(const CFeature* feature) {}
@@ -84,6 +84,7 @@ CEventHandler::CEventHandler()
 	SETUP_EVENT(UnitUnitCollision,    MANAGED_BIT);
 	SETUP_EVENT(UnitFeatureCollision, MANAGED_BIT);
 	SETUP_EVENT(UnitMoved,            MANAGED_BIT);
+	SETUP_EVENT(UnitsMoved,           MANAGED_BIT);
 	SETUP_EVENT(UnitMoveFailed,       MANAGED_BIT);
 
 	SETUP_EVENT(FeatureCreated,   MANAGED_BIT);
@@ -179,6 +180,7 @@ CEventHandler::CEventHandler()
 	SetupEvent("ShieldPreDamaged",       NULL, CONTROL_BIT);
 	SetupEvent("AllowWeaponTargetCheck", NULL, CONTROL_BIT);
 	SetupEvent("AllowWeaponTarget",      NULL, CONTROL_BIT);
+	SetupEvent("AllowWeaponTargets",     NULL, CONTROL_BIT);
 }
 
 
@@ -438,6 +440,41 @@ void CEventHandler::PlayerRemoved(int playerID, int reason)
 }
 
 
+void CEventHandler::FlushUnitsMoved()
+{
+	if (movedUnits.empty())
+		return;
+
+	const int count = listUnitsMoved.size();
+	for (int i = 0; i < count; i++) {
+		CEventClient* ec = listUnitsMoved[i];
+
+		if (ec->GetFullRead()) {
+			ec->UnitsMoved(movedUnits);
+			continue;
+		}
+
+		// the access can not change during the flush, so it is
+		// only queried once per client rather than once per unit
+		const int readAllyTeam = ec->GetReadAllyTeam();
+
+		movedUnitsFiltered.clear();
+
+		for (size_t n = 0; n < movedUnits.size(); n++) {
+			if (movedUnits[n]->allyteam == readAllyTeam) {
+				movedUnitsFiltered.push_back(movedUnits[n]);
+			}
+		}
+
+		if (!movedUnitsFiltered.empty()) {
+			ec->UnitsMoved(movedUnitsFiltered);
+		}
+	}
+
+	movedUnits.clear();
+}
+
+
 /******************************************************************************/
 /******************************************************************************/
 
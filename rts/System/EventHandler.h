@@ -101,6 +101,11 @@ class CEventHandler
 		void UnitMoved(const CUnit* unit);
 		void UnitMoveFailed(const CUnit* unit);
 
+		/// cheap check for the UnitMoved call site, false if nobody listens
+		bool HaveUnitMoved() const { return (!listUnitMoved.empty() || !listUnitsMoved.empty()); }
+		/// delivers the units queued by UnitMoved to the UnitsMoved clients
+		void FlushUnitsMoved();
+
 		void FeatureCreated(const CFeature* feature);
 		void FeatureDestroyed(const CFeature* feature);
 		void FeatureMoved(const CFeature* feature);
@@ -238,6 +243,10 @@ class CEventHandler
 	private:
 		CEventClient* mouseOwner;
 
+		/// units that moved since the last FlushUnitsMoved
+		std::vector<const CUnit*> movedUnits;
+		std::vector<const CUnit*> movedUnitsFiltered;
+
 	private:
 		EventMap eventMap;
 
@@ -295,6 +304,7 @@ class CEventHandler
 		EventClientList listUnitUnitCollision;
 		EventClientList listUnitFeatureCollision;
 		EventClientList listUnitMoved;
+		EventClientList listUnitsMoved;
 		EventClientList listUnitMoveFailed;
 
 		EventClientList listFeatureCreated;
@@ -400,7 +410,6 @@ inline void CEventHandler::UnitCreated(const CUnit* unit, const CUnit* builder)
 
 UNIT_CALLIN_NO_PARAM(UnitFinished)
 UNIT_CALLIN_NO_PARAM(UnitIdle)
-UNIT_CALLIN_NO_PARAM(UnitMoved)
 UNIT_CALLIN_NO_PARAM(UnitMoveFailed)
 UNIT_CALLIN_NO_PARAM(UnitEnteredWater)
 UNIT_CALLIN_NO_PARAM(UnitEnteredAir)
@@ -409,6 +418,24 @@ UNIT_CALLIN_NO_PARAM(UnitLeftAir)
 
 
 
+inline void CEventHandler::UnitMoved(const CUnit* unit)
+{
+	if (!listUnitsMoved.empty()) {
+		movedUnits.push_back(unit);
+	}
+
+	const int unitAllyTeam = unit->allyteam;
+	const int count = listUnitMoved.size();
+	for (int i = 0; i < count; i++) {
+		CEventClient* ec = listUnitMoved[i];
+		if (ec->CanReadAllyTeam(unitAllyTeam)) {
+			ec->UnitMoved(unit);
+		}
+	}
+}
+
+
+
 #define UNIT_CALLIN_INT_PARAM(name)                                       \
 	inline void CEventHandler:: Unit ## name (const CUnit* unit, int p)   \
 	{                                                                     \
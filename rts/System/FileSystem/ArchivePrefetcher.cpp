@@ -0,0 +1,117 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "ArchivePrefetcher.h"
+
+#include <algorithm>
+
+#include "System/mmgr.h"
+
+
+CArchivePrefetcher::CArchivePrefetcher(unsigned int numUnits, const boost::function<void()>& workerFunc)
+	: workerFunc(workerFunc)
+	, states(numUnits, UNIT_NONE)
+	, numActiveWorkers(0)
+	, stopping(false)
+{
+}
+
+CArchivePrefetcher::~CArchivePrefetcher()
+{
+	Stop();
+}
+
+
+void CArchivePrefetcher::Queue(const std::vector<unsigned int>& units)
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	for (std::vector<unsigned int>::const_iterator it = units.begin(); it != units.end(); ++it) {
+		if (*it < states.size() && states[*it] == UNIT_NONE) {
+			states[*it] = UNIT_QUEUED;
+			queue.push_back(*it);
+		}
+	}
+
+	const unsigned int numThreads = std::min(std::max(boost::thread::hardware_concurrency(), 1u), MAX_THREADS);
+	const unsigned int numWanted = std::min(numThreads, (unsigned int) queue.size());
+
+	for (; numActiveWorkers < numWanted; numActiveWorkers++) {
+		workers.create_thread(workerFunc);
+	}
+}
+
+void CArchivePrefetcher::Stop()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex);
+
+		for (std::deque<unsigned int>::const_iterator it = queue.begin(); it != queue.end(); ++it) {
+			if (states[*it] == UNIT_QUEUED) {
+				states[*it] = UNIT_NONE;
+			}
+		}
+
+		queue.clear();
+		stopping = true;
+	}
+
+	workers.join_all();
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+
+		// the results were dropped or are kept by the archive, either way
+		// they will not be decompressed by a worker again unless queued
+		std::fill(states.begin(), states.end(), UNIT_NONE);
+		stopping = false;
+	}
+}
+
+
+bool CArchivePrefetcher::Next(unsigned int& unit)
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	while (!stopping && !queue.empty()) {
+		unit = queue.front();
+		queue.pop_front();
+
+		// WaitFor may have taken it already
+		if (states[unit] == UNIT_QUEUED) {
+			states[unit] = UNIT_RUNNING;
+			return true;
+		}
+	}
+
+	numActiveWorkers--;
+	return false;
+}
+
+void CArchivePrefetcher::Done(unsigned int unit)
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	states[unit] = UNIT_DONE;
+	unitDone.notify_all();
+}
+
+
+bool CArchivePrefetcher::WaitFor(unsigned int unit)
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	if (unit >= states.size()) {
+		return false;
+	}
+
+	while (states[unit] == UNIT_RUNNING) {
+		unitDone.wait(lock);
+	}
+
+	if (states[unit] == UNIT_QUEUED) {
+		// the caller decompresses it now, no need to wait for a worker
+		states[unit] = UNIT_NONE;
+	}
+
+	return (states[unit] == UNIT_DONE);
+}
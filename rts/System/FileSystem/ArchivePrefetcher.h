@@ -0,0 +1,83 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _ARCHIVE_PREFETCHER_H
+#define _ARCHIVE_PREFETCHER_H
+
+#include <deque>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+/**
+ * Work queue for decompressing parts of an archive on worker threads ahead
+ * of the requests for them, see IArchive::Prefetch.
+ *
+ * A unit is whatever the archive can decompress independently (a solid
+ * block of a 7z archive, a file of a zip archive). The workers run the
+ * archive's worker function, which takes units with Next, decompresses them
+ * into the archive's own storage and reports them with Done.
+ *
+ * Before an archive decompresses a unit on request it calls WaitFor, which
+ * takes the unit out of the queue if no worker started on it yet, or waits
+ * for the worker that did. It must not hold any lock the worker function
+ * needs while doing that.
+ */
+class CArchivePrefetcher : public boost::noncopyable
+{
+public:
+	/// decompressing is mostly bound by the CPU, but also needs memory
+	static const unsigned int MAX_THREADS = 4;
+
+	/**
+	 * @param numUnits number of units of the archive
+	 * @param workerFunc run by each worker thread, until Next returns false
+	 */
+	CArchivePrefetcher(unsigned int numUnits, const boost::function<void()>& workerFunc);
+	/// calls Stop
+	~CArchivePrefetcher();
+
+	/// queues the units that were not queued before and starts the workers
+	void Queue(const std::vector<unsigned int>& units);
+	/**
+	 * Discards the queue and waits for the workers to finish.
+	 * Units can be queued again afterwards.
+	 */
+	void Stop();
+
+	/// called by the workers, false if there is no more work
+	bool Next(unsigned int& unit);
+	/// called by the workers after each unit, whether it succeeded or not
+	void Done(unsigned int unit);
+
+	/**
+	 * Makes sure no worker is or will be decompressing the unit.
+	 * @return true if a worker decompressed the unit
+	 */
+	bool WaitFor(unsigned int unit);
+
+private:
+	enum UnitState {
+		UNIT_NONE,
+		UNIT_QUEUED,
+		UNIT_RUNNING,
+		UNIT_DONE
+	};
+
+	boost::function<void()> workerFunc;
+
+	boost::mutex mutex;
+	boost::condition_variable unitDone;
+
+	std::vector<UnitState> states;
+	std::deque<unsigned int> queue;
+	boost::thread_group workers;
+	/// number of workers that did not get false from Next yet
+	unsigned int numActiveWorkers;
+
+	bool stopping;
+};
+
+#endif // _ARCHIVE_PREFETCHER_H
@@ -6,6 +6,8 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
 
 #include "System/mmgr.h"
 
@@ -23,7 +25,6 @@
 #include "System/CRC.h"
 #include "System/Util.h"
 #include "System/Exceptions.h"
-#include "System/OpenMP_cond.h"
 #if       !defined(DEDICATED) && !defined(UNITSYNC)
 #include "System/Platform/Watchdog.h"
 #endif // !defined(DEDICATED) && !defined(UNITSYNC)
@@ -342,6 +343,7 @@ CArchiveScanner::CArchiveScanner()
 	file << "cache" << (char)FileSystem::GetNativePathSeparator() << "ArchiveCache.lua";
 	cachefile = file.str();
 	ReadCacheData(dataDirLocater.GetWriteDirPath() + GetFilename());
+	ReadFileCRCCache(FileSystem::GetDirectory(dataDirLocater.GetWriteDirPath() + GetFilename()) + "ArchiveFileCRCs.lua");
 
 	const std::vector<std::string>& datadirs = dataDirLocater.GetDataDirPaths();
 	std::vector<std::string> scanDirs;
@@ -381,6 +383,8 @@ void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs, bool do
 			Scan(*dir, doChecksum);
 		}
 	}
+
+	ComputeChecksums();
 }
 
 
@@ -505,8 +509,11 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 	//! Time to parse the info we are interested in
 	if (cached) {
 		//! If cached is true, aii will point to the archive
-		if (doChecksum && (aii->second.checksum == 0))
-			aii->second.checksum = GetCRC(fullName);
+		if (doChecksum && (aii->second.checksum == 0)) {
+			pendingChecksums[lcfn] = fullName;
+		} else {
+			pendingChecksums.erase(lcfn);
+		}
 	} else {
 		IArchive* ar = archiveLoader.OpenArchive(fullName);
 		if (!ar || !ar->IsOpen()) {
@@ -610,13 +617,16 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		ai.updated = true;
 
 		//! Optionally calculate a checksum for the file
+		//! (done by ComputeChecksums once all directories are scanned)
 		//! To prevent reading all files in all directory (.sdd) archives
 		//! every time this function is called, directory archive checksums
 		//! are calculated on the fly.
+		ai.checksum = 0;
+
 		if (doChecksum) {
-			ai.checksum = GetCRC(fullName);
+			pendingChecksums[lcfn] = fullName;
 		} else {
-			ai.checksum = 0;
+			pendingChecksums.erase(lcfn);
 		}
 
 		archiveInfos[lcfn] = ai;
@@ -671,93 +681,203 @@ struct CRCPair {
 	std::string* filename;
 	unsigned int nameCRC;
 	unsigned int dataCRC;
+	bool cacheable;          ///< whether to store dataCRC in fileCRCs
 };
 
-/**
- * Get CRC of the data in the specified archive.
- * Returns 0 if file could not be opened.
- */
-unsigned int CArchiveScanner::GetCRC(const std::string& arcName)
-{
-	CRC crc;
+/// an archive whose checksum is being computed
+struct ChecksumArchive {
+	ChecksumArchive(): ar(NULL) {}
+
+	std::string lcName;
+	std::string fullName;
 	IArchive* ar;
 	std::list<std::string> files;
+	std::vector<CRCPair> crcs;
+};
+
+/// a file CRC that has to be computed by reading the file
+struct CRCJob {
+	CRCJob(IArchive* ar, unsigned int fid, CRCPair* crcp): ar(ar), fid(fid), crcp(crcp) {}
+
+	IArchive* ar;
+	unsigned int fid;
+	CRCPair* crcp;
+};
+
+/// work queue shared by the threads of ComputeChecksums
+class CRCJobQueue {
+public:
+	CRCJobQueue(std::vector<CRCJob>& jobs): jobs(jobs), nextJob(0) {}
+
+	void Run() {
+		for (size_t n = NextJob(); n < jobs.size(); n = NextJob()) {
+			jobs[n].crcp->dataCRC = jobs[n].ar->GetCrc32(jobs[n].fid);
+		#if !defined(DEDICATED) && !defined(UNITSYNC)
+			Watchdog::ClearTimer(WDT_MAIN);
+		#endif
+		}
+	}
 
-	//! Try to open an archive
-	ar = archiveLoader.OpenArchive(arcName);
-	if (!ar) {
-		return 0; // It wasn't an archive
+private:
+	size_t NextJob() {
+		boost::mutex::scoped_lock lock(mutex);
+		return nextJob++;
 	}
 
-	//! Load ignore list.
-	IFileFilter* ignore = CreateIgnoreFilter(ar);
+	std::vector<CRCJob>& jobs;
+	size_t nextJob;
+	boost::mutex mutex;
+};
 
-	//! Insert all files to check in lowercase format
-	for (unsigned fid = 0; fid != ar->NumFiles(); ++fid) {
-		std::string name;
-		int size;
-		ar->FileInfo(fid, name, size);
+/// reading files is mostly bound by IO, more threads do not help
+static const unsigned int MAX_CHECKSUM_THREADS = 4;
 
-		if (ignore->Match(name)) {
-			continue;
-		}
 
-		StringToLowerInPlace(name); //! case insensitive hash
-		files.push_back(name);
+void CArchiveScanner::ComputeChecksums()
+{
+	if (pendingChecksums.empty()) {
+		return;
 	}
 
-	//! Sort by FileName
-	files.sort();
+	std::vector<ChecksumArchive> archives(pendingChecksums.size());
+	std::vector<CRCJob> jobs;
+	unsigned int cachedFiles = 0;
 
-	//! Push the filenames into a std::vector, cause OMP can better iterate over those
-	std::vector<CRCPair> crcs;
-	crcs.reserve(files.size());
-	CRCPair crcp;
-	for (std::list<std::string>::iterator it = files.begin(); it != files.end(); ++it) {
-		crcp.filename = &(*it);
-		crcs.push_back(crcp);
+	//! Collect the files of all archives, take the CRCs that are cheap (the
+	//! ones stored in the archive meta-data) or cached right away
+	std::vector<ChecksumArchive>::iterator ca = archives.begin();
+	for (std::map<std::string, std::string>::const_iterator pi = pendingChecksums.begin(); pi != pendingChecksums.end(); ++pi, ++ca) {
+		const std::string& arcName = pi->second;
+
+		ca->lcName = pi->first;
+		ca->fullName = arcName;
+		ca->ar = archiveLoader.OpenArchive(arcName);
+
+		if (ca->ar == NULL) {
+			continue; // it wasn't an archive
+		}
+
+		IArchive* ar = ca->ar;
+
+		//! Load ignore list.
+		IFileFilter* ignore = CreateIgnoreFilter(ar);
+
+		//! Insert all files to check in lowercase format
+		for (unsigned fid = 0; fid != ar->NumFiles(); ++fid) {
+			std::string name;
+			int size;
+			ar->FileInfo(fid, name, size);
+
+			if (ignore->Match(name)) {
+				continue;
+			}
+
+			StringToLowerInPlace(name); //! case insensitive hash
+			ca->files.push_back(name);
+		}
+
+		delete ignore;
+
+		//! Sort by FileName
+		ca->files.sort();
+
+		//! Pointers into the list and the vector stay valid from here on
+		ca->crcs.resize(ca->files.size());
+
+		std::vector<CRCPair>::iterator crcp = ca->crcs.begin();
+		for (std::list<std::string>::iterator it = ca->files.begin(); it != ca->files.end(); ++it, ++crcp) {
+			const unsigned fid = ar->FindFile(*it);
+
+			crcp->filename = &(*it);
+			crcp->nameCRC = CRC().Update(it->data(), it->size()).GetDigest();
+			crcp->dataCRC = 0;
+			crcp->cacheable = false;
+
+			int size;
+			unsigned int modified;
+
+			if (!ar->GetFileStat(fid, size, modified)) {
+				crcp->dataCRC = ar->GetCrc32(fid);
+				continue;
+			}
+
+			FileCRC& fc = fileCRCs[arcName + "/" + *it];
+
+			if (fc.updated || (!fc.archive.empty() && fc.size == size && fc.modified == modified)) {
+				crcp->dataCRC = fc.crc;
+				fc.updated = true;
+				cachedFiles++;
+				continue;
+			}
+
+			fc.archive = arcName;
+			fc.size = size;
+			fc.modified = modified;
+			fc.updated = false;
+
+			crcp->cacheable = true;
+			jobs.push_back(CRCJob(ar, fid, &(*crcp)));
+		}
 	}
 
-	//! Compute CRCs of the files
-	//! Hint: Multithreading only speedups `.sdd` loading. For those the CRC generation is extremely slow -
+	//! Compute the remaining CRCs
+	//! Hint: These are the files of `.sdd` archives, for which the CRC generation is extremely slow -
 	//!       it has to load the full file to calc it! For the other formats (sd7, sdz, sdp) the CRC is saved
-	//!       in the metainformation of the container and so the loading is much faster. Neither does any of our
-	//!       current (2011) packing libraries support multithreading :/
-	int i;
-	#pragma omp parallel for private(i)
-	for (i=0; i<crcs.size(); ++i) {
-		CRCPair& crcp = crcs[i];
-		const unsigned int nameCRC = CRC().Update(crcp.filename->data(), crcp.filename->size()).GetDigest();
-		const unsigned fid = ar->FindFile(*crcp.filename);
-		const unsigned int dataCRC = ar->GetCrc32(fid);
-		crcp.nameCRC = nameCRC;
-		crcp.dataCRC = dataCRC;
-	#if !defined(DEDICATED) && !defined(UNITSYNC)
-		Watchdog::ClearTimer(WDT_MAIN);
-	#endif
+	//!       in the metainformation of the container, so they do not need any threads.
+	if (!jobs.empty()) {
+		LOG_S(LOG_SECTION_ARCHIVESCANNER, "Computing the CRCs of " _STPF_ " files (%u cached)", jobs.size(), cachedFiles);
+
+		CRCJobQueue queue(jobs);
+
+		const unsigned int numThreads = std::min(
+				std::min(std::max(boost::thread::hardware_concurrency(), 1u), MAX_CHECKSUM_THREADS),
+				(unsigned int) jobs.size());
+
+		boost::thread_group threads;
+		for (unsigned int n = 1; n < numThreads; n++) {
+			threads.create_thread(boost::bind(&CRCJobQueue::Run, &queue));
+		}
+
+		queue.Run();
+		threads.join_all();
 	}
 
-	//! Add file CRCs to the main archive CRC
-	for (std::vector<CRCPair>::iterator it = crcs.begin(); it != crcs.end(); ++it) {
-		crc.Update(it->nameCRC);
-		crc.Update(it->dataCRC);
+	//! Add file CRCs to the archive CRCs
+	for (ca = archives.begin(); ca != archives.end(); ++ca) {
+		if (ca->ar == NULL) {
+			continue;
+		}
+
+		CRC crc;
+
+		for (std::vector<CRCPair>::iterator it = ca->crcs.begin(); it != ca->crcs.end(); ++it) {
+			if (it->cacheable) {
+				FileCRC& fc = fileCRCs[ca->fullName + "/" + *it->filename];
+				fc.crc = it->dataCRC;
+				fc.updated = true;
+			}
+
+			crc.Update(it->nameCRC);
+			crc.Update(it->dataCRC);
+		}
+
+		delete ca->ar;
+
+		std::map<std::string, ArchiveInfo>::iterator aii = archiveInfos.find(ca->lcName);
+		if (aii == archiveInfos.end()) {
+			continue;
+		}
+
+		//! A value of 0 is used to indicate no crc.. so never use that
+		//! Shouldn't happen all that often
+		const unsigned int digest = crc.GetDigest();
+		aii->second.checksum = (digest != 0)? digest: 4711;
 	#if !defined(DEDICATED) && !defined(UNITSYNC)
 		Watchdog::ClearTimer();
 	#endif
 	}
 
-	delete ignore;
-	delete ar;
-
-	unsigned int digest = crc.GetDigest();
-
-	//! A value of 0 is used to indicate no crc.. so never return that
-	//! Shouldn't happen all that often
-	if (digest == 0) {
-		return 4711;
-	} else {
-		return digest;
-	}
+	pendingChecksums.clear();
 }
 
 void CArchiveScanner::ReadCacheData(const std::string& filename)
@@ -960,10 +1080,98 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 
 	fclose(out);
 
+	WriteFileCRCCache(FileSystem::GetDirectory(filename) + "ArchiveFileCRCs.lua");
+
 	isDirty = false;
 }
 
 
+void CArchiveScanner::ReadFileCRCCache(const std::string& filename)
+{
+	LuaParser p(filename, SPRING_VFS_RAW, SPRING_VFS_BASE);
+
+	if (!p.Execute()) {
+		// not an error, the file does not exist on the first start
+		return;
+	}
+	const LuaTable crcCache = p.GetRoot();
+	const LuaTable files = crcCache.SubTable("files");
+
+	// Do not load old version caches
+	const int ver = crcCache.GetInt("internalver", (INTERNAL_VER + 1));
+	if (ver != INTERNAL_VER) {
+		return;
+	}
+
+	for (int i = 1; files.KeyExists(i); ++i) {
+		const LuaTable curFile = files.SubTable(i);
+		const std::string name = curFile.GetString("name", "");
+		FileCRC fc;
+
+		fc.archive  = curFile.GetString("archive", "");
+		// stored as strings, see ReadCacheData
+		fc.size     = strtol(curFile.GetString("size", "-1").c_str(), 0, 10);
+		fc.modified = strtoul(curFile.GetString("modified", "0").c_str(), 0, 10);
+		fc.crc      = strtoul(curFile.GetString("crc", "0").c_str(), 0, 10);
+		fc.updated  = false;
+
+		if (fc.archive.empty() || name.empty()) {
+			continue;
+		}
+
+		fileCRCs[fc.archive + "/" + name] = fc;
+	}
+}
+
+void CArchiveScanner::WriteFileCRCCache(const std::string& filename)
+{
+	// Drop the files of archives that are gone; the ones of archives that
+	// were not checksummed in this run stay valid as long as the archive is
+	for (std::map<std::string, FileCRC>::iterator i = fileCRCs.begin(); i != fileCRCs.end(); ) {
+		const std::map<std::string, ArchiveInfo>::const_iterator aii =
+				archiveInfos.find(StringToLower(FileSystem::GetFilename(i->second.archive)));
+
+		const bool archiveExists = (aii != archiveInfos.end()) &&
+				((aii->second.path + aii->second.origName) == i->second.archive);
+
+		if (!i->second.updated && !archiveExists) {
+			i = set_erase(fileCRCs, i);
+		} else {
+			++i;
+		}
+	}
+
+	FILE* out = fopen(filename.c_str(), "wt");
+	if (!out) {
+		return;
+	}
+
+	fprintf(out, "local fileCRCCache = {\n\n");
+	fprintf(out, "\tinternalver = %i,\n\n", INTERNAL_VER);
+	fprintf(out, "\tfiles = {  -- count = "_STPF_"\n", fileCRCs.size());
+
+	std::map<std::string, FileCRC>::const_iterator fi;
+	for (fi = fileCRCs.begin(); fi != fileCRCs.end(); ++fi) {
+		const FileCRC& fc = fi->second;
+
+		fprintf(out, "\t\t{\n");
+		SafeStr(out, "\t\t\tarchive = ",         fc.archive);
+		SafeStr(out, "\t\t\tname = ",            fi->first.substr(fc.archive.size() + 1));
+		fprintf(out, "\t\t\tsize = \"%i\",\n",     fc.size);
+		fprintf(out, "\t\t\tmodified = \"%u\",\n", fc.modified);
+		fprintf(out, "\t\t\tcrc = \"%u\",\n",      fc.crc);
+		fprintf(out, "\t\t},\n");
+	}
+
+	fprintf(out, "\t},\n"); // close 'files'
+
+	fprintf(out, "}\n\n"); // close 'fileCRCCache'
+	fprintf(out, "return fileCRCCache\n");
+
+	fclose(out);
+}
+
+
 static bool archNameCompare(const CArchiveScanner::ArchiveData& a, const CArchiveScanner::ArchiveData& b)
 {
 	return (a.GetName() < b.GetName());
@@ -164,6 +164,17 @@ private:
 		bool updated;
 		std::string problem;
 	};
+	/// cached CRC of a file in an archive that supports IArchive::GetFileStat
+	struct FileCRC
+	{
+		FileCRC(): size(-1), modified(0), crc(0), updated(false) {}
+
+		std::string archive;      ///< full path of the archive
+		int size;
+		unsigned int modified;
+		unsigned int crc;
+		bool updated;
+	};
 
 private:
 	void ScanDirs(const std::vector<std::string>& dirs, bool checksum = false);
@@ -175,19 +186,27 @@ private:
 
 	void ReadCacheData(const std::string& filename);
 	void WriteCacheData(const std::string& filename);
+	void ReadFileCRCCache(const std::string& filename);
+	void WriteFileCRCCache(const std::string& filename);
 
 	IFileFilter* CreateIgnoreFilter(IArchive* ar);
 
 	/**
-	 * Get CRC of the data in the specified archive.
-	 * Returns 0 if file could not be opened.
+	 * Computes the checksums of all archives queued by ScanArchive.
+	 * File CRCs that are not in the cache are computed by a small pool
+	 * of threads.
 	 */
-	unsigned int GetCRC(const std::string& filename);
+	void ComputeChecksums();
 
 private:
 	std::map<std::string, ArchiveInfo> archiveInfos;
 	std::map<std::string, BrokenArchive> brokenArchives;
 
+	/// archives that need a checksum, lower-case name -> full path
+	std::map<std::string, std::string> pendingChecksums;
+	/// by "<full path of the archive>/<lower-case file name>"
+	std::map<std::string, FileCRC> fileCRCs;
+
 	bool isDirty;
 	std::string cachefile;
 };
@@ -2,6 +2,7 @@
 
 
 #include "BufferedArchive.h"
+#include "FileView.h"
 
 
 CBufferedArchive::CBufferedArchive(const std::string& name)
@@ -13,9 +14,8 @@ CBufferedArchive::~CBufferedArchive()
 {
 }
 
-bool CBufferedArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
+const CBufferedArchive::FileBuffer& CBufferedArchive::GetCachedFile(unsigned int fid)
 {
-	boost::mutex::scoped_lock lck(archiveLock);
 	assert(IsFileId(fid));
 
 	if (fid >= cache.size()) {
@@ -23,10 +23,34 @@ bool CBufferedArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& bu
 	}
 	
 	if (!cache[fid].populated) {
-		cache[fid].exists = GetFileImpl(fid, cache[fid].data);
+		boost::shared_ptr<std::vector<boost::uint8_t> > data(new std::vector<boost::uint8_t>());
+		cache[fid].exists = GetFileImpl(fid, *data);
+		cache[fid].data = data;
 		cache[fid].populated = true;
 	}
 
-	buffer = cache[fid].data;
-	return cache[fid].exists;
+	return cache[fid];
+}
+
+bool CBufferedArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
+{
+	boost::mutex::scoped_lock lck(archiveLock);
+
+	const FileBuffer& fb = GetCachedFile(fid);
+
+	buffer = *fb.data;
+	return fb.exists;
+}
+
+bool CBufferedArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	boost::mutex::scoped_lock lck(archiveLock);
+
+	const FileBuffer& fb = GetCachedFile(fid);
+
+	if (fb.exists) {
+		view.SetBuffer(fb.data);
+	}
+
+	return fb.exists;
 }
@@ -4,6 +4,7 @@
 #define _BUFFERED_ARCHIVE_H
 
 #include <map>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "IArchive.h"
@@ -19,6 +20,8 @@ public:
 	virtual ~CBufferedArchive();
 
 	virtual bool GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer);
+	/// shares the cached copy instead of copying it
+	virtual bool GetFileView(unsigned int fid, CFileView& view);
 
 protected:
 	virtual bool GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buffer) = 0;
@@ -29,9 +32,14 @@ protected:
 		FileBuffer() : populated(false), exists(false) {};
 		bool populated; // cause a file may be 0 bytes big
 		bool exists;
-		std::vector<boost::uint8_t> data;
+		// shared with file views, never modified once populated
+		boost::shared_ptr<const std::vector<boost::uint8_t> > data;
 	};
 	std::vector<FileBuffer> cache; // cache[fileId]
+
+private:
+	/// uncompresses the file into the cache if it is not there yet
+	const FileBuffer& GetCachedFile(unsigned int fid);
 };
 
 #endif // _BUFFERED_ARCHIVE_H
@@ -5,9 +5,12 @@
 
 #include <assert.h>
 #include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/FileView.h"
 #include "System/FileSystem/FileQueryFlags.h"
 #include "System/Util.h"
 #include "System/mmgr.h"
@@ -78,6 +81,18 @@ bool CDirArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
 	}
 }
 
+bool CDirArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	assert(IsFileId(fid));
+
+	if (view.MapFile(dataDirsAccess.LocateFile(dirName + searchFiles[fid]))) {
+		return true;
+	}
+
+	// empty (or not mappable) file
+	return IArchive::GetFileView(fid, view);
+}
+
 void CDirArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
 {
 	assert(IsFileId(fid));
@@ -92,3 +107,19 @@ void CDirArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
 		size = 0;
 	}
 }
+
+bool CDirArchive::GetFileStat(unsigned int fid, int& size, unsigned int& modified) const
+{
+	assert(IsFileId(fid));
+
+	const std::string rawPath = dataDirsAccess.LocateFile(dirName + searchFiles[fid]);
+
+	struct stat info;
+	if (stat(rawPath.c_str(), &info) != 0) {
+		return false;
+	}
+
+	size = info.st_size;
+	modified = info.st_mtime;
+	return true;
+}
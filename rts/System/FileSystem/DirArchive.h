@@ -36,7 +36,9 @@ public:
 	
 	virtual unsigned int NumFiles() const;
 	virtual bool GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer);
+	virtual bool GetFileView(unsigned int fid, CFileView& view);
 	virtual void FileInfo(unsigned int fid, std::string& name, int& size) const;
+	virtual bool GetFileStat(unsigned int fid, int& size, unsigned int& modified) const;
 	
 private:
 	/// "ExampleArchive.sdd/"
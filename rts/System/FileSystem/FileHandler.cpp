@@ -81,12 +81,8 @@ bool CFileHandler::TryReadFromModFS(const string& fileName)
 	}
 
 	const string file = StringToLower(fileName);
-	if (vfsHandler->LoadFile(file, fileBuffer)) {
-		//! did we allocated more mem than needed
-		//! (e.g. because of incorrect usage of std::vector)?
-		assert(fileBuffer.size() == fileBuffer.capacity()); 
-
-		fileSize = fileBuffer.size();
+	if (vfsHandler->LoadFileView(file, fileView)) {
+		fileSize = fileView.GetSize();
 		return true;
 	}
 	else
@@ -154,13 +150,13 @@ int CFileHandler::Read(void* buf, int length)
 		ifs->read((char*)buf, length);
 		return ifs->gcount ();
 	}
-	else if (!fileBuffer.empty()) {
+	else if ((fileView.GetSize() > 0)) {
 		if ((length + filePos) > fileSize) {
 			length = fileSize - filePos;
 		}
 		if (length > 0) {
-			assert(fileBuffer.size() >= (filePos + length));
-			memcpy(buf, &fileBuffer[filePos], length);
+			assert(fileView.GetSize() >= (filePos + length));
+			memcpy(buf, fileView.GetData() + filePos, length);
 			filePos += length;
 		}
 		return length;
@@ -181,7 +177,7 @@ void CFileHandler::Seek(int length, std::ios_base::seekdir where)
 		ifs->clear();
 		ifs->seekg(length, where);
 	}
-	else if (!fileBuffer.empty())
+	else if ((fileView.GetSize() > 0))
 	{
 		if (where == std::ios_base::beg)
 		{
@@ -206,9 +202,9 @@ int CFileHandler::Peek() const
 	if (ifs) {
 		return ifs->peek();
 	}
-	else if (!fileBuffer.empty()) {
+	else if ((fileView.GetSize() > 0)) {
 		if (filePos < fileSize) {
-			return fileBuffer.at(filePos);
+			return fileView.GetData()[filePos];
 		} else {
 			return EOF;
 		}
@@ -224,7 +220,7 @@ bool CFileHandler::Eof() const
 	if (ifs) {
 		return ifs->eof();
 	}
-	if (!fileBuffer.empty()) {
+	if ((fileView.GetSize() > 0)) {
 		return (filePos >= fileSize);
 	}
 	return true;
@@ -263,6 +259,39 @@ bool CFileHandler::LoadStringData(string& data)
 	return true;
 }
 
+bool CFileHandler::GetView(CFileView& view)
+{
+	GML_RECMUTEX_LOCK(file); // GetView
+
+	if (!FileExists()) {
+		return false;
+	}
+
+	if (ifs == NULL) {
+		view = fileView;
+		return true;
+	}
+
+	if (view.MapFile(dataDirsAccess.LocateFile(fileName))) {
+		return true;
+	}
+
+	// empty (or not mappable) file of the real file-system
+	boost::shared_ptr<CFileView::Buffer> buffer(new CFileView::Buffer(fileSize));
+
+	if (fileSize > 0) {
+		// tellg fails once the end was read past
+		const int pos = Eof()? fileSize: GetPos();
+
+		Seek(0);
+		Read(&(*buffer)[0], fileSize);
+		Seek(pos);
+	}
+
+	view.SetBuffer(buffer);
+	return true;
+}
+
 std::string CFileHandler::GetFileExt() const
 {
 	return FileSystem::GetExtension(fileName);
@@ -10,6 +10,7 @@
 #include <boost/cstdint.hpp>
 
 #include "VFSModes.h"
+#include "FileView.h"
 
 /**
  * This is for direct VFS file content access.
@@ -39,6 +40,13 @@ public:
 	int FileSize() const;
 
 	bool LoadStringData(std::string& data);
+	/**
+	 * Gives read-only access to the whole file without copying it where
+	 * possible (files of `.sdd` archives and of the real file-system are
+	 * memory-mapped), independent of the current read position.
+	 * @return false if the file does not exist
+	 */
+	bool GetView(CFileView& view);
 	std::string GetFileExt() const;
 
 	static bool InReadDir(const std::string& path);
@@ -71,7 +79,7 @@ private:
 
 	std::string fileName;
 	std::ifstream* ifs;
-	std::vector<boost::uint8_t> fileBuffer;
+	CFileView fileView;
 	int filePos;
 	int fileSize;
 };
@@ -300,6 +300,21 @@ bool FileSystemAbstraction::DeleteFile(const std::string& file)
 	return fileDeleted;
 }
 
+bool FileSystemAbstraction::RenameFile(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+	const bool fileRenamed = (MoveFileEx(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+	const bool fileRenamed = (rename(from.c_str(), to.c_str()) == 0);
+#endif
+
+	if (!fileRenamed) {
+		LOG_L(L_WARNING, "Could not rename file %s to %s", from.c_str(), to.c_str());
+	}
+
+	return fileRenamed;
+}
+
 bool FileSystemAbstraction::FileExists(const std::string& file)
 {
 	bool fileExists = false;
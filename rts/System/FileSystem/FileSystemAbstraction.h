@@ -20,6 +20,8 @@ public:
 	// almost direct wrappers to system calls
 	static bool MkDir(const std::string& dir);
 	static bool DeleteFile(const std::string& file);
+	/// replaces an existing file <to>, also on Windows (where rename() fails then)
+	static bool RenameFile(const std::string& from, const std::string& to);
 	/// Returns true if the file exists, and is not a directory
 	static bool FileExists(const std::string& file);
 	static bool DirExists(const std::string& dir);
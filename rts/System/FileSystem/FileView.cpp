@@ -0,0 +1,47 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "FileView.h"
+#include "MappedFile.h"
+#include "System/mmgr.h"
+
+
+CFileView::CFileView()
+	: data(NULL)
+	, size(0)
+{
+}
+
+bool CFileView::MapFile(const std::string& filePath)
+{
+	boost::shared_ptr<CMappedFile> file(new CMappedFile(filePath));
+
+	// empty files can not be mapped, they are left to the caller
+	if (!file->IsOpen()) {
+		return false;
+	}
+
+	Clear();
+
+	mapping = file;
+	data = mapping->GetData();
+	size = mapping->GetSize();
+	return true;
+}
+
+void CFileView::SetBuffer(const boost::shared_ptr<const Buffer>& buf)
+{
+	Clear();
+
+	buffer = buf;
+	size = buffer->size();
+	data = buffer->empty()? NULL: &(*buffer)[0];
+}
+
+void CFileView::Clear()
+{
+	mapping.reset();
+	buffer.reset();
+
+	data = NULL;
+	size = 0;
+}
@@ -0,0 +1,51 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef FILE_VIEW_H
+#define FILE_VIEW_H
+
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+
+class CMappedFile;
+
+/**
+ * Read-only view of the whole contents of a file.
+ *
+ * Filled by IArchive::GetFileView, CVFSHandler::LoadFileView and
+ * CFileHandler::GetView. Uncompressed files of the real file-system (eg. the
+ * files of `.sdd` archives) are memory-mapped, so no copy is made at all;
+ * everything else is backed by a single buffer, which may be shared with the
+ * archive's own cache (see CBufferedArchive).
+ *
+ * Copies of a view share the mapping or buffer, which stays valid as long as
+ * one of them exists.
+ */
+class CFileView
+{
+public:
+	typedef std::vector<boost::uint8_t> Buffer;
+
+	CFileView();
+
+	/// maps a file of the real file-system, false if it could not be mapped
+	bool MapFile(const std::string& filePath);
+	/// the buffer must not be modified anymore once it is in a view
+	void SetBuffer(const boost::shared_ptr<const Buffer>& buffer);
+	void Clear();
+
+	/// NULL if the view is empty
+	const boost::uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+	bool IsMapped() const { return (mapping.get() != NULL); }
+
+private:
+	boost::shared_ptr<CMappedFile> mapping;
+	boost::shared_ptr<const Buffer> buffer;
+
+	const boost::uint8_t* data;
+	size_t size;
+};
+
+#endif // FILE_VIEW_H
@@ -1,6 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "IArchive.h"
+#include "FileView.h"
 
 #include "System/CRC.h"
 #include "System/Util.h"
@@ -43,14 +44,27 @@ bool IArchive::HasLowReadingCost(unsigned int fid) const
 unsigned int IArchive::GetCrc32(unsigned int fid)
 {
 	CRC crc;
-	std::vector<boost::uint8_t> buffer;
-	if (GetFile(fid, buffer) && !buffer.empty()) {
-		crc.Update(&buffer[0], buffer.size());
+	CFileView view;
+	if (GetFileView(fid, view) && (view.GetSize() > 0)) {
+		crc.Update(view.GetData(), view.GetSize());
 	}
 
 	return crc.GetDigest();
 }
 
+bool IArchive::GetFileStat(unsigned int fid, int& size, unsigned int& modified) const
+{
+	return false;
+}
+
+void IArchive::Prefetch(const std::vector<unsigned int>& fids)
+{
+}
+
+void IArchive::ClearPrefetched()
+{
+}
+
 bool IArchive::GetFile(const std::string& name, std::vector<boost::uint8_t>& buffer)
 {
 	const unsigned int fid = FindFile(name);
@@ -63,3 +77,15 @@ bool IArchive::GetFile(const std::string& name, std::vector<boost::uint8_t>& buf
 
 	return found;
 }
+
+bool IArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	boost::shared_ptr<CFileView::Buffer> buffer(new CFileView::Buffer());
+
+	if (!GetFile(fid, *buffer)) {
+		return false;
+	}
+
+	view.SetBuffer(buffer);
+	return true;
+}
@@ -8,6 +8,8 @@
 #include <map>
 #include <boost/cstdint.hpp>
 
+class CFileView;
+
 /**
  * @brief Abstraction of different archive types
  *
@@ -72,6 +74,17 @@ public:
 	 * @see GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
 	 */
 	bool GetFile(const std::string& name, std::vector<boost::uint8_t>& buffer);
+	/**
+	 * Fetches a read-only view of the content of a file by its ID.
+	 * Avoids the copy made by GetFile where the archive can: directory
+	 * archives map the file into memory, buffered archives share their
+	 * cached copy. The default implementation reads the file into a new
+	 * buffer with GetFile.
+	 * @param fid file ID in [0, NumFiles())
+	 * @param view on success, this will view the contents of the file
+	 * @return true if the file was found, and its contents are in view
+	 */
+	virtual bool GetFileView(unsigned int fid, CFileView& view);
 	/**
 	 * Fetches the name and size in bytes of a file by its ID.
 	 */
@@ -92,6 +105,27 @@ public:
 	 * Fetches the CRC32 hash of a file by its ID.
 	 */
 	virtual unsigned int GetCrc32(unsigned int fid);
+	/**
+	 * Fetches the size in bytes and the modification time of a file by its
+	 * ID, if they can be had without reading the file.
+	 * Only archives for which GetCrc32 has to read the whole file support
+	 * this (ie. directory archives), CArchiveScanner uses it to cache their
+	 * CRCs between runs.
+	 * @return false if not supported
+	 */
+	virtual bool GetFileStat(unsigned int fid, int& size, unsigned int& modified) const;
+	/**
+	 * Hints that the files will be read soon, so the archive can decompress
+	 * them on worker threads in the meantime (see CArchivePrefetcher).
+	 * The decompressed data is kept until ClearPrefetched is called.
+	 * Most implementations ignore this.
+	 */
+	virtual void Prefetch(const std::vector<unsigned int>& fids);
+	/**
+	 * Stops prefetching and frees the data that was decompressed for it,
+	 * except for what the archive caches anyway.
+	 */
+	virtual void ClearPrefetched();
 
 
 protected:
@@ -0,0 +1,35 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "MappedFile.h"
+#include "System/Log/ILog.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace bip = boost::interprocess;
+
+
+CMappedFile::CMappedFile(const std::string& filePath, bool copyOnWrite)
+	: mapping(NULL)
+	, region(NULL)
+	, data(NULL)
+	, size(0)
+{
+	try {
+		mapping = new bip::file_mapping(filePath.c_str(), bip::read_only);
+		region = new bip::mapped_region(*mapping, (copyOnWrite? bip::copy_on_write: bip::read_only));
+
+		if (region->get_size() > 0) {
+			data = static_cast<boost::uint8_t*>(region->get_address());
+			size = region->get_size();
+		}
+	} catch (const bip::interprocess_exception& ex) {
+		LOG_L(L_DEBUG, "[%s] could not map \"%s\": %s", __FUNCTION__, filePath.c_str(), ex.what());
+	}
+}
+
+CMappedFile::~CMappedFile()
+{
+	delete region;
+	delete mapping;
+}
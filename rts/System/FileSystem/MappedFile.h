@@ -0,0 +1,48 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/cstdint.hpp>
+
+namespace boost {
+	namespace interprocess {
+		class file_mapping;
+		class mapped_region;
+	}
+}
+
+/**
+ * A whole file mapped into memory.
+ *
+ * The pages are backed by the file itself, so they are only read from disk
+ * when touched and are shared between all processes mapping the same file.
+ * In copy-on-write mode the data may be modified; the modified pages become
+ * private to this process and are never written back to the file.
+ *
+ * Files that are mapped must not be modified in place by anyone (replace
+ * them by renaming a new file over them instead).
+ */
+class CMappedFile : public boost::noncopyable
+{
+public:
+	CMappedFile(const std::string& filePath, bool copyOnWrite = false);
+	~CMappedFile();
+
+	/// false if the file does not exist, is empty or could not be mapped
+	bool IsOpen() const { return (data != NULL); }
+
+	boost::uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	boost::interprocess::file_mapping* mapping;
+	boost::interprocess::mapped_region* region;
+
+	boost::uint8_t* data;
+	size_t size;
+};
+
+#endif // MAPPED_FILE_H
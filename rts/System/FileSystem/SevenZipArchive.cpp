@@ -3,6 +3,7 @@
 #include "SevenZipArchive.h"
 
 #include <algorithm>
+#include <boost/bind.hpp>
 #include <boost/system/error_code.hpp>
 #include <stdexcept>
 #include <string.h> //memcpy
@@ -14,6 +15,7 @@ extern "C" {
 #include "lib/7z/7zCrc.h"
 }
 
+#include "ArchivePrefetcher.h"
 #include "System/Util.h"
 #include "System/mmgr.h"
 #include "System/Log/ILog.h"
@@ -37,6 +39,7 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name) :
 	blockIndex = 0xFFFFFFFF;
 	outBuffer = NULL;
 	outBufferSize = 0;
+	prefetcher = NULL;
 
 	allocImp.Alloc = SzAlloc;
 	allocImp.Free = SzFree;
@@ -130,10 +133,16 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name) :
 	}
 
 	delete [] folderUnpackSizes;
+
+	prefetcher = new CArchivePrefetcher(db.db.NumFolders, boost::bind(&CSevenZipArchive::PrefetchWorker, this));
 }
 
 CSevenZipArchive::~CSevenZipArchive()
 {
+	// the workers use db
+	ClearPrefetched();
+	delete prefetcher;
+
 	if (outBuffer) {
 		IAlloc_Free(&allocImp, outBuffer);
 	}
@@ -155,18 +164,43 @@ unsigned int CSevenZipArchive::NumFiles() const
 
 bool CSevenZipArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
 {
-	boost::mutex::scoped_lock lck(archiveLock);
 	assert(IsFileId(fid));
+
+	const UInt32 folderIndex = db.FileIndexToFolderIndexMap[fileData[fid].fp];
+
+	// must not hold archiveLock, the worker needs it to store the block
+	if ((prefetcher != NULL) && (folderIndex != ((UInt32)-1))) {
+		prefetcher->WaitFor(folderIndex);
+	}
+
+	boost::mutex::scoped_lock lck(archiveLock);
 	
 	// Get 7zip to decompress it
 	size_t offset;
 	size_t outSizeProcessed;
 	SRes res;
+	Byte* blockData;
+
+	const std::map<UInt32, Block>::const_iterator bi = prefetchedBlocks.find(folderIndex);
+
+	if (bi != prefetchedBlocks.end()) {
+		// the block matches, so this only locates (and checks) the file in it
+		UInt32 prefetchedIndex = folderIndex;
+		Byte* prefetchedData = bi->second.data;
+		size_t prefetchedSize = bi->second.size;
+
+		res = SzAr_Extract(&db, &lookStream.s, fileData[fid].fp, &prefetchedIndex, &prefetchedData, &prefetchedSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp);
+		blockData = prefetchedData;
+	} else {
+		res = SzAr_Extract(&db, &lookStream.s, fileData[fid].fp, &blockIndex, &outBuffer, &outBufferSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp);
+		blockData = outBuffer;
+	}
 
-	res = SzAr_Extract(&db, &lookStream.s, fileData[fid].fp, &blockIndex, &outBuffer, &outBufferSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp);
 	if (res == SZ_OK) {
 		buffer.resize(outSizeProcessed);
-		memcpy(&buffer[0], (char*)outBuffer+offset, outSizeProcessed);
+		if (outSizeProcessed > 0) {
+			memcpy(&buffer[0], (char*)blockData+offset, outSizeProcessed);
+		}
 		return true;
 	} else {
 		return false;
@@ -204,3 +238,96 @@ unsigned int CSevenZipArchive::GetCrc32(unsigned int fid)
 	assert(IsFileId(fid));
 	return fileData[fid].crc;
 }
+
+
+void CSevenZipArchive::Prefetch(const std::vector<unsigned int>& fids)
+{
+	if (prefetcher == NULL) {
+		return;
+	}
+
+	std::vector<unsigned int> folders;
+	folders.reserve(fids.size());
+
+	for (std::vector<unsigned int>::const_iterator it = fids.begin(); it != fids.end(); ++it) {
+		assert(IsFileId(*it));
+
+		const UInt32 folderIndex = db.FileIndexToFolderIndexMap[fileData[*it].fp];
+
+		// files without data have no folder
+		if (folderIndex != ((UInt32)-1)) {
+			folders.push_back(folderIndex);
+		}
+	}
+
+	prefetcher->Queue(folders);
+}
+
+void CSevenZipArchive::ClearPrefetched()
+{
+	if (prefetcher == NULL) {
+		return;
+	}
+
+	prefetcher->Stop();
+
+	boost::mutex::scoped_lock lck(archiveLock);
+
+	for (std::map<UInt32, Block>::iterator bi = prefetchedBlocks.begin(); bi != prefetchedBlocks.end(); ++bi) {
+		IAlloc_Free(&allocImp, bi->second.data);
+	}
+
+	prefetchedBlocks.clear();
+}
+
+void CSevenZipArchive::PrefetchWorker()
+{
+	// lookStream is used by GetFile, and the streams are not thread-safe
+	CFileInStream workerStream;
+	CLookToRead workerLookStream;
+
+	const bool streamOpen = (InFile_Open(&workerStream.file, GetArchiveName().c_str()) == 0);
+
+	if (streamOpen) {
+		FileInStream_CreateVTable(&workerStream);
+		LookToRead_CreateVTable(&workerLookStream, False);
+
+		workerLookStream.realStream = &workerStream.s;
+		LookToRead_Init(&workerLookStream);
+	}
+
+	unsigned int folderIndex;
+
+	while (prefetcher->Next(folderIndex)) {
+		if (!streamOpen) {
+			// GetFile will report the error
+			prefetcher->Done(folderIndex);
+			continue;
+		}
+
+		// db is not modified after the constructor, so it can be shared
+		UInt32 workerBlockIndex = 0xFFFFFFFF;
+		Byte* workerBuffer = NULL;
+		size_t workerBufferSize = 0;
+		size_t offset;
+		size_t outSizeProcessed;
+
+		const SRes res = SzAr_Extract(&db, &workerLookStream.s, db.FolderStartFileIndex[folderIndex], &workerBlockIndex, &workerBuffer, &workerBufferSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp);
+
+		if ((res == SZ_OK) && (workerBuffer != NULL)) {
+			boost::mutex::scoped_lock lck(archiveLock);
+
+			Block& block = prefetchedBlocks[folderIndex];
+			block.data = workerBuffer;
+			block.size = workerBufferSize;
+		} else {
+			IAlloc_Free(&allocImp, workerBuffer);
+		}
+
+		prefetcher->Done(folderIndex);
+	}
+
+	if (streamOpen) {
+		File_Close(&workerStream.file);
+	}
+}
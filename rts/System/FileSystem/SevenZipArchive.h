@@ -3,6 +3,7 @@
 #ifndef _7ZIP_ARCHIVE_H
 #define _7ZIP_ARCHIVE_H
 
+#include <map>
 #include <boost/thread/mutex.hpp>
 extern "C" {
 #include "lib/7z/7zFile.h"
@@ -12,6 +13,7 @@ extern "C" {
 #include "ArchiveFactory.h"
 #include "IArchive.h"
 
+class CArchivePrefetcher;
 
 /**
  * Creates LZMA/7zip compressed, single-file archives.
@@ -42,12 +44,29 @@ public:
 	virtual bool HasLowReadingCost(unsigned int fid) const;
 	virtual unsigned GetCrc32(unsigned int fid);
 
+	/// decompresses the solid blocks of the files on worker threads
+	virtual void Prefetch(const std::vector<unsigned int>& fids);
+	virtual void ClearPrefetched();
+
 private:
+	/// run by the prefetcher threads, each uses its own stream
+	void PrefetchWorker();
+
 	boost::mutex archiveLock;
 	UInt32 blockIndex;
 	Byte* outBuffer;
 	size_t outBufferSize;
 
+	/// a solid block decompressed by PrefetchWorker
+	struct Block {
+		Byte* data;
+		size_t size;
+	};
+	/// by folder (solid block) index, kept until ClearPrefetched
+	std::map<UInt32, Block> prefetchedBlocks;
+	/// units are folders, NULL if the archive could not be opened
+	CArchivePrefetcher* prefetcher;
+
 	/**
 	 * How much more unpacked data may be allowed in a solid block,
 	 * besides a meta-file.
@@ -60,8 +60,10 @@ bool CVFSHandler::AddArchive(const std::string& archiveName, bool override, cons
 		ar->FileInfo(fid, name, size);
 		StringToLowerInPlace(name);
 
+		const bool exists = (files.find(name) != files.end());
+
 		if (!override) {
-			if (files.find(name) != files.end()) {
+			if (exists) {
 				LOG_L(L_DEBUG, "%s (skipping, exists)", name.c_str());
 				continue;
 			} else {
@@ -75,6 +77,10 @@ bool CVFSHandler::AddArchive(const std::string& archiveName, bool override, cons
 		d.ar = ar;
 		d.size = size;
 		files[name] = d;
+
+		if (!exists) {
+			AddToDirs(name);
+		}
 	}
 	return true;
 }
@@ -104,10 +110,12 @@ bool CVFSHandler::RemoveArchive(const std::string& archiveName)
 	}
 	
 	// remove the files loaded from the archive-to-remove
-	for (std::map<std::string, FileData>::iterator f = files.begin(); f != files.end();) {
+	for (boost::unordered_map<std::string, FileData>::iterator f = files.begin(); f != files.end();) {
 		if (f->second.ar == ar) {
 			LOG_L(L_DEBUG, "%s (removing)", f->first.c_str());
+			const std::string name = f->first;
 			f = set_erase(files, f);
+			RemoveFromDirs(name);
 		} else {
 			 ++f;
 		}
@@ -134,11 +142,23 @@ std::string CVFSHandler::GetNormalizedPath(const std::string& rawPath)
 	return path;
 }
 
+std::string CVFSHandler::GetNormalizedDirPath(const std::string& rawDir)
+{
+	std::string dir = GetNormalizedPath(rawDir);
+
+	// Non-empty directories to look in should have a trailing backslash
+	if (!dir.empty() && (dir[dir.length() - 1] != '/')) {
+		dir += "/";
+	}
+
+	return dir;
+}
+
 const CVFSHandler::FileData* CVFSHandler::GetFileData(const std::string& normalizedFilePath)
 {
 	const FileData* fileData = NULL;
 
-	const std::map<std::string, FileData>::const_iterator fi = files.find(normalizedFilePath);
+	const boost::unordered_map<std::string, FileData>::const_iterator fi = files.find(normalizedFilePath);
 	if (fi != files.end()) {
 		fileData = &(fi->second);
 	}
@@ -166,6 +186,60 @@ bool CVFSHandler::LoadFile(const std::string& filePath, std::vector<boost::uint8
 	return true;
 }
 
+bool CVFSHandler::LoadFileView(const std::string& filePath, CFileView& view)
+{
+	LOG_L(L_DEBUG, "LoadFileView(filePath = \"%s\", )", filePath.c_str());
+
+	const std::string normalizedPath = GetNormalizedPath(filePath);
+
+	const FileData* fileData = GetFileData(normalizedPath);
+	if (fileData == NULL) {
+		LOG_L(L_DEBUG, "LoadFileView: File '%s' does not exist in VFS.", filePath.c_str());
+		return false;
+	}
+
+	const unsigned int fid = fileData->ar->FindFile(normalizedPath);
+	if ((fid >= fileData->ar->NumFiles()) || !fileData->ar->GetFileView(fid, view))
+	{
+		LOG_L(L_DEBUG, "LoadFileView: File '%s' does not exist in archive.", filePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+void CVFSHandler::Prefetch(const std::vector<std::string>& dirs)
+{
+	std::vector<std::string> filePaths;
+
+	for (std::vector<std::string>::const_iterator di = dirs.begin(); di != dirs.end(); ++di) {
+		GetFilesBelow(GetNormalizedDirPath(*di), filePaths);
+	}
+
+	std::map<IArchive*, std::vector<unsigned int> > archiveFiles;
+
+	for (std::vector<std::string>::const_iterator fi = filePaths.begin(); fi != filePaths.end(); ++fi) {
+		const FileData* fileData = GetFileData(*fi);
+		const unsigned int fid = fileData->ar->FindFile(*fi);
+
+		if (fid < fileData->ar->NumFiles()) {
+			archiveFiles[fileData->ar].push_back(fid);
+		}
+	}
+
+	std::map<IArchive*, std::vector<unsigned int> >::const_iterator ai;
+	for (ai = archiveFiles.begin(); ai != archiveFiles.end(); ++ai) {
+		ai->first->Prefetch(ai->second);
+	}
+}
+
+void CVFSHandler::ClearPrefetched()
+{
+	std::map<std::string, IArchive*>::const_iterator ai;
+	for (ai = archives.begin(); ai != archives.end(); ++ai) {
+		ai->second->ClearPrefetched();
+	}
+}
+
 bool CVFSHandler::FileExists(const std::string& filePath)
 {
 	LOG_L(L_DEBUG, "FileExists(filePath = \"%s\", )", filePath.c_str());
@@ -191,93 +265,89 @@ std::vector<std::string> CVFSHandler::GetFilesInDir(const std::string& rawDir)
 	LOG_L(L_DEBUG, "GetFilesInDir(rawDir = \"%s\")", rawDir.c_str());
 
 	std::vector<std::string> ret;
-	std::string dir = GetNormalizedPath(rawDir);
-
-	std::map<std::string, FileData>::const_iterator filesStart = files.begin();
-	std::map<std::string, FileData>::const_iterator filesEnd   = files.end();
 
-	// Non-empty directories to look in should have a trailing backslash
-	if (!dir.empty()) {
-		std::string::size_type dirLast = (dir.length() - 1);
-		if (dir[dirLast] != '/') {
-			dir += "/";
-			dirLast++;
-		}
-		// limit the iterator range
-		std::string dirEnd = dir;
-		dirEnd[dirLast] = dirEnd[dirLast] + 1;
-		filesStart = files.lower_bound(dir);
-		filesEnd   = files.upper_bound(dirEnd);
+	const boost::unordered_map<std::string, DirData>::const_iterator di = dirs.find(GetNormalizedDirPath(rawDir));
+	if (di != dirs.end()) {
+		ret.assign(di->second.files.begin(), di->second.files.end());
 	}
 
-	while (filesStart != filesEnd) {
-		const std::string path = FileSystem::GetDirectory(filesStart->first);
+	return ret;
+}
 
-		// Check if this file starts with the dir path
-		if (path.compare(0, dir.length(), dir) == 0) {
 
-			// Strip pathname
-			const std::string name = filesStart->first.substr(dir.length());
+std::vector<std::string> CVFSHandler::GetDirsInDir(const std::string& rawDir)
+{
+	LOG_L(L_DEBUG, "GetDirsInDir(rawDir = \"%s\")", rawDir.c_str());
 
-			// Do not return files in subfolders
-			if ((name.find('/') == std::string::npos)
-					&& (name.find('\\') == std::string::npos))
-			{
-				ret.push_back(name);
-				LOG_L(L_DEBUG, "%s", name.c_str());
-			}
-		}
-		++filesStart;
+	std::vector<std::string> ret;
+
+	const boost::unordered_map<std::string, DirData>::const_iterator di = dirs.find(GetNormalizedDirPath(rawDir));
+	if (di != dirs.end()) {
+		ret.assign(di->second.subDirs.begin(), di->second.subDirs.end());
 	}
 
 	return ret;
 }
 
 
-std::vector<std::string> CVFSHandler::GetDirsInDir(const std::string& rawDir)
+void CVFSHandler::AddToDirs(const std::string& normalizedFilePath)
 {
-	LOG_L(L_DEBUG, "GetDirsInDir(rawDir = \"%s\")", rawDir.c_str());
-
-	std::vector<std::string> ret;
-	std::string dir = GetNormalizedPath(rawDir);
+	std::string dir = FileSystem::GetDirectory(normalizedFilePath);
+	dirs[dir].files.insert(normalizedFilePath.substr(dir.length()));
 
-	std::map<std::string, FileData>::const_iterator filesStart = files.begin();
-	std::map<std::string, FileData>::const_iterator filesEnd   = files.end();
+	// register the dir with its parents, up to the first one that knew it
+	while (!dir.empty()) {
+		const std::string parent = FileSystem::GetDirectory(dir.substr(0, dir.length() - 1));
+		const std::string subDir = dir.substr(parent.length());
 
-	// Non-empty directories to look in should have a trailing backslash
-	if (!dir.empty()) {
-		std::string::size_type dirLast = (dir.length() - 1);
-		if (dir[dirLast] != '/') {
-			dir += "/";
-			++dirLast;
+		if (!dirs[parent].subDirs.insert(subDir).second) {
+			break;
 		}
-		// limit the iterator range
-		std::string dirEnd = dir;
-		dirEnd[dirLast] = dirEnd[dirLast] + 1;
-		filesStart = files.lower_bound(dir);
-		filesEnd   = files.upper_bound(dirEnd);
+
+		dir = parent;
+	}
+}
+
+void CVFSHandler::RemoveFromDirs(const std::string& normalizedFilePath)
+{
+	std::string dir = FileSystem::GetDirectory(normalizedFilePath);
+
+	boost::unordered_map<std::string, DirData>::iterator di = dirs.find(dir);
+	if (di == dirs.end()) {
+		return;
 	}
 
-	std::set<std::string> dirs;
-
-	while (filesStart != filesEnd) {
-		const std::string path = FileSystem::GetDirectory(filesStart->first);
-		// Test to see if this file start with the dir path
-		if (path.compare(0, dir.length(), dir) == 0) {
-			// Strip pathname
-			const std::string name = filesStart->first.substr(dir.length());
-			const std::string::size_type slash = name.find_first_of("/\\");
-			if (slash != std::string::npos) {
-				dirs.insert(name.substr(0, slash + 1));
-			}
+	di->second.files.erase(normalizedFilePath.substr(dir.length()));
+
+	// remove the dirs that became empty (except the root)
+	while (!dir.empty() && di->second.files.empty() && di->second.subDirs.empty()) {
+		dirs.erase(di);
+
+		const std::string parent = FileSystem::GetDirectory(dir.substr(0, dir.length() - 1));
+		const std::string subDir = dir.substr(parent.length());
+
+		di = dirs.find(parent);
+		if (di == dirs.end()) {
+			break;
 		}
-		++filesStart;
+
+		di->second.subDirs.erase(subDir);
+		dir = parent;
 	}
+}
 
-	for (std::set<std::string>::const_iterator it = dirs.begin(); it != dirs.end(); ++it) {
-		ret.push_back(*it);
-		LOG_L(L_DEBUG, "%s", it->c_str());
+void CVFSHandler::GetFilesBelow(const std::string& normalizedDirPath, std::vector<std::string>& filePaths) const
+{
+	const boost::unordered_map<std::string, DirData>::const_iterator di = dirs.find(normalizedDirPath);
+	if (di == dirs.end()) {
+		return;
 	}
 
-	return ret;
+	std::set<std::string>::const_iterator it;
+	for (it = di->second.files.begin(); it != di->second.files.end(); ++it) {
+		filePaths.push_back(normalizedDirPath + *it);
+	}
+	for (it = di->second.subDirs.begin(); it != di->second.subDirs.end(); ++it) {
+		GetFilesBelow(normalizedDirPath + *it, filePaths);
+	}
 }
@@ -4,11 +4,14 @@
 #define _VFS_HANDLER_H
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
 
 class IArchive;
+class CFileView;
 
 /**
  * Main API for accessing the Virtual File System (VFS).
@@ -37,6 +40,23 @@ public:
 	 * @return true if the file exists in the VFS and was successfully read
 	 */
 	bool LoadFile(const std::string& filePath, std::vector<boost::uint8_t>& buffer);
+	/**
+	 * Like LoadFile, but without copying the contents where the archive
+	 * allows that.
+	 * @see IArchive::GetFileView
+	 */
+	bool LoadFileView(const std::string& filePath, CFileView& view);
+
+	/**
+	 * Lets the archives decompress all files below the given (virtual)
+	 * directories on worker threads, ahead of them being loaded.
+	 * @param dirs raw directory paths, for example "units/",
+	 *   case-insensitive
+	 * @see IArchive::Prefetch
+	 */
+	void Prefetch(const std::vector<std::string>& dirs);
+	/// frees what was decompressed by Prefetch and not cached anyway
+	void ClearPrefetched();
 
 	/**
 	 * Returns all the files in the given (virtual) directory without the
@@ -78,12 +98,31 @@ protected:
 		IArchive* ar;
 		int size;
 	};
-	std::map<std::string, FileData> files; 
+	/// by normalized path
+	boost::unordered_map<std::string, FileData> files;
+
+	/// a directory that contains at least one file, directly or in a sub-dir
+	struct DirData {
+		std::set<std::string> files;   ///< file names, without the path
+		std::set<std::string> subDirs; ///< sub-dir names, with a trailing slash
+	};
+	/// by normalized path with a trailing slash, "" is the root
+	boost::unordered_map<std::string, DirData> dirs;
+
 	std::map<std::string, IArchive*> archives;
 
 private:
 	std::string GetNormalizedPath(const std::string& rawPath);
+	/// appends the trailing slash of the keys of dirs, if missing
+	std::string GetNormalizedDirPath(const std::string& rawDir);
 	const FileData* GetFileData(const std::string& normalizedFilePath);
+
+	/// adds a file that was not in files before to dirs
+	void AddToDirs(const std::string& normalizedFilePath);
+	/// removes a file that is not in files anymore from dirs
+	void RemoveFromDirs(const std::string& normalizedFilePath);
+	/// appends all files in the dir and its sub-dirs
+	void GetFilesBelow(const std::string& normalizedDirPath, std::vector<std::string>& filePaths) const;
 };
 
 extern CVFSHandler* vfsHandler;
@@ -5,7 +5,9 @@
 
 #include <algorithm>
 #include <stdexcept>
+#include <boost/bind.hpp>
 
+#include "ArchivePrefetcher.h"
 #include "System/Util.h"
 #include "System/mmgr.h"
 #include "System/Log/ILog.h"
@@ -24,14 +26,9 @@ IArchive* CZipArchiveFactory::DoCreateArchive(const std::string& filePath) const
 
 CZipArchive::CZipArchive(const std::string& archiveName)
 	: CBufferedArchive(archiveName)
+	, prefetcher(NULL)
 {
-#ifdef USEWIN32IOAPI
-	zlib_filefunc_def ffunc;
-	fill_win32_filefunc(&ffunc);
-	zip = unzOpen2(archiveName.c_str(),&ffunc);
-#else
-	zip = unzOpen(archiveName.c_str());
-#endif
+	zip = OpenZip(archiveName);
 	if (!zip) {
 		LOG_L(L_ERROR, "Error opening %s", archiveName.c_str());
 		return;
@@ -62,10 +59,15 @@ CZipArchive::CZipArchive(const std::string& archiveName)
 		fileData.push_back(fd);
 		lcNameIndex[fLowerName] = fileData.size() - 1;
 	}
+
+	prefetcher = new CArchivePrefetcher(fileData.size(), boost::bind(&CZipArchive::PrefetchWorker, this));
 }
 
 CZipArchive::~CZipArchive()
 {
+	// the workers use fileData and prefetchedFiles
+	delete prefetcher;
+
 	if (zip) {
 		unzClose(zip);
 	}
@@ -107,7 +109,34 @@ bool CZipArchive::GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buf
 	}
 	assert(IsFileId(fid));
 
-	unzGoToFilePos(zip, &fileData[fid].fp);
+	// called with archiveLock held
+	const std::map<unsigned int, PrefetchedFile>::iterator pi = prefetchedFiles.find(fid);
+
+	if (pi != prefetchedFiles.end()) {
+		const bool exists = pi->second.exists;
+		buffer.swap(pi->second.data);
+		prefetchedFiles.erase(pi);
+		return exists;
+	}
+
+	return ReadFile(zip, fileData[fid].fp, buffer);
+}
+
+
+unzFile CZipArchive::OpenZip(const std::string& archiveName)
+{
+#ifdef USEWIN32IOAPI
+	zlib_filefunc_def ffunc;
+	fill_win32_filefunc(&ffunc);
+	return unzOpen2(archiveName.c_str(),&ffunc);
+#else
+	return unzOpen(archiveName.c_str());
+#endif
+}
+
+bool CZipArchive::ReadFile(unzFile zip, unz_file_pos fp, std::vector<boost::uint8_t>& buffer)
+{
+	unzGoToFilePos(zip, &fp);
 
 	unz_file_info fi;
 	unzGetCurrentFileInfo(zip, &fi, NULL, 0, NULL, 0, NULL, 0);
@@ -133,3 +162,100 @@ bool CZipArchive::GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buf
 
 	return ret;
 }
+
+
+bool CZipArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
+{
+	// must not hold archiveLock, the worker needs it to store the file
+	if (prefetcher != NULL) {
+		prefetcher->WaitFor(fid);
+	}
+
+	return CBufferedArchive::GetFile(fid, buffer);
+}
+
+bool CZipArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	if (prefetcher != NULL) {
+		prefetcher->WaitFor(fid);
+	}
+
+	return CBufferedArchive::GetFileView(fid, view);
+}
+
+void CZipArchive::Prefetch(const std::vector<unsigned int>& fids)
+{
+	if (prefetcher == NULL) {
+		return;
+	}
+
+	std::vector<unsigned int> uncached;
+	uncached.reserve(fids.size());
+
+	{
+		boost::mutex::scoped_lock lck(archiveLock);
+
+		for (std::vector<unsigned int>::const_iterator it = fids.begin(); it != fids.end(); ++it) {
+			assert(IsFileId(*it));
+
+			if ((*it < cache.size()) && cache[*it].populated) {
+				continue;
+			}
+			if (prefetchedFiles.find(*it) != prefetchedFiles.end()) {
+				continue;
+			}
+
+			uncached.push_back(*it);
+		}
+	}
+
+	prefetcher->Queue(uncached);
+}
+
+void CZipArchive::ClearPrefetched()
+{
+	if (prefetcher == NULL) {
+		return;
+	}
+
+	prefetcher->Stop();
+
+	// the files that were read are in the cache, free the others
+	boost::mutex::scoped_lock lck(archiveLock);
+	prefetchedFiles.clear();
+}
+
+void CZipArchive::PrefetchWorker()
+{
+	// zip is used by GetFileImpl, and unzFile handles are not thread-safe
+	unzFile workerZip = OpenZip(GetArchiveName());
+
+	unsigned int fid;
+
+	while (prefetcher->Next(fid)) {
+		if (workerZip == NULL) {
+			// GetFile will report the error
+			prefetcher->Done(fid);
+			continue;
+		}
+
+		std::vector<boost::uint8_t> data;
+		const bool exists = ReadFile(workerZip, fileData[fid].fp, data);
+
+		{
+			boost::mutex::scoped_lock lck(archiveLock);
+
+			if ((fid >= cache.size()) || !cache[fid].populated) {
+				PrefetchedFile& pf = prefetchedFiles[fid];
+				pf.exists = exists;
+				pf.data.swap(data);
+			}
+		}
+
+		prefetcher->Done(fid);
+	}
+
+	if (workerZip != NULL) {
+		unzClose(workerZip);
+	}
+}
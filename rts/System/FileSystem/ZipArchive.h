@@ -15,9 +15,11 @@
 #include "minizip/iowin32.h"
 #endif
 
+#include <map>
 #include <string>
 #include <vector>
 
+class CArchivePrefetcher;
 
 /**
  * Creates zip compressed, single-file archives.
@@ -46,6 +48,12 @@ public:
 	virtual void FileInfo(unsigned int fid, std::string& name, int& size) const;
 	virtual unsigned int GetCrc32(unsigned int fid);
 
+	virtual bool GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer);
+	virtual bool GetFileView(unsigned int fid, CFileView& view);
+	/// decompresses the files on worker threads, see prefetchedFiles
+	virtual void Prefetch(const std::vector<unsigned int>& fids);
+	virtual void ClearPrefetched();
+
 protected:
 	unzFile zip;
 
@@ -58,6 +66,26 @@ protected:
 	std::vector<FileData> fileData;
 	
 	virtual bool GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buffer);
+
+private:
+	static unzFile OpenZip(const std::string& archiveName);
+	static bool ReadFile(unzFile zip, unz_file_pos fp, std::vector<boost::uint8_t>& buffer);
+
+	/// run by the prefetcher threads, each uses its own unzFile
+	void PrefetchWorker();
+
+	/// a file decompressed by PrefetchWorker
+	struct PrefetchedFile {
+		bool exists;
+		std::vector<boost::uint8_t> data;
+	};
+	/**
+	 * By file id, guarded by archiveLock. A file moves into the cache
+	 * when it is first read, the rest is freed by ClearPrefetched.
+	 */
+	std::map<unsigned int, PrefetchedFile> prefetchedFiles;
+	/// units are files, NULL if the archive could not be opened
+	CArchivePrefetcher* prefetcher;
 };
 
 #endif // _ZIP_ARCHIVE_H
@@ -31,6 +31,7 @@
 #include <sys/utsname.h> // for uname()
 #include <sys/types.h> // for getpw
 #include <pwd.h> // for getpw
+#include <unistd.h> // for getpid
 #endif
 
 #include <cstring>
@@ -323,6 +324,15 @@ std::string GetOS()
 #endif
 }
 
+int GetProcessId()
+{
+#ifdef WIN32
+	return _getpid();
+#else
+	return getpid();
+#endif
+}
+
 bool Is64Bit()
 {
 	return (sizeof(void*) == 8);
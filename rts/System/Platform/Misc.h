@@ -71,6 +71,12 @@ std::string GetModuleFile(std::string moduleName = "");
  */
 std::string GetModulePath(const std::string& moduleName = "");
 
+/**
+ * Returns the ID of the running process, e.g. to make the names of
+ * temporary files unique between several running engines.
+ */
+int GetProcessId();
+
 std::string GetOS();
 bool Is64Bit();
 bool Is32BitEmulation();
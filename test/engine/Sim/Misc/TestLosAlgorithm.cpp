@@ -0,0 +1,148 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/LosMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#define BOOST_TEST_MODULE LosAlgorithm
+#include <boost/test/unit_test.hpp>
+
+/*
+ * Compares the batched LOS ray-casting (as done by CLosHandler between
+ * BeginLosUpdateBatch and EndLosUpdateBatch) with the serial path, where
+ * every instance is ray-casted and added to the count map right away.
+ * Both must produce the same square lists and the same counts.
+ */
+
+static const int MAP_SIZE_X = 256;
+static const int MAP_SIZE_Z = 192;
+static const int NUM_INSTANCES = 2000;
+static const int NUM_ROUNDS = 8;
+
+
+struct Instance {
+	Instance(): losSize(0), baseHeight(0.0f), queued(false), added(false) {}
+
+	int2 basePos;
+	int losSize;
+	float baseHeight;
+	std::vector<int> losSquares;
+
+	bool queued;
+	bool added;
+};
+
+
+/// same minimal counting as CLosMap::AddMapSquares, without the unsynced heightmap part
+static void AddSquares(std::vector<int>& map, const std::vector<int>& squares, int amount)
+{
+	for (std::vector<int>::const_iterator it = squares.begin(); it != squares.end(); ++it) {
+		map[*it] += amount;
+	}
+}
+
+
+static std::vector<float> MakeHeightMap()
+{
+	std::vector<float> heightmap(MAP_SIZE_X * MAP_SIZE_Z);
+
+	for (int z = 0; z < MAP_SIZE_Z; ++z) {
+		for (int x = 0; x < MAP_SIZE_X; ++x) {
+			heightmap[z * MAP_SIZE_X + x] =
+				100.0f * std::sin(x * 0.07f) * std::cos(z * 0.05f) +
+				 30.0f * std::sin((x + z) * 0.21f);
+		}
+	}
+
+	return heightmap;
+}
+
+
+static void MoveInstance(Instance& i)
+{
+	// include positions at and near the edges so SafeLosAdd is covered too
+	i.basePos.x = (rand() % (MAP_SIZE_X + 20)) - 10;
+	i.basePos.y = (rand() % (MAP_SIZE_Z + 20)) - 10;
+	i.basePos.x = std::max(0, std::min(MAP_SIZE_X - 1, i.basePos.x));
+	i.basePos.y = std::max(0, std::min(MAP_SIZE_Z - 1, i.basePos.y));
+	i.losSize = 1 + (rand() % 40);
+	i.baseHeight = (rand() % 100) * 0.5f;
+}
+
+
+
+BOOST_AUTO_TEST_CASE(BatchedEqualsSerial)
+{
+	const std::vector<float> heightmap = MakeHeightMap();
+	CLosAlgorithm losAlgo(int2(MAP_SIZE_X, MAP_SIZE_Z), -1e6f, 15, &heightmap[0]);
+
+	std::vector<Instance> serial(NUM_INSTANCES);
+	std::vector<Instance> batched(NUM_INSTANCES);
+	std::vector<int> serialMap(MAP_SIZE_X * MAP_SIZE_Z, 0);
+	std::vector<int> batchedMap(MAP_SIZE_X * MAP_SIZE_Z, 0);
+
+	srand(1234);
+
+	for (int round = 0; round < NUM_ROUNDS; ++round) {
+		std::vector<Instance*> queue;
+
+		for (int n = 0; n < NUM_INSTANCES; ++n) {
+			// move about half of the instances each round
+			if (round > 0 && (rand() & 1))
+				continue;
+
+			Instance& s = serial[n];
+			Instance& b = batched[n];
+
+			// remove the old LOS
+			if (s.added) {
+				AddSquares(serialMap, s.losSquares, -1);
+				s.losSquares.clear();
+			}
+			if (b.added) {
+				AddSquares(batchedMap, b.losSquares, -1);
+				b.losSquares.clear();
+			}
+
+			MoveInstance(s);
+			b.basePos = s.basePos;
+			b.losSize = s.losSize;
+			b.baseHeight = s.baseHeight;
+
+			losAlgo.LosAdd(s.basePos, s.losSize, s.baseHeight, s.losSquares);
+			AddSquares(serialMap, s.losSquares, 1);
+			s.added = true;
+
+			b.queued = true;
+			b.added = false;
+			queue.push_back(&b);
+
+			// sometimes the instance gets removed again before the batch is flushed
+			if ((rand() % 10) == 0) {
+				AddSquares(serialMap, s.losSquares, -1);
+				s.losSquares.clear();
+				s.added = false;
+
+				queue.pop_back();
+				b.queued = false;
+			}
+		}
+
+		losAlgo.LosAdd(queue);
+
+		for (std::vector<Instance*>::const_iterator it = queue.begin(); it != queue.end(); ++it) {
+			AddSquares(batchedMap, (*it)->losSquares, 1);
+			(*it)->queued = false;
+			(*it)->added = true;
+		}
+
+		for (int n = 0; n < NUM_INSTANCES; ++n) {
+			BOOST_CHECK(serial[n].losSquares == batched[n].losSquares);
+		}
+
+		BOOST_CHECK(serialMap == batchedMap);
+	}
+}
@@ -0,0 +1,441 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/QuadFieldStorage.h"
+#include "System/float3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <vector>
+
+#define BOOST_TEST_MODULE QuadFieldStorage
+#include <boost/test/unit_test.hpp>
+
+/*
+ * Replays a unit/projectile distribution against both quad storage layouts
+ * (std::list vs. contiguous arrays), through the same QuadFieldStorage
+ * functions CQuadField uses, and compares the query results and the time
+ * spent.
+ *
+ * By default a synthetic distribution is generated (a number of army blobs
+ * moving across the map, projectiles flying between them). A distribution
+ * recorded from a real game can be used instead by pointing the environment
+ * variable SPRING_QUADFIELD_REPLAY to a text file with one object per line:
+ *   <frame> <u|p> <id> <x> <z> <radius>
+ * Frames must be in ascending order; an object not listed in a frame it was
+ * listed in before is considered to be removed.
+ */
+
+static const int QUAD_SIZE = 256;
+static const int NUM_QUADS_X = 64;
+static const int NUM_QUADS_Z = 64;
+static const float MAP_SIZE_X = NUM_QUADS_X * QUAD_SIZE;
+static const float MAP_SIZE_Z = NUM_QUADS_Z * QUAD_SIZE;
+
+
+/// the members of CUnit and CProjectile the quad field touches
+struct Object {
+	Object(): type('u'), id(0), radius(0.0f), allyteam(0), tempNum(0), cellIdx(-1) {}
+
+	int GetQuadFieldCellIdx() const { return cellIdx; }
+	void SetQuadFieldCellIdx(int idx) { cellIdx = idx; }
+
+	char type;
+	int id;
+	float3 pos;
+	float3 midPos;
+	float radius;
+	int allyteam;
+	int tempNum;
+	int cellIdx;
+	std::vector<int> quads;
+};
+
+struct ObjectState {
+	char type;
+	int id;
+	float x, z;
+	float radius;
+};
+
+typedef std::vector<ObjectState> Frame;
+
+
+
+/// same members as CQuadField::Quad (minus the features)
+template<template<typename> class Container>
+struct Quad {
+	Quad(): teamUnits(1) {}
+
+	typename Container<Object>::type units;
+	std::vector<typename Container<Object>::type> teamUnits;
+	typename Container<Object>::type projectiles;
+};
+
+/**
+ * CQuadField without the globals (gs->tempNum, the map size) it needs:
+ * the bookkeeping is done by QuadFieldStorage, this only finds the quads.
+ */
+template<template<typename> class Container>
+class TestField {
+public:
+	TestField(): quads(NUM_QUADS_X * NUM_QUADS_Z), tempNum(1) {}
+
+	/// same as CQuadField::GetQuads
+	void GetQuads(const float3& pos, float radius, std::vector<int>& ret) const {
+		ret.clear();
+
+		const int maxx = std::min(((int)(pos.x + radius)) / QUAD_SIZE + 1, NUM_QUADS_X - 1);
+		const int maxz = std::min(((int)(pos.z + radius)) / QUAD_SIZE + 1, NUM_QUADS_Z - 1);
+		const int minx = std::max(((int)(pos.x - radius)) / QUAD_SIZE, 0);
+		const int minz = std::max(((int)(pos.z - radius)) / QUAD_SIZE, 0);
+
+		const float maxSqLength = (radius + QUAD_SIZE * 0.72f) * (radius + QUAD_SIZE * 0.72f);
+
+		for (int qz = minz; qz <= maxz; ++qz) {
+			for (int qx = minx; qx <= maxx; ++qx) {
+				const float3 quadPos(qx * QUAD_SIZE + QUAD_SIZE * 0.5f, 0.0f, qz * QUAD_SIZE + QUAD_SIZE * 0.5f);
+
+				if ((pos - quadPos).SqLength2D() < maxSqLength) {
+					ret.push_back(qz * NUM_QUADS_X + qx);
+				}
+			}
+		}
+	}
+
+	void MovedUnit(Object* o) {
+		GetQuads(o->pos, o->radius, newQuads);
+
+		if (newQuads == o->quads)
+			return;
+
+		QuadFieldStorage::MoveUnit(quads, o, newQuads);
+	}
+
+	void RemoveUnit(Object* o) {
+		QuadFieldStorage::RemoveUnit(quads, o);
+	}
+
+	int ProjectileCell(const Object* o) const {
+		const int cx = std::max(0, std::min(int(o->pos.x / QUAD_SIZE), NUM_QUADS_X - 1));
+		const int cz = std::max(0, std::min(int(o->pos.z / QUAD_SIZE), NUM_QUADS_Z - 1));
+		return (cz * NUM_QUADS_X + cx);
+	}
+
+	void AddProjectile(Object* o) {
+		o->quads.assign(1, ProjectileCell(o));
+		QuadFieldStorage::AddProjectile(quads[o->quads[0]].projectiles, o);
+	}
+
+	void RemoveProjectile(Object* o) {
+		BOOST_REQUIRE(QuadFieldStorage::RemoveProjectile(quads[o->quads[0]].projectiles, o));
+		o->quads.clear();
+	}
+
+	void MovedProjectile(Object* o) {
+		if (o->quads.empty() || ProjectileCell(o) != o->quads[0]) {
+			if (!o->quads.empty())
+				RemoveProjectile(o);
+
+			AddProjectile(o);
+		}
+	}
+
+	struct CollectVisitor {
+		CollectVisitor(std::vector<int>& ret): ret(ret) {}
+		bool operator() (Object* u) { ret.push_back(u->id); return true; }
+		std::vector<int>& ret;
+	};
+
+	/// same as CQuadField::GetUnitsExact (spherical = false)
+	void GetUnitsExact(const float3& pos, float radius, std::vector<int>& ret) {
+		CollectVisitor visitor(ret);
+
+		GetQuads(pos, radius, queryQuads);
+
+		const int* begin = queryQuads.empty()? NULL: &queryQuads[0];
+		QuadFieldStorage::VisitUnitsExact(quads, begin, begin + queryQuads.size(), pos, radius, false, tempNum++, visitor);
+	}
+
+	/// same as CQuadField::GetProjectilesExact
+	void GetProjectilesExact(const float3& pos, float radius, std::vector<int>& ret) {
+		CollectVisitor visitor(ret);
+
+		GetQuads(pos, radius, queryQuads);
+
+		const int* begin = queryQuads.empty()? NULL: &queryQuads[0];
+		QuadFieldStorage::VisitProjectilesExact(quads, begin, begin + queryQuads.size(), pos, radius, visitor);
+	}
+
+private:
+	std::vector< Quad<Container> > quads;
+
+	std::vector<int> newQuads;
+	std::vector<int> queryQuads;
+
+	int tempNum;
+};
+
+
+
+static float RandFloat(unsigned int& seed)
+{
+	// same LCG as used by CGlobalSynced
+	seed = (seed * 214013L + 2531011L);
+	return float((seed >> 16) & 0x7FFF) / 32767.0f;
+}
+
+static std::vector<Frame> GenerateDistribution(int numFrames, int numUnits, int numProjectiles)
+{
+	std::vector<Frame> frames(numFrames);
+	std::vector<ObjectState> units(numUnits);
+	std::vector<ObjectState> projectiles(numProjectiles);
+	std::vector<float> unitDirs(numUnits * 2);
+	std::vector<float> projDirs(numProjectiles * 2);
+
+	unsigned int seed = 1234;
+
+	// units move in blobs of 50
+	for (int i = 0; i < numUnits; ++i) {
+		const int blob = i / 50;
+		unsigned int blobSeed = blob * 7919 + 1;
+		const float cx = RandFloat(blobSeed) * MAP_SIZE_X;
+		const float cz = RandFloat(blobSeed) * MAP_SIZE_Z;
+
+		units[i].type = 'u';
+		units[i].id = i;
+		units[i].x = std::max(0.0f, std::min(MAP_SIZE_X - 1.0f, cx + (RandFloat(seed) - 0.5f) * 600.0f));
+		units[i].z = std::max(0.0f, std::min(MAP_SIZE_Z - 1.0f, cz + (RandFloat(seed) - 0.5f) * 600.0f));
+		units[i].radius = 10.0f + RandFloat(seed) * 40.0f;
+		unitDirs[i * 2 + 0] = (RandFloat(blobSeed) - 0.5f) * 4.0f;
+		unitDirs[i * 2 + 1] = (RandFloat(blobSeed) - 0.5f) * 4.0f;
+	}
+	for (int i = 0; i < numProjectiles; ++i) {
+		projectiles[i].type = 'p';
+		projectiles[i].id = numUnits + i;
+		projectiles[i].radius = 0.0f;
+		projDirs[i * 2] = 0.0f;
+	}
+
+	for (int f = 0; f < numFrames; ++f) {
+		for (int i = 0; i < numUnits; ++i) {
+			units[i].x += unitDirs[i * 2 + 0];
+			units[i].z += unitDirs[i * 2 + 1];
+
+			if (units[i].x < 0.0f || units[i].x >= MAP_SIZE_X) { unitDirs[i * 2 + 0] = -unitDirs[i * 2 + 0]; }
+			if (units[i].z < 0.0f || units[i].z >= MAP_SIZE_Z) { unitDirs[i * 2 + 1] = -unitDirs[i * 2 + 1]; }
+
+			units[i].x = std::max(0.0f, std::min(MAP_SIZE_X - 1.0f, units[i].x));
+			units[i].z = std::max(0.0f, std::min(MAP_SIZE_Z - 1.0f, units[i].z));
+
+			frames[f].push_back(units[i]);
+		}
+
+		for (int i = 0; i < numProjectiles; ++i) {
+			ObjectState& p = projectiles[i];
+
+			// (re)spawn projectiles at a random unit, headed for another
+			if (projDirs[i * 2] == 0.0f || (RandFloat(seed) < 0.01f)) {
+				const ObjectState& src = units[int(RandFloat(seed) * (numUnits - 1))];
+				const ObjectState& dst = units[int(RandFloat(seed) * (numUnits - 1))];
+				const float dx = dst.x - src.x;
+				const float dz = dst.z - src.z;
+				const float len = std::max(1.0f, std::sqrt(dx * dx + dz * dz));
+
+				// give every spawn a new id, so that the replay sees it as
+				// a projectile being removed and another one being created
+				p.id += numProjectiles;
+				p.x = src.x;
+				p.z = src.z;
+				projDirs[i * 2 + 0] = (dx / len) * 20.0f;
+				projDirs[i * 2 + 1] = (dz / len) * 20.0f;
+			}
+
+			p.x = std::max(0.0f, std::min(MAP_SIZE_X - 1.0f, p.x + projDirs[i * 2 + 0]));
+			p.z = std::max(0.0f, std::min(MAP_SIZE_Z - 1.0f, p.z + projDirs[i * 2 + 1]));
+
+			frames[f].push_back(p);
+		}
+	}
+
+	return frames;
+}
+
+static bool LoadDistribution(const char* fileName, std::vector<Frame>& frames)
+{
+	FILE* file = fopen(fileName, "r");
+
+	if (file == NULL)
+		return false;
+
+	ObjectState s;
+	int frame = 0;
+
+	while (fscanf(file, "%d %c %d %f %f %f", &frame, &s.type, &s.id, &s.x, &s.z, &s.radius) == 6) {
+		if (frame < 0)
+			continue;
+		if (frame >= frames.size())
+			frames.resize(frame + 1);
+
+		s.x = std::max(0.0f, std::min(MAP_SIZE_X - 1.0f, s.x));
+		s.z = std::max(0.0f, std::min(MAP_SIZE_Z - 1.0f, s.z));
+		frames[frame].push_back(s);
+	}
+
+	fclose(file);
+	return !frames.empty();
+}
+
+
+
+/**
+ * Replays @c frames against a TestField with the given layout.
+ * Every frame moves (adds/removes) all objects and then does one
+ * unit and one projectile query around every 10th unit.
+ * @return a checksum over the (sorted) query results
+ */
+template<template<typename> class Container>
+static unsigned int Replay(const std::vector<Frame>& frames, float& seconds)
+{
+	TestField<Container> field;
+
+	// NOTE: a deque, the field keeps pointers to its elements
+	std::deque<Object> objects;
+	std::vector<int> lastSeen;
+	std::vector<int> results;
+
+	unsigned int checksum = 0;
+
+	const clock_t startTime = clock();
+
+	for (int f = 0; f < frames.size(); ++f) {
+		const Frame& frame = frames[f];
+
+		for (Frame::const_iterator si = frame.begin(); si != frame.end(); ++si) {
+			if (si->id >= objects.size()) {
+				objects.resize(si->id + 1);
+				lastSeen.resize(si->id + 1, -1);
+			}
+
+			Object& o = objects[si->id];
+			o.type = si->type;
+			o.id = si->id;
+			o.pos = float3(si->x, 0.0f, si->z);
+			o.midPos = o.pos;
+			o.radius = si->radius;
+			lastSeen[si->id] = f;
+
+			if (si->type == 'p') {
+				field.MovedProjectile(&o);
+			} else {
+				field.MovedUnit(&o);
+			}
+		}
+
+		// remove everything that was not part of this frame
+		for (int id = 0; id < objects.size(); ++id) {
+			if (lastSeen[id] != (f - 1) || objects[id].quads.empty())
+				continue;
+
+			if (objects[id].type == 'p') {
+				field.RemoveProjectile(&objects[id]);
+			} else {
+				field.RemoveUnit(&objects[id]);
+			}
+		}
+
+		for (int i = 0; i < frame.size(); i += 10) {
+			if (frame[i].type != 'u')
+				continue;
+
+			results.clear();
+			const float3 pos(frame[i].x, 0.0f, frame[i].z);
+
+			field.GetUnitsExact(pos, 500.0f, results);
+			field.GetProjectilesExact(pos, 300.0f, results);
+
+			// iteration order differs between the layouts, results must not
+			std::sort(results.begin(), results.end());
+
+			for (int r = 0; r < results.size(); ++r) {
+				checksum = checksum * 31 + results[r];
+			}
+		}
+	}
+
+	seconds = float(clock() - startTime) / CLOCKS_PER_SEC;
+	return checksum;
+}
+
+
+
+BOOST_AUTO_TEST_CASE(SwapRemove)
+{
+	std::vector<Object> objects(5);
+	std::vector<Object*> array;
+
+	for (int i = 0; i < objects.size(); ++i) {
+		objects[i].id = i;
+		QuadFieldStorage::Insert(array, &objects[i]);
+	}
+
+	BOOST_CHECK(QuadFieldStorage::Remove(array, &objects[1]));
+	BOOST_CHECK(!QuadFieldStorage::Remove(array, &objects[1]));
+	BOOST_CHECK(array.size() == 4);
+	BOOST_CHECK(array[1] == &objects[4]);
+
+	BOOST_CHECK(QuadFieldStorage::RemoveAt(array, 3) == NULL);
+	BOOST_CHECK(QuadFieldStorage::RemoveAt(array, 0) == &objects[2]);
+	BOOST_CHECK(array.size() == 2);
+	BOOST_CHECK(array[0] == &objects[2]);
+	BOOST_CHECK(array[1] == &objects[4]);
+}
+
+BOOST_AUTO_TEST_CASE(ProjectileSlots)
+{
+	std::vector<Object> objects(4);
+	std::vector<Object*> array;
+
+	for (int i = 0; i < objects.size(); ++i) {
+		QuadFieldStorage::AddProjectile(array, &objects[i]);
+		BOOST_CHECK(objects[i].GetQuadFieldCellIdx() == i);
+	}
+
+	// the last one takes over the slot of the removed one
+	BOOST_CHECK(QuadFieldStorage::RemoveProjectile(array, &objects[1]));
+	BOOST_CHECK(objects[1].GetQuadFieldCellIdx() == -1);
+	BOOST_CHECK(objects[3].GetQuadFieldCellIdx() == 1);
+	BOOST_CHECK(array[1] == &objects[3]);
+
+	BOOST_CHECK(!QuadFieldStorage::RemoveProjectile(array, &objects[1]));
+	BOOST_CHECK(QuadFieldStorage::RemoveProjectile(array, &objects[2]));
+	BOOST_CHECK(array.size() == 2);
+	BOOST_CHECK(objects[0].GetQuadFieldCellIdx() == 0);
+	BOOST_CHECK(objects[3].GetQuadFieldCellIdx() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(ReplayDistribution)
+{
+	std::vector<Frame> frames;
+
+	const char* replayFile = getenv("SPRING_QUADFIELD_REPLAY");
+
+	if (replayFile == NULL || !LoadDistribution(replayFile, frames)) {
+		frames = GenerateDistribution(60, 5000, 2000);
+	}
+
+	float listTime = 0.0f;
+	float arrayTime = 0.0f;
+
+	const unsigned int listChecksum = Replay<QuadFieldStorage::List>(frames, listTime);
+	const unsigned int arrayChecksum = Replay<QuadFieldStorage::Array>(frames, arrayTime);
+
+	BOOST_CHECK(listChecksum == arrayChecksum);
+
+	BOOST_TEST_MESSAGE("frames replayed: " << frames.size());
+	BOOST_TEST_MESSAGE("std::list layout: " << listTime << "s");
+	BOOST_TEST_MESSAGE("array layout:     " << arrayTime << "s");
+}
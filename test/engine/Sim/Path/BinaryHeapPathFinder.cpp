@@ -0,0 +1,17 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+// CPathFinder again, with the std::priority_queue based open-list; renamed
+// so it can live next to the default one in test_PathOpenList
+
+#define PATH_BINARY_HEAP_OPENLIST
+#define CPathFinder CBinaryHeapPathFinder
+#define PathPriorityQueue PathBinaryHeapQueue
+
+#include "Sim/Path/Default/PathFinder.cpp"
+
+#include "PathFinderReplay.h"
+
+double ReplayPathRequestsBinaryHeap(const MoveData& moveData, const std::vector<PathRequest>& requests, std::vector<PathResult>& results)
+{
+	return ReplayPathRequests<CBinaryHeapPathFinder>(moveData, requests, results);
+}
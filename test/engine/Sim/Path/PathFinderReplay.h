@@ -0,0 +1,61 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PATH_FINDER_REPLAY_H
+#define PATH_FINDER_REPLAY_H
+
+#include "Sim/Path/Default/IPath.h"
+#include "Sim/Path/Default/PathFinderDef.h"
+#include "Sim/MoveTypes/MoveInfo.h"
+
+#include <ctime>
+#include <vector>
+
+struct PathRequest {
+	float3 start;
+	float3 goal;
+};
+
+struct PathResult {
+	IPath::SearchResult result;
+	float pathCost;
+	std::vector<int2> squares;
+};
+
+
+/**
+ * Runs @c requests through a new instance of @c PathFinder
+ * (CPathFinder, built with one or the other open-list).
+ * @return the time spent searching, in seconds
+ */
+template<typename PathFinder>
+static double ReplayPathRequests(const MoveData& moveData, const std::vector<PathRequest>& requests, std::vector<PathResult>& results)
+{
+	PathFinder* pf = new PathFinder();
+
+	results.clear();
+	results.resize(requests.size());
+
+	const std::clock_t t0 = std::clock();
+
+	for (size_t n = 0; n < requests.size(); ++n) {
+		const CPathFinderDef pfDef(requests[n].goal, 0.0f);
+
+		IPath::Path path;
+		PathResult& r = results[n];
+
+		r.result = pf->GetPath(moveData, requests[n].start, pfDef, path, false, false, MAX_SEARCHED_NODES_PF, true, 0, true);
+		r.pathCost = path.pathCost;
+		r.squares = path.squares;
+	}
+
+	const std::clock_t t1 = std::clock();
+
+	delete pf;
+
+	return (double(t1 - t0) / CLOCKS_PER_SEC);
+}
+
+/// ReplayPathRequests with CPathFinder built for PATH_BINARY_HEAP_OPENLIST
+double ReplayPathRequestsBinaryHeap(const MoveData& moveData, const std::vector<PathRequest>& requests, std::vector<PathResult>& results);
+
+#endif // PATH_FINDER_REPLAY_H
@@ -0,0 +1,136 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Path/Default/PathFinder.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
+#include "PathFinderReplay.h"
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#define BOOST_TEST_MODULE PathOpenList
+#include <boost/test/unit_test.hpp>
+
+/*
+ * Runs the same set of path requests through CPathFinder built with
+ * either open-list implementation (the binary heap one comes from
+ * BinaryHeapPathFinder.cpp) and checks that the results are identical.
+ * Also reports the time each implementation took.
+ *
+ * The map is a grid of speed-modifiers read by the CMoveMath functions
+ * below (quantized, so that many nodes tie in fCost) with some walls.
+ */
+
+static const int MAP_SIZE_X = 256;
+static const int MAP_SIZE_Z = 256;
+static const int NUM_REQUESTS = 100;
+
+static std::vector<float> speedMods;
+
+CGlobalSynced* gs = NULL;
+
+
+creg::Class* CMoveMath::GetClass() { return NULL; }
+
+float CMoveMath::yLevel(const float3& pos) const
+{
+	return yLevel((pos.x / SQUARE_SIZE), (pos.z / SQUARE_SIZE));
+}
+
+float CMoveMath::GetPosSpeedMod(const MoveData& moveData, int xSquare, int zSquare) const
+{
+	if (xSquare < 0 || zSquare < 0 || xSquare >= MAP_SIZE_X || zSquare >= MAP_SIZE_Z) {
+		return 0.0f;
+	}
+
+	return speedMods[zSquare * MAP_SIZE_X + xSquare];
+}
+
+CMoveMath::BlockType CMoveMath::IsBlockedNoSpeedModCheck(const MoveData& moveData, int xSquare, int zSquare) const
+{
+	return BLOCK_NONE;
+}
+
+class CTestMoveMath: public CMoveMath {
+protected:
+	float SpeedMod(const MoveData&, float, float) const { return 1.0f; }
+	float SpeedMod(const MoveData&, float, float, float) const { return 1.0f; }
+
+public:
+	float yLevel(int, int) const { return 0.0f; }
+};
+
+
+struct TestMap {
+	TestMap() {
+		// only the map dimensions are read by CPathFinder
+		gs = static_cast<CGlobalSynced*>(::operator new(sizeof(CGlobalSynced)));
+		gs->mapx = MAP_SIZE_X; gs->mapxm1 = MAP_SIZE_X - 1; gs->hmapx = MAP_SIZE_X / 2;
+		gs->mapy = MAP_SIZE_Z; gs->mapym1 = MAP_SIZE_Z - 1; gs->hmapy = MAP_SIZE_Z / 2;
+
+		srand(5678);
+		speedMods.resize(MAP_SIZE_X * MAP_SIZE_Z);
+
+		for (int z = 0; z < MAP_SIZE_Z; ++z) {
+			for (int x = 0; x < MAP_SIZE_X; ++x) {
+				float s = 1.0f / (1 + (rand() % 4));
+
+				if ((x % 64) == 32 && (z % 128) > 16)
+					s = 0.0f;
+
+				speedMods[z * MAP_SIZE_X + x] = s;
+			}
+		}
+	}
+	~TestMap() {
+		::operator delete(gs);
+		gs = NULL;
+	}
+};
+
+BOOST_GLOBAL_FIXTURE(TestMap);
+
+
+
+BOOST_AUTO_TEST_CASE(IdenticalPaths)
+{
+	CTestMoveMath moveMath;
+	MoveData moveData(NULL);
+	moveData.moveMath = &moveMath;
+
+	std::vector<PathRequest> requests(NUM_REQUESTS);
+
+	for (int n = 0; n < NUM_REQUESTS; ++n) {
+		requests[n].start = float3(rand() % (MAP_SIZE_X * SQUARE_SIZE), 0.0f, rand() % (MAP_SIZE_Z * SQUARE_SIZE));
+		requests[n].goal  = float3(rand() % (MAP_SIZE_X * SQUARE_SIZE), 0.0f, rand() % (MAP_SIZE_Z * SQUARE_SIZE));
+	}
+
+	std::vector<PathResult> binResults;
+	std::vector<PathResult> daryResults;
+
+	const double binTime = ReplayPathRequestsBinaryHeap(moveData, requests, binResults);
+	const double daryTime = ReplayPathRequests<CPathFinder>(moveData, requests, daryResults);
+
+	BOOST_TEST_MESSAGE("binary heap: " << binTime << "s, 4-ary heap: " << daryTime << "s");
+
+	int numFound = 0;
+
+	for (int n = 0; n < NUM_REQUESTS; ++n) {
+		const PathResult& b = binResults[n];
+		const PathResult& d = daryResults[n];
+
+		BOOST_CHECK_EQUAL(b.result, d.result);
+		BOOST_CHECK_EQUAL(b.pathCost, d.pathCost);
+		BOOST_CHECK_EQUAL(b.squares.size(), d.squares.size());
+
+		for (size_t i = 0; i < std::min(b.squares.size(), d.squares.size()); ++i) {
+			BOOST_CHECK(b.squares[i].x == d.squares[i].x && b.squares[i].y == d.squares[i].y);
+		}
+
+		numFound += (d.result == IPath::Ok);
+	}
+
+	// most requests are not blocked by the walls
+	BOOST_CHECK(numFound > (NUM_REQUESTS / 2));
+}
@@ -0,0 +1,116 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Path/Default/PathSearchWorker.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#define BOOST_TEST_MODULE PathSearchWorker
+#include <boost/test/unit_test.hpp>
+
+/*
+ * Checks when and on which thread CPathSearchWorker runs the searches:
+ * threaded ones on its own thread, deferred ones (GML) only by Finish.
+ */
+
+struct Search {
+	Search(): numCalls(0), sleepTime(0), running(false) {}
+
+	void operator() () {
+		running = true;
+		threadId = boost::this_thread::get_id();
+
+		if (sleepTime > 0)
+			boost::this_thread::sleep(boost::posix_time::milliseconds(sleepTime));
+
+		++numCalls;
+		running = false;
+	}
+
+	volatile int numCalls;
+	int sleepTime;
+	volatile bool running;
+	boost::thread::id threadId;
+};
+
+static void Finish(CPathSearchWorker* worker, volatile bool* joined)
+{
+	*joined = worker->Finish();
+}
+
+
+BOOST_AUTO_TEST_CASE(Threaded)
+{
+	Search search;
+	CPathSearchWorker worker(boost::ref(search), true);
+
+	BOOST_CHECK(worker.IsThreaded());
+	BOOST_CHECK(worker.IsIdle());
+	BOOST_CHECK(!worker.Wait());
+
+	BOOST_CHECK(worker.Start());
+	// not joined yet
+	BOOST_CHECK(!worker.Start());
+	BOOST_CHECK(worker.Wait());
+
+	BOOST_CHECK_EQUAL(search.numCalls, 1);
+	BOOST_CHECK(search.threadId != boost::this_thread::get_id());
+	BOOST_CHECK(worker.IsIdle());
+
+	// Finish does not search again
+	BOOST_CHECK(!worker.Finish());
+	BOOST_CHECK_EQUAL(search.numCalls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(Deferred)
+{
+	Search search;
+	CPathSearchWorker worker(boost::ref(search), false);
+
+	BOOST_CHECK(!worker.IsThreaded());
+	BOOST_CHECK(worker.Start());
+	BOOST_CHECK(!worker.Start());
+
+	// waiting (eg. for a cost change) does not run deferred searches
+	BOOST_CHECK(!worker.Wait());
+	BOOST_CHECK_EQUAL(search.numCalls, 0);
+	BOOST_CHECK(!worker.IsIdle());
+
+	BOOST_CHECK(worker.Finish());
+	BOOST_CHECK_EQUAL(search.numCalls, 1);
+	BOOST_CHECK(search.threadId == boost::this_thread::get_id());
+	BOOST_CHECK(worker.IsIdle());
+
+	BOOST_CHECK(!worker.Finish());
+	BOOST_CHECK_EQUAL(search.numCalls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(DeferredBlocksWait)
+{
+	Search search;
+	search.sleepTime = 100;
+
+	CPathSearchWorker worker(boost::ref(search), false);
+	volatile bool finishJoined = false;
+
+	BOOST_CHECK(worker.Start());
+
+	// Finish on another thread (the sim), Wait on this one (the draw thread)
+	boost::thread finishThread(boost::bind(&Finish, &worker, &finishJoined));
+
+	while (!search.running && search.numCalls == 0) {
+		boost::this_thread::yield();
+	}
+
+	const bool waitJoined = worker.Wait();
+
+	// Wait returned only after the search was done
+	BOOST_CHECK_EQUAL(search.numCalls, 1);
+	BOOST_CHECK(search.threadId != boost::this_thread::get_id());
+
+	finishThread.join();
+
+	// whichever came first joined it
+	BOOST_CHECK(waitJoined != finishJoined);
+	BOOST_CHECK(worker.IsIdle());
+}
@@ -0,0 +1,290 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/ActiveUnitArray.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <list>
+#include <vector>
+
+#define BOOST_TEST_MODULE ActiveUnitArray
+#include <boost/test/unit_test.hpp>
+
+/*
+ * Checks that passes over the dense active-unit array (as done by
+ * CUnitHandler::Update) visit every unit exactly once while units are
+ * added during the pass and removed between frames, and that the three
+ * per-frame passes over it are cheaper than over the old std::list (at
+ * 5k and 20k units).
+ */
+
+static const unsigned int MAX_UNITS = 32000;
+static const int SLOWUPDATE_RATE = 16;
+
+
+struct Unit {
+	Unit(): id(0), addFrame(0), visits(0), slowVisits(0) {}
+
+	unsigned int id;
+	int addFrame;
+	int visits;
+	int slowVisits;
+	char payload[512]; // roughly spread units like the real ones are
+};
+
+
+struct Handler {
+	Handler(): slowUpdateIndex(0), updateIndex(0) {
+		slots.resize(MAX_UNITS, 0);
+	}
+
+	void Add(Unit* u) {
+		unsigned int pos = units.size();
+
+		if (!units.empty()) {
+			const unsigned int minPos = std::max(slowUpdateIndex, updateIndex);
+			pos = minPos + (rand() % (units.size() - minPos + 1));
+		}
+
+		ActiveUnitArray::Insert(units, slots, u, pos);
+	}
+
+	void Remove(Unit* u) {
+		ActiveUnitArray::Remove(units, slots, u, slowUpdateIndex);
+	}
+
+	std::vector<Unit*> units;
+	std::vector<unsigned int> slots;
+
+	unsigned int slowUpdateIndex;
+	unsigned int updateIndex;
+};
+
+
+
+BOOST_AUTO_TEST_CASE(VisitEachUnitOnce)
+{
+	Handler h;
+	std::vector<Unit> storage(MAX_UNITS);
+	std::vector<unsigned int> freeIDs;
+
+	for (unsigned int id = 0; id < MAX_UNITS; id++) {
+		storage[id].id = id;
+		freeIDs.push_back(MAX_UNITS - 1 - id);
+	}
+
+	srand(42);
+
+	for (int n = 0; n < 2000; n++) {
+		h.Add(&storage[freeIDs.back()]);
+		freeIDs.pop_back();
+	}
+
+	for (int frame = 0; frame < 200; frame++) {
+		// removals happen between the passes only
+		for (int n = rand() % 30; n > 0 && !h.units.empty(); n--) {
+			Unit* u = h.units[rand() % h.units.size()];
+			h.Remove(u);
+			freeIDs.push_back(u->id);
+			BOOST_CHECK(!ActiveUnitArray::Contains(h.units, h.slots, (const Unit*) u));
+		}
+
+		for (unsigned int n = 0; n < h.units.size(); n++) {
+			BOOST_CHECK(h.slots[h.units[n]->id] == n);
+			h.units[n]->visits = 0;
+		}
+
+		// a per-frame pass that adds units while it runs
+
+		for (h.updateIndex = 0; h.updateIndex < h.units.size(); ) {
+			Unit* u = h.units[h.updateIndex++];
+			u->visits++;
+
+			if ((rand() % 100) == 0 && !freeIDs.empty()) {
+				Unit* nu = &storage[freeIDs.back()];
+				freeIDs.pop_back();
+				nu->addFrame = frame;
+				nu->visits = 0;
+				nu->slowVisits = 0;
+				h.Add(nu);
+			}
+		}
+
+		h.updateIndex = 0;
+
+		for (unsigned int n = 0; n < h.units.size(); n++) {
+			BOOST_CHECK_EQUAL(h.units[n]->visits, 1);
+		}
+
+		// the staggered slow-update pass
+		if ((frame % SLOWUPDATE_RATE) == 0) {
+			// if the last round got through, every unit that was active
+			// during all of it has been visited exactly once
+			const bool roundDone = (frame > 0 && h.slowUpdateIndex == h.units.size());
+
+			for (unsigned int n = 0; n < h.units.size(); n++) {
+				if (roundDone && h.units[n]->addFrame < (frame - SLOWUPDATE_RATE)) {
+					BOOST_CHECK_EQUAL(h.units[n]->slowVisits, 1);
+				}
+
+				h.units[n]->slowVisits = 0;
+			}
+
+			h.slowUpdateIndex = 0;
+		}
+
+		for (int n = (h.units.size() / SLOWUPDATE_RATE) + 1; h.slowUpdateIndex < h.units.size() && n != 0; n--) {
+			h.units[h.slowUpdateIndex++]->slowVisits++;
+		}
+
+		// units added in this round may or may not get their slow-update
+		// (like before); just make sure no unit gets it twice
+		for (unsigned int n = 0; n < h.units.size(); n++) {
+			BOOST_CHECK(h.units[n]->slowVisits <= 1);
+		}
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(RemoveVisitedAtEndOfRound)
+{
+	// the slow-update cursor stays at the end from the end of a round
+	// until the next one starts, removals then hit only visited units
+	const unsigned int numUnits = 8;
+
+	for (unsigned int removeIdx = 0; removeIdx < numUnits; removeIdx++) {
+		Handler h;
+		std::vector<Unit> storage(numUnits);
+
+		for (unsigned int id = 0; id < numUnits; id++) {
+			storage[id].id = id;
+			ActiveUnitArray::Insert(h.units, h.slots, &storage[id], id);
+		}
+
+		h.slowUpdateIndex = h.units.size();
+
+		Unit* u = h.units[removeIdx];
+		h.Remove(u);
+
+		BOOST_CHECK_EQUAL(h.units.size(), numUnits - 1);
+		BOOST_CHECK_EQUAL(h.slowUpdateIndex, h.units.size());
+		BOOST_CHECK(!ActiveUnitArray::Contains(h.units, h.slots, (const Unit*) u));
+
+		for (unsigned int id = 0; id < numUnits; id++) {
+			if (&storage[id] == u)
+				continue;
+
+			BOOST_CHECK(ActiveUnitArray::Contains(h.units, h.slots, (const Unit*) &storage[id]));
+		}
+
+		for (unsigned int n = 0; n < h.units.size(); n++) {
+			BOOST_CHECK_EQUAL(h.slots[h.units[n]->id], n);
+		}
+	}
+}
+
+
+template<typename Container>
+static float TimePasses(Container& units, int frames)
+{
+	for (typename Container::iterator it = units.begin(); it != units.end(); ++it) {
+		(*it)->visits = 0;
+		(*it)->slowVisits = 0;
+	}
+
+	const clock_t t0 = clock();
+
+	typename Container::iterator slowIt = units.end();
+
+	for (int frame = 0; frame < frames; frame++) {
+		// MoveType::Update, Update
+		for (int pass = 0; pass < 2; pass++) {
+			for (typename Container::iterator it = units.begin(); it != units.end(); ++it) {
+				(*it)->visits++;
+			}
+		}
+
+		// SlowUpdate
+		if ((frame % SLOWUPDATE_RATE) == 0) {
+			slowIt = units.begin();
+		}
+
+		for (int n = (units.size() / SLOWUPDATE_RATE) + 1; slowIt != units.end() && n != 0; ++slowIt, --n) {
+			(*slowIt)->slowVisits++;
+		}
+	}
+
+	return (float(clock() - t0) / CLOCKS_PER_SEC) * 1000.0f;
+}
+
+template<typename Container>
+static void CheckPasses(const Container& units, int frames, int& numSlowVisits)
+{
+	numSlowVisits = 0;
+
+	for (typename Container::const_iterator it = units.begin(); it != units.end(); ++it) {
+		BOOST_CHECK_EQUAL((*it)->visits, 2 * frames);
+		numSlowVisits += (*it)->slowVisits;
+	}
+}
+
+static void ComparePasses(unsigned int numUnits)
+{
+	// allocate the units in shuffled order and the list nodes in between,
+	// so neither layout gets a perfectly sequential access pattern
+	std::vector<Unit*> allocated(numUnits);
+	std::list<Unit*> listUnits;
+	Handler h;
+
+	for (unsigned int n = 0; n < numUnits; n++) {
+		allocated[n] = new Unit();
+		allocated[n]->id = n;
+	}
+
+	std::random_shuffle(allocated.begin(), allocated.end());
+
+	for (unsigned int n = 0; n < numUnits; n++) {
+		std::list<Unit*>::iterator ui = listUnits.begin();
+		std::advance(ui, listUnits.empty()? 0: (rand() % listUnits.size()));
+		listUnits.insert(ui, allocated[n]);
+
+		h.Add(allocated[n]);
+	}
+
+	const int frames = 2000000 / numUnits;
+
+	// best of three, to be less sensitive to other load on the machine
+	float listTime = 1e9f;
+	float arrayTime = 1e9f;
+	int listSlowVisits = 0;
+	int arraySlowVisits = 0;
+
+	for (int run = 0; run < 3; run++) {
+		listTime = std::min(listTime, TimePasses(listUnits, frames));
+		CheckPasses(listUnits, frames, listSlowVisits);
+
+		arrayTime = std::min(arrayTime, TimePasses(h.units, frames));
+		CheckPasses(h.units, frames, arraySlowVisits);
+
+		BOOST_CHECK_EQUAL(listSlowVisits, arraySlowVisits);
+	}
+
+	printf("[%s] %u units, %d frames: std::list %.2fms, dense array %.2fms\n", __FUNCTION__, numUnits, frames, listTime, arrayTime);
+
+	// the reason for the array (it is about 4x faster here)
+	BOOST_CHECK_MESSAGE(arrayTime < listTime, "dense array passes are not faster than std::list ones");
+
+	for (unsigned int n = 0; n < numUnits; n++) {
+		delete allocated[n];
+	}
+}
+
+BOOST_AUTO_TEST_CASE(ArrayPassesFasterThanList)
+{
+	srand(1234);
+
+	ComparePasses(5000);
+	ComparePasses(20000);
+}
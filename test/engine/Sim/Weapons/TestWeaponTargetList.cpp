@@ -0,0 +1,54 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Weapons/WeaponTargetList.h"
+
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#define BOOST_TEST_MODULE WeaponTargetList
+#include <boost/test/unit_test.hpp>
+
+/*
+ * CWeaponTargetList must hand out the candidates in exactly the order the
+ * std::multimap<float, CUnit*> used by CWeapon::SlowUpdate did, including
+ * equal priorities, no matter how many of them are read.
+ */
+
+static const int NUM_ROUNDS = 500;
+
+
+BOOST_AUTO_TEST_CASE(SameOrderAsMultimap)
+{
+	std::vector<char> units(1000);
+	CWeaponTargetList targets;
+
+	srand(1234);
+
+	for (int round = 0; round < NUM_ROUNDS; ++round) {
+		std::multimap<float, CUnit*> reference;
+		const int numTargets = rand() % 300;
+
+		targets.Clear();
+
+		for (int n = 0; n < numTargets; ++n) {
+			// few distinct values, so there are plenty of ties
+			const float priority = (rand() % 20) * 0.25f;
+			CUnit* unit = reinterpret_cast<CUnit*>(&units[rand() % units.size()]);
+
+			reference.insert(std::pair<float, CUnit*>(priority, unit));
+			targets.Add(priority, unit);
+		}
+
+		BOOST_CHECK_EQUAL(targets.Size(), reference.size());
+
+		// stop early like the weapon does when TryTarget succeeds
+		const int numRead = (round & 1)? numTargets: (rand() % (numTargets + 1));
+		std::multimap<float, CUnit*>::const_iterator it = reference.begin();
+
+		for (int n = 0; n < numRead; ++n, ++it) {
+			BOOST_CHECK_EQUAL(targets.Get(n).priority, it->first);
+			BOOST_CHECK(targets.Get(n).unit == it->second);
+		}
+	}
+}
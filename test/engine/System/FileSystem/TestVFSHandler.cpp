@@ -0,0 +1,325 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/FileSystem/VFSHandler.h"
+#include "System/FileSystem/ArchiveLoader.h"
+#include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/IArchive.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE VFSHandler
+#include <boost/test/unit_test.hpp>
+
+/*
+ * Checks the file index and directory tree of CVFSHandler against a plain
+ * prefix scan over a sorted list of all files (what CVFSHandler did before),
+ * and that the tree and the hashed file table are faster than the sorted
+ * structures they replaced, on an archive with the layout of a large mod.
+ */
+
+
+/// an archive that only has file names, generated from its name
+class CTestArchive : public IArchive
+{
+public:
+	CTestArchive(const std::string& name, const std::vector<std::string>& fileNames)
+		: IArchive(name)
+		, fileNames(fileNames)
+	{
+		for (unsigned int fid = 0; fid < fileNames.size(); fid++) {
+			lcNameIndex[fileNames[fid]] = fid;
+		}
+	}
+
+	bool IsOpen() { return true; }
+	unsigned int NumFiles() const { return fileNames.size(); }
+	bool GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer) { buffer.clear(); return true; }
+	void FileInfo(unsigned int fid, std::string& name, int& size) const { name = fileNames[fid]; size = 0; }
+
+private:
+	std::vector<std::string> fileNames;
+};
+
+
+static std::vector<std::string> MakeNames(const std::string& dir, const std::string& ext, int count)
+{
+	std::vector<std::string> names;
+
+	for (int n = 0; n < count; n++) {
+		std::ostringstream name;
+		name << dir << "file" << n << ext;
+		names.push_back(name.str());
+	}
+
+	return names;
+}
+
+static void Append(std::vector<std::string>& names, const std::vector<std::string>& more)
+{
+	names.insert(names.end(), more.begin(), more.end());
+}
+
+/// roughly the layout of a large mod (16k files)
+static std::vector<std::string> MakeModFiles()
+{
+	std::vector<std::string> names;
+
+	Append(names, MakeNames("", ".txt", 5));
+	Append(names, MakeNames("gamedata/", ".lua", 40));
+	Append(names, MakeNames("units/", ".lua", 1500));
+	Append(names, MakeNames("weapons/", ".lua", 300));
+	Append(names, MakeNames("features/", ".lua", 200));
+	Append(names, MakeNames("scripts/", ".cob", 1500));
+	Append(names, MakeNames("objects3d/", ".s3o", 1700));
+	Append(names, MakeNames("unittextures/", ".dds", 3000));
+	Append(names, MakeNames("unitpics/", ".png", 1500));
+	Append(names, MakeNames("bitmaps/", ".tga", 400));
+	Append(names, MakeNames("luarules/gadgets/", ".lua", 400));
+	Append(names, MakeNames("luaui/widgets/", ".lua", 500));
+
+	for (int n = 0; n < 20; n++) {
+		std::ostringstream dir;
+		dir << "sounds/set" << n << "/";
+		Append(names, MakeNames(dir.str(), ".wav", 250));
+	}
+
+	return names;
+}
+
+/// overrides a few files of the mod and adds a dir
+static std::vector<std::string> MakeMapFiles()
+{
+	std::vector<std::string> names;
+
+	Append(names, MakeNames("units/", ".lua", 10));
+	Append(names, MakeNames("maps/", ".smf", 1));
+	Append(names, MakeNames("maps/extra/", ".tga", 5));
+
+	return names;
+}
+
+
+CArchiveLoader::CArchiveLoader() {}
+CArchiveLoader::~CArchiveLoader() {}
+
+CArchiveLoader& CArchiveLoader::GetInstance()
+{
+	static CArchiveLoader instance;
+	return instance;
+}
+
+IArchive* CArchiveLoader::OpenArchive(const std::string& fileName, const std::string& type) const
+{
+	if (fileName == "mod.sdz") {
+		return new CTestArchive(fileName, MakeModFiles());
+	}
+	if (fileName == "map.sdz") {
+		return new CTestArchive(fileName, MakeMapFiles());
+	}
+	return NULL;
+}
+
+CArchiveScanner* archiveScanner = NULL;
+
+std::vector<std::string> CArchiveScanner::GetArchives(const std::string& root, int depth) const
+{
+	return std::vector<std::string>();
+}
+
+
+/// the files and sub-dirs of a dir, found by scanning the sorted file list
+static void PrefixScan(const std::set<std::string>& files, const std::string& dir,
+		std::vector<std::string>& dirFiles, std::vector<std::string>& subDirs)
+{
+	std::set<std::string> subDirSet;
+
+	std::set<std::string>::const_iterator it;
+	for (it = files.lower_bound(dir); it != files.end(); ++it) {
+		if (it->compare(0, dir.length(), dir) != 0) {
+			break;
+		}
+
+		const std::string name = it->substr(dir.length());
+		const std::string::size_type slash = name.find('/');
+
+		if (slash == std::string::npos) {
+			dirFiles.push_back(name);
+		} else {
+			subDirSet.insert(name.substr(0, slash + 1));
+		}
+	}
+
+	subDirs.assign(subDirSet.begin(), subDirSet.end());
+}
+
+static void CheckDirs(CVFSHandler& vfs, const std::set<std::string>& files)
+{
+	std::set<std::string> dirs;
+	dirs.insert("");
+
+	for (std::set<std::string>::const_iterator it = files.begin(); it != files.end(); ++it) {
+		for (std::string::size_type slash = it->find('/'); slash != std::string::npos; slash = it->find('/', slash + 1)) {
+			dirs.insert(it->substr(0, slash + 1));
+		}
+
+		BOOST_CHECK(vfs.FileExists(*it));
+	}
+
+	for (std::set<std::string>::const_iterator it = dirs.begin(); it != dirs.end(); ++it) {
+		std::vector<std::string> dirFiles;
+		std::vector<std::string> subDirs;
+		PrefixScan(files, *it, dirFiles, subDirs);
+
+		BOOST_CHECK(vfs.GetFilesInDir(*it) == dirFiles);
+		BOOST_CHECK(vfs.GetDirsInDir(*it) == subDirs);
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(DirTreeMatchesPrefixScan)
+{
+	CVFSHandler vfs;
+
+	const std::vector<std::string> modFiles = MakeModFiles();
+	const std::vector<std::string> mapFiles = MakeMapFiles();
+
+	std::set<std::string> files(modFiles.begin(), modFiles.end());
+
+	BOOST_CHECK(vfs.AddArchive("mod.sdz", false));
+	CheckDirs(vfs, files);
+
+	files.insert(mapFiles.begin(), mapFiles.end());
+
+	BOOST_CHECK(vfs.AddArchive("map.sdz", true));
+	CheckDirs(vfs, files);
+
+	// both spellings of a dir, and one that does not exist
+	BOOST_CHECK(vfs.GetFilesInDir("Maps") == vfs.GetFilesInDir("maps/"));
+	BOOST_CHECK(vfs.GetFilesInDir("maps/nothing/").empty());
+	BOOST_CHECK(!vfs.FileExists("maps/nothing.smf"));
+
+	// all files that point to the removed archive disappear, including the
+	// ones it had overridden (they are not restored), and so does maps/
+	for (std::vector<std::string>::const_iterator it = mapFiles.begin(); it != mapFiles.end(); ++it) {
+		files.erase(*it);
+	}
+
+	BOOST_CHECK(vfs.RemoveArchive("map.sdz"));
+	CheckDirs(vfs, files);
+	BOOST_CHECK(vfs.GetDirsInDir("").size() == 12);
+	BOOST_CHECK(vfs.GetFilesInDir("maps/extra/").empty());
+}
+
+
+/// times lookups in the file table against a std::map with the same keys
+class CTimedVFSHandler : public CVFSHandler
+{
+public:
+	/// both in seconds, the best of three runs
+	void TimeFileTable(const std::vector<std::string>& names, int rounds, float& hashTime, float& mapTime) const
+	{
+		const std::map<std::string, FileData> sortedFiles(files.begin(), files.end());
+
+		hashTime = 1e9f;
+		mapTime = 1e9f;
+
+		for (int run = 0; run < 3; run++) {
+			unsigned int numFound = 0;
+
+			clock_t t0 = clock();
+			for (int n = 0; n < rounds; n++) {
+				for (unsigned int f = 0; f < names.size(); f++) {
+					numFound += (files.find(names[f]) != files.end());
+				}
+			}
+			hashTime = std::min(hashTime, float(clock() - t0) / CLOCKS_PER_SEC);
+
+			t0 = clock();
+			for (int n = 0; n < rounds; n++) {
+				for (unsigned int f = 0; f < names.size(); f++) {
+					numFound -= (sortedFiles.find(names[f]) != sortedFiles.end());
+				}
+			}
+			mapTime = std::min(mapTime, float(clock() - t0) / CLOCKS_PER_SEC);
+
+			BOOST_CHECK(numFound == 0);
+		}
+	}
+};
+
+
+BOOST_AUTO_TEST_CASE(FasterThanSortedStructures)
+{
+	CTimedVFSHandler vfs;
+	vfs.AddArchive("mod.sdz", false);
+
+	const std::vector<std::string> modFiles = MakeModFiles();
+	const std::set<std::string> files(modFiles.begin(), modFiles.end());
+
+	std::vector<std::string> dirs;
+	dirs.push_back("");
+	dirs.push_back("units/");
+	dirs.push_back("objects3d/");
+	dirs.push_back("unittextures/");
+	dirs.push_back("luaui/widgets/");
+	dirs.push_back("sounds/");
+	dirs.push_back("sounds/set7/");
+
+	const int numListings = 200;
+	unsigned int numFound = 0;
+
+	clock_t t0 = clock();
+	for (int n = 0; n < numListings; n++) {
+		for (unsigned int d = 0; d < dirs.size(); d++) {
+			numFound += vfs.GetFilesInDir(dirs[d]).size();
+			numFound += vfs.GetDirsInDir(dirs[d]).size();
+		}
+	}
+	const float treeTime = float(clock() - t0) / CLOCKS_PER_SEC;
+
+	t0 = clock();
+	for (int n = 0; n < numListings; n++) {
+		for (unsigned int d = 0; d < dirs.size(); d++) {
+			std::vector<std::string> dirFiles;
+			std::vector<std::string> subDirs;
+			PrefixScan(files, dirs[d], dirFiles, subDirs);
+			numFound -= (dirFiles.size() + subDirs.size());
+		}
+	}
+	const float scanTime = float(clock() - t0) / CLOCKS_PER_SEC;
+
+	BOOST_CHECK(numFound == 0);
+
+	// FileExists as a whole also normalizes the path and asks the archive
+	const int numRounds = 20;
+
+	t0 = clock();
+	for (int n = 0; n < numRounds; n++) {
+		for (unsigned int f = 0; f < modFiles.size(); f++) {
+			numFound += vfs.FileExists(modFiles[f]);
+		}
+	}
+	const float fileExistsTime = float(clock() - t0) / CLOCKS_PER_SEC;
+
+	BOOST_CHECK(numFound == (numRounds * modFiles.size()));
+
+	float hashTime = 0.0f;
+	float mapTime = 0.0f;
+	vfs.TimeFileTable(modFiles, numRounds, hashTime, mapTime);
+
+	printf("[%s] %u files, %u listings: dir tree %.3fs, prefix scan %.3fs\n",
+			__FUNCTION__, (unsigned int) files.size(), (unsigned int) (numListings * dirs.size()), treeTime, scanTime);
+	printf("[%s] %u lookups: file table hashed %.3fs, std::map %.3fs (FileExists in total %.3fs)\n",
+			__FUNCTION__, (unsigned int) (numRounds * modFiles.size()), hashTime, mapTime, fileExistsTime);
+
+	// the reasons for the tree and the hashed table
+	BOOST_CHECK_MESSAGE(treeTime < scanTime, "dir tree listings are not faster than a prefix scan");
+	BOOST_CHECK_MESSAGE(hashTime < mapTime, "hashed file table lookups are not faster than std::map ones");
+}
@@ -0,0 +1,45 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+// what System/EventHandler.cpp needs besides its clients, for tests that
+// dispatch events without Lua (and without GL)
+
+#include "Game/UI/LuaUI.h"
+#include "Lua/LuaHandle.h"
+#include "Lua/LuaOpenGL.h"
+#include "System/EventBatchHandler.h"
+
+#include <cstddef>
+
+CLuaUI* luaUI = NULL;
+
+void CLuaHandle::ExecuteUnitEventBatch() {}
+void CLuaHandle::ExecuteFeatEventBatch() {}
+void CLuaHandle::ExecuteObjEventBatch() {}
+void CLuaHandle::ExecuteProjEventBatch() {}
+
+EventBatchHandler* EventBatchHandler::GetInstance() { return NULL; }
+void EventBatchHandler::UpdateUnits() {}
+void EventBatchHandler::UpdateDrawUnits() {}
+void EventBatchHandler::DeleteSyncedUnits() {}
+void EventBatchHandler::UpdateFeatures() {}
+void EventBatchHandler::UpdateDrawFeatures() {}
+void EventBatchHandler::DeleteSyncedFeatures() {}
+void EventBatchHandler::UpdateProjectiles() {}
+void EventBatchHandler::UpdateDrawProjectiles() {}
+void EventBatchHandler::DeleteSyncedProjectiles() {}
+void EventBatchHandler::UpdateObjects() {}
+
+#define NULL_DRAW_MODE(name)                   \
+	void LuaOpenGL::Enable  ## name () {}      \
+	void LuaOpenGL::Reset   ## name () {}      \
+	void LuaOpenGL::Disable ## name () {}
+
+NULL_DRAW_MODE(DrawGenesis)
+NULL_DRAW_MODE(DrawWorld)
+NULL_DRAW_MODE(DrawWorldPreUnit)
+NULL_DRAW_MODE(DrawWorldShadow)
+NULL_DRAW_MODE(DrawWorldReflection)
+NULL_DRAW_MODE(DrawWorldRefraction)
+NULL_DRAW_MODE(DrawScreenEffects)
+NULL_DRAW_MODE(DrawScreen)
+NULL_DRAW_MODE(DrawInMiniMap)
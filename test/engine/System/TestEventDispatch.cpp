@@ -0,0 +1,214 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/EventHandler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <new>
+#include <vector>
+
+#define BOOST_TEST_MODULE EventDispatch
+#include <boost/test/unit_test.hpp>
+
+/*
+ * Runs the UnitMoved dispatch of CEventHandler as CUnitHandler::Update
+ * does (UnitMoved per moving unit, FlushUnitsMoved after the pass), checks
+ * that the batched UnitsMoved clients get the same units in the same order
+ * as the per-unit UnitMoved ones for every access level, and that batching
+ * is cheaper once there are several clients.
+ */
+
+static const int NUM_UNITS = 5000;
+static const int NUM_FRAMES = 400;
+
+
+class Client: public CEventClient {
+public:
+	Client(int readAllyTeam, bool batched)
+		: CEventClient(batched? "[UnitsMoved]": "[UnitMoved]", 0, false)
+		, record(false)
+		, readAllyTeam(readAllyTeam)
+		, batched(batched)
+		, sum(0)
+	{}
+
+	bool WantsEvent(const std::string& eventName) {
+		return (eventName == (batched? "UnitsMoved": "UnitMoved"));
+	}
+
+	int  GetReadAllyTeam() const { return readAllyTeam; }
+
+	void UnitMoved(const CUnit* unit) { Process(unit); }
+
+	std::vector<const CUnit*> received;
+	bool record;
+
+protected:
+	void Process(const CUnit* unit) {
+		if (record) {
+			received.push_back(unit);
+		}
+		sum += unit->allyteam;
+	}
+
+private:
+	int readAllyTeam;
+	bool batched;
+	int sum;
+};
+
+/// an engine-internal client such as CGroundDecalHandler
+class EngineClient: public Client {
+public:
+	EngineClient(bool batched): Client(AllAccessTeam, batched) {}
+
+	bool GetFullRead() const { return true; }
+
+	void UnitsMoved(const std::vector<const CUnit*>& units) {
+		for (std::vector<const CUnit*>::const_iterator it = units.begin(); it != units.end(); ++it) {
+			Process(*it);
+		}
+	}
+};
+
+
+static Client* NewClient(int readAllyTeam, bool batched)
+{
+	Client* client = NULL;
+
+	if (readAllyTeam == CEventClient::AllAccessTeam) {
+		client = new EngineClient(batched);
+	} else {
+		client = new Client(readAllyTeam, batched);
+	}
+
+	eventHandler.AddClient(client);
+	return client;
+}
+
+
+/// CUnit can not be constructed without a running sim, but the
+/// dispatch only reads the allyteam of the units it passes on
+static std::vector<CUnit*> NewUnits()
+{
+	std::vector<CUnit*> units(NUM_UNITS);
+
+	for (int n = 0; n < NUM_UNITS; n++) {
+		units[n] = static_cast<CUnit*>(::operator new(sizeof(CUnit)));
+		units[n]->allyteam = n % 4;
+	}
+
+	return units;
+}
+
+static void DeleteUnits(std::vector<CUnit*>& units)
+{
+	for (int n = 0; n < NUM_UNITS; n++) {
+		::operator delete(units[n]);
+	}
+
+	units.clear();
+}
+
+/// one MoveType pass per frame in which every unit moves
+static float TimeFrames(const std::vector<CUnit*>& units)
+{
+	const clock_t t0 = clock();
+
+	for (int frame = 0; frame < NUM_FRAMES; frame++) {
+		for (int n = 0; n < NUM_UNITS; n++) {
+			if (eventHandler.HaveUnitMoved()) {
+				eventHandler.UnitMoved(units[n]);
+			}
+		}
+
+		eventHandler.FlushUnitsMoved();
+	}
+
+	const float ms = (float(clock() - t0) / CLOCKS_PER_SEC) * 1000.0f;
+	return ((ms * 1000000.0f) / (NUM_FRAMES * NUM_UNITS)); // ns per event
+}
+
+static float TimeClients(const std::vector<CUnit*>& units, unsigned int numClients, bool batched)
+{
+	std::vector<Client*> clients;
+
+	for (unsigned int n = 0; n < numClients; n++) {
+		// like the engine-internal clients, the first one reads everything
+		clients.push_back(NewClient((n == 0)? CEventClient::AllAccessTeam: (n % 4), batched));
+	}
+
+	const float time = TimeFrames(units);
+
+	for (unsigned int n = 0; n < numClients; n++) {
+		delete clients[n];
+	}
+
+	BOOST_CHECK(!eventHandler.HaveUnitMoved());
+	return time;
+}
+
+static float CompareClients(const std::vector<CUnit*>& units, unsigned int numClients)
+{
+	float perUnitTime = 1e9f;
+	float batchedTime = 1e9f;
+
+	// best of three, to be less sensitive to other load on the machine
+	for (int run = 0; run < 3; run++) {
+		perUnitTime = std::min(perUnitTime, TimeClients(units, numClients, false));
+		batchedTime = std::min(batchedTime, TimeClients(units, numClients, true));
+	}
+
+	printf("[%s] %u clients: per-unit %.2fns/event, batched %.2fns/event\n", __FUNCTION__, numClients, perUnitTime, batchedTime);
+	return (batchedTime / perUnitTime);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(BatchedEqualsPerUnit)
+{
+	std::vector<CUnit*> units = NewUnits();
+
+	for (int readAllyTeam = CEventClient::MinSpecialTeam; readAllyTeam < 4; readAllyTeam++) {
+		Client* perUnitClient = NewClient(readAllyTeam, false);
+		Client* batchedClient = NewClient(readAllyTeam, true);
+
+		perUnitClient->record = true;
+		batchedClient->record = true;
+
+		for (int n = 0; n < NUM_UNITS; n += 3) {
+			eventHandler.UnitMoved(units[n]);
+		}
+
+		BOOST_CHECK(batchedClient->received.empty());
+		eventHandler.FlushUnitsMoved();
+
+		BOOST_CHECK(perUnitClient->received == batchedClient->received);
+
+		// nothing is delivered twice
+		batchedClient->received.clear();
+		eventHandler.FlushUnitsMoved();
+		BOOST_CHECK(batchedClient->received.empty());
+
+		delete perUnitClient;
+		delete batchedClient;
+	}
+
+	DeleteUnits(units);
+}
+
+
+BOOST_AUTO_TEST_CASE(BatchedIsCheaperForSeveralClients)
+{
+	std::vector<CUnit*> units = NewUnits();
+
+	CompareClients(units, 0);
+	CompareClients(units, 1);
+
+	// one call per client and frame instead of a virtual access check
+	// and a virtual call per client and unit (about 2x cheaper here)
+	BOOST_CHECK(CompareClients(units, 8) < 1.0f);
+
+	DeleteUnits(units);
+}
@@ -0,0 +1,119 @@
+
+function widget:GetInfo()
+return {
+	name    = "GC-ListTables",
+	desc    = "Polls the list queries every frame and logs the LuaUI GC time (see replay-gc.sh)",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = true,
+}
+end
+
+-- 0: off, 1: new result tables every call, 2: the result tables are reused
+local mode = Spring.GetConfigInt("ListTableGCBench", 0)
+
+if (mode == 0) then
+	return false
+end
+
+local Spring_GetAllUnits            = Spring.GetAllUnits
+local Spring_GetTeamUnits           = Spring.GetTeamUnits
+local Spring_GetUnitsInRectangle    = Spring.GetUnitsInRectangle
+local Spring_GetAllFeatures         = Spring.GetAllFeatures
+local Spring_GetFeaturesInRectangle = Spring.GetFeaturesInRectangle
+
+local FRAMES_PER_MINUTE = 30 * 60
+
+local reuse = (mode == 2)
+local teams = Spring.GetTeamList()
+local halfX = Game.mapSizeX / 2
+local halfZ = Game.mapSizeZ / 2
+
+local allUnits    = {}
+local teamUnits   = {}
+local rectUnits   = {}
+local allFeatures = {}
+local rectFeats   = {}
+
+for i = 1, #teams do
+	teamUnits[i] = {}
+end
+
+local startStats = nil
+local startFrame = 0
+local numIDs = 0
+
+local function GetUIStats()
+	local stats = Spring.GetLuaGCStats()["LuaUI"]
+	return stats and stats.sim
+end
+
+local function Count(t)
+	numIDs = numIDs + #t
+end
+
+-- what a typical polling widget asks for every frame
+local function Poll()
+	if (reuse) then
+		Count(Spring_GetAllUnits(allUnits))
+		for i = 1, #teams do
+			Count(Spring_GetTeamUnits(teams[i], teamUnits[i]))
+		end
+		Count(Spring_GetUnitsInRectangle(0, 0, halfX, halfZ, nil, rectUnits))
+		Count(Spring_GetAllFeatures(allFeatures))
+		Count(Spring_GetFeaturesInRectangle(0, 0, halfX, halfZ, rectFeats))
+	else
+		Count(Spring_GetAllUnits())
+		for i = 1, #teams do
+			Count(Spring_GetTeamUnits(teams[i]))
+		end
+		Count(Spring_GetUnitsInRectangle(0, 0, halfX, halfZ))
+		Count(Spring_GetAllFeatures())
+		Count(Spring_GetFeaturesInRectangle(0, 0, halfX, halfZ))
+	end
+end
+
+local function Report(n, final)
+	local stats = GetUIStats()
+
+	if (startStats == nil or stats == nil) then
+		return
+	end
+
+	local minutes = (n - startFrame) / FRAMES_PER_MINUTE
+
+	if (minutes <= 0) then
+		return
+	end
+
+	local gcTime = stats.stepTime - startStats.stepTime
+	local cycles = stats.cycles - startStats.cycles
+
+	Spring.Echo(string.format("[GC-ListTables] %s mode=%s minutes=%.1f ids=%d gcTime=%.2fms (%.2fms/min) cycles=%d (%.2f/min) heap=%dKB",
+		(final and "total" or "progress"), (reuse and "reuse" or "new"), minutes, numIDs,
+		gcTime, gcTime / minutes, cycles, cycles / minutes, stats.heapSize))
+end
+
+function widget:GameFrame(n)
+	if (startStats == nil) then
+		startStats = GetUIStats()
+		startFrame = n
+
+		if (startStats == nil) then
+			Spring.Echo("[GC-ListTables] no GC stats, is LuaGarbageCollectionBudget 0?")
+			widgetHandler:RemoveWidget()
+			return
+		end
+	end
+
+	Poll()
+
+	if (((n - startFrame) % FRAMES_PER_MINUTE) == 0) then
+		Report(n, false)
+	end
+end
+
+function widget:Shutdown()
+	Report(Spring.GetGameFrame(), true)
+end
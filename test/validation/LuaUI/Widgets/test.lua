@@ -28,7 +28,8 @@ function widget:GameFrame(n)
 			Spring.SendCommands("speedup")
 		end
 	end
-	if n==27000 then -- run spring 15 minutes (ingame time)
+	-- run spring 15 minutes (ingame time), replays stop before the demo ends
+	if n==27000 or (n==26000 and Spring.IsReplay()) then
 		Spring.Echo("Tests run long enough, quitting...")
 		Spring.SendCommands("quit")
 	end
@@ -0,0 +1,64 @@
+#!/bin/sh
+
+# replays the newest demo of a validation game twice with the GC-ListTables
+# widget, once with new result tables for every list query and once with
+# reused ones, and prints the LuaUI garbage collection time per minute of
+# game of both (see Spring.GetLuaGCStats)
+
+set -e #abort on error
+
+if [ $# -le 1 ]; then
+	echo "Usage: $0 /path/to/spring /path/to/demos"
+	exit 1
+fi
+
+
+if [ ! -x "$1" ]; then
+	echo "Parameter 1 $1 isn't executable!"
+	exit 1
+fi
+
+DEMO=$(ls -t "$2"/*.sdf | head -n 1)
+
+if [ ! -f "$DEMO" ]; then
+	echo "No demo found in $2!"
+	exit 1
+fi
+
+LOG=$(mktemp)
+CONFIG=$(mktemp)
+EXIT=0
+
+#same limits as run.sh
+ulimit -v 1000000
+ulimit -t 900
+
+for MODE in 1 2; do
+	if [ -f "$HOME/.springrc" ]; then
+		cp "$HOME/.springrc" $CONFIG
+	else
+		: > $CONFIG
+	fi
+	echo "ListTableGCBench = $MODE" >> $CONFIG
+
+	echo "Replaying $DEMO with ListTableGCBench = $MODE"
+
+	set +e #temp disable abort on error
+	"$1" --config $CONFIG "$DEMO" > $LOG 2>&1
+	RET=$?
+	set -e
+
+	if [ $RET -ne 0 ]; then
+		cat $LOG
+		EXIT=$RET
+	fi
+
+	if ! grep "\[GC-ListTables\] total" $LOG; then
+		echo "Error: no GC-ListTables results in the log"
+		EXIT=1
+	fi
+done
+
+#cleanup
+rm -f $LOG $CONFIG
+exit $EXIT
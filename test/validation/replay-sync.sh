@@ -0,0 +1,50 @@
+#!/bin/sh
+
+# replays the newest demo of a validation game with a single thread, so
+# the move-type plan pass (see CUnitHandler::Update) runs serially, and
+# fails if the checksums differ from those recorded by the (parallel) game
+
+set -e #abort on error
+
+if [ $# -le 1 ]; then
+	echo "Usage: $0 /path/to/spring /path/to/demos"
+	exit 1
+fi
+
+
+if [ ! -x "$1" ]; then
+	echo "Parameter 1 $1 isn't executable!"
+	exit 1
+fi
+
+DEMO=$(ls -t "$2"/*.sdf | head -n 1)
+
+if [ ! -f "$DEMO" ]; then
+	echo "No demo found in $2!"
+	exit 1
+fi
+
+LOG=$(mktemp)
+
+#same limits as run.sh
+ulimit -v 1000000
+ulimit -t 900
+
+echo "Replaying $DEMO with OMP_NUM_THREADS=1"
+
+set +e #temp disable abort on error
+OMP_NUM_THREADS=1 "$1" "$DEMO" > $LOG 2>&1
+EXIT=$?
+set -e
+
+cat $LOG
+
+#the server checks the recorded checksums while replaying
+if grep -q "Sync error for" $LOG; then
+	echo "Error: the serial replay of $DEMO desynced"
+	EXIT=1
+fi
+
+#cleanup
+rm -f $LOG
+exit $EXIT